@@ -0,0 +1,44 @@
+#!/usr/bin/env bash
+# MIT License
+#
+# Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+# Distributed under the terms of the MIT License.
+#
+# times every program in bench/programs on each execution engine: the
+# tree-walking interpreter, the closure compiler, the jit and, when a c++
+# compiler is at hand, the native build of its --emit-cpp translation. each
+# time is the best wall time of several runs, in seconds.
+#
+# usage: bench/engines.sh [lox binary] [runs]
+set -u
+here=$(cd "$(dirname "$0")" && pwd)
+repo=$(dirname "$here")
+lox=${1:-./lox}
+runs=${2:-3}
+build=$(mktemp -d)
+trap 'rm -rf "$build"' EXIT
+TIMEFORMAT=%R
+
+best() {
+  local fastest= seconds
+  for ((run = 0; run < runs; ++run)); do
+    seconds=$({ time "$@" > /dev/null 2>&1; } 2>&1)
+    if [[ -z $fastest ]] || awk "BEGIN { exit !($seconds < $fastest) }"; then
+      fastest=$seconds
+    fi
+  done
+  echo "$fastest"
+}
+
+printf '%-12s %12s %12s %12s %12s\n' program interpreter closures jit native
+for program in "$here"/programs/*.lox; do
+  name=$(basename "$program" .lox)
+  native=-
+  if command -v c++ > /dev/null && "$lox" --emit-cpp "$program" > "$build/$name.cpp" &&
+     c++ -std=c++20 -O2 -I "$repo/include" "$build/$name.cpp" "$repo/src/lox_runtime.cpp" \
+       "$repo/src/output_sink.cpp" -o "$build/$name" 2> /dev/null; then
+    native=$(best "$build/$name")
+  fi
+  printf '%-12s %12s %12s %12s %12s\n' "$name" "$(best "$lox" "$program")" \
+    "$(best "$lox" --compile-closures "$program")" "$(best "$lox" --jit "$program")" "$native"
+done
@@ -0,0 +1,100 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include "../include/parser.hpp"
+#include "../include/scanner.hpp"
+
+using namespace loxplusplus;
+
+// parser microbenchmark: scans a source once and parses the tokens again and
+// again, so the times cover the parser alone. without a script it parses a
+// generated program that mixes every statement and most expression forms.
+
+[[nodiscard]] static std::string generate(std::size_t functions) {
+  std::string source;
+  for (std::size_t i = 0; i < functions; ++i) {
+    const std::string index = std::to_string(i);
+    source += "fun f" + index + "(a, b, c) {\n"
+              "  var x = a + b * 3 - c / 2;\n"
+              "  if (x < 10 and !(b == c) or a == nil) x = -x; else x = x + 1.5;\n"
+              "  while (x > 0) { x = x - 1; print \"step\"; }\n"
+              "  for (var i = 0; i < 3; i = i + 1) x = x + i;\n"
+              "  return f" + index + "(x, b, c).y.z(1, 2);\n"
+              "}\n"
+              "class C" + index + " < B { init(v) { this.v = v; } get() { return super.get() + this.v; } }\n"
+              "var v" + index + " = C" + index + "(" + index + ").get() >= 2 == true;\n";
+  }
+  return source;
+}
+
+void usage() noexcept {
+  std::cout << "Usage: parse_bench [--iterations <n>] [--functions <n>] [script]\n";
+}
+
+int main(int argc, char *argv[]) {
+  std::size_t iterations = 20, functions = 20000;
+  std::string_view script;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--iterations" && i + 1 < argc) {
+      iterations = std::max<std::size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+    } else if (arg == "--functions" && i + 1 < argc) {
+      functions = std::strtoull(argv[++i], nullptr, 10);
+    } else if (script.empty() && !arg.starts_with("--")) {
+      script = arg;
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  std::string source;
+  if (script.empty()) {
+    source = generate(functions);
+  } else {
+    std::ifstream file(std::string(script), std::ios::binary);
+    if (!file) {
+      std::cerr << "failed to open file '" << script << "'.\n";
+      return 1;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    source = std::move(contents).str();
+  }
+
+  Diagnostics diagnostics;
+  Scanner scanner(source, diagnostics);
+  const std::vector<SourceToken> tokens = scanner.scan_tokens();
+  if (diagnostics.had_error)
+    return 1;
+  double best = std::numeric_limits<double>::infinity(), total = 0;
+  std::size_t statements = 0;
+  for (std::size_t i = 0; i < iterations; ++i) {
+    Lexicon lexicon;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<Stmt>> parsed = Parser(tokens, lexicon, diagnostics).parse();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (diagnostics.had_error)
+      return 1;
+    best = std::min(best, seconds);
+    total += seconds;
+    statements = parsed.size();
+  }
+  std::cout << std::fixed << std::setprecision(3)
+            << "parse: " << source.size() << " bytes, " << tokens.size() << " tokens, " << statements
+            << " statements\n"
+            << "parse: " << best * 1000 << "ms best, " << total * 1000 / static_cast<double>(iterations)
+            << "ms mean of " << iterations << ", " << static_cast<double>(source.size()) / best / 1e6
+            << " MB/s\n";
+}
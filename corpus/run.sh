@@ -0,0 +1,52 @@
+#!/usr/bin/env bash
+# MIT License
+#
+# Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+# Distributed under the terms of the MIT License.
+#
+# conformance corpus: runs every corpus/*.lox program under each execution
+# mode and compares its combined output and errors byte for byte with the
+# .out file next to it. when a c++ compiler is at hand the --emit-cpp
+# translation is built and compared too, and every program is scanned in
+# forced chunks against a sequential scan.
+#
+# usage: corpus/run.sh [lox binary]
+set -u
+here=$(cd "$(dirname "$0")" && pwd)
+repo=$(dirname "$here")
+lox=${1:-./lox}
+build=$(mktemp -d)
+trap 'rm -rf "$build"' EXIT
+modes=("" "--compile-closures" "--jit-threshold 1" "--lazy-parse" "--lazy-parse --compile-closures" "--memoize")
+failed=0
+
+fail() {
+  echo "FAIL $1"
+  failed=$((failed + 1))
+}
+
+for program in "$here"/*.lox; do
+  name=$(basename "$program" .lox)
+  expected="$here/$name.out"
+  for mode in "${modes[@]}"; do
+    # modes hold several words on purpose.
+    # shellcheck disable=SC2086
+    "$lox" $mode "$program" > "$build/$name.actual" 2>&1
+    cmp -s "$expected" "$build/$name.actual" || fail "$name ${mode:-(interpreter)}"
+  done
+  for chunks in 2 3 7; do
+    "$lox" --check-scan "$chunks" "$program" || fail "$name --check-scan $chunks"
+  done
+  if command -v c++ > /dev/null; then
+    if "$lox" --emit-cpp "$program" > "$build/$name.cpp" &&
+       c++ -std=c++20 -I "$repo/include" "$build/$name.cpp" "$repo/src/lox_runtime.cpp" \
+         "$repo/src/output_sink.cpp" -o "$build/$name" 2> /dev/null; then
+      "$build/$name" > "$build/$name.actual" 2>&1
+      cmp -s "$expected" "$build/$name.actual" || fail "$name --emit-cpp"
+    else
+      fail "$name --emit-cpp (build)"
+    fi
+  fi
+done
+echo "corpus: $failed failed"
+[ "$failed" -eq 0 ]
@@ -0,0 +1,65 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "engine.hpp"
+#include "output_sink.hpp"
+#include "thread_pool.hpp"
+
+namespace loxplusplus {
+// runs many independent scripts in one process. every script gets a fresh
+// engine whose output and errors are captured in memory; the captures are
+// written in input order as soon as all earlier scripts have finished, so the
+// combined output matches running the scripts one after another.
+class BatchRunner {
+public:
+  struct Statistics {
+    std::size_t scripts{0};
+    std::size_t failed{0};
+    double wall_seconds{0};
+    double total_seconds{0};
+    double min_seconds{0};
+    double max_seconds{0};
+  };
+
+  BatchRunner(EngineOptions options, std::size_t jobs = ThreadPool::default_threads());
+
+  // every *.lox file of a directory sorted by path, or the non-empty lines of
+  // a list file. nullopt if path is neither.
+  [[nodiscard]] static std::optional<std::vector<std::string>> collect(const std::string &path);
+
+  Statistics run(const std::vector<std::string> &scripts, OutputSink &output, std::ostream &errors);
+
+  static void report(const Statistics &statistics, std::size_t jobs, std::ostream &stream);
+
+  [[nodiscard]] std::size_t jobs() const noexcept;
+
+private:
+  struct Job {
+    std::string output;
+    std::string errors;
+    double seconds{0};
+    bool failed{false};
+    bool done{false};
+  };
+
+  void execute(const std::string &script, Job &job) const;
+  void emit_ready(std::vector<Job> &jobs, OutputSink &output, std::ostream &errors);
+
+private:
+  EngineOptions options;
+  ThreadPool pool;
+  std::mutex mutex;
+  std::size_t next{0};
+};
+}// namespace loxplusplus
@@ -0,0 +1,135 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <set>
+
+#include "expr.hpp"
+#include "lox_function.hpp"
+#include "stmt.hpp"
+
+namespace loxplusplus {
+class Interpreter;
+
+// local variables of compiled code live in numbered slots instead of the
+// name-keyed Environment. scopes that declare nothing are never allocated.
+struct Scope {
+  std::vector<Object> slots;
+  std::shared_ptr<Scope> enclosing;
+};
+
+struct Frame {
+  std::shared_ptr<Scope> scope;
+  Object result;
+};
+
+using Evaluation = std::function<Object(Frame &)>;
+// returns true while a return statement unwinds to its function; the value
+// is left in Frame::result.
+using Execution = std::function<bool(Frame &)>;
+
+struct CompiledBody {
+  std::vector<Execution> statements;
+  std::size_t slots;
+  // compiles the body of a function whose parsing was deferred on its first
+  // call, so an invalid body only fails the calls that reach it.
+  std::function<CompiledBody()> pending;
+  // the body of Function::replaced, run while its classes are replaceable.
+  std::shared_ptr<CompiledBody> replaced;
+};
+
+class ClosureFunction : public LoxFunction {
+public:
+  ClosureFunction(std::shared_ptr<Function> declaration, std::shared_ptr<CompiledBody> body,
+                  std::shared_ptr<Scope> scope, bool is_initializer);
+
+  [[nodiscard]] std::shared_ptr<LoxFunction> bind(std::shared_ptr<LoxInstance> instance) override;
+
+protected:
+  [[nodiscard]] Object execute(Interpreter &interpreter, std::vector<Object> arguments) override;
+
+private:
+  std::shared_ptr<CompiledBody> body;
+  std::shared_ptr<Scope> scope;
+};
+
+// alternative execution engine: converts every resolved node once into a
+// tree of pre-bound closures. operands, slot positions and the operator are
+// captured at compile time, so running the program is a chain of indirect
+// calls without accept()/visit() dispatch or token type switches.
+class ClosureCompiler : public ExprVisitor, public StmtVisitor {
+public:
+  ClosureCompiler(Interpreter &interpreter);
+
+  void run(const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<While> stmt) override;
+
+  [[nodiscard]] Object visit(std::shared_ptr<Assign> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Binary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Call> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Get> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Grouping> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Literal> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Logical> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Set> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Super> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<This> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Unary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Variable> expr) override;
+
+private:
+  // mirrors one scope of the Resolver.
+  struct CompileScope {
+    std::map<std::string, std::size_t> slots;
+    bool allocated;
+  };
+
+  struct Location {
+    int hops;
+    std::size_t slot;
+  };
+
+  [[nodiscard]] Execution compile(std::shared_ptr<Stmt> stmt);
+  [[nodiscard]] Evaluation compile(std::shared_ptr<Expr> expr);
+  [[nodiscard]] std::vector<Execution> compile(const std::vector<std::shared_ptr<Stmt>> &statements);
+  [[nodiscard]] Execution compile_block(const std::vector<std::shared_ptr<Stmt>> &statements);
+  [[nodiscard]] std::shared_ptr<CompiledBody> compile_function(const Function &function);
+  [[nodiscard]] CompiledBody compile_body(const Function &function, const std::vector<std::shared_ptr<Stmt>> &body);
+  [[nodiscard]] bool compile_inlined(const std::shared_ptr<Call> &expr, std::vector<Evaluation> &arguments);
+
+  void begin_scope(bool allocated);
+  void end_scope();
+  [[nodiscard]] std::size_t declare(const std::string &name);
+  [[nodiscard]] Location locate(const std::string &name, int depth) const;
+  [[nodiscard]] Execution define(const Token &name, int slot, Evaluation value);
+
+  [[nodiscard]] static std::size_t declarations(const std::vector<std::shared_ptr<Stmt>> &statements);
+
+private:
+  Interpreter &interpreter;
+  std::vector<CompileScope> scopes;
+  // modules whose compilation is in progress; an import cycle back into one
+  // of them compiles to nothing, as the module has already started running.
+  std::set<std::string> importing;
+  Evaluation evaluation;
+  Execution execution;
+  // returned expressions of the functions inlined so far.
+  std::map<const Function *, std::shared_ptr<Evaluation>> inlined;
+};
+}// namespace loxplusplus
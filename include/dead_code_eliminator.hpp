@@ -0,0 +1,74 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "module_cache.hpp"
+#include "stmt.hpp"
+
+namespace loxplusplus {
+// removes code that can never run or whose result nothing uses:
+//
+// - statements following a return, or a block or if that returns on every
+//   path, in the same list.
+// - local variables, functions and classes that nothing after them names,
+//   when declaring them cannot fail.
+// - with eliminate_globals(), top-level declarations of the same kind that
+//   nothing in the program or its modules names outside themselves.
+//
+// uses are found by name, whatever scope a use resolves to. runs after the
+// Resolver; removing declarations leaves the depths of other variables as
+// they are.
+class DeadCodeEliminator {
+public:
+  // prunes statements and the functions nested in them.
+  void eliminate(std::vector<std::shared_ptr<Stmt>> &statements);
+  // the same for the body of a function whose parsing was deferred.
+  void eliminate_function(std::vector<std::shared_ptr<Stmt>> &body);
+  // only valid when nothing but the program and its modules ever runs in
+  // its globals: no earlier or later runs of the engine and no snapshots.
+  // does nothing while a deferred body may still name a declaration.
+  void eliminate_globals(std::vector<std::shared_ptr<Stmt>> &statements, const Modules &modules);
+
+  // what each part of the pass removed.
+  [[nodiscard]] std::string report() const;
+
+private:
+  using Mentions = std::unordered_map<std::string, int>;
+
+  [[nodiscard]] std::vector<std::shared_ptr<Stmt>> prune(const std::vector<std::shared_ptr<Stmt>> &statements,
+                                                         bool local);
+  [[nodiscard]] std::shared_ptr<Stmt> prune(const std::shared_ptr<Stmt> &stmt);
+  void prune(Function &function);
+  [[nodiscard]] static bool terminates(const std::shared_ptr<Stmt> &stmt);
+  [[nodiscard]] static const Token *declared(const std::shared_ptr<Stmt> &stmt);
+  [[nodiscard]] static const Token *removable(const std::shared_ptr<Stmt> &stmt);
+  [[nodiscard]] bool subclass(const std::vector<std::shared_ptr<Stmt>> &statements,
+                              const std::unordered_map<std::string, std::vector<std::size_t>> &declarations,
+                              std::size_t index) const;
+  [[nodiscard]] static bool pure(const std::shared_ptr<Expr> &expr);
+
+  void count(const std::shared_ptr<Stmt> &stmt, Mentions &mentions);
+  void count(const std::shared_ptr<Expr> &expr, Mentions &mentions);
+
+private:
+  std::size_t unreachable{0};
+  std::size_t locals{0};
+  // names of the removed top-level declarations, per kind.
+  std::vector<std::string> variables;
+  std::vector<std::string> functions;
+  std::vector<std::string> classes;
+  // names the counted statements assign, and whether they hold a deferred
+  // body, which may name anything.
+  std::unordered_set<std::string> assigned;
+  bool opaque{false};
+};
+}// namespace loxplusplus
@@ -0,0 +1,114 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <cstdio>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "error.hpp"
+#include "interpreter.hpp"
+#include "module_cache.hpp"
+#include "output_sink.hpp"
+#include "program_cache.hpp"
+
+namespace loxplusplus {
+// execution settings shared by every engine of a run.
+struct EngineOptions {
+  std::optional<std::size_t> jit_threshold;
+  bool compile_closures{false};
+  std::optional<std::string> cache_directory;
+  bool lazy_parsing{false};
+  bool dump_ir{false};
+  bool stats{false};
+  bool memoize{false};
+  // each engine runs one program and writes no snapshot.
+  bool whole_program{false};
+};
+
+// how Engine::compile treats a source.
+struct CompileOptions {
+  // defers parsing top-level function and method bodies to their first call.
+  bool lazy{false};
+  // reports the optimized ir and the passes' statistics to the diagnostics.
+  bool dump_ir{false};
+};
+
+// embeddable lox instance. an engine owns its diagnostics, output sink,
+// symbols and interpreter, and with the interpreter every object its programs
+// allocate, so engines share no mutable state apart from the internally
+// synchronized ModuleCache. independent engines may run concurrently on
+// different threads; a single engine must not be used by two threads at once.
+class Engine {
+public:
+  enum class Result { OK,
+                      COMPILE_ERROR,
+                      RUNTIME_ERROR };
+
+  Engine(std::FILE *output = stdout, std::ostream &errors = std::cerr);
+  // hands everything the program prints to writer.
+  Engine(OutputWriter writer, std::ostream &errors);
+
+  Engine(const Engine &) = delete;
+  Engine &operator=(const Engine &) = delete;
+
+  // runs source in the engine's global scope; globals persist across calls.
+  // imports are looked up relative to the directory of origin, the path of
+  // the file source was read from, or the working directory without one.
+  Result run(std::string_view source, std::string_view origin = {});
+  // writes the c++ translation of source to the output instead of running it.
+  Result transpile(std::string_view source, std::string_view source_name);
+
+  // writes the globals defined so far to a snapshot file / restores them.
+  [[nodiscard]] bool save_snapshot(const std::string &path) const;
+  [[nodiscard]] bool load_snapshot(const std::string &path);
+
+  [[nodiscard]] bool open_output(const std::string &path);
+  void set_line_buffered(bool line_buffered);
+  void flush();
+
+  void configure(const EngineOptions &options);
+  void enable_jit(std::size_t threshold);
+  void enable_closure_compilation();
+  void enable_cache(std::string directory);
+  // defers parsing top-level function and method bodies to their first call.
+  void enable_lazy_parsing();
+  void enable_ir_dump();
+  // reports what the DeadCodeEliminator removed from each program.
+  void enable_stats();
+  // promises that nothing but the next program runs in the engine's globals,
+  // so top-level declarations it never names can be removed.
+  void enable_whole_program();
+  // caches the results of pure functions of the programs by their arguments.
+  void enable_memoization();
+
+  // scans, parses, resolves, type checks and optimizes source, reporting to
+  // diagnostics. the lexemes of its tokens are interned in lexicon and its
+  // globals in symbols.
+  [[nodiscard]] static std::optional<std::vector<std::shared_ptr<Stmt>>> compile(std::string_view source,
+                                                                                 Diagnostics &diagnostics,
+                                                                                 Lexicon &lexicon,
+                                                                                 SymbolTable &symbols,
+                                                                                 CompileOptions options = {});
+
+private:
+  OutputSink output;
+  Diagnostics diagnostics;
+  // outlive the interpreter, whose functions hold tokens and global slots
+  // interned here.
+  Lexicon lexicon;
+  SymbolTable symbols;
+  Interpreter interpreter;
+  std::optional<ProgramCache> cache;
+  CompileOptions compile_options;
+  bool stats{false};
+  bool whole_program{false};
+  bool memoize{false};
+};
+}// namespace loxplusplus
@@ -7,34 +7,88 @@
 #pragma once
 
 #include <iostream>
+#include <string>
 #include <string_view>
 
+#include "output_sink.hpp"
 #include "runtime_error.hpp"
 #include "token.hpp"
 
 namespace loxplusplus {
-static inline bool had_error{false};
-static inline bool had_runtime_error{false};
-
-static void report(int line, std::string_view where, std::string_view message) {
-  std::cerr << "[line " << line << "]: " << where << ": " << message << '\n';
-  had_error = true;
-}
-
-static void error(const Token &token, std::string_view message) {
-  if (token.type == TokenType::EOF_) {
-    report(token.line, " at end", message);
-    return;
-  }
-  report(token.line, " at '" + token.lexeme + "'", message);
-}
-
-static void error(int line, std::string_view message) {
-  report(line, "", message);
-}
-
-static void runtime_error(const RuntimeError &error) {
-  std::cerr << "[line " << error.token.line << "]: " << error.what() << '\n';
-  had_runtime_error = true;
-}
+// error state and destination of one engine. the scanner, parser, resolver and
+// interpreter report through the instance they were constructed with, so
+// independent engines never observe each other's errors. errors may also be
+// reported while a program runs, such as those of a deferred body, so the
+// program output written before one is flushed ahead of it.
+class Diagnostics {
+public:
+  Diagnostics(std::ostream &stream = std::cerr, OutputSink *output = nullptr)
+      : stream{stream}, output{output} {}
+
+  void report(int line, std::string_view where, std::string_view message) {
+    this->write("[line " + std::to_string(line) + "]: " + std::string(where) + ": " + std::string(message) + '\n');
+    this->had_error = true;
+  }
+
+  void error(const Token &token, std::string_view message) {
+    this->error(token.type, token.line, token.lexeme, message);
+  }
+
+  void error(const SourceToken &token, std::string_view message) {
+    this->error(token.type, token.line, token.lexeme, message);
+  }
+
+  void error(int line, std::string_view message) {
+    this->report(line, "", message);
+  }
+
+  // passes on messages already written by another instance, such as the
+  // errors of a cached module.
+  void forward(std::string_view messages) {
+    this->write(std::string(messages));
+    this->had_error = true;
+  }
+
+  // writes text that is neither an error nor fails the run, such as a dump.
+  void note(std::string_view text) {
+    this->write(std::string(text));
+  }
+
+  void runtime_error(const RuntimeError &error) {
+    this->write("[line " + std::to_string(error.token.line) + "]: " + error.what() + '\n');
+    this->had_runtime_error = true;
+  }
+
+  [[nodiscard]] bool failed() const {
+    return this->had_error || this->had_runtime_error;
+  }
+
+  void reset() {
+    this->had_error = this->had_runtime_error = false;
+  }
+
+public:
+  bool had_error{false};
+  bool had_runtime_error{false};
+
+private:
+  void error(TokenType type, int line, std::string_view lexeme, std::string_view message) {
+    if (type == TokenType::EOF_) {
+      this->report(line, " at end", message);
+      return;
+    }
+    this->report(line, " at '" + std::string(lexeme) + "'", message);
+  }
+
+  // one write per message keeps lines whole when engines share a stream.
+  void write(const std::string &message) {
+    if (this->output != nullptr)
+      this->output->flush();
+    this->stream.write(message.data(), message.size());
+  }
+
+private:
+  std::ostream &stream;
+  OutputSink *output;
+};
 }// namespace loxplusplus
@@ -6,9 +6,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include "token.hpp"
+#include "value_type.hpp"
 
 namespace loxplusplus {
 class Assign;
@@ -23,6 +25,7 @@ class Super;
 class This;
 class Unary;
 class Variable;
+class Function;
 
 class ExprVisitor {
 public:
@@ -41,10 +44,30 @@ public:
   virtual ~ExprVisitor() = default;
 };
 
+enum class ExprKind : std::uint8_t {
+  ASSIGN,
+  BINARY,
+  CALL,
+  GET,
+  GROUPING,
+  LITERAL,
+  LOGICAL,
+  SET,
+  SUPER,
+  THIS,
+  UNARY,
+  VARIABLE
+};
+
 class Expr {
 public:
+  explicit Expr(ExprKind kind) noexcept : kind{kind} {}
   virtual ~Expr();
   virtual Object accept(ExprVisitor &visitor) = 0;
+
+public:
+  // the concrete type, for passes that dispatch with a switch.
+  const ExprKind kind;
 };
 
 class Assign : public Expr, public std::enable_shared_from_this<Assign> {
@@ -57,6 +80,11 @@ public:
 public:
   const Token name;
   const std::shared_ptr<Expr> value;
+  int depth{-1};
+  int slot{-1};
+  // annotation of an assigned local whose value the TypeChecker could not
+  // prove to match it; ANY when no check is needed.
+  ValueType check{ValueType::ANY};
 };
 
 class Binary : public Expr, public std::enable_shared_from_this<Binary> {
@@ -70,6 +98,19 @@ public:
   const std::shared_ptr<Expr> left;
   const Token op;
   const std::shared_ptr<Expr> right;
+  // set by the TypeChecker when both operands are known to be numbers.
+  bool numeric{false};
+};
+
+// call of a global the Inliner found to hold a top-level function whose body
+// is a single return statement. while the callee still is that function,
+// engines evaluate the returned expression on the arguments instead of
+// going through the call.
+struct InlinedCall {
+  std::shared_ptr<Function> function;
+  // a copy of the returned expression whose parameters hold their position
+  // in slot; null for a bare `return;`.
+  std::shared_ptr<Expr> value;
 };
 
 class Call : public Expr, public std::enable_shared_from_this<Call> {
@@ -84,6 +125,7 @@ public:
   const std::shared_ptr<Expr> callee;
   const Token paren;
   const std::vector<std::shared_ptr<Expr>> arguments;
+  std::shared_ptr<InlinedCall> inlined;
 };
 
 class Get : public Expr, public std::enable_shared_from_this<Get> {
@@ -156,6 +198,7 @@ public:
 public:
   const Token keyword;
   const Token method;
+  int depth{-1};
 };
 
 class This : public Expr, public std::enable_shared_from_this<This> {
@@ -167,6 +210,7 @@ public:
 
 public:
   const Token keyword;
+  int depth{-1};
 };
 
 class Unary : public Expr, public std::enable_shared_from_this<Unary> {
@@ -179,6 +223,8 @@ public:
 public:
   const Token op;
   const std::shared_ptr<Expr> right;
+  // set by the TypeChecker when the operand is known to be a number.
+  bool numeric{false};
 };
 
 class Variable : public Expr, public std::enable_shared_from_this<Variable> {
@@ -190,5 +236,28 @@ public:
 
 public:
   const Token name;
+  int depth{-1};
+  int slot{-1};
 };
+
+// calls the visit overload for the concrete type of expr without going
+// through accept(): a switch on the kind tag and a static cast replace the
+// virtual accept() and its shared_from_this().
+[[nodiscard]] inline Object dispatch(ExprVisitor &visitor, const std::shared_ptr<Expr> &expr) {
+  switch (expr->kind) {
+  case ExprKind::ASSIGN: return visitor.visit(std::static_pointer_cast<Assign>(expr));
+  case ExprKind::BINARY: return visitor.visit(std::static_pointer_cast<Binary>(expr));
+  case ExprKind::CALL: return visitor.visit(std::static_pointer_cast<Call>(expr));
+  case ExprKind::GET: return visitor.visit(std::static_pointer_cast<Get>(expr));
+  case ExprKind::GROUPING: return visitor.visit(std::static_pointer_cast<Grouping>(expr));
+  case ExprKind::LITERAL: return visitor.visit(std::static_pointer_cast<Literal>(expr));
+  case ExprKind::LOGICAL: return visitor.visit(std::static_pointer_cast<Logical>(expr));
+  case ExprKind::SET: return visitor.visit(std::static_pointer_cast<Set>(expr));
+  case ExprKind::SUPER: return visitor.visit(std::static_pointer_cast<Super>(expr));
+  case ExprKind::THIS: return visitor.visit(std::static_pointer_cast<This>(expr));
+  case ExprKind::UNARY: return visitor.visit(std::static_pointer_cast<Unary>(expr));
+  case ExprKind::VARIABLE: return visitor.visit(std::static_pointer_cast<Variable>(expr));
+  }
+  return nullptr;
+}
 }// namespace loxplusplus
@@ -0,0 +1,35 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "runtime_error.hpp"
+#include "token.hpp"
+#include "value_type.hpp"
+
+namespace loxplusplus {
+// global variables indexed by symbol. references to globals are bound to
+// their symbol by the resolver, while a slot stays undefined until the
+// declaration executes, which keeps lox's late binding for globals.
+class GlobalTable {
+  friend class SnapshotWriter;
+
+public:
+  // type is the annotation of the defining var, enforced on assignment.
+  void define(int symbol, Object value, ValueType type = ValueType::ANY);
+  void assign(int symbol, const Token &name, Object value);
+
+  [[nodiscard]] const Object &get(int symbol, const Token &name) const;
+  [[nodiscard]] const Object *find(int symbol) const;
+
+private:
+  std::vector<std::optional<Object>> slots;
+  std::vector<ValueType> types;
+};
+}// namespace loxplusplus
@@ -0,0 +1,67 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "expr.hpp"
+#include "stmt.hpp"
+
+namespace loxplusplus {
+// marks the calls of top-level functions whose body is a single unchecked
+// return statement with an InlinedCall, when the program declares the
+// function once and never assigns its global. engines still compare the
+// callee against the declaration at runtime, as code the pass does not see
+// (deferred bodies, modules, later runs of an engine) may replace it. the
+// InlinedCall holds a copy of the returned expression with the parameters
+// bound to their position in the arguments, so the interpreter evaluates it
+// without an environment. a depth of -1 is what marks a callee or an assignment as global.
+class Inliner : public ExprVisitor, public StmtVisitor {
+public:
+  void inline_calls(const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<While> stmt) override;
+
+  [[nodiscard]] Object visit(std::shared_ptr<Assign> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Binary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Call> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Get> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Grouping> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Literal> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Logical> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Set> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Super> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<This> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Unary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Variable> expr) override;
+
+private:
+  void scan(const std::shared_ptr<Stmt> &stmt);
+  void scan(const std::shared_ptr<Expr> &expr);
+
+  [[nodiscard]] static bool inlinable(const Function &function);
+  [[nodiscard]] static std::shared_ptr<Expr> bind(const std::shared_ptr<Expr> &expr, const Function &function);
+  [[nodiscard]] static int position(const Function &function, const Token &name);
+
+private:
+  std::unordered_map<std::string, std::shared_ptr<Function>> candidates;
+  // globals the program assigns, and the calls of globals it makes.
+  std::unordered_set<std::string> assigned;
+  std::vector<std::shared_ptr<Call>> calls;
+};
+}// namespace loxplusplus
@@ -6,33 +6,62 @@
 
 #pragma once
 
+#include <cstdint>
+#include <unordered_set>
+
+#include "closure_compiler.hpp"
 #include "environment.hpp"
 #include "error.hpp"
 #include "expr.hpp"
+#include "global_table.hpp"
+#include "jit.hpp"
 #include "lox_callable.hpp"
 #include "lox_class.hpp"
 #include "lox_function.hpp"
 #include "lox_instance.hpp"
 #include "lox_return.hpp"
+#include "module_cache.hpp"
+#include "number.hpp"
+#include "output_sink.hpp"
 #include "runtime_error.hpp"
 #include "stmt.hpp"
+#include "symbol_table.hpp"
 
 namespace loxplusplus {
 class Interpreter : public ExprVisitor, public StmtVisitor {
+  friend class ClosureCompiler;
+  friend class ClosureFunction;
+  friend class Jit;
   friend class LoxFunction;
-  friend class Resolver;
+  friend class SnapshotReader;
+  friend class SnapshotWriter;
 
 public:
-  Interpreter();
+  // symbols names the slots of the globals.
+  Interpreter(OutputSink &output, Diagnostics &diagnostics, SymbolTable &symbols);
 
   void interpret(const std::vector<std::shared_ptr<Stmt>> &statements);
+  void enable_jit(std::size_t threshold);
+  void enable_closure_compilation();
+  // makes modules available to import statements; each module runs at most
+  // once per interpreter.
+  void add_modules(Modules modules);
+
+  // calls fail with a stack overflow error once less than stack_margin of the
+  // thread's stack is left, or, where its size is unknown, once a program
+  // uses max_stack_size below interpret().
+  static constexpr std::size_t stack_margin = std::size_t{256} << 10;
+  static constexpr std::size_t max_stack_size = std::size_t{4} << 20;
 
 private:
-  [[nodiscard]] Object evaluate(std::shared_ptr<Expr> expr);
-  [[nodiscard]] Object look_up_variable(const Token &name, std::shared_ptr<Expr> expr);
+  void check_stack(const Token &name) const;
+  [[nodiscard]] Object evaluate(const std::shared_ptr<Expr> &expr);
 
-  void execute(std::shared_ptr<Stmt> stmt);
-  void resolve(std::shared_ptr<Expr> expr, int depth);
+  void execute(const std::shared_ptr<Stmt> &stmt);
+  [[nodiscard]] bool execute_counted(const CountedLoop &loop);
+  [[nodiscard]] Object evaluate_inlined(const InlinedCall &call, std::vector<Object> arguments);
+  [[nodiscard]] bool replaceable(const ScalarReplacement &replacement) const;
+  void define(const Token &name, int slot, Object value, ValueType type = ValueType::ANY);
   void execute_block(const std::vector<std::shared_ptr<Stmt>> &statements,
                      std::shared_ptr<Environment> environment);
   void check_number_operand(const Token &op, const Object &operand);
@@ -44,12 +73,14 @@ private:
   [[nodiscard]] bool is_equal(const Object &a, const Object &b);
 
   [[nodiscard]] std::string stringify(const Object &object);
+  void print(const Object &value);
 
   [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
@@ -69,8 +100,23 @@ private:
   [[nodiscard]] Object visit(std::shared_ptr<Variable> expr) override;
 
 private:
+  OutputSink &output;
+  Diagnostics &diagnostics;
+  SymbolTable &symbols;
+  // declared first, so the tokens of module functions held by the globals
+  // are destroyed before the lexicons they point into.
+  Modules modules;
+  GlobalTable global_slots;
   std::shared_ptr<Environment> globals;
   std::shared_ptr<Environment> environment;
-  std::map<std::shared_ptr<Expr>, int> locals;
+  NumberBuffer number_buffer;
+  std::unique_ptr<Jit> jit;
+  bool compile_closures{false};
+  std::unordered_set<std::string> imported;
+  // the arguments of the inlined call being evaluated, which local reads
+  // and assignments with a slot refer to.
+  std::vector<Object> *arguments{nullptr};
+  // lowest stack address calls may reach, set by interpret().
+  std::uintptr_t stack_limit{0};
 };
 }// namespace loxplusplus
\ No newline at end of file
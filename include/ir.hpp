@@ -0,0 +1,253 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "expr.hpp"
+#include "stmt.hpp"
+
+namespace loxplusplus {
+enum class Opcode : std::uint8_t { CONSTANT,
+                                   PARAMETER,
+                                   PHI,
+                                   COPY,
+                                   UNARY,
+                                   BINARY,
+                                   LOAD,
+                                   STORE,
+                                   CALL,
+                                   GET,
+                                   SET,
+                                   SUPER,
+                                   CLOSURE,
+                                   IMPORT,
+                                   PRINT,
+                                   RETURN,
+                                   BRANCH,
+                                   JUMP };
+
+// one ssa value, or an effect such as a store or a branch. operands are ids
+// of other instructions of the same function.
+struct IrInstruction {
+  Opcode opcode;
+  int block;
+  std::vector<int> operands;
+  // successors of BRANCH (true, false) and JUMP.
+  std::vector<int> targets;
+  // value of a CONSTANT.
+  Object constant;
+  // operator of UNARY and BINARY.
+  TokenType op{TokenType::EOF_};
+  // variable, property or declaration the instruction refers to.
+  const Token *name{nullptr};
+  // expression computing the value, and the declaration a COPY defines.
+  Expr *origin{nullptr};
+  const Var *declaration{nullptr};
+  // annotation a PARAMETER or COPY is checked against at runtime.
+  ValueType annotation{ValueType::ANY};
+  ValueType type{ValueType::ANY};
+  // index of the statement of the body the instruction belongs to.
+  int statement{-1};
+  // outermost loop the instruction was hoisted out of, or -1.
+  int hoisted{-1};
+  // whether a COPY is ever read as the value of its variable.
+  bool read{false};
+  bool pure{false};
+  bool removed{false};
+};
+
+struct IrBlock {
+  std::vector<int> instructions;
+  std::vector<int> predecessors;
+  int phis{0};
+  bool sealed{false};
+  // innermost loop containing the block, or -1.
+  int loop{-1};
+};
+
+// a While of the body. its blocks are the ids in [header, end). code hoisted
+// out of it runs in front of `hoist`, which is the loop itself or the block
+// a counting for loop desugars into, and may read the variables of
+// `definitions` that hold the listed values there.
+struct IrLoop {
+  int preheader;
+  int header;
+  int end;
+  int parent{-1};
+  const Stmt *hoist;
+  std::vector<std::pair<const Token *, int>> definitions;
+};
+
+// the ssa form of a function body, or of the top-level statements.
+struct IrFunction {
+  std::string name;
+  // null for the top-level statements.
+  const Function *declaration{nullptr};
+  std::vector<IrInstruction> values;
+  std::vector<IrBlock> blocks;
+  std::vector<IrLoop> loops;
+  // where an expression's value comes from, and the COPY of a definition.
+  std::unordered_map<const Expr *, int> values_of;
+  std::unordered_map<const Stmt *, int> copies;
+  // forwarding of values replaced by another, see resolve().
+  std::vector<int> replacement;
+
+  [[nodiscard]] int resolve(int value);
+  void replace(int value, int by);
+  [[nodiscard]] bool script() const noexcept;
+  // the function as text, one instruction per line.
+  [[nodiscard]] std::string to_string() const;
+};
+
+// finds the locals of a body that functions nested in it refer to, the
+// functions nested in it, and its size.
+class CaptureScanner : public ExprVisitor, public StmtVisitor {
+public:
+  [[nodiscard]] std::unordered_set<const Token *> scan(const std::vector<Token> *params,
+                                                       const std::vector<std::shared_ptr<Stmt>> &body);
+  // statements and expressions of the body, not counting nested functions.
+  [[nodiscard]] std::size_t size() const noexcept;
+  [[nodiscard]] std::vector<std::pair<std::string, std::shared_ptr<Function>>> take_nested();
+
+  [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<While> stmt) override;
+
+  [[nodiscard]] Object visit(std::shared_ptr<Assign> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Binary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Call> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Get> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Grouping> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Literal> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Logical> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Set> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Super> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<This> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Unary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Variable> expr) override;
+
+private:
+  struct Declaration {
+    const Token *name;
+    int level;
+  };
+
+  void scan(const std::shared_ptr<Stmt> &stmt);
+  void scan(const std::shared_ptr<Expr> &expr);
+  void scan_function(const Function &function);
+  void declare(const Token &name);
+  void reference(const Token &name, int depth);
+
+private:
+  // nesting depth of the function being scanned; the body itself is level 0.
+  int level{0};
+  std::vector<std::unordered_map<const std::string *, Declaration>> scopes;
+  std::unordered_set<const Token *> captured;
+  std::size_t nodes{0};
+  std::vector<std::pair<std::string, std::shared_ptr<Function>>> nested;
+};
+
+// builds the ssa form of one body with the algorithm of braun et al.:
+// variables are looked up per block, and phis are placed on demand in blocks
+// with several predecessors. locals captured by a nested function stay in
+// memory and are read and written with LOAD and STORE, as are globals.
+// nested functions and methods are not entered; their declarations are
+// collected for the caller.
+class IrBuilder : public ExprVisitor, public StmtVisitor {
+public:
+  // bodies larger than this are left as they are; the passes are not
+  // linear in the worst case and would take longer than they save.
+  static constexpr std::size_t max_size = 50000;
+
+  IrBuilder(IrFunction &function);
+
+  // returns false, building nothing, when the body is larger than max_size.
+  [[nodiscard]] bool build(const std::vector<Token> &params, const std::vector<std::shared_ptr<Stmt>> &body);
+  [[nodiscard]] std::vector<std::pair<std::string, std::shared_ptr<Function>>> take_nested();
+
+  [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<While> stmt) override;
+
+  [[nodiscard]] Object visit(std::shared_ptr<Assign> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Binary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Call> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Get> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Grouping> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Literal> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Logical> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Set> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Super> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<This> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Unary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Variable> expr) override;
+
+private:
+  struct Local {
+    const Token *name;
+    bool captured;
+  };
+
+  void build(const std::shared_ptr<Stmt> &stmt);
+  [[nodiscard]] int build(const std::shared_ptr<Expr> &expr);
+  void build_loop(const While &loop, const Stmt &hoist, std::vector<std::pair<const Token *, int>> definitions);
+
+  [[nodiscard]] int emit(Opcode opcode, std::vector<int> operands = {}, Expr *origin = nullptr);
+  [[nodiscard]] int constant(Object value);
+  [[nodiscard]] int new_block(bool sealed);
+  void jump(int target);
+  [[nodiscard]] int branch(int condition, int if_true, int if_false);
+  void seal(int block);
+
+  // a local declared in the current scope; -1 for a global.
+  [[nodiscard]] int declare(const Token &name);
+  void define(const Token &name, int variable, int value, const Var *declaration = nullptr, Expr *origin = nullptr,
+              ValueType annotation = ValueType::ANY);
+  [[nodiscard]] int lookup(const Token &name) const;
+  void write(int variable, int block, int value);
+  [[nodiscard]] int read(int variable, int block);
+  [[nodiscard]] int read_recursive(int variable, int block);
+  [[nodiscard]] int new_phi(int block);
+  [[nodiscard]] int add_phi_operands(int variable, int phi);
+  [[nodiscard]] int try_remove_trivial_phi(int phi);
+  [[nodiscard]] std::vector<std::pair<const Token *, int>> definitions();
+
+private:
+  IrFunction &function;
+  int current{0};
+  // instructions at the start of the entry block: parameters, then constants.
+  int prologue{0};
+  int statement{-1};
+  int value{-1};
+  std::unordered_set<const Token *> captured;
+  std::vector<Local> variables;
+  std::vector<std::unordered_map<const std::string *, int>> scopes;
+  // current definition of every variable per block.
+  std::vector<std::unordered_map<int, int>> current_definitions;
+  std::unordered_map<int, std::vector<std::pair<int, int>>> incomplete_phis;
+  std::vector<int> reads;
+  std::vector<std::pair<std::string, std::shared_ptr<Function>>> nested;
+};
+}// namespace loxplusplus
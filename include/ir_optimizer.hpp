@@ -0,0 +1,126 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ir.hpp"
+
+namespace loxplusplus {
+// optimizes resolved and type checked code in ssa form, one function at a
+// time, and lowers the results back into the AST both engines execute:
+//
+// - copy propagation forwards unannotated copies and trivial phis.
+// - type inference marks operators whose operands are always numbers as
+//   `numeric`, beyond what the annotations let the TypeChecker prove.
+// - common subexpression elimination reuses a pure value computed on every
+//   path to a repeated expression through a temporary.
+// - loop invariant code motion moves pure arithmetic on values defined
+//   outside a loop in front of it.
+// - dead code elimination drops pure expression statements and stores to
+//   locals that are never read.
+//
+// temporaries are named with a leading digit, so they never clash with a lox
+// identifier. only locals are tracked; globals, captured locals and fields
+// may change behind any call and are always loaded. bodies larger than
+// IrBuilder::max_size are not optimized.
+class IrOptimizer {
+public:
+  // the names of temporaries go to lexicon.
+  IrOptimizer(Lexicon &lexicon);
+
+  // optimizes statements and the functions nested in them; returns whether
+  // the AST changed, in which case it has to be resolved again.
+  [[nodiscard]] bool optimize(std::vector<std::shared_ptr<Stmt>> &statements);
+  // the same for the body of a function whose parsing was deferred.
+  [[nodiscard]] bool optimize_function(const Function &function, std::vector<std::shared_ptr<Stmt>> &body);
+
+  // keeps the ir of every function for report().
+  void enable_dump();
+  // the optimized ir, then the time spent in each pass and what it changed.
+  [[nodiscard]] std::string report() const;
+
+private:
+  enum Pass { COPY_PROPAGATION,
+              TYPES,
+              CSE,
+              LICM,
+              DCE,
+              PASSES };
+
+  struct Statistics {
+    std::chrono::steady_clock::duration time{};
+    std::size_t changes{0};
+  };
+
+  [[nodiscard]] bool optimize(IrFunction &function, std::vector<std::shared_ptr<Stmt>> &body,
+                              const std::vector<Token> &params);
+  [[nodiscard]] bool optimize_nested();
+  void run(Pass pass, IrFunction &function);
+
+  [[nodiscard]] std::size_t propagate_copies(IrFunction &function);
+  [[nodiscard]] std::size_t infer_types(IrFunction &function);
+  [[nodiscard]] std::size_t eliminate_common_subexpressions(IrFunction &function);
+  [[nodiscard]] std::size_t hoist_invariants(IrFunction &function);
+  [[nodiscard]] std::size_t eliminate_dead_code(IrFunction &function);
+
+  [[nodiscard]] std::vector<int> reverse_postorder(const IrFunction &function) const;
+  [[nodiscard]] bool materializable(IrFunction &function, int value, int loop, int depth);
+  [[nodiscard]] std::shared_ptr<Expr> materialize(IrFunction &function, int value, int loop, bool root);
+  [[nodiscard]] bool encloses(const IrFunction &function, int outer, int loop) const;
+
+  void plan(const std::vector<std::shared_ptr<Stmt>> &body);
+  void count(const std::shared_ptr<Stmt> &stmt);
+  void count(const std::shared_ptr<Expr> &expr);
+  [[nodiscard]] std::shared_ptr<Stmt> lower(const std::shared_ptr<Stmt> &stmt);
+  [[nodiscard]] std::shared_ptr<Stmt> lower_statement(const std::shared_ptr<Stmt> &stmt);
+  [[nodiscard]] std::shared_ptr<Expr> lower(const std::shared_ptr<Expr> &expr);
+  [[nodiscard]] bool pure(const std::shared_ptr<Expr> &expr);
+  [[nodiscard]] bool dead(const Assign &assign);
+  [[nodiscard]] int value_of(const Expr *expr);
+  [[nodiscard]] std::shared_ptr<Stmt> declare(int value);
+  [[nodiscard]] std::shared_ptr<Expr> placeholder(ValueType type);
+  [[nodiscard]] const Token &temporary(const std::string &prefix, const Expr *origin);
+
+private:
+  Lexicon &lexicon;
+  std::array<Statistics, PASSES> statistics{};
+  bool dump{false};
+  std::string dumped;
+  std::vector<std::pair<std::string, std::shared_ptr<Function>>> nested;
+  // names of the temporaries; the AST copies them.
+  std::deque<Token> tokens;
+  int next_temporary{0};
+
+  // the function being optimized and lowered.
+  IrFunction *function{nullptr};
+  // per loop, the variables holding a value in front of it.
+  std::vector<std::unordered_map<int, const Token *>> live;
+  // the values hoisted out of each loop, and the statement they go in front of.
+  std::vector<std::vector<int>> hoisted;
+  std::unordered_map<const Stmt *, int> hoists;
+  // loops whose hoisted values are in scope while lowering.
+  std::unordered_set<int> in_scope;
+  std::unordered_map<int, const Token *> temporaries;
+  // values computed by one expression and reused by others, how often each
+  // occurs, whether its computing expression runs, whether it is reused in
+  // a loop it is not computed in, and the top-level statement it occurs in,
+  // or -1 for several.
+  std::set<int> reused;
+  std::unordered_map<int, int> occurrences;
+  std::unordered_set<int> defined;
+  std::unordered_set<int> invariant;
+  std::unordered_map<int, int> statements;
+  int statement{-1};
+};
+}// namespace loxplusplus
@@ -0,0 +1,139 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <cstdio>
+#include <map>
+#include <optional>
+#include <unordered_map>
+
+#include "stmt.hpp"
+#include "x64_emitter.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define LOX_JIT_SUPPORTED 1
+#endif
+
+namespace loxplusplus {
+class Interpreter;
+
+// baseline method jit. top-level functions that are called more than
+// `threshold` times are compiled to x86-64 if their body only uses integer
+// arithmetic, comparisons, locals, control flow and calls to themselves.
+// such functions have no side effects, so whenever a guard fails (argument
+// not an integer, overflow, inexact division, recursion past the interpreter's
+// stack limit, ...) the native code bails out and the call is
+// simply re-executed by the interpreter.
+class Jit {
+public:
+  // bail points to the bail flag, followed by the lowest address the native
+  // stack may reach.
+  using Code = std::int64_t (*)(std::int64_t *bail, std::int64_t, std::int64_t,
+                                std::int64_t, std::int64_t, std::int64_t);
+
+  static constexpr std::size_t max_parameters = 5;
+  static constexpr std::size_t max_bails = 16;
+  static constexpr std::size_t default_threshold = 100;
+
+  Jit(std::size_t threshold);
+  ~Jit();
+
+  Jit(const Jit &) = delete;
+  Jit &operator=(const Jit &) = delete;
+
+  [[nodiscard]] std::optional<Object> call(Interpreter &interpreter,
+                                           const std::shared_ptr<Function> &declaration,
+                                           const std::vector<Object> &arguments);
+
+private:
+  struct Entry {
+    std::size_t calls{0};
+    std::size_t bails{0};
+    Code code{nullptr};
+    bool self_call{false};
+    bool failed{false};
+  };
+
+  [[nodiscard]] bool compile(const Function &declaration, Entry &entry);
+  [[nodiscard]] void *install(const std::vector<std::uint8_t> &code, const std::string &name);
+
+private:
+  std::size_t threshold;
+  std::unordered_map<const Function *, Entry> entries;
+  std::vector<std::pair<void *, std::size_t>> regions;
+  std::FILE *perf_map{nullptr};
+};
+
+// translates one function body for the Jit. values are either integers or
+// booleans (0/1) and always live in rax; intermediate results are pushed on
+// the native stack, locals live in fixed slots below rbp.
+class JitCompiler : public ExprVisitor, public StmtVisitor {
+public:
+  JitCompiler(const Function &function);
+
+  [[nodiscard]] bool compile();
+  [[nodiscard]] const std::vector<std::uint8_t> &code();
+  [[nodiscard]] bool calls_itself() const;
+
+  [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<While> stmt) override;
+
+  [[nodiscard]] Object visit(std::shared_ptr<Assign> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Binary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Call> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Get> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Grouping> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Literal> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Logical> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Set> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Super> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<This> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Unary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Variable> expr) override;
+
+private:
+  enum class Type { INTEGER,
+                    BOOLEAN };
+
+  struct Local {
+    std::int32_t offset;
+    Type type;
+  };
+
+  struct Unsupported {};
+
+  void compile(const std::vector<std::shared_ptr<Stmt>> &statements);
+  void compile(std::shared_ptr<Stmt> stmt);
+  [[nodiscard]] Type compile(std::shared_ptr<Expr> expr);
+  void expect(std::shared_ptr<Expr> expr, Type type);
+  void push();
+  void pop(X64Emitter::Register reg);
+  // bails when rax left the integer range of the interpreter.
+  void guard_exact();
+  [[nodiscard]] Local *find(const std::string &name);
+  [[nodiscard]] Local &declare(const std::string &name, Type type);
+
+private:
+  const Function &function;
+  X64Emitter emitter;
+  X64Emitter::Label entry, bail, epilogue;
+  std::vector<std::map<std::string, Local>> scopes;
+  std::int32_t next_offset{-16};
+  std::int32_t frame_size{8};
+  std::size_t pushed{0};
+  Type type{Type::INTEGER};
+  bool self_call{false};
+};
+}// namespace loxplusplus
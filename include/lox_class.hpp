@@ -17,6 +17,7 @@ class LoxFunction;
 class LoxClass : public LoxCallable,
                  public std::enable_shared_from_this<LoxClass> {
   friend class LoxInstance;
+  friend class SnapshotWriter;
 
 public:
   LoxClass(std::string name, std::shared_ptr<LoxClass> superclass,
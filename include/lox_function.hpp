@@ -14,15 +14,27 @@ class Function;
 class LoxInstance;
 
 class LoxFunction : public LoxCallable {
+  friend class Jit;
+  friend class SnapshotWriter;
+
 public:
   LoxFunction(std::shared_ptr<Function> declaration,
               std::shared_ptr<Environment> closure, bool is_initializer);
   [[nodiscard]] int arity() override;
   [[nodiscard]] Object call(Interpreter &interpreter, std::vector<Object> arguments) override;
   [[nodiscard]] std::string to_string() override;
-  [[nodiscard]] std::shared_ptr<LoxFunction> bind(std::shared_ptr<LoxInstance> instance);
+  [[nodiscard]] virtual std::shared_ptr<LoxFunction> bind(std::shared_ptr<LoxInstance> instance);
+  [[nodiscard]] bool declared_by(const Function &declaration) const noexcept;
+
+protected:
+  // runs the body with checked arguments.
+  [[nodiscard]] virtual Object execute(Interpreter &interpreter, std::vector<Object> arguments);
+  // enforces the parameter annotations of the declaration.
+  void check_arguments(const std::vector<Object> &arguments) const;
+  // enforces the return annotation when the body ends without a return.
+  void check_fall_through() const;
 
-private:
+protected:
   std::shared_ptr<Function> declaration;
   std::shared_ptr<Environment> closure;
   bool is_initializer;
@@ -14,6 +14,9 @@ class LoxClass;
 class Token;
 
 class LoxInstance : public std::enable_shared_from_this<LoxInstance> {
+  friend class SnapshotReader;
+  friend class SnapshotWriter;
+
 public:
   LoxInstance();
   LoxInstance(std::shared_ptr<LoxClass> klass);
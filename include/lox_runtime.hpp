@@ -0,0 +1,135 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "number.hpp"
+
+// runtime library of programs produced by `lox --emit-cpp`. values keep the
+// alternative order of Object so that printing and arithmetic share the
+// interpreter's number helpers and produce byte-identical output.
+namespace loxplusplus::runtime {
+struct Function;
+struct Class;
+struct Instance;
+
+using Value = std::variant<std::string, double, bool, std::nullptr_t,
+                           std::shared_ptr<Function>, std::shared_ptr<Class>,
+                           std::shared_ptr<Instance>, std::int64_t>;
+
+// boxed local, used for variables captured by a nested function.
+using Cell = std::shared_ptr<Value>;
+using Arguments = std::vector<Value>;
+
+struct Error {
+  int line;
+  std::string message;
+};
+
+// `: num`, `: str` and `: bool` annotations, in the order of ValueType.
+enum class Type { ANY,
+                  NUMBER,
+                  STRING,
+                  BOOL };
+
+// operands and call arguments are aggregated in braced initializers, which
+// evaluate left to right like the interpreter does.
+struct Operands {
+  Value left, right;
+};
+
+struct Invocation {
+  Value callee;
+  Arguments arguments;
+};
+
+struct Function {
+  std::string name;
+  std::size_t arity;
+  std::function<Value(Arguments &)> body;
+};
+
+struct Method {
+  std::string name;
+  std::size_t arity;
+  bool is_initializer;
+  std::function<Value(const std::shared_ptr<Instance> &, Arguments &)> body;
+};
+
+struct Class {
+  std::string name;
+  std::shared_ptr<Class> superclass;
+  std::unordered_map<std::string, std::shared_ptr<Method>> methods;
+
+  [[nodiscard]] Method *find_method(const std::string &name) const;
+};
+
+struct Instance {
+  std::shared_ptr<Class> klass;
+  std::unordered_map<std::string, Value> fields;
+};
+
+// late-bound global variable, like the interpreter's global slots. an
+// annotated global checks every assignment against its type.
+struct Global {
+  const char *name;
+  Value value{nullptr};
+  bool defined{false};
+  Type type{Type::ANY};
+};
+
+[[nodiscard]] Value function(std::string name, std::size_t arity, std::function<Value(Arguments &)> body);
+[[nodiscard]] std::shared_ptr<Method> method(std::string name, std::size_t arity, bool is_initializer,
+                                             std::function<Value(const std::shared_ptr<Instance> &, Arguments &)> body);
+[[nodiscard]] std::shared_ptr<Class> superclass(const Value &value, int line);
+
+[[nodiscard]] inline bool truthy(const Value &value) {
+  if (value.index() == NullptrIndex)
+    return false;
+  if (value.index() == BoolIndex)
+    return std::get<BoolIndex>(value);
+  return true;
+}
+
+[[nodiscard]] Value add(const Operands &operands, int line);
+[[nodiscard]] Value subtract(const Operands &operands, int line);
+[[nodiscard]] Value multiply(const Operands &operands, int line);
+[[nodiscard]] Value divide(const Operands &operands, int line);
+[[nodiscard]] Value greater(const Operands &operands, int line);
+[[nodiscard]] Value greater_equal(const Operands &operands, int line);
+[[nodiscard]] Value less(const Operands &operands, int line);
+[[nodiscard]] Value less_equal(const Operands &operands, int line);
+[[nodiscard]] Value equal(const Operands &operands);
+[[nodiscard]] Value not_equal(const Operands &operands);
+[[nodiscard]] Value negate(const Value &operand, int line);
+
+// returns value unless it does not fit type; subject names the checked value.
+[[nodiscard]] Value checked(Value value, Type type, const char *subject, int line);
+
+void define_global(Global &global, Value value, Type type = Type::ANY);
+[[nodiscard]] const Value &get_global(const Global &global, int line);
+Value assign_global(Global &global, Value value, int line);
+
+Value call(Invocation invocation, int line);
+[[nodiscard]] Value get(const Value &object, const char *name, int line);
+[[nodiscard]] const std::shared_ptr<Instance> &instance_for_set(const Value &object, int line);
+[[nodiscard]] Value super_method(const std::shared_ptr<Class> &superclass, const std::shared_ptr<Instance> &self,
+                                 const char *name, int line);
+
+void print(const Value &value);
+
+// runs the program, reports an uncaught runtime error like the interpreter
+// does and flushes the output.
+int run(void (*program)());
+}// namespace loxplusplus::runtime
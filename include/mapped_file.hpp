@@ -0,0 +1,37 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LOX_MAPPED_FILES
+#endif
+
+namespace loxplusplus {
+// read-only view of a whole file; mapped where the platform allows it and
+// read into memory otherwise. data is nullptr if the file could not be opened
+// or is empty.
+class MappedFile {
+public:
+  MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+public:
+  const char *data{nullptr};
+  std::size_t size{0};
+
+private:
+#ifndef LOX_MAPPED_FILES
+  std::string contents;
+#endif
+};
+}// namespace loxplusplus
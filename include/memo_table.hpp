@@ -0,0 +1,47 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "global_table.hpp"
+
+namespace loxplusplus {
+class Function;
+
+// the results of a pure function keyed by its arguments. the table holds at
+// most `capacity` results and starts over once it is full.
+class MemoTable {
+public:
+  static constexpr std::size_t capacity = 1 << 16;
+
+  // the global slots of the functions its results depend on, with the
+  // declarations they held when the function was found pure.
+  explicit MemoTable(std::vector<std::pair<int, const Function *>> callees);
+
+  // whether a call can use the table: its arguments are numbers, strings,
+  // booleans or nil, and the globals still hold the same functions.
+  [[nodiscard]] bool applies(const GlobalTable &globals, const std::vector<Object> &arguments) const;
+  [[nodiscard]] const Object *find(const std::vector<Object> &arguments) const;
+  void insert(std::vector<Object> arguments, Object result);
+
+private:
+  // numbers compare by representation, so 1 and 1.0, or 0 and -0, are
+  // different keys.
+  struct Hash {
+    [[nodiscard]] std::size_t operator()(const std::vector<Object> &arguments) const noexcept;
+  };
+  struct Equal {
+    [[nodiscard]] bool operator()(const std::vector<Object> &a, const std::vector<Object> &b) const noexcept;
+  };
+
+  std::vector<std::pair<int, const Function *>> callees;
+  std::unordered_map<std::vector<Object>, Object, Hash, Equal> results;
+};
+}// namespace loxplusplus
@@ -0,0 +1,51 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "stmt.hpp"
+
+namespace loxplusplus {
+// gives pure top-level functions a MemoTable, so calls with arguments seen
+// before return the stored result instead of running the body. a function
+// is pure when the program declares it once at the top level and its body
+// only computes with its parameters and locals, and calls other pure
+// functions by their global name: no prints, globals, properties, nested
+// functions or classes. of these, only functions containing a loop or a
+// call are worth a table.
+//
+// engines consult the table when the arguments are numbers, strings,
+// booleans or nil and every function the result depends on still holds its
+// declaration, since code the pass does not see may reassign their globals.
+// resolved depths tell locals from globals in a body, and the tables guard
+// the functions by the global slots the Resolver assigned them.
+class Memoizer {
+public:
+  void memoize(const std::vector<std::shared_ptr<Stmt>> &statements);
+
+private:
+  // the global names a body calls.
+  using Callees = std::unordered_set<std::string>;
+
+  [[nodiscard]] static bool pure(const std::shared_ptr<Stmt> &stmt, Callees &callees, bool &costly);
+  [[nodiscard]] static bool pure(const std::shared_ptr<Expr> &expr, Callees &callees, bool &costly);
+  void depend(const std::string &name, std::unordered_set<std::string> &visited,
+              std::vector<std::pair<int, const Function *>> &dependencies) const;
+
+private:
+  struct Candidate {
+    std::shared_ptr<Function> function;
+    Callees callees;
+    bool costly{false};
+  };
+
+  std::unordered_map<std::string, Candidate> candidates;
+};
+}// namespace loxplusplus
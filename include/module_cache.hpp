@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "error.hpp"
+#include "stmt.hpp"
+#include "symbol_table.hpp"
+
+namespace loxplusplus {
+// a module as loaded into one engine: resolved against the engine's global
+// symbols and optimized. errors holds the diagnostics of a module that failed
+// to compile.
+struct Module {
+  std::string path;
+  Lexicon lexicon;
+  std::vector<std::shared_ptr<Stmt>> statements;
+  std::string errors;
+};
+
+using Modules = std::unordered_map<std::string, std::shared_ptr<const Module>>;
+
+// process-wide cache of compiled modules keyed by canonical path. an entry is
+// reused while the file keeps its modification time, so a module imported by
+// many scripts, engines or threads goes through the front-end once. entries
+// are kept as program images, which each importing engine decodes with its
+// own lexicon and symbols.
+class ModuleCache {
+public:
+  // points the imports of statements at their files and loads the modules
+  // they import, transitively. all modules found at the same import depth are
+  // compiled concurrently, then decoded on the calling thread with their
+  // globals bound in symbols.
+  [[nodiscard]] static Modules load(const std::vector<std::shared_ptr<Stmt>> &statements,
+                                    const std::filesystem::path &directory,
+                                    SymbolTable &symbols,
+                                    Diagnostics &diagnostics);
+
+  // compiles modules and their imports ahead of the first import, so a
+  // long-running process pays for them once at startup.
+  [[nodiscard]] static bool preload(const std::vector<std::string> &paths, Diagnostics &diagnostics);
+
+private:
+  // a compiled module: the ProgramWriter image of its resolved and type
+  // checked statements, or its diagnostics.
+  struct Image {
+    std::string bytes;
+    std::string errors;
+  };
+
+  struct Entry {
+    std::filesystem::file_time_type modified;
+    std::shared_ptr<const Image> image;
+  };
+
+  [[nodiscard]] static std::vector<Import *> link(const std::vector<std::shared_ptr<Stmt>> &statements,
+                                                  const std::filesystem::path &directory);
+  [[nodiscard]] static std::shared_ptr<const Image> get(const std::string &path);
+  [[nodiscard]] static std::shared_ptr<const Image> compile(const std::string &path);
+  // decodes image and runs the passes an engine runs on its own programs.
+  [[nodiscard]] static std::shared_ptr<const Module> instantiate(const std::string &path, const Image &image,
+                                                                 SymbolTable &symbols);
+
+private:
+  static inline std::mutex mutex;
+  static inline std::unordered_map<std::string, Entry> entries;
+};
+}// namespace loxplusplus
@@ -0,0 +1,184 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include "token.hpp"
+
+// numbers are stored either as an IEEE double or, when the value is integral
+// and at most 2^53 in magnitude, as an int64; both are the same lox type and
+// every such integer is exact as a double too, so the representation is never
+// observable. integer arithmetic stays on the integer path until a result
+// leaves that range, in which case it falls back to double.
+// the helpers taking values are templates so that any variant sharing
+// Object's alternative indices (such as the transpiler runtime's) can use them.
+namespace loxplusplus {
+template <typename Value>
+[[nodiscard]] inline bool is_number(const Value &object) {
+  return object.index() == IntegerIndex || object.index() == DoubleIndex;
+}
+
+template <typename Value>
+[[nodiscard]] inline bool is_integer(const Value &object) {
+  return object.index() == IntegerIndex;
+}
+
+template <typename Value>
+[[nodiscard]] inline double as_double(const Value &object) {
+  if (object.index() == IntegerIndex)
+    return static_cast<double>(std::get<IntegerIndex>(object));
+  return std::get<DoubleIndex>(object);
+}
+
+// the largest magnitude an integer keeps on the integer path.
+inline constexpr std::int64_t max_exact_integer = std::int64_t{1} << 53;
+
+[[nodiscard]] inline bool is_exact_integer(std::int64_t value) {
+  return value >= -max_exact_integer && value <= max_exact_integer;
+}
+
+[[nodiscard]] static inline bool add_overflow(std::int64_t a, std::int64_t b, std::int64_t &result) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_add_overflow(a, b, &result);
+#else
+  if ((b > 0 && a > std::numeric_limits<std::int64_t>::max() - b) ||
+      (b < 0 && a < std::numeric_limits<std::int64_t>::min() - b))
+    return true;
+  result = a + b;
+  return false;
+#endif
+}
+
+[[nodiscard]] static inline bool sub_overflow(std::int64_t a, std::int64_t b, std::int64_t &result) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_sub_overflow(a, b, &result);
+#else
+  if ((b < 0 && a > std::numeric_limits<std::int64_t>::max() + b) ||
+      (b > 0 && a < std::numeric_limits<std::int64_t>::min() + b))
+    return true;
+  result = a - b;
+  return false;
+#endif
+}
+
+[[nodiscard]] static inline bool mul_overflow(std::int64_t a, std::int64_t b, std::int64_t &result) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_mul_overflow(a, b, &result);
+#else
+  constexpr std::int64_t max = std::numeric_limits<std::int64_t>::max(),
+                         min = std::numeric_limits<std::int64_t>::min();
+  if (a > 0 ? (b > 0 ? a > max / b : b < min / a)
+            : (b > 0 ? a < min / b : (a != 0 && b < max / a)))
+    return true;
+  result = a * b;
+  return false;
+#endif
+}
+
+// operands of the functions below must already be checked with is_number().
+template <typename Value>
+[[nodiscard]] inline Value number_add(const Value &left, const Value &right) {
+  if (std::int64_t result; is_integer(left) && is_integer(right) &&
+                           !add_overflow(std::get<IntegerIndex>(left), std::get<IntegerIndex>(right), result) &&
+                           is_exact_integer(result))
+    return result;
+  return as_double(left) + as_double(right);
+}
+
+template <typename Value>
+[[nodiscard]] inline Value number_subtract(const Value &left, const Value &right) {
+  if (std::int64_t result; is_integer(left) && is_integer(right) &&
+                           !sub_overflow(std::get<IntegerIndex>(left), std::get<IntegerIndex>(right), result) &&
+                           is_exact_integer(result))
+    return result;
+  return as_double(left) - as_double(right);
+}
+
+template <typename Value>
+[[nodiscard]] inline Value number_multiply(const Value &left, const Value &right) {
+  if (std::int64_t result; is_integer(left) && is_integer(right) &&
+                           !mul_overflow(std::get<IntegerIndex>(left), std::get<IntegerIndex>(right), result) &&
+                           is_exact_integer(result)) {
+    // a zero product of a negative operand is -0 in ieee arithmetic.
+    if (result == 0 && (std::get<IntegerIndex>(left) < 0 || std::get<IntegerIndex>(right) < 0))
+      return -0.0;
+    return result;
+  }
+  return as_double(left) * as_double(right);
+}
+
+template <typename Value>
+[[nodiscard]] inline Value number_divide(const Value &left, const Value &right) {
+  if (is_integer(left) && is_integer(right)) {
+    const std::int64_t a = std::get<IntegerIndex>(left), b = std::get<IntegerIndex>(right);
+    if (b != 0 && !(a == std::numeric_limits<std::int64_t>::min() && b == -1) && a % b == 0) {
+      if (a == 0 && b < 0)
+        return -0.0;
+      return a / b;
+    }
+  }
+  return as_double(left) / as_double(right);
+}
+
+template <typename Value>
+[[nodiscard]] inline Value number_negate(const Value &operand) {
+  if (is_integer(operand)) {
+    const std::int64_t value = std::get<IntegerIndex>(operand);
+    if (value != 0 && value != std::numeric_limits<std::int64_t>::min())
+      return -value;
+  }
+  return -as_double(operand);
+}
+
+template <typename Value>
+[[nodiscard]] inline bool number_less(const Value &left, const Value &right) {
+  if (is_integer(left) && is_integer(right))
+    return std::get<IntegerIndex>(left) < std::get<IntegerIndex>(right);
+  return as_double(left) < as_double(right);
+}
+
+template <typename Value>
+[[nodiscard]] inline bool number_less_equal(const Value &left, const Value &right) {
+  if (is_integer(left) && is_integer(right))
+    return std::get<IntegerIndex>(left) <= std::get<IntegerIndex>(right);
+  return as_double(left) <= as_double(right);
+}
+
+template <typename Value>
+[[nodiscard]] inline bool number_equal(const Value &left, const Value &right) {
+  if (is_integer(left) && is_integer(right))
+    return std::get<IntegerIndex>(left) == std::get<IntegerIndex>(right);
+  return as_double(left) == as_double(right);
+}
+
+using NumberBuffer = std::array<char, 64>;
+
+// formats the shortest text that round-trips to the same number. doubles use
+// fixed notation inside [1e-7, 1e21) and scientific outside of it, so integral
+// doubles never print a trailing '.0'.
+template <typename Value>
+[[nodiscard]] inline std::string_view number_to_chars(const Value &number, NumberBuffer &buffer) {
+  char *first = buffer.data(), *last = buffer.data() + buffer.size();
+  std::to_chars_result result;
+  if (is_integer(number)) {
+    result = std::to_chars(first, last, std::get<IntegerIndex>(number));
+  } else {
+    const double value = std::get<DoubleIndex>(number), magnitude = std::fabs(value);
+    if (magnitude == 0.0 || (magnitude >= 1e-7 && magnitude < 1e21))
+      result = std::to_chars(first, last, value, std::chars_format::fixed);
+    else
+      result = std::to_chars(first, last, value, std::chars_format::scientific);
+  }
+  return std::string_view(first, result.ptr - first);
+}
+}// namespace loxplusplus
@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include "expr.hpp"
+#include "stmt.hpp"
+
+namespace loxplusplus {
+// rewrites resolved statements into forms the interpreter executes faster.
+// runs after the Resolver, since it relies on resolved variable depths.
+class Optimizer : public StmtVisitor {
+public:
+  void optimize(const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<While> stmt) override;
+
+private:
+  void optimize(std::shared_ptr<Stmt> stmt);
+
+  [[nodiscard]] std::shared_ptr<CountedLoop> counted_loop(const Block &block);
+};
+
+// finds statements and expressions that would invalidate keeping a
+// variable in a register: assignments to it and nested functions or classes
+// that may capture it.
+class VariableEscapeScanner : public ExprVisitor, public StmtVisitor {
+public:
+  VariableEscapeScanner(const std::string &name);
+
+  [[nodiscard]] bool escapes(std::shared_ptr<Stmt> stmt);
+  [[nodiscard]] bool escapes(std::shared_ptr<Expr> expr);
+
+  [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<While> stmt) override;
+
+  [[nodiscard]] Object visit(std::shared_ptr<Assign> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Binary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Call> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Get> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Grouping> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Literal> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Logical> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Set> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Super> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<This> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Unary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Variable> expr) override;
+
+private:
+  void scan(std::shared_ptr<Stmt> stmt);
+  void scan(std::shared_ptr<Expr> expr);
+
+private:
+  const std::string &name;
+  bool found{false};
+};
+}// namespace loxplusplus
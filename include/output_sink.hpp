@@ -0,0 +1,54 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loxplusplus {
+using OutputWriter = std::function<void(std::string_view)>;
+
+// buffered destination of `print`. output is collected in a large buffer and
+// written with a single fwrite per flush, bypassing iostream synchronization.
+// the buffer is flushed when full, on flush() (REPL prompt, runtime errors),
+// on destruction, and after every line when line buffering is enabled.
+class OutputSink {
+public:
+  static constexpr std::size_t default_capacity = 1 << 16;
+
+  OutputSink(std::FILE *file = stdout, std::size_t capacity = default_capacity);
+  // hands every flushed chunk to writer instead of a file.
+  OutputSink(OutputWriter writer, std::size_t capacity = default_capacity);
+  ~OutputSink();
+
+  OutputSink(const OutputSink &) = delete;
+  OutputSink &operator=(const OutputSink &) = delete;
+
+  [[nodiscard]] bool open(const std::string &path);
+
+  void set_line_buffered(bool line_buffered);
+  void write(std::string_view text);
+  void write_line(std::string_view text);
+  void flush();
+
+private:
+  void flush_buffer();
+  void emit(const char *data, std::size_t count);
+  void close();
+
+private:
+  std::FILE *file;
+  OutputWriter writer;
+  bool owns_file{false};
+  bool line_buffered{false};
+  std::vector<char> buffer;
+  std::size_t size{0};
+};
+}// namespace loxplusplus
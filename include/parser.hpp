@@ -6,23 +6,79 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+
 #include "error.hpp"
 #include "expr.hpp"
 #include "stmt.hpp"
+#include "symbol_table.hpp"
 #include "token.hpp"
 #include "token_type.hpp"
 
 namespace loxplusplus {
+// binding strength of infix operators, weakest first.
+enum class Precedence : std::uint8_t { NONE,
+                                       ASSIGNMENT,
+                                       OR,
+                                       AND,
+                                       EQUALITY,
+                                       COMPARISON,
+                                       TERM,
+                                       FACTOR,
+                                       UNARY,
+                                       CALL };
+
+[[nodiscard]] constexpr Precedence next(Precedence precedence) {
+  return static_cast<Precedence>(static_cast<std::uint8_t>(precedence) + 1);
+}
+
+// infix precedence of every token type, indexed by the type's byte value;
+// token types that are no infix operator map to NONE.
+inline constexpr std::array<Precedence, 256> precedences = [] {
+  std::array<Precedence, 256> table{};
+  const auto set = [&table](TokenType type, Precedence precedence) {
+    table[static_cast<std::uint8_t>(type)] = precedence;
+  };
+  set(TokenType::EQUAL, Precedence::ASSIGNMENT);
+  set(TokenType::OR, Precedence::OR);
+  set(TokenType::AND, Precedence::AND);
+  set(TokenType::BANG_EQUAL, Precedence::EQUALITY);
+  set(TokenType::EQUAL_EQUAL, Precedence::EQUALITY);
+  set(TokenType::GREATER, Precedence::COMPARISON);
+  set(TokenType::GREATER_EQUAL, Precedence::COMPARISON);
+  set(TokenType::LESS, Precedence::COMPARISON);
+  set(TokenType::LESS_EQUAL, Precedence::COMPARISON);
+  set(TokenType::MINUS, Precedence::TERM);
+  set(TokenType::PLUS, Precedence::TERM);
+  set(TokenType::SLASH, Precedence::FACTOR);
+  set(TokenType::STAR, Precedence::FACTOR);
+  set(TokenType::LEFT_PAREN, Precedence::CALL);
+  set(TokenType::DOT, Precedence::CALL);
+  return table;
+}();
+
+[[nodiscard]] constexpr Precedence precedence_of(TokenType type) {
+  return precedences[static_cast<std::uint8_t>(type)];
+}
+
 class Parser {
   using ParseError = std::runtime_error;
 
 public:
-  Parser(const std::vector<Token> &tokens);
+  // the lexemes of the tokens the statements keep go to lexicon.
+  Parser(const std::vector<SourceToken> &tokens, Lexicon &lexicon, Diagnostics &diagnostics);
+  // defers the bodies of top-level functions and of methods of top-level
+  // classes: they are only brace-matched here, and parsed and resolved from
+  // the shared tokens when first used, binding globals in symbols.
+  Parser(std::shared_ptr<const std::vector<SourceToken>> tokens, Lexicon &lexicon, SymbolTable &symbols,
+         Diagnostics &diagnostics);
 
   [[nodiscard]] std::vector<std::shared_ptr<Stmt>> parse();
 
 private:
   [[nodiscard]] std::shared_ptr<Stmt> declaration();
+  [[nodiscard]] std::shared_ptr<Stmt> import_declaration();
   [[nodiscard]] std::shared_ptr<Stmt> class_declaration();
   [[nodiscard]] std::shared_ptr<Stmt> statement();
   [[nodiscard]] std::shared_ptr<Stmt> for_statement();
@@ -34,37 +90,40 @@ private:
   [[nodiscard]] std::shared_ptr<Stmt> expression_statement();
 
   [[nodiscard]] std::shared_ptr<Function> function(std::string kind);
+  [[nodiscard]] ValueType annotation();
+  [[nodiscard]] std::shared_ptr<Function> defer_function(Token name, std::vector<Token> parameters, bool method);
 
   [[nodiscard]] std::vector<std::shared_ptr<Stmt>> block();
 
   [[nodiscard]] std::shared_ptr<Expr> expression();
-  [[nodiscard]] std::shared_ptr<Expr> assignment();
-  [[nodiscard]] std::shared_ptr<Expr> or_();
-  [[nodiscard]] std::shared_ptr<Expr> and_();
-  [[nodiscard]] std::shared_ptr<Expr> equality();
-  [[nodiscard]] std::shared_ptr<Expr> comparison();
-  [[nodiscard]] std::shared_ptr<Expr> term();
-  [[nodiscard]] std::shared_ptr<Expr> factor();
-  [[nodiscard]] std::shared_ptr<Expr> unary();
+  [[nodiscard]] std::shared_ptr<Expr> parse_precedence(Precedence minimum);
+  [[nodiscard]] std::shared_ptr<Expr> prefix();
   [[nodiscard]] std::shared_ptr<Expr> finish_call(std::shared_ptr<Expr> callee);
-  [[nodiscard]] std::shared_ptr<Expr> call();
-  [[nodiscard]] std::shared_ptr<Expr> primary();
 
-  [[nodiscard]] bool match(std::initializer_list<TokenType> &&type);
+  [[nodiscard]] bool match(TokenType type);
   [[nodiscard]] bool check(TokenType type);
   [[nodiscard]] bool is_at_end();
 
-  Token consume(TokenType type, std::string_view message);
-  Token advance();
-  [[nodiscard]] Token peek();
-  [[nodiscard]] Token previous();
+  const SourceToken &consume(TokenType type, std::string_view message);
+  const SourceToken &advance();
+  [[nodiscard]] const SourceToken &peek() const;
+  [[nodiscard]] const SourceToken &previous() const;
+  // what the AST keeps of a scanned token.
+  [[nodiscard]] Token token(const SourceToken &token);
 
-  ParseError parse_error(const Token &token, std::string_view message);
+  ParseError parse_error(const SourceToken &token, std::string_view message);
 
   void synchronize();
 
 private:
-  const std::vector<Token> &tokens;
+  const std::vector<SourceToken> &tokens;
+  Lexicon &lexicon;
+  Diagnostics &diagnostics;
   int current{0};
+  // set when bodies are deferred.
+  std::shared_ptr<const std::vector<SourceToken>> shared_tokens;
+  SymbolTable *symbols{nullptr};
+  int block_depth{0};
+  bool in_subclass{false};
 };
 }// namespace loxplusplus
@@ -0,0 +1,185 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "expr.hpp"
+#include "stmt.hpp"
+#include "symbol_table.hpp"
+
+namespace loxplusplus {
+// on-disk cache of resolved programs. a program is stored after a successful
+// scan, parse and resolve under a file named by a hash of its source and the
+// build; later runs of the same source map that file and rebuild the
+// statements without touching the front-end.
+class ProgramCache {
+public:
+  static constexpr std::uint32_t format_version = 4;
+
+  ProgramCache(std::string directory);
+
+  [[nodiscard]] std::optional<std::vector<std::shared_ptr<Stmt>>> load(std::string_view source, Lexicon &lexicon, SymbolTable &symbols) const;
+  void store(std::string_view source, const std::vector<std::shared_ptr<Stmt>> &statements) const;
+
+  // fnv-1a, by default seeded with the format version. checks the payload
+  // of an image.
+  [[nodiscard]] static std::uint64_t hash(std::string_view bytes,
+                                          std::uint64_t seed = 14695981039346656037ull ^ format_version);
+  // names the file of a source.
+  [[nodiscard]] static std::uint64_t key(std::string_view source);
+
+private:
+  [[nodiscard]] std::string path(std::uint64_t key) const;
+
+private:
+  std::string directory;
+};
+
+enum class NodeKind : std::uint8_t {
+  NONE,
+  ASSIGN,
+  BINARY,
+  CALL,
+  GET,
+  GROUPING,
+  LITERAL,
+  LOGICAL,
+  SET,
+  SUPER,
+  THIS,
+  UNARY,
+  VARIABLE,
+  BLOCK,
+  CLASS,
+  EXPRESSION,
+  FUNCTION,
+  IF,
+  IMPORT,
+  PRINT,
+  RETURN,
+  VAR,
+  WHILE
+};
+
+// serializes statements in prefix order. identifiers and string literals go
+// to a deduplicated pool and nodes refer to them by index; global slots are
+// stored as a flag, since symbol ids are only valid inside one process. the
+// header carries a hash of the pool and nodes.
+class ProgramWriter : public ExprVisitor, public StmtVisitor {
+public:
+  [[nodiscard]] std::string write(std::uint64_t key, const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<While> stmt) override;
+
+  [[nodiscard]] Object visit(std::shared_ptr<Assign> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Binary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Call> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Get> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Grouping> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Literal> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Logical> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Set> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Super> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<This> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Unary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Variable> expr) override;
+
+private:
+  void write(std::shared_ptr<Stmt> stmt);
+  void write(std::shared_ptr<Expr> expr);
+  void write(const std::vector<std::shared_ptr<Stmt>> &statements);
+  void write(const Token &token);
+  void write_string(const std::string &value);
+  void write_kind(NodeKind kind);
+  void write_type(ValueType type);
+
+  template <typename T>
+  void write_value(T value);
+
+private:
+  std::string nodes;
+  std::vector<std::string_view> pool;
+  std::unordered_map<std::string_view, std::uint32_t> pool_index;
+};
+
+// rebuilds statements from a mapped cache file. any inconsistency throws
+// ProgramReader::Corrupt, which makes the cache fall back to the front-end:
+// a payload that does not match its hash, or a resolved depth or global flag
+// that disagrees with the scopes the statements declare, so a bad file never
+// walks an environment chain past its end.
+class ProgramReader {
+public:
+  struct Corrupt {};
+  // a name a function resolves outside of its own scopes: the distance of
+  // the environment holding it, counted from the function's closure.
+  struct Capture {
+    int distance;
+    std::string name;
+  };
+
+  ProgramReader(const char *data, std::size_t size, Lexicon &lexicon, SymbolTable &symbols);
+
+  [[nodiscard]] std::vector<std::shared_ptr<Stmt>> read(std::uint64_t key);
+  // reads functions written apart from the scopes they were declared in; the
+  // names each one captures are left in captures for the caller to check
+  // against its closure.
+  [[nodiscard]] std::vector<std::shared_ptr<Function>> read_functions(std::uint64_t key,
+                                                                     std::vector<std::vector<Capture>> &captures);
+
+private:
+  void read_header(std::uint64_t key);
+  [[nodiscard]] std::shared_ptr<Stmt> read_stmt();
+  [[nodiscard]] std::shared_ptr<Expr> read_expr();
+  [[nodiscard]] std::vector<std::shared_ptr<Stmt>> read_statements();
+  [[nodiscard]] std::shared_ptr<Function> read_function(bool method);
+  [[nodiscard]] Token read_token();
+  [[nodiscard]] const std::string &read_string();
+  [[nodiscard]] NodeKind read_kind();
+  [[nodiscard]] int read_slot(const Token &name);
+  // global is where the resolver would have assigned a slot to name.
+  [[nodiscard]] int read_slot(const Token &name, bool global);
+  // a depth must name a scope declaring name; local is false where the
+  // resolver may fall back to a global.
+  [[nodiscard]] int read_depth(const Token &name, bool local);
+  void require(int depth, std::string_view name);
+  [[nodiscard]] ValueType read_type();
+
+  // mirror the resolver's scopes while reading.
+  void begin_scope();
+  void end_scope();
+  void declare(const Token &name);
+
+  template <typename T>
+  [[nodiscard]] T read_value();
+
+private:
+  const char *cursor;
+  const char *end;
+  Lexicon &lexicon;
+  SymbolTable &symbols;
+  std::vector<std::string> pool;
+  std::vector<std::unordered_set<std::string_view>> scopes;
+  // set while reading a detached function.
+  std::vector<Capture> *captures{nullptr};
+};
+}// namespace loxplusplus
@@ -6,7 +6,12 @@
 
 #pragma once
 
-#include "interpreter.hpp"
+#include <map>
+
+#include "error.hpp"
+#include "expr.hpp"
+#include "stmt.hpp"
+#include "symbol_table.hpp"
 
 namespace loxplusplus {
 class Resolver : public ExprVisitor, public StmtVisitor {
@@ -19,13 +24,15 @@ class Resolver : public ExprVisitor, public StmtVisitor {
                          SUBCLASS };
 
 public:
-  Resolver(Interpreter &interpreter);
+  // globals are bound to their symbol in symbols.
+  Resolver(Diagnostics &diagnostics, SymbolTable &symbols);
 
   [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
   [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
@@ -45,19 +52,27 @@ public:
   [[nodiscard]] Object visit(std::shared_ptr<Variable> expr) override;
 
   void resolve(const std::vector<std::shared_ptr<Stmt>> &statements);
-  void resolve(std::shared_ptr<Stmt> stmt);
-  void resolve(std::shared_ptr<Expr> expr);
-  void resolve_function(std::shared_ptr<Function> function, FunctionType type);
+  void resolve(const std::shared_ptr<Stmt> &stmt);
+  void resolve(const std::shared_ptr<Expr> &expr);
+  // resolves the body of a deferred top-level function, or of a method of a
+  // top-level class, in the scopes its declaration would have provided.
+  void resolve_deferred(const Function &function, const std::vector<std::shared_ptr<Stmt>> &body,
+                        bool method, bool subclass);
+  void resolve_function(const Function &function, const std::vector<std::shared_ptr<Stmt>> &body,
+                        FunctionType type);
   void begin_scope();
   void end_scope();
   void declare(const Token &name);
   void define(const Token &name);
-  void resolve_local(std::shared_ptr<Expr> expr, const Token &name);
+
+  [[nodiscard]] int resolve_local(const Token &name);
+  [[nodiscard]] int global_slot(const Token &name);
 
 private:
+  Diagnostics &diagnostics;
+  SymbolTable &symbols;
   ClassType current_class{ClassType::NONE};
   FunctionType current_function{FunctionType::NONE};
-  Interpreter &interpreter;
   std::vector<std::map<std::string, bool>> scopes;
 };
 }// namespace loxplusplus
\ No newline at end of file
@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "stmt.hpp"
+
+namespace loxplusplus {
+// keeps instances that never leave the block creating them in locals, one
+// per field, instead of allocating them. `var p = K(args);` in a block or
+// directly in a function body qualifies when:
+//
+// - K is a class the program declares once at the top level, without a
+//   superclass, whose init only stores expressions of its parameters and
+//   globals into distinct fields of `this`.
+// - every later use of p in the block reads or stores one of these fields,
+//   outside nested functions and classes.
+// - nothing in front of it in the block calls a function, so K still holds
+//   what it held when the block was entered.
+//
+// the rewritten statements go to Block::replaced or Function::replaced next
+// to the originals, and engines run them when every class they assume still
+// has the init they were made from on entering the block or the call. fields become `0p.f` and arguments
+// `0p(x`, named with a leading digit like the IrOptimizer's temporaries.
+// resolved depths find the uses of p and tell the parameters of init from
+// globals; the rewritten statements are not resolved again, so they are
+// built with the depths the Resolver would give them.
+class ScalarReplacer : public StmtVisitor {
+public:
+  // the names of the new locals go to lexicon.
+  ScalarReplacer(Lexicon &lexicon);
+
+  void replace(const std::vector<std::shared_ptr<Stmt>> &statements);
+
+  [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<While> stmt) override;
+
+private:
+  // what init stores into each field, in order.
+  struct Layout {
+    std::shared_ptr<Function> init;
+    std::vector<std::pair<std::string, std::shared_ptr<Expr>>> fields;
+    // whether it stores its parameters as they are, one per field.
+    bool forwarding{true};
+
+    [[nodiscard]] bool stores(const std::string &field) const;
+  };
+
+  // the variable holding the instance being replaced, and its class.
+  struct Instance {
+    const std::string &name;
+    const Layout &layout;
+    Lexicon &lexicon;
+  };
+
+  void scan(const std::shared_ptr<Stmt> &stmt);
+  [[nodiscard]] static bool layout(const Class &klass, Layout &layout);
+  [[nodiscard]] static bool storable(const std::shared_ptr<Expr> &expr, const Function &init);
+  [[nodiscard]] static bool calls(const std::shared_ptr<Stmt> &stmt);
+  [[nodiscard]] static bool calls(const std::shared_ptr<Expr> &expr);
+
+  [[nodiscard]] const Layout *candidate(const std::shared_ptr<Stmt> &stmt) const;
+  [[nodiscard]] std::shared_ptr<ScalarReplacement> replacement(const std::vector<std::shared_ptr<Stmt>> &scope);
+  [[nodiscard]] std::vector<std::shared_ptr<Stmt>> expand(const Var &var, const Layout &layout);
+  [[nodiscard]] std::shared_ptr<Expr> substitute(const std::shared_ptr<Expr> &expr, const std::string &prefix,
+                                                 const Function &init);
+  // depth is the number of scopes between the statement and the block
+  // declaring the instance, or -1 inside a nested function or class.
+  [[nodiscard]] static bool escapes(const Instance &instance, const std::shared_ptr<Stmt> &stmt, int depth);
+  [[nodiscard]] static bool escapes(const Instance &instance, const std::shared_ptr<Expr> &expr, int depth);
+  [[nodiscard]] static bool refers(const Instance &instance, const Token &name, int reference, int depth);
+  [[nodiscard]] static std::shared_ptr<Stmt> rewrite(const Instance &instance, const std::shared_ptr<Stmt> &stmt,
+                                                     int depth);
+  [[nodiscard]] static std::shared_ptr<Expr> rewrite(const Instance &instance, const std::shared_ptr<Expr> &expr,
+                                                     int depth);
+  [[nodiscard]] static std::vector<std::shared_ptr<Stmt>> rewrite(const Instance &instance,
+                                                                  const std::vector<std::shared_ptr<Stmt>> &statements,
+                                                                  int depth);
+
+private:
+  Lexicon &lexicon;
+  std::unordered_map<std::string, Layout> layouts;
+};
+}// namespace loxplusplus
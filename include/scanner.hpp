@@ -7,6 +7,7 @@
 #pragma once
 
 #include <map>
+#include <ostream>
 #include <string_view>
 #include <vector>
 
@@ -16,11 +17,31 @@
 namespace loxplusplus {
 class Scanner {
 public:
-  Scanner(std::string_view source);
+  // sources at least this large are split into chunks scanned in parallel.
+  static constexpr std::size_t parallel_threshold = 1 << 20;
 
-  [[nodiscard]] std::vector<Token> scan_tokens();
+  Scanner(std::string_view source, Diagnostics &diagnostics);
+
+  [[nodiscard]] std::vector<SourceToken> scan_tokens();
+  // scans in about chunks parallel chunks whatever the size of the source;
+  // fewer if it has fewer lines to split at.
+  [[nodiscard]] std::vector<SourceToken> scan_tokens(std::size_t chunks);
+
+  // scans source once sequentially and once in chunks and writes the first
+  // difference in tokens, lines or errors to report. true if there is none.
+  [[nodiscard]] static bool check_chunks(std::string_view source, std::size_t chunks, std::ostream &report);
 
 private:
+  // a part of the source starting at a line start outside string literals,
+  // which any scan reaches in the same state as at the start of the source.
+  struct Chunk {
+    std::size_t begin;
+    int line;
+  };
+
+  [[nodiscard]] static std::vector<Chunk> split(std::string_view source, std::size_t count);
+  void scan_chunks(std::size_t count);
+  void scan();
   void scan_token();
   void identifier();
   void number();
@@ -37,18 +58,18 @@ private:
   [[nodiscard]] bool is_at_end();
 
   void add_token(TokenType type);
-  void add_token(TokenType type, Object literal);
 
 private:
   std::string_view source;
-  std::vector<Token> tokens;
+  Diagnostics &diagnostics;
+  std::vector<SourceToken> tokens;
 
   int start{0},
     current{0},
     line{1};
 
   static inline const char null_char = '\0';
-  static inline const std::map<std::string, TokenType> keywords{
+  static inline const std::map<std::string, TokenType, std::less<>> keywords{
     {"and", TokenType::AND},
     {"class", TokenType::CLASS},
     {"else", TokenType::ELSE},
@@ -58,6 +79,7 @@ private:
     {"if", TokenType::IF},
     {"nil", TokenType::NIL},
     {"or", TokenType::OR},
+    {"import", TokenType::IMPORT},
     {"print", TokenType::PRINT},
     {"return", TokenType::RETURN},
     {"super", TokenType::SUPER},
@@ -0,0 +1,51 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "engine.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LOX_SERVER_SUPPORTED
+#endif
+
+namespace loxplusplus {
+// warm daemon listening on a unix socket. every request runs in a fresh
+// engine on its own thread; modules stay compiled in the process-wide
+// ModuleCache between requests. output and errors are streamed back as they
+// are flushed, followed by the exit status.
+//
+// both directions use frames of a one-byte kind, a four-byte little-endian
+// length and the payload. a request is any number of 'a' (argument), 'd'
+// (working directory) and 'i' (standard input) frames closed by 'r'; a
+// response is 'o' (output) and 'e' (error) frames closed by 'x' carrying the
+// exit status.
+class Server {
+public:
+  Server(std::string socket_path, EngineOptions options);
+
+  // accepts requests until the process is terminated. returns false if the
+  // socket could not be set up.
+  [[nodiscard]] bool serve();
+
+private:
+  void handle(int connection) const;
+
+private:
+  std::string socket_path;
+  EngineOptions options;
+};
+
+// forwards arguments, the working directory and, when no script is named,
+// standard input to a Server; relays the response and returns its exit status.
+class Client {
+public:
+  [[nodiscard]] static int run(const std::string &socket_path, const std::vector<std::string> &arguments);
+};
+}// namespace loxplusplus
@@ -0,0 +1,132 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "environment.hpp"
+#include "lox_class.hpp"
+#include "lox_function.hpp"
+#include "lox_instance.hpp"
+#include "program_cache.hpp"
+#include "stmt.hpp"
+
+namespace loxplusplus {
+class Interpreter;
+
+// global state of an interpreter after running a prelude: the defined
+// globals, every environment, function, class and instance reachable from
+// them, the declarations of those functions, and the modules already
+// imported. a snapshot file is mapped and restored into a fresh interpreter
+// without running the prelude again.
+//
+// layout: magic, version, a hash of the rest, the declarations as a
+// ProgramWriter image, then heap records in id order. records refer to each
+// other by id, so restoring is one pass that allocates every object and one
+// that links them. record 0 is always the global environment.
+class Snapshot {
+public:
+  static constexpr std::uint32_t format_version = 3;
+
+  // false if the file cannot be written or the heap holds functions of the
+  // closure compiler, which have no serialized form.
+  [[nodiscard]] static bool save(const std::string &path, const Interpreter &interpreter);
+  // false if the file cannot be read or is not a valid snapshot; interpreter
+  // is left untouched then. the restored functions intern their tokens in
+  // lexicon.
+  [[nodiscard]] static bool restore(const std::string &path, Interpreter &interpreter, Lexicon &lexicon);
+};
+
+enum class HeapKind : std::uint8_t {
+  ENVIRONMENT,
+  FUNCTION,
+  CLASS,
+  INSTANCE
+};
+
+using HeapObject = std::variant<std::shared_ptr<Environment>, std::shared_ptr<LoxFunction>,
+                                std::shared_ptr<LoxClass>, std::shared_ptr<LoxInstance>>;
+
+class SnapshotWriter {
+public:
+  struct Unsupported {};
+
+  [[nodiscard]] std::string write(const Interpreter &interpreter);
+
+private:
+  void write_record(const HeapObject &object);
+  void write_value(const Object &value);
+  void write_entries(const std::map<std::string, Object> &entries);
+  void write_string(std::string_view value);
+  [[nodiscard]] std::uint32_t reference(const HeapObject &object);
+  [[nodiscard]] std::uint32_t declaration(const std::shared_ptr<Function> &function);
+
+  template <typename T>
+  void write_raw(T value);
+
+private:
+  std::string heap;
+  std::vector<HeapObject> objects;
+  std::unordered_map<const void *, std::uint32_t> ids;
+  std::vector<std::shared_ptr<Stmt>> declarations;
+  std::unordered_map<const Function *, std::uint32_t> declaration_ids;
+};
+
+class SnapshotReader {
+public:
+  struct Corrupt {};
+
+  SnapshotReader(const char *data, std::size_t size, Lexicon &lexicon);
+
+  void read(Interpreter &interpreter);
+
+private:
+  // a value as stored: a literal, or the id of a heap record.
+  struct Value {
+    Object literal;
+    std::optional<std::uint32_t> id;
+  };
+
+  struct Record {
+    HeapKind kind;
+    std::uint32_t link;
+    std::uint32_t declaration;
+    bool is_initializer;
+    std::string name;
+    std::vector<std::pair<std::string, Value>> entries;
+  };
+
+  [[nodiscard]] Record read_record();
+  [[nodiscard]] Value read_value();
+  [[nodiscard]] std::vector<std::pair<std::string, Value>> read_entries();
+  [[nodiscard]] std::uint32_t read_count();
+  [[nodiscard]] std::string read_string();
+  void check(std::uint32_t id, HeapKind kind) const;
+  void check(const Value &value) const;
+  // the environments a function runs in hold every name its body captures.
+  void check(const Record &function, const std::vector<ProgramReader::Capture> &captures, bool bound) const;
+  [[nodiscard]] Object resolve(const Value &value) const;
+  [[nodiscard]] std::shared_ptr<LoxClass> build_class(std::uint32_t id, std::vector<bool> &building);
+
+  template <typename T>
+  [[nodiscard]] T read_raw();
+
+private:
+  const char *cursor;
+  const char *end;
+  Lexicon &lexicon;
+  std::vector<std::shared_ptr<Function>> declarations;
+  std::vector<Record> records;
+  std::vector<HeapObject> objects;
+};
+}// namespace loxplusplus
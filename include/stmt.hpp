@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <functional>
+#include <unordered_map>
+
 #include "expr.hpp"
 #include "token.hpp"
 
@@ -15,6 +18,8 @@ class Class;
 class Expression;
 class Function;
 class If;
+class Import;
+class MemoTable;
 class Print;
 class Return;
 class Var;
@@ -27,6 +32,7 @@ public:
   [[nodiscard]] virtual Object visit(std::shared_ptr<Expression> stmt) = 0;
   [[nodiscard]] virtual Object visit(std::shared_ptr<Function> stmt) = 0;
   [[nodiscard]] virtual Object visit(std::shared_ptr<If> stmt) = 0;
+  [[nodiscard]] virtual Object visit(std::shared_ptr<Import> stmt) = 0;
   [[nodiscard]] virtual Object visit(std::shared_ptr<Print> stmt) = 0;
   [[nodiscard]] virtual Object visit(std::shared_ptr<Return> stmt) = 0;
   [[nodiscard]] virtual Object visit(std::shared_ptr<Var> stmt) = 0;
@@ -34,10 +40,35 @@ public:
   virtual ~StmtVisitor() = default;
 };
 
+enum class StmtKind : std::uint8_t {
+  BLOCK,
+  CLASS,
+  EXPRESSION,
+  FUNCTION,
+  IF,
+  IMPORT,
+  PRINT,
+  RETURN,
+  VAR,
+  WHILE
+};
+
 class Stmt {
 public:
+  explicit Stmt(StmtKind kind) noexcept : kind{kind} {}
   virtual ~Stmt();
   virtual Object accept(StmtVisitor &visitor) = 0;
+
+public:
+  // the concrete type, for passes that dispatch with a switch.
+  const StmtKind kind;
+};
+
+// the statements of a block with the instances that do not escape it kept in
+// locals, and for each of them the global class and init it assumes.
+struct ScalarReplacement {
+  std::vector<std::pair<std::shared_ptr<Variable>, std::shared_ptr<Function>>> classes;
+  std::vector<std::shared_ptr<Stmt>> statements;
 };
 
 class Block : public Stmt, public std::enable_shared_from_this<Block> {
@@ -49,6 +80,7 @@ public:
 
 public:
   const std::vector<std::shared_ptr<Stmt>> statements;
+  std::shared_ptr<ScalarReplacement> replaced;
 };
 
 class Class : public Stmt, public std::enable_shared_from_this<Class> {
@@ -63,6 +95,7 @@ public:
   const Token name;
   const std::shared_ptr<Variable> superclass;
   const std::vector<std::shared_ptr<Function>> methods;
+  int slot{-1};
 };
 
 class Expression : public Stmt,
@@ -77,18 +110,41 @@ public:
   const std::shared_ptr<Expr> expression;
 };
 
+// produces the parsed and resolved body of a function whose parsing was
+// deferred; throws RuntimeError if the body turns out to be invalid.
+using DeferredBody = std::function<std::vector<std::shared_ptr<Stmt>>(const Function &)>;
+
 class Function : public Stmt, public std::enable_shared_from_this<Function> {
 public:
   Function(Token name, std::vector<Token> params,
            std::vector<std::shared_ptr<Stmt>> body);
+  Function(Token name, std::vector<Token> params, DeferredBody deferred);
   ~Function();
 
   [[nodiscard]] Object accept(StmtVisitor &visitor) override;
 
+  // parses a deferred body on first use. a body that failed to parse stays
+  // deferred, so every later use reports the error again.
+  [[nodiscard]] const std::vector<std::shared_ptr<Stmt>> &body() const;
+  // swaps in an optimized body; the caller resolves it again.
+  void replace_body(std::vector<std::shared_ptr<Stmt>> body);
+  [[nodiscard]] bool deferred() const noexcept;
+
 public:
   const Token name;
   const std::vector<Token> params;
-  const std::vector<std::shared_ptr<Stmt>> body;
+  int slot{-1};
+  // annotations of the parameters, empty when none is annotated.
+  std::vector<ValueType> param_types;
+  ValueType return_type{ValueType::ANY};
+  // results by arguments, when the Memoizer found the function pure.
+  std::shared_ptr<MemoTable> memo;
+  // the body with the instances it keeps in locals, see ScalarReplacer.
+  std::shared_ptr<ScalarReplacement> replaced;
+
+private:
+  mutable std::vector<std::shared_ptr<Stmt>> statements;
+  mutable DeferredBody pending;
 };
 
 class If : public Stmt, public std::enable_shared_from_this<If> {
@@ -105,6 +161,21 @@ public:
   const std::shared_ptr<Stmt> else_branch;
 };
 
+// `import "path";` at the top level of a file. module is the canonical path
+// of the imported file, filled in when the imports of a program are loaded.
+class Import : public Stmt, public std::enable_shared_from_this<Import> {
+public:
+  Import(Token keyword, Token path);
+  ~Import();
+
+  [[nodiscard]] Object accept(StmtVisitor &visitor) override;
+
+public:
+  const Token keyword;
+  const Token path;
+  std::string module;
+};
+
 class Print : public Stmt, public std::enable_shared_from_this<Print> {
 public:
   Print(std::shared_ptr<Expr> expression);
@@ -125,6 +196,9 @@ public:
 public:
   const Token keyword;
   const std::shared_ptr<Expr> value;
+  // return annotation of the function when the TypeChecker could not prove
+  // the value to match it.
+  ValueType check{ValueType::ANY};
 };
 
 class Var : public Stmt, public std::enable_shared_from_this<Var> {
@@ -137,6 +211,21 @@ public:
 public:
   const Token name;
   const std::shared_ptr<Expr> initializer;
+  int slot{-1};
+  ValueType type{ValueType::ANY};
+  // type when the TypeChecker could not prove the initializer to match it.
+  ValueType check{ValueType::ANY};
+};
+
+// canonical `for (var i = a; i < n; i = i + k)` loop recognized by the
+// Optimizer. the loop variable is an integer that is neither assigned nor
+// captured by the body, so the interpreter can keep it unboxed and only
+// store it back into the environment once per iteration.
+struct CountedLoop {
+  std::string variable;
+  std::shared_ptr<Binary> condition;
+  std::shared_ptr<Stmt> body;
+  std::int64_t step;
 };
 
 class While : public Stmt, public std::enable_shared_from_this<While> {
@@ -149,5 +238,29 @@ public:
 public:
   const std::shared_ptr<Expr> condition;
   const std::shared_ptr<Stmt> body;
+  std::shared_ptr<CountedLoop> counted;
 };
+
+// how often the top level declares each name with var, fun or class. a name
+// declared twice refers to different values over the run of the program, so
+// passes that rely on what a global holds skip it.
+[[nodiscard]] std::unordered_map<std::string, std::size_t> top_level_declarations(
+  const std::vector<std::shared_ptr<Stmt>> &statements);
+
+// the statement counterpart of dispatch() for expressions.
+[[nodiscard]] inline Object dispatch(StmtVisitor &visitor, const std::shared_ptr<Stmt> &stmt) {
+  switch (stmt->kind) {
+  case StmtKind::BLOCK: return visitor.visit(std::static_pointer_cast<Block>(stmt));
+  case StmtKind::CLASS: return visitor.visit(std::static_pointer_cast<Class>(stmt));
+  case StmtKind::EXPRESSION: return visitor.visit(std::static_pointer_cast<Expression>(stmt));
+  case StmtKind::FUNCTION: return visitor.visit(std::static_pointer_cast<Function>(stmt));
+  case StmtKind::IF: return visitor.visit(std::static_pointer_cast<If>(stmt));
+  case StmtKind::IMPORT: return visitor.visit(std::static_pointer_cast<Import>(stmt));
+  case StmtKind::PRINT: return visitor.visit(std::static_pointer_cast<Print>(stmt));
+  case StmtKind::RETURN: return visitor.visit(std::static_pointer_cast<Return>(stmt));
+  case StmtKind::VAR: return visitor.visit(std::static_pointer_cast<Var>(stmt));
+  case StmtKind::WHILE: return visitor.visit(std::static_pointer_cast<While>(stmt));
+  }
+  return nullptr;
+}
 }// namespace loxplusplus
\ No newline at end of file
@@ -0,0 +1,28 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace loxplusplus {
+// interning of the global names of one engine's programs and modules. a
+// symbol is a dense index that stays valid for the lifetime of the table, so
+// it can be stored in the AST and used to index the interpreter's globals;
+// it is not synchronized.
+class SymbolTable {
+public:
+  [[nodiscard]] int intern(std::string_view name);
+  [[nodiscard]] const std::string &name(int symbol) const;
+
+private:
+  std::unordered_map<std::string_view, int> symbols;
+  std::deque<std::string> names;
+};
+}// namespace loxplusplus
\ No newline at end of file
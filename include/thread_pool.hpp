@@ -0,0 +1,49 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace loxplusplus {
+// work-stealing pool for independent tasks. each worker owns a queue seeded
+// with a contiguous range of task indices and works through it in order; a
+// worker that runs dry steals from the back of the others, so a few slow
+// tasks do not leave the remaining threads idle.
+class ThreadPool {
+public:
+  ThreadPool(std::size_t threads = default_threads());
+
+  // runs task(0) ... task(count - 1) and returns once every task finished.
+  // the calling thread works as one of the workers. a task that throws does
+  // not stop the others; the first exception is rethrown once all finished.
+  void run(std::size_t count, const std::function<void(std::size_t)> &task);
+
+  [[nodiscard]] std::size_t size() const noexcept;
+  [[nodiscard]] static std::size_t default_threads() noexcept;
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::size_t> tasks;
+  };
+
+  void work(std::size_t worker, const std::function<void(std::size_t)> &task);
+  [[nodiscard]] bool take(std::size_t worker, std::size_t &index);
+  [[nodiscard]] bool steal(std::size_t worker, std::size_t &index);
+
+private:
+  std::size_t threads;
+  std::vector<Queue> queues;
+  std::mutex mutex;
+  std::exception_ptr error;
+};
+}// namespace loxplusplus
@@ -6,20 +6,25 @@
 
 #pragma once
 
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 
 #include "token_type.hpp"
 
 #define StringIndex 0
-#define LongDoubleIndex 1
+#define DoubleIndex 1
 #define BoolIndex 2
 #define NullptrIndex 3
 #define LoxFunctionIndex 4
 #define LoxClassIndex 5
 #define LoxInstanceIndex 6
+#define IntegerIndex 7
 
 namespace loxplusplus {
 class LoxFunction;
@@ -27,20 +32,49 @@ class LoxClass;
 class LoxInstance;
 
 using Object =
-  std::variant<std::string, long double, bool, std::nullptr_t,
+  std::variant<std::string, double, bool, std::nullptr_t,
                std::shared_ptr<LoxFunction>, std::shared_ptr<LoxClass>,
-               std::shared_ptr<LoxInstance>>;
+               std::shared_ptr<LoxInstance>, std::int64_t>;
 
-class Token {
+// a token as the scanner produces it. the lexeme points into the scanned
+// source, which must outlive the token; only the parser sees these, and the
+// AST keeps Token.
+class SourceToken {
 public:
-  Token(TokenType type, std::string lexeme, Object literal, int line) noexcept;
-  ~Token() noexcept;
+  SourceToken(TokenType type, std::string_view lexeme, int line) noexcept;
+  // the value of a NUMBER or STRING token.
+  [[nodiscard]] Object literal() const;
   [[nodiscard]] std::string to_string() const noexcept;
 
+public:
+  TokenType type;
+  int line;
+  std::string_view lexeme;
+};
+
+// stores each distinct lexeme of the tokens of one engine's programs, or of
+// one module, once. tokens refer into it, so it must outlive every AST built
+// with it; it is not synchronized.
+class Lexicon {
+public:
+  [[nodiscard]] const std::string &intern(std::string_view lexeme);
+
+private:
+  std::unordered_map<std::string_view, const std::string *> lexemes;
+  std::deque<std::string> storage;
+};
+
+// what the AST keeps of a token: its type, its line and its lexeme interned
+// in a Lexicon. literal values go to Literal nodes, so a token takes two
+// words instead of a string and an Object.
+class Token {
+public:
+  Token(TokenType type, std::string_view lexeme, int line, Lexicon &lexicon);
+  Token(const SourceToken &token, Lexicon &lexicon);
+
 public:
   const TokenType type;
-  const std::string lexeme;
-  const Object literal;
   const int line;
+  const std::string &lexeme;
 };
 }// namespace loxplusplus
\ No newline at end of file
@@ -17,6 +17,7 @@ enum TokenType {
   LEFT_BRACE = '{',
   RIGHT_BRACE = '}',
   COMMA = ',',
+  COLON = ':',
   DOT = '.',
   MINUS = '-',
   PLUS = '+',
@@ -47,6 +48,7 @@ enum TokenType {
   FUN,
   FOR,
   IF,
+  IMPORT,
   NIL,
   OR,
   PRINT,
@@ -60,14 +62,14 @@ enum TokenType {
   EOF_
 };
 
-static const std::array<std::string, 39> strings {
+static const std::array<std::string, 41> strings {
   "LEFT_PAREN", "RIGHT_PAREN", "LEFT_BRACE", "RIGHT_BRACE", "COMMA",
-  "DOT", "MINUS", "PLUS", "SEMICOLON", "SLASH",
+  "COLON", "DOT", "MINUS", "PLUS", "SEMICOLON", "SLASH",
   "STAR", "BANG", "BANG_EQUAL", "EQUAL", "EQUAL_EQUAL",
   "GREATER", "GREATER_EQUAL", "LESS", "LESS_EQUAL", "IDENTIFIER",
   "STRING", "NUMBER", "AND", "CLASS", "ELSE",
-  "FALSE", "FUN", "FOR", "IF", "NIL",
-  "OR", "PRINT", "RETURN", "SUPER", "THIS",
+  "FALSE", "FUN", "FOR", "IF", "IMPORT",
+  "NIL", "OR", "PRINT", "RETURN", "SUPER", "THIS",
   "TRUE", "VAR", "WHILE", "EOF"
 };
 
@@ -0,0 +1,99 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "expr.hpp"
+#include "module_cache.hpp"
+#include "stmt.hpp"
+
+namespace loxplusplus {
+// ahead-of-time backend: translates a resolved program into standalone c++
+// that links against the runtime in lox_runtime.hpp. expressions are visited
+// into c++ expression strings, statements are written line by line. lox
+// functions become lambdas; locals captured by a nested function are boxed in
+// a Cell, every other local is a plain Value the c++ compiler can keep in
+// registers. captures are only known once the whole program has been seen, so
+// the program is translated twice and the first result is discarded.
+class Transpiler : public ExprVisitor, public StmtVisitor {
+public:
+  // imported modules are translated inline at their first import.
+  [[nodiscard]] std::string transpile(const std::vector<std::shared_ptr<Stmt>> &statements,
+                                      std::string_view source_name, const Modules &modules);
+
+  [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<While> stmt) override;
+
+  [[nodiscard]] Object visit(std::shared_ptr<Assign> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Binary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Call> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Get> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Grouping> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Literal> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Logical> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Set> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Super> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<This> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Unary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Variable> expr) override;
+
+private:
+  enum class FunctionType { NONE,
+                            FUNCTION,
+                            INITIALIZER,
+                            METHOD };
+
+  // declarations are keyed by the address of the node (or parameter token)
+  // that declares them, which stays stable across both translations.
+  struct Declaration {
+    int function_depth;
+    bool captured{false};
+  };
+
+  void translate(const std::vector<std::shared_ptr<Stmt>> &statements);
+  void emit(std::shared_ptr<Stmt> stmt);
+  [[nodiscard]] std::string emit(std::shared_ptr<Expr> expr);
+  void line(const std::string &text);
+  [[nodiscard]] std::string lambda(const Function &function, FunctionType type);
+
+  void begin_scope();
+  void end_scope();
+  [[nodiscard]] std::string declare(const void *key, const std::string &name, const std::string &value);
+  [[nodiscard]] std::string reference(const std::string &name, int depth);
+  [[nodiscard]] std::string global(const std::string &name);
+
+  [[nodiscard]] static std::string type_literal(ValueType type);
+  [[nodiscard]] static std::string checked(const std::string &value, ValueType type, const std::string &subject, int line);
+  [[nodiscard]] static std::string string_literal(const std::string &value);
+  [[nodiscard]] static std::string number_literal(const Object &value);
+
+private:
+  std::string code;
+  int indent{1};
+  int function_depth{0};
+  int class_count{0};
+  FunctionType current_function{FunctionType::NONE};
+  std::vector<std::string> superclasses;
+  std::vector<std::map<std::string, const void *>> scopes;
+  std::map<const void *, Declaration> declarations;
+  std::set<std::string> globals;
+  const Modules *modules{nullptr};
+  std::set<std::string> imported;
+};
+}// namespace loxplusplus
@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <map>
+
+#include "error.hpp"
+#include "expr.hpp"
+#include "stmt.hpp"
+
+namespace loxplusplus {
+// checks the optional `: num`, `: str` and `: bool` annotations of resolved
+// code. an expression whose static type contradicts its annotation is a
+// compile error; one whose type is unknown gets a runtime check attached.
+// operators whose operands are known to be numbers are marked `numeric`, so
+// the interpreters skip their operand tag checks. globals may be redefined at
+// any time, so reading one is always of unknown type.
+class TypeChecker : public ExprVisitor, public StmtVisitor {
+public:
+  TypeChecker(Diagnostics &diagnostics);
+
+  [[nodiscard]] Object visit(std::shared_ptr<Block> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Class> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Expression> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Function> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<If> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Import> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Print> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Return> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Var> stmt) override;
+  [[nodiscard]] Object visit(std::shared_ptr<While> stmt) override;
+
+  [[nodiscard]] Object visit(std::shared_ptr<Assign> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Binary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Call> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Get> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Grouping> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Literal> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Logical> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Set> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Super> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<This> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Unary> expr) override;
+  [[nodiscard]] Object visit(std::shared_ptr<Variable> expr) override;
+
+  void check(const std::vector<std::shared_ptr<Stmt>> &statements);
+  // checks the body of a function whose parsing was deferred.
+  void check_function(const Function &function, const std::vector<std::shared_ptr<Stmt>> &body);
+
+private:
+  void check(const std::shared_ptr<Stmt> &stmt);
+  [[nodiscard]] ValueType infer(const std::shared_ptr<Expr> &expr);
+  // returns the annotation left to check at runtime, reporting a mismatch.
+  [[nodiscard]] ValueType expect(const Token &token, std::string_view subject, ValueType expected, ValueType actual);
+
+  void begin_scope();
+  void end_scope();
+  void declare(const Token &name, ValueType type);
+  [[nodiscard]] ValueType lookup(const Token &name) const;
+
+private:
+  Diagnostics &diagnostics;
+  std::vector<std::map<std::string, ValueType>> scopes;
+  ValueType return_type{ValueType::ANY};
+  ValueType type{ValueType::ANY};
+};
+}// namespace loxplusplus
@@ -0,0 +1,47 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "runtime_error.hpp"
+#include "token.hpp"
+
+namespace loxplusplus {
+// type of an optional annotation. ANY stands for a missing annotation, whose
+// values keep lox's dynamic typing.
+enum class ValueType : std::uint8_t { ANY,
+                                      NUMBER,
+                                      STRING,
+                                      BOOL };
+
+[[nodiscard]] inline std::string_view type_name(ValueType type) {
+  switch (type) {
+  case ValueType::NUMBER: return "num";
+  case ValueType::STRING: return "str";
+  case ValueType::BOOL: return "bool";
+  default: return "any";
+  }
+}
+
+[[nodiscard]] inline bool has_type(const Object &value, ValueType type) {
+  switch (type) {
+  case ValueType::NUMBER: return value.index() == IntegerIndex || value.index() == DoubleIndex;
+  case ValueType::STRING: return value.index() == StringIndex;
+  case ValueType::BOOL: return value.index() == BoolIndex;
+  default: return true;
+  }
+}
+
+// throws unless value fits the annotation; subject names the checked value.
+inline void check_type(const Token &token, std::string_view subject, ValueType type, const Object &value) {
+  if (!has_type(value, type))
+    throw RuntimeError(token, std::string(subject) + " must be of type " + std::string(type_name(type)) + ".");
+}
+}// namespace loxplusplus
@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace loxplusplus {
+// minimal x86-64 machine code emitter used by the Jit. it only knows the
+// handful of 64-bit integer instructions the baseline compiler needs; memory
+// operands are [rbp + displacement], [register] or [register + displacement].
+class X64Emitter {
+public:
+  enum Register : std::uint8_t {
+    RAX,
+    RCX,
+    RDX,
+    RBX,
+    RSP,
+    RBP,
+    RSI,
+    RDI,
+    R8,
+    R9
+  };
+
+  enum Condition : std::uint8_t {
+    OVERFLOW_ = 0x0,
+    BELOW = 0x2,
+    EQUAL = 0x4,
+    NOT_EQUAL = 0x5,
+    SIGN = 0x8,
+    LESS = 0xC,
+    GREATER_EQUAL = 0xD,
+    LESS_EQUAL = 0xE,
+    GREATER = 0xF
+  };
+
+  using Label = std::size_t;
+
+  [[nodiscard]] Label new_label();
+  void bind(Label label);
+
+  void push(Register reg);
+  void pop(Register reg);
+  void mov(Register dst, Register src);
+  void mov(Register dst, std::int64_t imm);
+  void load(Register dst, std::int32_t displacement);
+  void store(std::int32_t displacement, Register src);
+  void store_indirect(Register base, std::int32_t imm);
+  void compare_indirect(Register base, std::int8_t imm);
+  void add(Register dst, Register src);
+  void sub(Register dst, Register src);
+  void imul(Register dst, Register src);
+  void or_(Register dst, Register src);
+  void cmp(Register left, Register right);
+  void cmp(Register left, std::int8_t imm);
+  void cmp(Register left, Register base, std::int8_t displacement);
+  void test(Register left, Register right);
+  void xor_(Register dst, std::int8_t imm);
+  void add_rsp(std::int32_t imm);
+  void sub_rsp(std::int32_t imm);
+  [[nodiscard]] std::size_t sub_rsp_placeholder();
+  void patch_imm32(std::size_t offset, std::int32_t imm);
+  void neg(Register reg);
+  void cqo();
+  void idiv(Register divisor);
+  void set(Condition condition);
+  void jump(Label label);
+  void jump(Condition condition, Label label);
+  void call(Label label);
+  void ret();
+
+  [[nodiscard]] const std::vector<std::uint8_t> &finish();
+
+private:
+  void byte(std::uint8_t value);
+  void imm32(std::int32_t value);
+  void rex(Register reg, Register rm);
+  void register_operands(std::uint8_t opcode, Register reg, Register rm);
+  void rbp_operand(Register reg, std::int32_t displacement);
+  void rel32(Label label);
+
+private:
+  struct Fixup {
+    std::size_t offset;
+    Label label;
+  };
+
+  std::vector<std::uint8_t> code;
+  std::vector<std::size_t> labels;
+  std::vector<Fixup> fixups;
+};
+}// namespace loxplusplus
@@ -0,0 +1,137 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "../include/batch_runner.hpp"
+
+namespace loxplusplus {
+BatchRunner::BatchRunner(EngineOptions options, std::size_t jobs)
+    : options{std::move(options)}, pool{jobs} {}
+
+[[nodiscard]] std::optional<std::vector<std::string>> BatchRunner::collect(const std::string &path) {
+  std::error_code error;
+  std::vector<std::string> scripts;
+  if (std::filesystem::is_directory(path, error)) {
+    for (const auto &entry: std::filesystem::directory_iterator(path, error))
+      if (entry.is_regular_file(error) && entry.path().extension() == ".lox")
+        scripts.push_back(entry.path().string());
+    if (error)
+      return std::nullopt;
+    std::sort(scripts.begin(), scripts.end());
+    return scripts;
+  }
+  std::ifstream list(path);
+  if (!list)
+    return std::nullopt;
+  for (std::string line; std::getline(list, line);)
+    if (!line.empty())
+      scripts.push_back(std::move(line));
+  return scripts;
+}
+
+BatchRunner::Statistics BatchRunner::run(const std::vector<std::string> &scripts, OutputSink &output, std::ostream &errors) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<Job> jobs(scripts.size());
+  this->next = 0;
+  this->pool.run(scripts.size(), [&](std::size_t index) {
+    // a script that throws past its engine still counts as done, or the
+    // output of every later script would be held back.
+    try {
+      this->execute(scripts[index], jobs[index]);
+    } catch (const std::exception &error) {
+      jobs[index].errors += "script '" + scripts[index] + "' failed: " + error.what() + "\n";
+      jobs[index].failed = true;
+    } catch (...) {
+      jobs[index].errors += "script '" + scripts[index] + "' failed.\n";
+      jobs[index].failed = true;
+    }
+    std::lock_guard<std::mutex> lock(this->mutex);
+    jobs[index].done = true;
+    this->emit_ready(jobs, output, errors);
+  });
+  output.flush();
+
+  Statistics statistics;
+  statistics.scripts = jobs.size();
+  statistics.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  for (const Job &job: jobs) {
+    statistics.failed += job.failed;
+    statistics.total_seconds += job.seconds;
+    statistics.min_seconds = (&job == &jobs.front()) ? job.seconds : std::min(statistics.min_seconds, job.seconds);
+    statistics.max_seconds = std::max(statistics.max_seconds, job.seconds);
+  }
+  return statistics;
+}
+
+void BatchRunner::report(const Statistics &statistics, std::size_t jobs, std::ostream &stream) {
+  double mean = statistics.scripts == 0 ? 0 : statistics.total_seconds / static_cast<double>(statistics.scripts);
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(6)
+       << "batch: " << statistics.scripts << " scripts, " << statistics.failed << " failed, "
+       << jobs << " jobs, " << statistics.wall_seconds << "s wall\n"
+       << "batch: per script " << statistics.min_seconds << "s min, " << mean << "s mean, "
+       << statistics.max_seconds << "s max, " << statistics.total_seconds << "s total\n";
+  stream << text.str();
+}
+
+[[nodiscard]] std::size_t BatchRunner::jobs() const noexcept {
+  return this->pool.size();
+}
+
+// the errors of a script with every line led by its path, as the errors of
+// all scripts end up in one stream.
+[[nodiscard]] static std::string prefixed(const std::string &text, const std::string &prefix) {
+  std::string result;
+  for (std::size_t start = 0; start < text.size();) {
+    std::size_t end = text.find('\n', start);
+    end = end == std::string::npos ? text.size() : end + 1;
+    result.append(prefix).append(text, start, end - start);
+    start = end;
+  }
+  return result;
+}
+
+void BatchRunner::execute(const std::string &script, Job &job) const {
+  auto start = std::chrono::steady_clock::now();
+  std::ifstream file(script, std::ios::binary);
+  if (!file) {
+    job.errors = "failed to open file '" + script + "'.\n";
+    job.failed = true;
+    return;
+  }
+  std::ostringstream source, errors;
+  source << file.rdbuf();
+  {
+    Engine engine([&job](std::string_view text) { job.output.append(text); }, errors);
+    engine.configure(this->options);
+    job.failed = engine.run(source.str(), script) != Engine::Result::OK;
+  }
+  job.errors = prefixed(std::move(errors).str(), script + ": ");
+  job.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// called with the mutex held by whichever worker finished a job; writes every
+// job that is done and not preceded by an unfinished one.
+void BatchRunner::emit_ready(std::vector<Job> &jobs, OutputSink &output, std::ostream &errors) {
+  for (; this->next < jobs.size() && jobs[this->next].done; ++this->next) {
+    Job &job = jobs[this->next];
+    output.write(job.output);
+    if (!job.errors.empty()) {
+      output.flush();
+      errors << job.errors;
+    }
+    std::string().swap(job.output);
+    std::string().swap(job.errors);
+  }
+}
+}// namespace loxplusplus
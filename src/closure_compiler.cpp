@@ -0,0 +1,670 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include "../include/closure_compiler.hpp"
+#include "../include/interpreter.hpp"
+
+namespace loxplusplus {
+[[nodiscard]] static Scope *ancestor(Scope *scope, int hops) {
+  for (; hops > 0; --hops)
+    scope = scope->enclosing.get();
+  return scope;
+}
+
+[[nodiscard]] static Object call_value(Interpreter &interpreter, const Object &callee, std::vector<Object> arguments,
+                                 const Token &paren) {
+  LoxCallable *function;
+  if (callee.index() == LoxFunctionIndex)
+    function = std::get<LoxFunctionIndex>(callee).get();
+  else if (callee.index() == LoxClassIndex)
+    function = std::get<LoxClassIndex>(callee).get();
+  else
+    throw RuntimeError{paren, "can only call functions and classes."};
+  if (arguments.size() != function->arity())
+    throw RuntimeError{paren, "expected " + std::to_string(function->arity()) + " arguments but got " + std::to_string(arguments.size()) + "."};
+  return function->call(interpreter, std::move(arguments));
+}
+
+ClosureFunction::ClosureFunction(std::shared_ptr<Function> declaration, std::shared_ptr<CompiledBody> body,
+                                 std::shared_ptr<Scope> scope, bool is_initializer)
+    : LoxFunction(std::move(declaration), nullptr, is_initializer),
+      body{std::move(body)},
+      scope{std::move(scope)} {}
+
+[[nodiscard]] Object ClosureFunction::execute(Interpreter &interpreter, std::vector<Object> arguments) {
+  // a body that fails to compile stays pending and fails every later call.
+  if (this->body->pending)
+    *this->body = this->body->pending();
+  const CompiledBody &compiled = this->body->replaced != nullptr && interpreter.replaceable(*this->declaration->replaced)
+                                     ? *this->body->replaced
+                                     : *this->body;
+  Frame frame{this->scope, nullptr};
+  if (compiled.slots > 0) {
+    // parameters occupy the first slots, so the argument vector becomes the scope.
+    arguments.resize(compiled.slots);
+    frame.scope = std::make_shared<Scope>(Scope{std::move(arguments), this->scope});
+  }
+  bool returned = false;
+  for (const Execution &statement : compiled.statements)
+    if (statement(frame)) {
+      returned = true;
+      break;
+    }
+  if (this->is_initializer)
+    return this->scope->slots[0];
+  if (!returned)
+    this->check_fall_through();
+  return std::move(frame.result);
+}
+
+[[nodiscard]] std::shared_ptr<LoxFunction> ClosureFunction::bind(std::shared_ptr<LoxInstance> instance) {
+  auto scope = std::make_shared<Scope>(Scope{{std::move(instance)}, this->scope});
+  return std::make_shared<ClosureFunction>(this->declaration, this->body, std::move(scope), this->is_initializer);
+}
+
+ClosureCompiler::ClosureCompiler(Interpreter &interpreter)
+    : interpreter{interpreter} {}
+
+void ClosureCompiler::run(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  std::vector<Execution> program = this->compile(statements);
+  Frame frame{nullptr, nullptr};
+  for (const Execution &statement : program)
+    (void)statement(frame);
+}
+
+[[nodiscard]] Execution ClosureCompiler::compile(std::shared_ptr<Stmt> stmt) {
+  (void)dispatch(*this, stmt);
+  return std::move(this->execution);
+}
+
+[[nodiscard]] Evaluation ClosureCompiler::compile(std::shared_ptr<Expr> expr) {
+  (void)dispatch(*this, expr);
+  return std::move(this->evaluation);
+}
+
+[[nodiscard]] std::vector<Execution> ClosureCompiler::compile(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  std::vector<Execution> compiled;
+  compiled.reserve(statements.size());
+  for (const std::shared_ptr<Stmt> &stmt : statements)
+    compiled.push_back(this->compile(stmt));
+  return compiled;
+}
+
+[[nodiscard]] std::shared_ptr<CompiledBody> ClosureCompiler::compile_function(const Function &function) {
+  if (function.deferred()) {
+    // the enclosing scopes are copied as they are now, which is all the
+    // resolver let the body see.
+    auto pending = [&interpreter = this->interpreter, &function, scopes = this->scopes] {
+      (void)function.body();
+      ClosureCompiler compiler(interpreter);
+      compiler.scopes = scopes;
+      return *compiler.compile_function(function);
+    };
+    return std::make_shared<CompiledBody>(CompiledBody{{}, 0, std::move(pending), nullptr});
+  }
+  auto body = std::make_shared<CompiledBody>(this->compile_body(function, function.body()));
+  if (function.replaced != nullptr)
+    body->replaced = std::make_shared<CompiledBody>(this->compile_body(function, function.replaced->statements));
+  return body;
+}
+
+[[nodiscard]] CompiledBody ClosureCompiler::compile_body(const Function &function,
+                                                         const std::vector<std::shared_ptr<Stmt>> &body) {
+  const bool allocated = !function.params.empty() || declarations(body) > 0;
+  this->begin_scope(allocated);
+  for (const Token &param : function.params)
+    (void)this->declare(param.lexeme);
+  std::vector<Execution> statements = this->compile(body);
+  const std::size_t slots = allocated ? this->scopes.back().slots.size() : 0;
+  this->end_scope();
+  return CompiledBody{std::move(statements), slots, nullptr, nullptr};
+}
+
+void ClosureCompiler::begin_scope(bool allocated) {
+  this->scopes.push_back(CompileScope{{}, allocated});
+}
+
+void ClosureCompiler::end_scope() {
+  this->scopes.pop_back();
+}
+
+[[nodiscard]] std::size_t ClosureCompiler::declare(const std::string &name) {
+  auto &slots = this->scopes.back().slots;
+  return slots.try_emplace(name, slots.size()).first->second;
+}
+
+// translates a resolver depth into the number of allocated scopes to walk.
+[[nodiscard]] ClosureCompiler::Location ClosureCompiler::locate(const std::string &name, int depth) const {
+  const std::size_t target = this->scopes.size() - 1 - depth;
+  int hops = 0;
+  for (std::size_t i = target + 1; i < this->scopes.size(); ++i)
+    hops += this->scopes[i].allocated;
+  return Location{hops, this->scopes[target].slots.at(name)};
+}
+
+[[nodiscard]] std::size_t ClosureCompiler::declarations(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  std::size_t count = 0;
+  for (const std::shared_ptr<Stmt> &stmt : statements)
+    count += stmt->kind == StmtKind::VAR || stmt->kind == StmtKind::FUNCTION || stmt->kind == StmtKind::CLASS;
+  return count;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Block> stmt) {
+  Execution original = this->compile_block(stmt->statements);
+  if (stmt->replaced == nullptr) {
+    this->execution = std::move(original);
+    return nullptr;
+  }
+  Execution replaced = this->compile_block(stmt->replaced->statements);
+  this->execution = [&interpreter = this->interpreter, replacement = stmt->replaced,
+                     original = std::move(original), replaced = std::move(replaced)](Frame &frame) {
+    return interpreter.replaceable(*replacement) ? replaced(frame) : original(frame);
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Execution ClosureCompiler::compile_block(const std::vector<std::shared_ptr<Stmt>> &block) {
+  const bool allocated = declarations(block) > 0;
+  this->begin_scope(allocated);
+  std::vector<Execution> statements = this->compile(block);
+  const std::size_t slots = this->scopes.back().slots.size();
+  this->end_scope();
+  if (!allocated) {
+    return [statements = std::move(statements)](Frame &frame) {
+      for (const Execution &statement : statements)
+        if (statement(frame))
+          return true;
+      return false;
+    };
+  }
+  return [statements = std::move(statements), slots](Frame &frame) {
+    std::shared_ptr<Scope> enclosing = frame.scope;
+    frame.scope = std::make_shared<Scope>(Scope{std::vector<Object>(slots), enclosing});
+    for (const Execution &statement : statements) {
+      if (statement(frame)) {
+        frame.scope = std::move(enclosing);
+        return true;
+      }
+    }
+    frame.scope = std::move(enclosing);
+    return false;
+  };
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Class> stmt) {
+  Evaluation superclass;
+  if (stmt->superclass != nullptr)
+    superclass = this->compile(stmt->superclass);
+  const bool global = this->scopes.empty();
+  const std::size_t local = global ? 0 : this->declare(stmt->name.lexeme);
+  if (stmt->superclass != nullptr) {
+    this->begin_scope(true);
+    (void)this->declare("super");
+  }
+  this->begin_scope(true);
+  (void)this->declare("this");
+  std::vector<std::pair<std::shared_ptr<Function>, std::shared_ptr<CompiledBody>>> methods;
+  for (const std::shared_ptr<Function> &method : stmt->methods)
+    methods.emplace_back(method, this->compile_function(*method));
+  this->end_scope();
+  if (stmt->superclass != nullptr)
+    this->end_scope();
+  this->execution = [stmt, superclass = std::move(superclass), methods = std::move(methods), global, local,
+                     &globals = this->interpreter.global_slots](Frame &frame) {
+    Object super_value;
+    std::shared_ptr<LoxClass> superklass;
+    if (superclass) {
+      super_value = superclass(frame);
+      if (super_value.index() != LoxClassIndex)
+        throw RuntimeError(stmt->superclass->name, "superclass must be a class.");
+      superklass = std::get<LoxClassIndex>(super_value);
+    }
+    if (global)
+      globals.define(stmt->slot, nullptr);
+    else
+      frame.scope->slots[local] = nullptr;
+    std::shared_ptr<Scope> scope = frame.scope;
+    if (superklass != nullptr)
+      scope = std::make_shared<Scope>(Scope{{std::move(super_value)}, std::move(scope)});
+    std::map<std::string, std::shared_ptr<LoxFunction>> functions;
+    for (const auto &[method, body] : methods)
+      functions[method->name.lexeme] = std::make_shared<ClosureFunction>(method, body, scope, method->name.lexeme == "init");
+    auto klass = std::make_shared<LoxClass>(stmt->name.lexeme, std::move(superklass), std::move(functions));
+    if (global)
+      globals.define(stmt->slot, std::move(klass));
+    else
+      frame.scope->slots[local] = std::move(klass);
+    return false;
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Expression> stmt) {
+  this->execution = [expression = this->compile(stmt->expression)](Frame &frame) {
+    (void)expression(frame);
+    return false;
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Function> stmt) {
+  // declared before the body is compiled, which may call it recursively.
+  const bool global = this->scopes.empty();
+  const std::size_t local = global ? 0 : this->declare(stmt->name.lexeme);
+  std::shared_ptr<CompiledBody> body = this->compile_function(*stmt);
+  if (global) {
+    this->execution = [stmt, body = std::move(body), &globals = this->interpreter.global_slots](Frame &frame) {
+      globals.define(stmt->slot, std::make_shared<ClosureFunction>(stmt, body, frame.scope, false));
+      return false;
+    };
+  } else {
+    this->execution = [stmt, body = std::move(body), local](Frame &frame) {
+      frame.scope->slots[local] = std::make_shared<ClosureFunction>(stmt, body, frame.scope, false);
+      return false;
+    };
+  }
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<If> stmt) {
+  Evaluation condition = this->compile(stmt->condition);
+  Execution then_branch = this->compile(stmt->then_branch);
+  Execution else_branch;
+  if (stmt->else_branch != nullptr)
+    else_branch = this->compile(stmt->else_branch);
+  this->execution = [condition = std::move(condition), then_branch = std::move(then_branch),
+                     else_branch = std::move(else_branch), &interpreter = this->interpreter](Frame &frame) {
+    if (interpreter.is_truthy(condition(frame)))
+      return then_branch(frame);
+    if (else_branch)
+      return else_branch(frame);
+    return false;
+  };
+  return nullptr;
+}
+
+// a module is compiled into the importing program at the point of its import
+// and guarded so that it runs once per interpreter.
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Import> stmt) {
+  if (!this->importing.insert(stmt->module).second) {
+    this->execution = [](Frame &) { return false; };
+    return nullptr;
+  }
+  std::vector<CompileScope> enclosing = std::move(this->scopes);
+  this->scopes.clear();
+  std::vector<Execution> statements = this->compile(this->interpreter.modules.at(stmt->module)->statements);
+  this->scopes = std::move(enclosing);
+  this->importing.erase(stmt->module);
+  this->execution = [statements = std::move(statements), module = stmt->module,
+                     &interpreter = this->interpreter](Frame &) {
+    if (!interpreter.imported.insert(module).second)
+      return false;
+    Frame frame{nullptr, nullptr};
+    for (const Execution &statement : statements)
+      (void)statement(frame);
+    return false;
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Print> stmt) {
+  this->execution = [expression = this->compile(stmt->expression), &interpreter = this->interpreter](Frame &frame) {
+    interpreter.print(expression(frame));
+    return false;
+  };
+  return nullptr;
+}
+
+// wraps value with the runtime check the TypeChecker left to an annotation.
+[[nodiscard]] static Evaluation checked(Evaluation value, ValueType type, const Token &token, std::string subject) {
+  if (type == ValueType::ANY)
+    return value;
+  return [value = std::move(value), type, &token, subject = std::move(subject)](Frame &frame) {
+    Object result = value(frame);
+    check_type(token, subject, type, result);
+    return result;
+  };
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Return> stmt) {
+  if (stmt->value == nullptr) {
+    this->execution = [](Frame &frame) {
+      frame.result = nullptr;
+      return true;
+    };
+    return nullptr;
+  }
+  this->execution = [value = checked(this->compile(stmt->value), stmt->check, stmt->keyword, "return value")](Frame &frame) {
+    frame.result = value(frame);
+    return true;
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Var> stmt) {
+  Evaluation value = [](Frame &) -> Object { return nullptr; };
+  if (stmt->initializer != nullptr)
+    value = checked(this->compile(stmt->initializer), stmt->check, stmt->name, "'" + stmt->name.lexeme + "'");
+  if (this->scopes.empty()) {
+    this->execution = [slot = stmt->slot, value = std::move(value), type = stmt->type,
+                       &globals = this->interpreter.global_slots](Frame &frame) {
+      globals.define(slot, value(frame), type);
+      return false;
+    };
+    return nullptr;
+  }
+  this->execution = [local = this->declare(stmt->name.lexeme), value = std::move(value)](Frame &frame) {
+    frame.scope->slots[local] = value(frame);
+    return false;
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<While> stmt) {
+  this->execution = [condition = this->compile(stmt->condition), body = this->compile(stmt->body),
+                     &interpreter = this->interpreter](Frame &frame) {
+    while (interpreter.is_truthy(condition(frame)))
+      if (body(frame))
+        return true;
+    return false;
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Assign> expr) {
+  Evaluation value = checked(this->compile(expr->value), expr->check, expr->name, "'" + expr->name.lexeme + "'");
+  if (expr->depth < 0) {
+    this->evaluation = [value = std::move(value), slot = expr->slot, &name = expr->name,
+                        &globals = this->interpreter.global_slots](Frame &frame) {
+      Object result = value(frame);
+      globals.assign(slot, name, result);
+      return result;
+    };
+    return nullptr;
+  }
+  const Location location = this->locate(expr->name.lexeme, expr->depth);
+  this->evaluation = [value = std::move(value), location](Frame &frame) {
+    Object result = value(frame);
+    ancestor(frame.scope.get(), location.hops)->slots[location.slot] = result;
+    return result;
+  };
+  return nullptr;
+}
+
+// builds the closure of a numeric operator; the operation is a lambda so it
+// is inlined into the closure body. known operands skip the tag check.
+template <typename Operation>
+[[nodiscard]] static Evaluation numeric(Evaluation left, Evaluation right, const Token &op, bool known,
+                                        Operation operation) {
+  if (known)
+    return [left = std::move(left), right = std::move(right), operation](Frame &frame) -> Object {
+      // function arguments are evaluated in no particular order.
+      Object a = left(frame);
+      return operation(a, right(frame));
+    };
+  return [left = std::move(left), right = std::move(right), &op, operation](Frame &frame) -> Object {
+    Object a = left(frame), b = right(frame);
+    if (!is_number(a) || !is_number(b))
+      throw RuntimeError(op, "operands must be numbers.");
+    return operation(a, b);
+  };
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Binary> expr) {
+  Evaluation left = this->compile(expr->left), right = this->compile(expr->right);
+  const Token &op = expr->op;
+  switch (op.type) {
+  case TokenType::BANG_EQUAL:
+  case TokenType::EQUAL_EQUAL: {
+    this->evaluation = [left = std::move(left), right = std::move(right), equal = op.type == TokenType::EQUAL_EQUAL,
+                        &interpreter = this->interpreter](Frame &frame) -> Object {
+      Object a = left(frame), b = right(frame);
+      return interpreter.is_equal(a, b) == equal;
+    };
+    break;
+  }
+  case TokenType::GREATER: {
+    this->evaluation = numeric(std::move(left), std::move(right), op, expr->numeric, [](const Object &a, const Object &b) -> Object {
+      return number_less(b, a);
+    });
+    break;
+  }
+  case TokenType::GREATER_EQUAL: {
+    this->evaluation = numeric(std::move(left), std::move(right), op, expr->numeric, [](const Object &a, const Object &b) -> Object {
+      return number_less_equal(b, a);
+    });
+    break;
+  }
+  case TokenType::LESS: {
+    this->evaluation = numeric(std::move(left), std::move(right), op, expr->numeric, [](const Object &a, const Object &b) -> Object {
+      return number_less(a, b);
+    });
+    break;
+  }
+  case TokenType::LESS_EQUAL: {
+    this->evaluation = numeric(std::move(left), std::move(right), op, expr->numeric, [](const Object &a, const Object &b) -> Object {
+      return number_less_equal(a, b);
+    });
+    break;
+  }
+  case TokenType::MINUS: {
+    this->evaluation = numeric(std::move(left), std::move(right), op, expr->numeric, [](const Object &a, const Object &b) {
+      return number_subtract(a, b);
+    });
+    break;
+  }
+  case TokenType::SLASH: {
+    this->evaluation = numeric(std::move(left), std::move(right), op, expr->numeric, [](const Object &a, const Object &b) {
+      return number_divide(a, b);
+    });
+    break;
+  }
+  case TokenType::STAR: {
+    this->evaluation = numeric(std::move(left), std::move(right), op, expr->numeric, [](const Object &a, const Object &b) {
+      return number_multiply(a, b);
+    });
+    break;
+  }
+  case TokenType::PLUS: {
+    if (expr->numeric) {
+      this->evaluation = [left = std::move(left), right = std::move(right)](Frame &frame) -> Object {
+        Object a = left(frame);
+        return number_add(a, right(frame));
+      };
+      break;
+    }
+    this->evaluation = [left = std::move(left), right = std::move(right), &op](Frame &frame) -> Object {
+      Object a = left(frame), b = right(frame);
+      if (is_number(a) && is_number(b))
+        return number_add(a, b);
+      if (a.index() == StringIndex && b.index() == StringIndex)
+        return std::get<StringIndex>(a) + std::get<StringIndex>(b);
+      throw RuntimeError{op, "operands must be two numbers or two strings."};
+    };
+    break;
+  }
+  default: {
+    this->evaluation = [](Frame &) -> Object { return nullptr; };
+  }
+  }
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Call> expr) {
+  std::vector<Evaluation> arguments;
+  arguments.reserve(expr->arguments.size());
+  for (const std::shared_ptr<Expr> &argument : expr->arguments)
+    arguments.push_back(this->compile(argument));
+  if (expr->inlined != nullptr && this->compile_inlined(expr, arguments))
+    return nullptr;
+  this->evaluation = [callee = this->compile(expr->callee), arguments = std::move(arguments), &paren = expr->paren,
+                      &interpreter = this->interpreter](Frame &frame) {
+    Object value = callee(frame);
+    std::vector<Object> values;
+    values.reserve(arguments.size());
+    for (const Evaluation &argument : arguments)
+      values.push_back(argument(frame));
+    return call_value(interpreter, value, std::move(values), paren);
+  };
+  return nullptr;
+}
+
+// the returned expression is compiled once per function, in a scope of the
+// parameters; it reads nothing but them and globals, so that scope is all
+// the frame needs. returns false for a call within the expression itself,
+// which stays a call.
+[[nodiscard]] bool ClosureCompiler::compile_inlined(const std::shared_ptr<Call> &expr,
+                                                    std::vector<Evaluation> &arguments) {
+  const InlinedCall &inlined = *expr->inlined;
+  auto [it, inserted] = this->inlined.try_emplace(inlined.function.get(), std::make_shared<Evaluation>());
+  std::shared_ptr<const Evaluation> value = it->second;
+  if (!inserted && !*value)
+    return false;
+  if (inserted) {
+    if (inlined.value == nullptr)
+      *it->second = [](Frame &) -> Object { return nullptr; };
+    else {
+      this->begin_scope(!inlined.function->params.empty());
+      for (const Token &param : inlined.function->params)
+        (void)this->declare(param.lexeme);
+      *it->second = this->compile(inlined.value);
+      this->end_scope();
+    }
+  }
+  this->evaluation = [callee = this->compile(expr->callee), arguments = std::move(arguments), value = std::move(value),
+                      &function = *inlined.function, &paren = expr->paren,
+                      &interpreter = this->interpreter](Frame &frame) {
+    Object target = callee(frame);
+    std::vector<Object> values;
+    values.reserve(arguments.size());
+    for (const Evaluation &argument : arguments)
+      values.push_back(argument(frame));
+    if (target.index() == LoxFunctionIndex && std::get<LoxFunctionIndex>(target)->declared_by(function)) {
+      interpreter.check_stack(function.name);
+      Frame inlined{values.empty() ? nullptr : std::make_shared<Scope>(Scope{std::move(values), nullptr}), nullptr};
+      return (*value)(inlined);
+    }
+    return call_value(interpreter, target, std::move(values), paren);
+  };
+  return true;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Get> expr) {
+  this->evaluation = [object = this->compile(expr->object), &name = expr->name](Frame &frame) {
+    Object value = object(frame);
+    if (value.index() != LoxInstanceIndex)
+      throw RuntimeError(name, "only instances have properties.");
+    return std::get<LoxInstanceIndex>(value)->get(name);
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Grouping> expr) {
+  this->evaluation = this->compile(expr->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Literal> expr) {
+  this->evaluation = [value = expr->value](Frame &) { return value; };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Logical> expr) {
+  Evaluation left = this->compile(expr->left), right = this->compile(expr->right);
+  if (expr->op.type == TokenType::OR) {
+    this->evaluation = [left = std::move(left), right = std::move(right), &interpreter = this->interpreter](Frame &frame) {
+      Object value = left(frame);
+      if (interpreter.is_truthy(value))
+        return value;
+      return right(frame);
+    };
+  } else {
+    this->evaluation = [left = std::move(left), right = std::move(right), &interpreter = this->interpreter](Frame &frame) {
+      Object value = left(frame);
+      if (!interpreter.is_truthy(value))
+        return value;
+      return right(frame);
+    };
+  }
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Set> expr) {
+  this->evaluation = [object = this->compile(expr->object), value = this->compile(expr->value), &name = expr->name](Frame &frame) {
+    Object instance = object(frame);
+    if (instance.index() != LoxInstanceIndex)
+      throw RuntimeError(name, "only instances have fields.");
+    Object result = value(frame);
+    std::get<LoxInstanceIndex>(instance)->set(name, result);
+    return result;
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Super> expr) {
+  this->evaluation = [superclass = this->locate("super", expr->depth), object = this->locate("this", expr->depth - 1),
+                      &method = expr->method](Frame &frame) -> Object {
+    Scope *scope = frame.scope.get();
+    auto klass = std::get<LoxClassIndex>(ancestor(scope, superclass.hops)->slots[superclass.slot]);
+    auto instance = std::get<LoxInstanceIndex>(ancestor(scope, object.hops)->slots[object.slot]);
+    std::shared_ptr<LoxFunction> function = klass->find_method(method.lexeme);
+    if (function == nullptr)
+      throw RuntimeError(method, "undefined property '" + method.lexeme + "'.");
+    return function->bind(std::move(instance));
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<This> expr) {
+  this->evaluation = [location = this->locate("this", expr->depth)](Frame &frame) {
+    return ancestor(frame.scope.get(), location.hops)->slots[location.slot];
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Unary> expr) {
+  Evaluation right = this->compile(expr->right);
+  if (expr->op.type == TokenType::BANG) {
+    this->evaluation = [right = std::move(right), &interpreter = this->interpreter](Frame &frame) -> Object {
+      return !interpreter.is_truthy(right(frame));
+    };
+    return nullptr;
+  }
+  if (expr->numeric) {
+    this->evaluation = [right = std::move(right)](Frame &frame) {
+      return number_negate(right(frame));
+    };
+    return nullptr;
+  }
+  this->evaluation = [right = std::move(right), &op = expr->op](Frame &frame) {
+    Object value = right(frame);
+    if (!is_number(value))
+      throw RuntimeError(op, "operand must be a number.");
+    return number_negate(value);
+  };
+  return nullptr;
+}
+
+[[nodiscard]] Object ClosureCompiler::visit(std::shared_ptr<Variable> expr) {
+  if (expr->depth < 0) {
+    this->evaluation = [slot = expr->slot, &name = expr->name, &globals = this->interpreter.global_slots](Frame &) {
+      return globals.get(slot, name);
+    };
+    return nullptr;
+  }
+  // the two innermost scopes hold most accesses and skip the walk.
+  const Location location = this->locate(expr->name.lexeme, expr->depth);
+  if (location.hops == 0)
+    this->evaluation = [slot = location.slot](Frame &frame) { return frame.scope->slots[slot]; };
+  else if (location.hops == 1)
+    this->evaluation = [slot = location.slot](Frame &frame) { return frame.scope->enclosing->slots[slot]; };
+  else
+    this->evaluation = [location](Frame &frame) {
+      return ancestor(frame.scope.get(), location.hops)->slots[location.slot];
+    };
+  return nullptr;
+}
+}// namespace loxplusplus
@@ -0,0 +1,385 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <algorithm>
+
+#include "../include/dead_code_eliminator.hpp"
+
+namespace loxplusplus {
+void DeadCodeEliminator::eliminate(std::vector<std::shared_ptr<Stmt>> &statements) {
+  statements = this->prune(statements, false);
+}
+
+void DeadCodeEliminator::eliminate_function(std::vector<std::shared_ptr<Stmt>> &body) {
+  body = this->prune(body, true);
+}
+
+void DeadCodeEliminator::eliminate_globals(std::vector<std::shared_ptr<Stmt>> &statements, const Modules &modules) {
+  Mentions mentions;
+  this->opaque = false;
+  this->assigned.clear();
+  for (const std::shared_ptr<Stmt> &stmt : statements)
+    this->count(stmt, mentions);
+  for (const auto &[path, module] : modules)
+    if (module != nullptr)
+      for (const std::shared_ptr<Stmt> &stmt : module->statements)
+        this->count(stmt, mentions);
+  if (this->opaque)
+    return;
+
+  // the declarations of each name, in the order the program first declares
+  // them. a name with one declaration that may fail stays declared.
+  std::unordered_map<std::string, std::vector<std::size_t>> declarations;
+  std::vector<std::string> names;
+  for (std::size_t i = 0; i < statements.size(); ++i) {
+    const Token *name = declared(statements[i]);
+    if (name == nullptr)
+      continue;
+    std::vector<std::size_t> &indices = declarations[name->lexeme];
+    if (indices.empty())
+      names.push_back(name->lexeme);
+    indices.push_back(i);
+  }
+  std::unordered_set<std::string> kept;
+  for (std::size_t i = 0; i < statements.size(); ++i) {
+    const Token *name = declared(statements[i]);
+    if (name != nullptr && removable(statements[i]) == nullptr && !this->subclass(statements, declarations, i))
+      kept.insert(name->lexeme);
+  }
+
+  // drops a name while the program names it only inside its own
+  // declarations, and with it what those name.
+  std::vector<Mentions> own(statements.size());
+  for (const auto &[name, indices] : declarations)
+    for (std::size_t index : indices)
+      this->count(statements[index], own[index]);
+  std::vector<bool> removed(statements.size(), false);
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (const std::string &name : names) {
+      const std::vector<std::size_t> &indices = declarations[name];
+      if (kept.contains(name) || removed[indices.front()])
+        continue;
+      int self = 0;
+      for (std::size_t index : indices)
+        if (auto it = own[index].find(name); it != own[index].end())
+          self += it->second;
+      if (mentions[name] > self)
+        continue;
+      for (std::size_t index : indices) {
+        removed[index] = true;
+        for (const auto &[mentioned, times] : own[index])
+          mentions[mentioned] -= times;
+        switch (statements[index]->kind) {
+        case StmtKind::CLASS: this->classes.push_back(name); break;
+        case StmtKind::FUNCTION: this->functions.push_back(name); break;
+        default: this->variables.push_back(name); break;
+        }
+      }
+      changed = true;
+    }
+  }
+  std::size_t index = 0;
+  std::erase_if(statements, [&removed, &index](const std::shared_ptr<Stmt> &) { return removed[index++]; });
+}
+
+[[nodiscard]] std::string DeadCodeEliminator::report() const {
+  auto list = [](const char *kind, const std::vector<std::string> &names) {
+    std::string text = std::string(kind) + ": " + std::to_string(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i)
+      text += (i == 0 ? " (" : ", ") + names[i];
+    return text + (names.empty() ? "\n" : ")\n");
+  };
+  return "unreachable statements: " + std::to_string(this->unreachable) + "\n" +
+         "unused locals: " + std::to_string(this->locals) + "\n" +
+         list("unused globals", this->variables) +
+         list("unused functions", this->functions) +
+         list("unused classes", this->classes);
+}
+
+// prunes the statements nested in each statement of a list, drops those
+// following one that always returns and, in a local scope, declarations
+// nothing after them names. going from the last statement up, a declaration
+// only named by an unused one goes too.
+[[nodiscard]] std::vector<std::shared_ptr<Stmt>> DeadCodeEliminator::prune(
+  const std::vector<std::shared_ptr<Stmt>> &statements, bool local) {
+  std::vector<std::shared_ptr<Stmt>> result;
+  result.reserve(statements.size());
+  for (std::size_t i = 0; i < statements.size(); ++i) {
+    result.push_back(this->prune(statements[i]));
+    if (terminates(result.back())) {
+      this->unreachable += statements.size() - i - 1;
+      break;
+    }
+  }
+  if (!local)
+    return result;
+  Mentions mentions;
+  std::vector<std::shared_ptr<Stmt>> kept;
+  kept.reserve(result.size());
+  for (auto stmt = result.rbegin(); stmt != result.rend(); ++stmt) {
+    if (const Token *name = removable(*stmt); name != nullptr && !mentions.contains(name->lexeme)) {
+      ++this->locals;
+      continue;
+    }
+    this->count(*stmt, mentions);
+    kept.push_back(*stmt);
+  }
+  std::reverse(kept.begin(), kept.end());
+  return kept;
+}
+
+[[nodiscard]] std::shared_ptr<Stmt> DeadCodeEliminator::prune(const std::shared_ptr<Stmt> &stmt) {
+  switch (stmt->kind) {
+  case StmtKind::BLOCK: {
+    auto block = std::static_pointer_cast<Block>(stmt);
+    std::vector<std::shared_ptr<Stmt>> statements = this->prune(block->statements, true);
+    if (statements == block->statements)
+      return stmt;
+    return std::make_shared<Block>(std::move(statements));
+  }
+  case StmtKind::CLASS:
+    for (const std::shared_ptr<Function> &method : std::static_pointer_cast<Class>(stmt)->methods)
+      this->prune(*method);
+    return stmt;
+  case StmtKind::FUNCTION:
+    this->prune(*std::static_pointer_cast<Function>(stmt));
+    return stmt;
+  case StmtKind::IF: {
+    auto branch = std::static_pointer_cast<If>(stmt);
+    std::shared_ptr<Stmt> then_branch = this->prune(branch->then_branch);
+    std::shared_ptr<Stmt> else_branch = branch->else_branch != nullptr ? this->prune(branch->else_branch) : nullptr;
+    if (then_branch == branch->then_branch && else_branch == branch->else_branch)
+      return stmt;
+    return std::make_shared<If>(branch->condition, std::move(then_branch), std::move(else_branch));
+  }
+  case StmtKind::WHILE: {
+    auto loop = std::static_pointer_cast<While>(stmt);
+    std::shared_ptr<Stmt> body = this->prune(loop->body);
+    if (body == loop->body)
+      return stmt;
+    return std::make_shared<While>(loop->condition, std::move(body));
+  }
+  default:
+    return stmt;
+  }
+}
+
+void DeadCodeEliminator::prune(Function &function) {
+  // a deferred body is pruned once it has been parsed.
+  if (function.deferred())
+    return;
+  std::vector<std::shared_ptr<Stmt>> body = this->prune(function.body(), true);
+  if (body != function.body())
+    function.replace_body(std::move(body));
+}
+
+// whether a statement returns on every path through it. the last statement
+// of a pruned block is the only one that can.
+[[nodiscard]] bool DeadCodeEliminator::terminates(const std::shared_ptr<Stmt> &stmt) {
+  switch (stmt->kind) {
+  case StmtKind::BLOCK: {
+    const std::vector<std::shared_ptr<Stmt>> &statements = std::static_pointer_cast<Block>(stmt)->statements;
+    return !statements.empty() && terminates(statements.back());
+  }
+  case StmtKind::IF: {
+    auto branch = std::static_pointer_cast<If>(stmt);
+    return branch->else_branch != nullptr && terminates(branch->then_branch) && terminates(branch->else_branch);
+  }
+  case StmtKind::RETURN:
+    return true;
+  default:
+    return false;
+  }
+}
+
+[[nodiscard]] const Token *DeadCodeEliminator::declared(const std::shared_ptr<Stmt> &stmt) {
+  switch (stmt->kind) {
+  case StmtKind::CLASS: return &std::static_pointer_cast<Class>(stmt)->name;
+  case StmtKind::FUNCTION: return &std::static_pointer_cast<Function>(stmt)->name;
+  case StmtKind::VAR: return &std::static_pointer_cast<Var>(stmt)->name;
+  default: return nullptr;
+  }
+}
+
+// the name a statement declares, when declaring it has no effect but
+// defining the name: a function, a class without a superclass or a variable
+// with a pure initializer that needs no runtime check.
+[[nodiscard]] const Token *DeadCodeEliminator::removable(const std::shared_ptr<Stmt> &stmt) {
+  switch (stmt->kind) {
+  case StmtKind::CLASS: {
+    auto klass = std::static_pointer_cast<Class>(stmt);
+    return klass->superclass == nullptr ? &klass->name : nullptr;
+  }
+  case StmtKind::FUNCTION:
+    return &std::static_pointer_cast<Function>(stmt)->name;
+  case StmtKind::VAR: {
+    auto var = std::static_pointer_cast<Var>(stmt);
+    if (var->check != ValueType::ANY || (var->initializer != nullptr && !pure(var->initializer)))
+      return nullptr;
+    return &var->name;
+  }
+  default:
+    return nullptr;
+  }
+}
+
+// a top-level class whose superclass is a class declared only in front of
+// it and never assigned, so evaluating the superclass cannot fail.
+[[nodiscard]] bool DeadCodeEliminator::subclass(const std::vector<std::shared_ptr<Stmt>> &statements,
+                                                const std::unordered_map<std::string, std::vector<std::size_t>> &declarations,
+                                                std::size_t index) const {
+  if (statements[index]->kind != StmtKind::CLASS)
+    return false;
+  const std::shared_ptr<Variable> &superclass = std::static_pointer_cast<Class>(statements[index])->superclass;
+  if (superclass == nullptr || this->assigned.contains(superclass->name.lexeme))
+    return false;
+  auto found = declarations.find(superclass->name.lexeme);
+  if (found == declarations.end())
+    return false;
+  return std::all_of(found->second.begin(), found->second.end(), [&statements, index](std::size_t declaration) {
+    return declaration < index && statements[declaration]->kind == StmtKind::CLASS;
+  });
+}
+
+// evaluating the expression can neither fail nor have an effect. globals may
+// be undefined, and operators other than equality need operands of the
+// right type unless the type checker proved them numbers.
+[[nodiscard]] bool DeadCodeEliminator::pure(const std::shared_ptr<Expr> &expr) {
+  switch (expr->kind) {
+  case ExprKind::BINARY: {
+    auto binary = std::static_pointer_cast<Binary>(expr);
+    return (binary->numeric || binary->op.type == TokenType::EQUAL_EQUAL || binary->op.type == TokenType::BANG_EQUAL) &&
+           pure(binary->left) && pure(binary->right);
+  }
+  case ExprKind::GROUPING:
+    return pure(std::static_pointer_cast<Grouping>(expr)->expression);
+  case ExprKind::LITERAL:
+  case ExprKind::THIS:
+    return true;
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    return pure(logical->left) && pure(logical->right);
+  }
+  case ExprKind::UNARY: {
+    auto unary = std::static_pointer_cast<Unary>(expr);
+    return (unary->numeric || unary->op.type == TokenType::BANG) && pure(unary->right);
+  }
+  case ExprKind::VARIABLE:
+    return std::static_pointer_cast<Variable>(expr)->depth >= 0;
+  default:
+    return false;
+  }
+}
+
+void DeadCodeEliminator::count(const std::shared_ptr<Stmt> &stmt, Mentions &mentions) {
+  switch (stmt->kind) {
+  case StmtKind::BLOCK:
+    for (const std::shared_ptr<Stmt> &statement : std::static_pointer_cast<Block>(stmt)->statements)
+      this->count(statement, mentions);
+    break;
+  case StmtKind::CLASS: {
+    auto klass = std::static_pointer_cast<Class>(stmt);
+    if (klass->superclass != nullptr)
+      this->count(klass->superclass, mentions);
+    for (const std::shared_ptr<Function> &method : klass->methods)
+      this->count(method, mentions);
+    break;
+  }
+  case StmtKind::EXPRESSION:
+    this->count(std::static_pointer_cast<Expression>(stmt)->expression, mentions);
+    break;
+  case StmtKind::FUNCTION: {
+    auto function = std::static_pointer_cast<Function>(stmt);
+    if (function->deferred()) {
+      this->opaque = true;
+      break;
+    }
+    for (const std::shared_ptr<Stmt> &statement : function->body())
+      this->count(statement, mentions);
+    break;
+  }
+  case StmtKind::IF: {
+    auto branch = std::static_pointer_cast<If>(stmt);
+    this->count(branch->condition, mentions);
+    this->count(branch->then_branch, mentions);
+    if (branch->else_branch != nullptr)
+      this->count(branch->else_branch, mentions);
+    break;
+  }
+  case StmtKind::PRINT:
+    this->count(std::static_pointer_cast<Print>(stmt)->expression, mentions);
+    break;
+  case StmtKind::RETURN:
+    if (auto value = std::static_pointer_cast<Return>(stmt)->value; value != nullptr)
+      this->count(value, mentions);
+    break;
+  case StmtKind::VAR:
+    if (auto initializer = std::static_pointer_cast<Var>(stmt)->initializer; initializer != nullptr)
+      this->count(initializer, mentions);
+    break;
+  case StmtKind::WHILE: {
+    auto loop = std::static_pointer_cast<While>(stmt);
+    this->count(loop->condition, mentions);
+    this->count(loop->body, mentions);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void DeadCodeEliminator::count(const std::shared_ptr<Expr> &expr, Mentions &mentions) {
+  switch (expr->kind) {
+  case ExprKind::ASSIGN: {
+    auto assign = std::static_pointer_cast<Assign>(expr);
+    ++mentions[assign->name.lexeme];
+    this->assigned.insert(assign->name.lexeme);
+    this->count(assign->value, mentions);
+    break;
+  }
+  case ExprKind::BINARY: {
+    auto binary = std::static_pointer_cast<Binary>(expr);
+    this->count(binary->left, mentions);
+    this->count(binary->right, mentions);
+    break;
+  }
+  case ExprKind::CALL: {
+    auto call = std::static_pointer_cast<Call>(expr);
+    this->count(call->callee, mentions);
+    for (const std::shared_ptr<Expr> &argument : call->arguments)
+      this->count(argument, mentions);
+    break;
+  }
+  case ExprKind::GET:
+    this->count(std::static_pointer_cast<Get>(expr)->object, mentions);
+    break;
+  case ExprKind::GROUPING:
+    this->count(std::static_pointer_cast<Grouping>(expr)->expression, mentions);
+    break;
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    this->count(logical->left, mentions);
+    this->count(logical->right, mentions);
+    break;
+  }
+  case ExprKind::SET: {
+    auto set = std::static_pointer_cast<Set>(expr);
+    this->count(set->object, mentions);
+    this->count(set->value, mentions);
+    break;
+  }
+  case ExprKind::UNARY:
+    this->count(std::static_pointer_cast<Unary>(expr)->right, mentions);
+    break;
+  case ExprKind::VARIABLE:
+    ++mentions[std::static_pointer_cast<Variable>(expr)->name.lexeme];
+    break;
+  default:
+    break;
+  }
+}
+}// namespace loxplusplus
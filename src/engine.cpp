@@ -0,0 +1,196 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include "../include/engine.hpp"
+#include "../include/dead_code_eliminator.hpp"
+#include "../include/inliner.hpp"
+#include "../include/ir_optimizer.hpp"
+#include "../include/memoizer.hpp"
+#include "../include/optimizer.hpp"
+#include "../include/parser.hpp"
+#include "../include/resolver.hpp"
+#include "../include/scalar_replacer.hpp"
+#include "../include/scanner.hpp"
+#include "../include/snapshot.hpp"
+#include "../include/transpiler.hpp"
+#include "../include/type_checker.hpp"
+
+namespace loxplusplus {
+Engine::Engine(std::FILE *output, std::ostream &errors)
+    : output{output}, diagnostics{errors, &this->output}, interpreter{this->output, this->diagnostics, this->symbols} {}
+
+Engine::Engine(OutputWriter writer, std::ostream &errors)
+    : output{std::move(writer)}, diagnostics{errors, &this->output}, interpreter{this->output, this->diagnostics, this->symbols} {}
+
+Engine::Result Engine::run(std::string_view source, std::string_view origin) {
+  this->diagnostics.reset();
+  std::optional<std::vector<std::shared_ptr<Stmt>>> statements;
+  if (this->cache.has_value())
+    statements = this->cache->load(source, this->lexicon, this->symbols);
+  if (!statements.has_value()) {
+    statements = compile(source, this->diagnostics, this->lexicon, this->symbols, this->compile_options);
+    if (!statements.has_value())
+      return Result::COMPILE_ERROR;
+    // storing would parse every deferred body; a cached program is rebuilt
+    // without the front-end anyway.
+    if (this->cache.has_value() && !this->compile_options.lazy)
+      this->cache->store(source, *statements);
+  }
+  Modules modules = ModuleCache::load(*statements, std::filesystem::path(origin).parent_path(), this->symbols,
+                                     this->diagnostics);
+  if (this->diagnostics.failed())
+    return Result::COMPILE_ERROR;
+  DeadCodeEliminator eliminator;
+  eliminator.eliminate(*statements);
+  if (this->whole_program)
+    eliminator.eliminate_globals(*statements, modules);
+  if (this->stats)
+    this->diagnostics.note(eliminator.report());
+  this->interpreter.add_modules(std::move(modules));
+  // the order matters: the Optimizer and the Inliner also rewrite the blocks
+  // the ScalarReplacer adds, and the Inliner leaves the functions the
+  // Memoizer gave a table alone.
+  ScalarReplacer replacer(this->lexicon);
+  replacer.replace(*statements);
+  Optimizer optimizer;
+  optimizer.optimize(*statements);
+  // modules are left alone; they are loaded the same way whatever the options.
+  if (this->memoize) {
+    Memoizer memoizer;
+    memoizer.memoize(*statements);
+  }
+  Inliner inliner;
+  inliner.inline_calls(*statements);
+  this->interpreter.interpret(*statements);
+  return this->diagnostics.had_runtime_error ? Result::RUNTIME_ERROR : Result::OK;
+}
+
+Engine::Result Engine::transpile(std::string_view source, std::string_view source_name) {
+  this->diagnostics.reset();
+  std::optional<std::vector<std::shared_ptr<Stmt>>> statements = compile(source, this->diagnostics, this->lexicon, this->symbols, {.dump_ir = this->compile_options.dump_ir});
+  if (!statements.has_value())
+    return Result::COMPILE_ERROR;
+  Modules modules = ModuleCache::load(*statements, std::filesystem::path(source_name).parent_path(), this->symbols,
+                                     this->diagnostics);
+  if (this->diagnostics.failed())
+    return Result::COMPILE_ERROR;
+  Transpiler transpiler;
+  this->output.write(transpiler.transpile(*statements, source_name, modules));
+  return Result::OK;
+}
+
+[[nodiscard]] bool Engine::save_snapshot(const std::string &path) const {
+  return Snapshot::save(path, this->interpreter);
+}
+
+[[nodiscard]] bool Engine::load_snapshot(const std::string &path) {
+  return Snapshot::restore(path, this->interpreter, this->lexicon);
+}
+
+[[nodiscard]] bool Engine::open_output(const std::string &path) {
+  return this->output.open(path);
+}
+
+void Engine::set_line_buffered(bool line_buffered) {
+  this->output.set_line_buffered(line_buffered);
+}
+
+void Engine::flush() {
+  this->output.flush();
+}
+
+void Engine::configure(const EngineOptions &options) {
+  if (options.jit_threshold.has_value())
+    this->enable_jit(*options.jit_threshold);
+  if (options.compile_closures)
+    this->enable_closure_compilation();
+  if (options.cache_directory.has_value())
+    this->enable_cache(*options.cache_directory);
+  if (options.lazy_parsing)
+    this->enable_lazy_parsing();
+  if (options.dump_ir)
+    this->enable_ir_dump();
+  if (options.stats)
+    this->enable_stats();
+  if (options.whole_program)
+    this->enable_whole_program();
+  if (options.memoize)
+    this->enable_memoization();
+}
+
+void Engine::enable_jit(std::size_t threshold) {
+  this->interpreter.enable_jit(threshold);
+}
+
+void Engine::enable_closure_compilation() {
+  this->interpreter.enable_closure_compilation();
+}
+
+void Engine::enable_cache(std::string directory) {
+  this->cache.emplace(std::move(directory));
+}
+
+void Engine::enable_lazy_parsing() {
+  this->compile_options.lazy = true;
+}
+
+void Engine::enable_ir_dump() {
+  this->compile_options.dump_ir = true;
+}
+
+void Engine::enable_stats() {
+  this->stats = true;
+}
+
+void Engine::enable_whole_program() {
+  this->whole_program = true;
+}
+
+void Engine::enable_memoization() {
+  this->memoize = true;
+}
+
+[[nodiscard]] std::optional<std::vector<std::shared_ptr<Stmt>>> Engine::compile(std::string_view source,
+                                                                               Diagnostics &diagnostics,
+                                                                               Lexicon &lexicon,
+                                                                               SymbolTable &symbols,
+                                                                               CompileOptions options) {
+  std::vector<std::shared_ptr<Stmt>> statements;
+  if (options.lazy) {
+    // deferred bodies are parsed after the caller's source is gone, so the
+    // tokens share ownership of a copy their lexemes point into.
+    struct Retained {
+      std::string source;
+      std::vector<SourceToken> tokens;
+    };
+    auto retained = std::make_shared<Retained>(std::string(source));
+    Scanner scanner(retained->source, diagnostics);
+    retained->tokens = scanner.scan_tokens();
+    statements = Parser(std::shared_ptr<const std::vector<SourceToken>>(retained, &retained->tokens), lexicon, symbols, diagnostics).parse();
+  } else {
+    Scanner scanner(source, diagnostics);
+    statements = Parser(scanner.scan_tokens(), lexicon, diagnostics).parse();
+  }
+  if (diagnostics.failed())
+    return std::nullopt;
+  Resolver resolver(diagnostics, symbols);
+  resolver.resolve(statements);
+  if (diagnostics.failed())
+    return std::nullopt;
+  TypeChecker checker(diagnostics);
+  checker.check(statements);
+  if (diagnostics.failed())
+    return std::nullopt;
+  IrOptimizer optimizer(lexicon);
+  if (options.dump_ir)
+    optimizer.enable_dump();
+  if (optimizer.optimize(statements))
+    resolver.resolve(statements);
+  if (options.dump_ir)
+    diagnostics.note(optimizer.report());
+  return statements;
+}
+}// namespace loxplusplus
@@ -16,10 +16,10 @@ Environment::Environment(std::shared_ptr<Environment> enclosing)
 }
 
 [[nodiscard]] Object Environment::get(const Token &name) {
-  if (auto it = this->values.find(name.lexeme); it != this->values.end())
-    return it->second;
-  if (this->enclosing != nullptr)
-    return this->enclosing->get(name);
+  for (Environment *environment = this; environment != nullptr; environment = environment->enclosing.get()) {
+    if (auto it = environment->values.find(name.lexeme); it != environment->values.end())
+      return it->second;
+  }
   throw RuntimeError(name, "undefined variable '" + name.lexeme + "'.");
 }
 
@@ -28,13 +28,11 @@ Environment::Environment(std::shared_ptr<Environment> enclosing)
 }
 
 void Environment::assign(const Token &name, Object value) {
-  if (auto it = this->values.find(name.lexeme); it != this->values.end()) {
-    it->second = value;
-    return;
-  }
-  if (this->enclosing != nullptr) {
-    this->enclosing->assign(name, std::move(value));
-    return;
+  for (Environment *environment = this; environment != nullptr; environment = environment->enclosing.get()) {
+    if (auto it = environment->values.find(name.lexeme); it != environment->values.end()) {
+      it->second = std::move(value);
+      return;
+    }
   }
   throw RuntimeError(name, "undefined variable '" + name.lexeme + "'.");
 }
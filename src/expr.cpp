@@ -11,7 +11,7 @@ Expr::~Expr() {
 }
 
 Assign::Assign(Token name, std::shared_ptr<Expr> value)
-    : name{std::move(name)}, value{std::move(value)} {}
+    : Expr(ExprKind::ASSIGN), name{std::move(name)}, value{std::move(value)} {}
 
 Assign::~Assign() {
 }
@@ -22,7 +22,7 @@ Assign::~Assign() {
 
 Binary::Binary(std::shared_ptr<Expr> left, Token op,
                std::shared_ptr<Expr> right)
-    : left{std::move(left)}, op{std::move(op)}, right{std::move(right)} {
+    : Expr(ExprKind::BINARY), left{std::move(left)}, op{std::move(op)}, right{std::move(right)} {
 }
 
 Binary::~Binary() {
@@ -34,7 +34,7 @@ Binary::~Binary() {
 
 Call::Call(std::shared_ptr<Expr> callee, Token paren,
            std::vector<std::shared_ptr<Expr>> arguments)
-    : callee{std::move(callee)}, paren{std::move(paren)},
+    : Expr(ExprKind::CALL), callee{std::move(callee)}, paren{std::move(paren)},
       arguments{std::move(arguments)} {
 }
 
@@ -46,7 +46,7 @@ Call::~Call() {
 }
 
 Get::Get(std::shared_ptr<Expr> object, Token name)
-    : object{std::move(object)}, name{std::move(name)} {
+    : Expr(ExprKind::GET), object{std::move(object)}, name{std::move(name)} {
 }
 
 Get::~Get() {
@@ -57,7 +57,7 @@ Get::~Get() {
 }
 
 Grouping::Grouping(std::shared_ptr<Expr> expression)
-    : expression{std::move(expression)} {}
+    : Expr(ExprKind::GROUPING), expression{std::move(expression)} {}
 
 Grouping::~Grouping() {
 }
@@ -66,7 +66,7 @@ Grouping::~Grouping() {
   return visitor.visit(shared_from_this());
 }
 
-Literal::Literal(Object value) : value{std::move(value)} {}
+Literal::Literal(Object value) : Expr(ExprKind::LITERAL), value{std::move(value)} {}
 
 Literal::~Literal() {
 }
@@ -77,7 +77,7 @@ Literal::~Literal() {
 
 Logical::Logical(std::shared_ptr<Expr> left, Token op,
                  std::shared_ptr<Expr> right)
-    : left{std::move(left)}, op{std::move(op)}, right{std::move(right)} {}
+    : Expr(ExprKind::LOGICAL), left{std::move(left)}, op{std::move(op)}, right{std::move(right)} {}
 
 Logical::~Logical() {}
 
@@ -86,7 +86,7 @@ Logical::~Logical() {}
 }
 
 Set::Set(std::shared_ptr<Expr> object, Token name, std::shared_ptr<Expr> value)
-    : object{std::move(object)}, name{std::move(name)},
+    : Expr(ExprKind::SET), object{std::move(object)}, name{std::move(name)},
       value{std::move(value)} {}
 
 Set::~Set() {
@@ -97,7 +97,7 @@ Set::~Set() {
 }
 
 Super::Super(Token keyword, Token method)
-    : keyword{std::move(keyword)}, method{std::move(method)} {}
+    : Expr(ExprKind::SUPER), keyword{std::move(keyword)}, method{std::move(method)} {}
 
 Super::~Super() {
 }
@@ -106,7 +106,7 @@ Super::~Super() {
   return visitor.visit(shared_from_this());
 }
 
-This::This(Token keyword) : keyword{std::move(keyword)} {
+This::This(Token keyword) : Expr(ExprKind::THIS), keyword{std::move(keyword)} {
 }
 
 This::~This() {
@@ -117,7 +117,7 @@ This::~This() {
 }
 
 Unary::Unary(Token op, std::shared_ptr<Expr> right)
-    : op{std::move(op)}, right{std::move(right)} {}
+    : Expr(ExprKind::UNARY), op{std::move(op)}, right{std::move(right)} {}
 
 Unary::~Unary() {
 }
@@ -126,7 +126,7 @@ Unary::~Unary() {
   return visitor.visit(shared_from_this());
 }
 
-Variable::Variable(Token name) : name{std::move(name)} {}
+Variable::Variable(Token name) : Expr(ExprKind::VARIABLE), name{std::move(name)} {}
 
 Variable::~Variable() {
 }
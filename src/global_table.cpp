@@ -0,0 +1,38 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include "../include/global_table.hpp"
+
+namespace loxplusplus {
+void GlobalTable::define(int symbol, Object value, ValueType type) {
+  if (symbol >= this->slots.size()) {
+    this->slots.resize(symbol + 1);
+    this->types.resize(symbol + 1);
+  }
+  this->slots[symbol] = std::move(value);
+  this->types[symbol] = type;
+}
+
+void GlobalTable::assign(int symbol, const Token &name, Object value) {
+  if (symbol >= this->slots.size() || !this->slots[symbol].has_value())
+    throw RuntimeError(name, "undefined variable '" + name.lexeme + "'.");
+  if (this->types[symbol] != ValueType::ANY)
+    check_type(name, "'" + name.lexeme + "'", this->types[symbol], value);
+  *this->slots[symbol] = std::move(value);
+}
+
+[[nodiscard]] const Object &GlobalTable::get(int symbol, const Token &name) const {
+  if (const Object *value = this->find(symbol); value != nullptr)
+    return *value;
+  throw RuntimeError(name, "undefined variable '" + name.lexeme + "'.");
+}
+
+[[nodiscard]] const Object *GlobalTable::find(int symbol) const {
+  if (symbol < 0 || symbol >= this->slots.size() || !this->slots[symbol].has_value())
+    return nullptr;
+  return &*this->slots[symbol];
+}
+}// namespace loxplusplus
@@ -0,0 +1,273 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include "../include/inliner.hpp"
+
+namespace loxplusplus {
+void Inliner::inline_calls(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  for (const std::shared_ptr<Stmt> &stmt : statements)
+    if (stmt->kind == StmtKind::FUNCTION)
+      if (auto function = std::static_pointer_cast<Function>(stmt); inlinable(*function))
+        this->candidates[function->name.lexeme] = function;
+  for (const auto &[name, count] : top_level_declarations(statements))
+    if (count > 1)
+      this->candidates.erase(name);
+  if (this->candidates.empty())
+    return;
+
+  for (const std::shared_ptr<Stmt> &stmt : statements)
+    this->scan(stmt);
+  std::unordered_map<const Function *, std::shared_ptr<InlinedCall>> inlined;
+  for (const std::shared_ptr<Call> &call : this->calls) {
+    const std::string &name = std::static_pointer_cast<Variable>(call->callee)->name.lexeme;
+    const auto candidate = this->candidates.find(name);
+    if (candidate == this->candidates.end() || this->assigned.contains(name) ||
+        candidate->second->params.size() != call->arguments.size())
+      continue;
+    std::shared_ptr<InlinedCall> &target = inlined[candidate->second.get()];
+    if (target == nullptr)
+      target = std::make_shared<InlinedCall>(InlinedCall{candidate->second, nullptr});
+    call->inlined = target;
+  }
+  // bound once every call is marked, so the copies carry the calls they inline.
+  for (const auto &[function, call] : inlined)
+    if (const std::shared_ptr<Expr> &value = std::static_pointer_cast<Return>(function->body().front())->value;
+        value != nullptr)
+      call->value = bind(value, *function);
+  this->candidates.clear();
+  this->assigned.clear();
+  this->calls.clear();
+}
+
+// a body that is one return statement evaluates to an expression without
+// executing statements. annotations that need a runtime check keep the call,
+// as do memoized functions, whose calls consult their table.
+[[nodiscard]] bool Inliner::inlinable(const Function &function) {
+  if (function.deferred() || function.memo != nullptr)
+    return false;
+  const std::vector<std::shared_ptr<Stmt>> &body = function.body();
+  if (body.size() != 1 || body.front()->kind != StmtKind::RETURN ||
+      std::static_pointer_cast<Return>(body.front())->check != ValueType::ANY)
+    return false;
+  for (ValueType type : function.param_types)
+    if (type != ValueType::ANY)
+      return false;
+  return true;
+}
+
+// a copy of a returned expression whose reads and assignments of parameters
+// hold their position in slot, so engines take them from the arguments. the
+// body of a top-level function sees no other locals.
+[[nodiscard]] std::shared_ptr<Expr> Inliner::bind(const std::shared_ptr<Expr> &expr, const Function &function) {
+  switch (expr->kind) {
+  case ExprKind::ASSIGN: {
+    auto assign = std::static_pointer_cast<Assign>(expr);
+    auto result = std::make_shared<Assign>(assign->name, bind(assign->value, function));
+    result->depth = assign->depth;
+    result->slot = assign->depth < 0 ? assign->slot : position(function, assign->name);
+    result->check = assign->check;
+    return result;
+  }
+  case ExprKind::BINARY: {
+    auto binary = std::static_pointer_cast<Binary>(expr);
+    auto result = std::make_shared<Binary>(bind(binary->left, function), binary->op, bind(binary->right, function));
+    result->numeric = binary->numeric;
+    return result;
+  }
+  case ExprKind::CALL: {
+    auto call = std::static_pointer_cast<Call>(expr);
+    std::vector<std::shared_ptr<Expr>> arguments;
+    for (const std::shared_ptr<Expr> &argument : call->arguments)
+      arguments.push_back(bind(argument, function));
+    auto result = std::make_shared<Call>(bind(call->callee, function), call->paren, std::move(arguments));
+    result->inlined = call->inlined;
+    return result;
+  }
+  case ExprKind::GET: {
+    auto get = std::static_pointer_cast<Get>(expr);
+    return std::make_shared<Get>(bind(get->object, function), get->name);
+  }
+  case ExprKind::GROUPING:
+    return std::make_shared<Grouping>(bind(std::static_pointer_cast<Grouping>(expr)->expression, function));
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    return std::make_shared<Logical>(bind(logical->left, function), logical->op, bind(logical->right, function));
+  }
+  case ExprKind::SET: {
+    auto set = std::static_pointer_cast<Set>(expr);
+    return std::make_shared<Set>(bind(set->object, function), set->name, bind(set->value, function));
+  }
+  case ExprKind::UNARY: {
+    auto unary = std::static_pointer_cast<Unary>(expr);
+    auto result = std::make_shared<Unary>(unary->op, bind(unary->right, function));
+    result->numeric = unary->numeric;
+    return result;
+  }
+  case ExprKind::VARIABLE: {
+    auto variable = std::static_pointer_cast<Variable>(expr);
+    if (variable->depth < 0)
+      return expr;
+    auto result = std::make_shared<Variable>(variable->name);
+    result->depth = variable->depth;
+    result->slot = position(function, variable->name);
+    return result;
+  }
+  default:
+    // literals; this and super do not occur outside methods.
+    return expr;
+  }
+}
+
+[[nodiscard]] int Inliner::position(const Function &function, const Token &name) {
+  for (std::size_t i = 0; i < function.params.size(); ++i)
+    if (function.params[i].lexeme == name.lexeme)
+      return static_cast<int>(i);
+  return -1;
+}
+
+void Inliner::scan(const std::shared_ptr<Stmt> &stmt) {
+  (void)dispatch(*this, stmt);
+}
+
+void Inliner::scan(const std::shared_ptr<Expr> &expr) {
+  (void)dispatch(*this, expr);
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Block> stmt) {
+  for (const std::shared_ptr<Stmt> &statement : stmt->statements)
+    this->scan(statement);
+  if (stmt->replaced != nullptr)
+    for (const std::shared_ptr<Stmt> &statement : stmt->replaced->statements)
+      this->scan(statement);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Class> stmt) {
+  if (stmt->superclass != nullptr)
+    this->scan(stmt->superclass);
+  for (const std::shared_ptr<Function> &method : stmt->methods)
+    this->scan(method);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Expression> stmt) {
+  this->scan(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Function> stmt) {
+  // a deferred body is not parsed for this; the runtime check covers
+  // whatever it assigns.
+  if (stmt->deferred())
+    return nullptr;
+  for (const std::shared_ptr<Stmt> &statement : stmt->body())
+    this->scan(statement);
+  if (stmt->replaced != nullptr)
+    for (const std::shared_ptr<Stmt> &statement : stmt->replaced->statements)
+      this->scan(statement);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<If> stmt) {
+  this->scan(stmt->condition);
+  this->scan(stmt->then_branch);
+  if (stmt->else_branch != nullptr)
+    this->scan(stmt->else_branch);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Import> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Print> stmt) {
+  this->scan(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Return> stmt) {
+  if (stmt->value != nullptr)
+    this->scan(stmt->value);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Var> stmt) {
+  if (stmt->initializer != nullptr)
+    this->scan(stmt->initializer);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<While> stmt) {
+  this->scan(stmt->condition);
+  this->scan(stmt->body);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Assign> expr) {
+  if (expr->depth < 0)
+    this->assigned.insert(expr->name.lexeme);
+  this->scan(expr->value);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Binary> expr) {
+  this->scan(expr->left);
+  this->scan(expr->right);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Call> expr) {
+  if (expr->callee->kind == ExprKind::VARIABLE && std::static_pointer_cast<Variable>(expr->callee)->depth < 0)
+    this->calls.push_back(expr);
+  this->scan(expr->callee);
+  for (const std::shared_ptr<Expr> &argument : expr->arguments)
+    this->scan(argument);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Get> expr) {
+  this->scan(expr->object);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Grouping> expr) {
+  this->scan(expr->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Literal> expr) {
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Logical> expr) {
+  this->scan(expr->left);
+  this->scan(expr->right);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Set> expr) {
+  this->scan(expr->object);
+  this->scan(expr->value);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Super> expr) {
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<This> expr) {
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Unary> expr) {
+  this->scan(expr->right);
+  return nullptr;
+}
+
+[[nodiscard]] Object Inliner::visit(std::shared_ptr<Variable> expr) {
+  return nullptr;
+}
+}// namespace loxplusplus
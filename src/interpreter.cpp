@@ -6,39 +6,93 @@
 
 #include "../include/interpreter.hpp"
 
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
 namespace loxplusplus {
-Interpreter::Interpreter() {
+// lowest address of the calling thread's stack, or 0 if it is unknown.
+[[nodiscard]] static std::uintptr_t stack_bottom() {
+#ifdef __linux__
+  pthread_attr_t attributes;
+  if (pthread_getattr_np(pthread_self(), &attributes) != 0)
+    return 0;
+  void *address = nullptr;
+  std::size_t size = 0;
+  const int status = pthread_attr_getstack(&attributes, &address, &size);
+  pthread_attr_destroy(&attributes);
+  if (status == 0)
+    return reinterpret_cast<std::uintptr_t>(address);
+#endif
+  return 0;
+}
+
+Interpreter::Interpreter(OutputSink &output, Diagnostics &diagnostics, SymbolTable &symbols)
+    : output{output}, diagnostics{diagnostics}, symbols{symbols} {
   this->globals = std::make_shared<Environment>();
   this->environment = this->globals;
 }
 
 void Interpreter::interpret(
   const std::vector<std::shared_ptr<Stmt>> &statements) {
+  if (const std::uintptr_t bottom = stack_bottom(); bottom != 0)
+    this->stack_limit = bottom + Interpreter::stack_margin;
+  else {
+    const auto base = reinterpret_cast<std::uintptr_t>(&statements);
+    this->stack_limit = base > Interpreter::max_stack_size ? base - Interpreter::max_stack_size : 0;
+  }
   try {
+    if (this->compile_closures) {
+      ClosureCompiler compiler(*this);
+      compiler.run(statements);
+      return;
+    }
     for (const std::shared_ptr<Stmt> &statement : statements) {
       this->execute(statement);
     }
   } catch (const RuntimeError &error) {
-    runtime_error(error);
+    this->output.flush();
+    this->diagnostics.runtime_error(error);
   }
 }
 
-[[nodiscard]] Object Interpreter::evaluate(std::shared_ptr<Expr> expr) {
-  return expr->accept(*this);
+// a call costs from about 2 to 7 KiB of native stack depending on how deeply
+// its body nests, so recursion is bounded by the stack left and not by a
+// call count.
+void Interpreter::check_stack(const Token &name) const {
+  const char marker = 0;
+  if (reinterpret_cast<std::uintptr_t>(&marker) < this->stack_limit)
+    throw RuntimeError(name, "stack overflow.");
+}
+
+void Interpreter::enable_jit(std::size_t threshold) {
+  this->jit = std::make_unique<Jit>(threshold);
 }
 
-[[nodiscard]] Object Interpreter::look_up_variable(const Token &name, std::shared_ptr<Expr> expr) {
-  if (auto it = this->locals.find(expr); it != this->locals.end())
-    return this->environment->get_at(it->second, name.lexeme);
-  return this->globals->get(name);
+void Interpreter::enable_closure_compilation() {
+  this->compile_closures = true;
 }
 
-void Interpreter::execute(std::shared_ptr<Stmt> stmt) {
+void Interpreter::add_modules(Modules modules) {
+  this->modules.merge(modules);
+}
+
+[[nodiscard]] Object Interpreter::evaluate(const std::shared_ptr<Expr> &expr) {
+  return dispatch(*this, expr);
+}
+
+// statements keep accept(): the switch, inlined into every caller of
+// execute(), made unwinding the return exception of a lox call measurably
+// slower, while statements are dispatched far less often than expressions.
+void Interpreter::execute(const std::shared_ptr<Stmt> &stmt) {
   stmt->accept(*this);
 }
 
-void Interpreter::resolve(std::shared_ptr<Expr> expr, int depth) {
-  this->locals[expr] = depth;
+void Interpreter::define(const Token &name, int slot, Object value, ValueType type) {
+  if (slot >= 0)
+    this->global_slots.define(slot, std::move(value), type);
+  else
+    this->environment->define(name.lexeme, std::move(value));
 }
 
 void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statements,
@@ -56,7 +110,9 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
 }
 
 [[nodiscard]] Object Interpreter::visit(std::shared_ptr<Block> stmt) {
-  this->execute_block(stmt->statements, std::make_shared<Environment>(this->environment));
+  const bool replaced = stmt->replaced != nullptr && this->replaceable(*stmt->replaced);
+  this->execute_block(replaced ? stmt->replaced->statements : stmt->statements,
+                      std::make_shared<Environment>(this->environment));
   return nullptr;
 }
 
@@ -67,7 +123,7 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
     if (superclass.index() != LoxClassIndex)
       throw RuntimeError(stmt->superclass->name, "superclass must be a class.");
   }
-  this->environment->define(stmt->name.lexeme, nullptr);
+  this->define(stmt->name, stmt->slot, nullptr);
   if (stmt->superclass != nullptr) {
     this->environment = std::make_shared<Environment>(this->environment);
     this->environment->define("super", superclass);
@@ -83,7 +139,10 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
   auto klass = std::make_shared<LoxClass>(stmt->name.lexeme, superklass, methods);
   if (superklass != nullptr)
     this->environment = this->environment->enclosing;
-  this->environment->assign(stmt->name, std::move(klass));
+  if (stmt->slot >= 0)
+    this->global_slots.define(stmt->slot, std::move(klass));
+  else
+    this->environment->assign(stmt->name, std::move(klass));
   return nullptr;
 }
 
@@ -94,7 +153,7 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
 
 [[nodiscard]] Object Interpreter::visit(std::shared_ptr<Function> stmt) {
   auto function = std::make_shared<LoxFunction>(stmt, environment, false);
-  this->environment->define(stmt->name.lexeme, std::move(function));
+  this->define(stmt->name, stmt->slot, std::move(function));
   return nullptr;
 }
 
@@ -106,16 +165,34 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
   return nullptr;
 }
 
+[[nodiscard]] Object Interpreter::visit(std::shared_ptr<Import> stmt) {
+  if (this->imported.insert(stmt->module).second)
+    this->execute_block(this->modules.at(stmt->module)->statements, this->globals);
+  return nullptr;
+}
+
 [[nodiscard]] Object Interpreter::visit(std::shared_ptr<Print> stmt) {
-  Object value = this->evaluate(stmt->expression);
-  std::cout << this->stringify(value) << "\n";
+  this->print(this->evaluate(stmt->expression));
   return nullptr;
 }
 
+void Interpreter::print(const Object &value) {
+  // numbers and strings are written straight from the buffer / object
+  // without building a temporary string.
+  if (is_number(value))
+    this->output.write_line(number_to_chars(value, this->number_buffer));
+  else if (value.index() == StringIndex)
+    this->output.write_line(std::get<StringIndex>(value));
+  else
+    this->output.write_line(this->stringify(value));
+}
+
 [[nodiscard]] Object Interpreter::visit(std::shared_ptr<Return> stmt) {
   Object value = nullptr;
   if (stmt->value != nullptr)
     value = this->evaluate(stmt->value);
+  if (stmt->check != ValueType::ANY)
+    check_type(stmt->keyword, "return value", stmt->check, value);
   throw LoxReturnException(value);
 }
 
@@ -123,22 +200,81 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
   Object value = nullptr;
   if (stmt->initializer != nullptr)
     value = this->evaluate(stmt->initializer);
-  this->environment->define(stmt->name.lexeme, value);
+  if (stmt->check != ValueType::ANY)
+    check_type(stmt->name, "'" + stmt->name.lexeme + "'", stmt->check, value);
+  this->define(stmt->name, stmt->slot, std::move(value), stmt->type);
   return nullptr;
 }
 
 [[nodiscard]] Object Interpreter::visit(std::shared_ptr<While> stmt) {
+  if (stmt->counted != nullptr && this->execute_counted(*stmt->counted))
+    return nullptr;
   while (this->is_truthy(this->evaluate(stmt->condition)))
     this->execute(stmt->body);
   return nullptr;
 }
 
+// runs a loop recognized by the Optimizer with the induction variable held in
+// a native integer. returns false, leaving the remaining iterations to the
+// generic loop, if the variable is not an integer or the next step leaves the
+// integer range.
+[[nodiscard]] bool Interpreter::execute_counted(const CountedLoop &loop) {
+  Object &slot = this->environment->values[loop.variable];
+  if (!is_integer(slot))
+    return false;
+  std::int64_t index = std::get<IntegerIndex>(slot);
+  const TokenType op = loop.condition->op.type;
+  std::shared_ptr<Environment> previous = this->environment;
+  // the body never declares into the block wrapping it and nothing captures
+  // that block, so one environment serves every iteration.
+  auto body_environment = std::make_shared<Environment>(previous);
+  try {
+    while (true) {
+      Object limit = this->evaluate(loop.condition->right);
+      if (!is_number(limit))
+        throw RuntimeError(loop.condition->op, "operands must be numbers.");
+      bool holds;
+      if (is_integer(limit)) {
+        const std::int64_t bound = std::get<IntegerIndex>(limit);
+        holds = op == TokenType::LESS            ? index < bound
+                : op == TokenType::LESS_EQUAL    ? index <= bound
+                : op == TokenType::GREATER       ? index > bound
+                                                 : index >= bound;
+      } else {
+        const double value = static_cast<double>(index), bound = std::get<DoubleIndex>(limit);
+        holds = op == TokenType::LESS            ? value < bound
+                : op == TokenType::LESS_EQUAL    ? value <= bound
+                : op == TokenType::GREATER       ? value > bound
+                                                 : value >= bound;
+      }
+      if (!holds)
+        break;
+      this->environment = body_environment;
+      this->execute(loop.body);
+      this->environment = previous;
+      if (add_overflow(index, loop.step, index) || !is_exact_integer(index)) {
+        slot = number_add(slot, Object{loop.step});
+        return false;
+      }
+      slot = index;
+    }
+  } catch (...) {
+    this->environment = previous;
+    throw;
+  }
+  return true;
+}
+
 [[nodiscard]] Object Interpreter::visit(std::shared_ptr<Assign> expr) {
   Object value = this->evaluate(expr->value);
-  if (auto it = this->locals.find(expr); it != this->locals.end())
-    this->environment->assign_at(it->second, expr->name, value);
+  if (expr->check != ValueType::ANY)
+    check_type(expr->name, "'" + expr->name.lexeme + "'", expr->check, value);
+  if (expr->depth < 0)
+    this->global_slots.assign(expr->slot, expr->name, value);
+  else if (expr->slot >= 0)
+    (*this->arguments)[expr->slot] = value;
   else
-    this->globals->assign(expr->name, value);
+    this->environment->assign_at(expr->depth, expr->name, value);
   return value;
 }
 
@@ -153,28 +289,33 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
     return this->is_equal(left, right);
   }
   case TokenType::GREATER: {
-    this->check_number_operands(expr->op, left, right);
-    return std::get<LongDoubleIndex>(left) > std::get<LongDoubleIndex>(right);
+    if (!expr->numeric)
+      this->check_number_operands(expr->op, left, right);
+    return number_less(right, left);
   }
   case TokenType::GREATER_EQUAL: {
-    this->check_number_operands(expr->op, left, right);
-    return std::get<LongDoubleIndex>(left) >= std::get<LongDoubleIndex>(right);
+    if (!expr->numeric)
+      this->check_number_operands(expr->op, left, right);
+    return number_less_equal(right, left);
   }
   case TokenType::LESS: {
-    this->check_number_operands(expr->op, left, right);
-    return std::get<LongDoubleIndex>(left) < std::get<LongDoubleIndex>(right);
+    if (!expr->numeric)
+      this->check_number_operands(expr->op, left, right);
+    return number_less(left, right);
   }
   case TokenType::LESS_EQUAL: {
-    this->check_number_operands(expr->op, left, right);
-    return std::get<LongDoubleIndex>(left) <= std::get<LongDoubleIndex>(right);
+    if (!expr->numeric)
+      this->check_number_operands(expr->op, left, right);
+    return number_less_equal(left, right);
   }
   case TokenType::MINUS: {
-    this->check_number_operands(expr->op, left, right);
-    return std::get<LongDoubleIndex>(left) - std::get<LongDoubleIndex>(right);
+    if (!expr->numeric)
+      this->check_number_operands(expr->op, left, right);
+    return number_subtract(left, right);
   }
   case TokenType::PLUS: {
-    if (left.index() == LongDoubleIndex && right.index() == LongDoubleIndex) {
-      return std::get<LongDoubleIndex>(left) + std::get<LongDoubleIndex>(right);
+    if (expr->numeric || (is_number(left) && is_number(right))) {
+      return number_add(left, right);
     }
     if (left.index() == StringIndex && right.index() == StringIndex) {
       return std::get<StringIndex>(left) + std::get<StringIndex>(right);
@@ -182,12 +323,14 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
     throw RuntimeError{expr->op, "operands must be two numbers or two strings."};
   }
   case TokenType::SLASH: {
-    this->check_number_operands(expr->op, left, right);
-    return std::get<LongDoubleIndex>(left) / std::get<LongDoubleIndex>(right);
+    if (!expr->numeric)
+      this->check_number_operands(expr->op, left, right);
+    return number_divide(left, right);
   }
   case TokenType::STAR: {
-    this->check_number_operands(expr->op, left, right);
-    return std::get<LongDoubleIndex>(left) * std::get<LongDoubleIndex>(right);
+    if (!expr->numeric)
+      this->check_number_operands(expr->op, left, right);
+    return number_multiply(left, right);
   }
   }
   return nullptr;
@@ -209,9 +352,48 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
   if (arguments.size() != function->arity()) {
     throw RuntimeError{expr->paren, "expected " + std::to_string(function->arity()) + " arguments but got " + std::to_string(arguments.size()) + "."};
   }
+  if (expr->inlined != nullptr && callee.index() == LoxFunctionIndex &&
+      std::get<LoxFunctionIndex>(callee)->declared_by(*expr->inlined->function))
+    return this->evaluate_inlined(*expr->inlined, std::move(arguments));
   return function->call(*this, std::move(arguments));
 }
 
+// evaluates the returned expression of a top-level function, whose
+// parameters the Inliner bound to positions in the arguments, without the
+// environment, the statements and the return exception of a call. the jit
+// still counts the call and runs the function once compiled.
+[[nodiscard]] Object Interpreter::evaluate_inlined(const InlinedCall &call, std::vector<Object> arguments) {
+  this->check_stack(call.function->name);
+  if (this->jit != nullptr)
+    if (std::optional<Object> result = this->jit->call(*this, call.function, arguments); result.has_value())
+      return std::move(*result);
+  if (call.value == nullptr)
+    return nullptr;
+  std::vector<Object> *previous = std::exchange(this->arguments, &arguments);
+  try {
+    Object value = this->evaluate(call.value);
+    this->arguments = previous;
+    return value;
+  } catch (...) {
+    this->arguments = previous;
+    throw;
+  }
+}
+
+// whether every class a block's replacement assumes still has the init it was
+// made from; code the ScalarReplacer does not see may assign their globals.
+[[nodiscard]] bool Interpreter::replaceable(const ScalarReplacement &replacement) const {
+  for (const auto &[klass, init] : replacement.classes) {
+    const Object *value = this->global_slots.find(klass->slot);
+    if (value == nullptr || value->index() != LoxClassIndex)
+      return false;
+    std::shared_ptr<LoxFunction> initializer = std::get<LoxClassIndex>(*value)->find_method("init");
+    if (initializer == nullptr || !initializer->declared_by(*init))
+      return false;
+  }
+  return true;
+}
+
 [[nodiscard]] Object Interpreter::visit(std::shared_ptr<Get> expr) {
   Object object = this->evaluate(expr->object);
   if (object.index() == LoxInstanceIndex) {
@@ -247,7 +429,7 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
 }
 
 [[nodiscard]] Object Interpreter::visit(std::shared_ptr<Super> expr) {
-  const int &distance = this->locals[expr];
+  const int &distance = expr->depth;
   auto superclass = std::get<LoxClassIndex>(this->environment->get_at(distance, "super"));
   auto object = std::get<LoxInstanceIndex>(this->environment->get_at(distance - 1, "this"));
   std::shared_ptr<LoxFunction> method = superclass->find_method(expr->method.lexeme);
@@ -257,7 +439,7 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
 }
 
 [[nodiscard]] Object Interpreter::visit(std::shared_ptr<This> expr) {
-  return this->look_up_variable(expr->keyword, expr);
+  return this->environment->get_at(expr->depth, expr->keyword.lexeme);
 }
 
 [[nodiscard]] Object Interpreter::visit(std::shared_ptr<Unary> expr) {
@@ -267,26 +449,31 @@ void Interpreter::execute_block(const std::vector<std::shared_ptr<Stmt>> &statem
     return !this->is_truthy(right);
   }
   case MINUS: {
-    this->check_number_operand(expr->op, right);
-    return -std::get<LongDoubleIndex>(right);
+    if (!expr->numeric)
+      this->check_number_operand(expr->op, right);
+    return number_negate(right);
   }
   }
   return nullptr;
 }
 
 [[nodiscard]] Object Interpreter::visit(std::shared_ptr<Variable> expr) {
-  return this->look_up_variable(expr->name, expr);
+  if (expr->depth < 0)
+    return this->global_slots.get(expr->slot, expr->name);
+  if (expr->slot >= 0)
+    return (*this->arguments)[expr->slot];
+  return this->environment->get_at(expr->depth, expr->name.lexeme);
 }
 
 void Interpreter::check_number_operand(const Token &op, const Object &operand) {
-  if (operand.index() == LongDoubleIndex)
+  if (is_number(operand))
     return;
   throw RuntimeError(op, "operand must be a number.");
 }
 
 void Interpreter::check_number_operands(const Token &op, const Object &left,
                                         const Object &right) {
-  if (left.index() == LongDoubleIndex && right.index() == LongDoubleIndex)
+  if (is_number(left) && is_number(right))
     return;
   throw RuntimeError(op, "operands must be numbers.");
 }
@@ -310,8 +497,8 @@ void Interpreter::check_number_operands(const Token &op, const Object &left,
     return false;
   if (a.index() == StringIndex && b.index() == StringIndex)
     return std::get<StringIndex>(a) == std::get<StringIndex>(b);
-  if (a.index() == LongDoubleIndex && b.index() == LongDoubleIndex)
-    return std::get<LongDoubleIndex>(a) == std::get<LongDoubleIndex>(b);
+  if (is_number(a) && is_number(b))
+    return number_equal(a, b);
   if (a.index() == BoolIndex && b.index() == BoolIndex)
     return std::get<BoolIndex>(a) == std::get<BoolIndex>(b);
   return false;
@@ -322,11 +509,9 @@ std::string Interpreter::stringify(const Object &object) {
   case StringIndex: {
     return std::get<StringIndex>(object);
   }
-  case LongDoubleIndex: {
-    std::string text = std::to_string(std::get<LongDoubleIndex>(object));
-    if (text.ends_with(".0"))
-      text = text.substr(0, text.length() - 2);
-    return text;
+  case IntegerIndex:
+  case DoubleIndex: {
+    return std::string(number_to_chars(object, this->number_buffer));
   }
   case BoolIndex: {
     return std::get<BoolIndex>(object) ? "true" : "false";
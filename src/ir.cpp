@@ -0,0 +1,805 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <charconv>
+#include <utility>
+
+#include "../include/ir.hpp"
+
+namespace loxplusplus {
+static const char *opcode_name(Opcode opcode) {
+  switch (opcode) {
+  case Opcode::CONSTANT: return "const";
+  case Opcode::PARAMETER: return "param";
+  case Opcode::PHI: return "phi";
+  case Opcode::COPY: return "copy";
+  case Opcode::UNARY: return "unary";
+  case Opcode::BINARY: return "binary";
+  case Opcode::LOAD: return "load";
+  case Opcode::STORE: return "store";
+  case Opcode::CALL: return "call";
+  case Opcode::GET: return "get";
+  case Opcode::SET: return "set";
+  case Opcode::SUPER: return "super";
+  case Opcode::CLOSURE: return "closure";
+  case Opcode::IMPORT: return "import";
+  case Opcode::PRINT: return "print";
+  case Opcode::RETURN: return "return";
+  case Opcode::BRANCH: return "branch";
+  case Opcode::JUMP: return "jump";
+  }
+  return "?";
+}
+
+static const char *operator_text(TokenType op) {
+  switch (op) {
+  case TokenType::MINUS: return "-";
+  case TokenType::PLUS: return "+";
+  case TokenType::SLASH: return "/";
+  case TokenType::STAR: return "*";
+  case TokenType::BANG: return "!";
+  case TokenType::BANG_EQUAL: return "!=";
+  case TokenType::EQUAL_EQUAL: return "==";
+  case TokenType::GREATER: return ">";
+  case TokenType::GREATER_EQUAL: return ">=";
+  case TokenType::LESS: return "<";
+  case TokenType::LESS_EQUAL: return "<=";
+  case TokenType::AND: return "and";
+  case TokenType::OR: return "or";
+  default: return "?";
+  }
+}
+
+static std::string constant_text(const Object &value) {
+  switch (value.index()) {
+  case StringIndex: return '"' + std::get<StringIndex>(value) + '"';
+  case DoubleIndex: {
+    char buffer[32];
+    return std::string(buffer, std::to_chars(buffer, buffer + sizeof buffer, std::get<DoubleIndex>(value)).ptr);
+  }
+  case BoolIndex: return std::get<BoolIndex>(value) ? "true" : "false";
+  case IntegerIndex: return std::to_string(std::get<IntegerIndex>(value));
+  default: return "nil";
+  }
+}
+
+[[nodiscard]] int IrFunction::resolve(int value) {
+  int target = value;
+  while (this->replacement[target] != target)
+    target = this->replacement[target];
+  while (this->replacement[value] != target)
+    value = std::exchange(this->replacement[value], target);
+  return target;
+}
+
+void IrFunction::replace(int value, int by) {
+  this->replacement[value] = by;
+  this->values[value].removed = true;
+}
+
+[[nodiscard]] bool IrFunction::script() const noexcept {
+  return this->declaration == nullptr;
+}
+
+[[nodiscard]] std::string IrFunction::to_string() const {
+  std::string text = "function " + this->name + '\n';
+  for (std::size_t block = 0; block < this->blocks.size(); ++block) {
+    const IrBlock &b = this->blocks[block];
+    if (b.instructions.empty() && block != 0)
+      continue;
+    text += "  b" + std::to_string(block) + ':';
+    if (!b.predecessors.empty()) {
+      text += " <-";
+      for (int predecessor : b.predecessors)
+        text += " b" + std::to_string(predecessor);
+    }
+    if (b.loop >= 0)
+      text += " (loop " + std::to_string(b.loop) + ')';
+    text += '\n';
+    for (int id : b.instructions) {
+      const IrInstruction &instruction = this->values[id];
+      if (instruction.removed)
+        continue;
+      text += "    v" + std::to_string(id) + " = " + opcode_name(instruction.opcode);
+      if (instruction.opcode == Opcode::UNARY || instruction.opcode == Opcode::BINARY)
+        text += std::string(" ") + operator_text(instruction.op);
+      if (instruction.opcode == Opcode::CONSTANT)
+        text += ' ' + constant_text(instruction.constant);
+      if (instruction.name != nullptr)
+        text += ' ' + instruction.name->lexeme;
+      for (int operand : instruction.operands)
+        text += " v" + std::to_string(operand);
+      for (int target : instruction.targets)
+        text += " b" + std::to_string(target);
+      if (instruction.type != ValueType::ANY)
+        text += " : " + std::string(type_name(instruction.type));
+      if (instruction.hoisted >= 0)
+        text += " (hoisted)";
+      text += '\n';
+    }
+  }
+  return text;
+}
+
+[[nodiscard]] std::unordered_set<const Token *> CaptureScanner::scan(const std::vector<Token> *params,
+                                                                     const std::vector<std::shared_ptr<Stmt>> &body) {
+  // top-level declarations are globals and never captured.
+  if (params != nullptr) {
+    this->scopes.emplace_back();
+    for (const Token &param : *params)
+      this->declare(param);
+  }
+  for (const std::shared_ptr<Stmt> &stmt : body)
+    this->scan(stmt);
+  return std::move(this->captured);
+}
+
+[[nodiscard]] std::size_t CaptureScanner::size() const noexcept {
+  return this->nodes;
+}
+
+[[nodiscard]] std::vector<std::pair<std::string, std::shared_ptr<Function>>> CaptureScanner::take_nested() {
+  return std::move(this->nested);
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Block> stmt) {
+  this->scopes.emplace_back();
+  for (const std::shared_ptr<Stmt> &statement : stmt->statements)
+    this->scan(statement);
+  this->scopes.pop_back();
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Class> stmt) {
+  this->declare(stmt->name);
+  if (stmt->superclass != nullptr)
+    this->scan(stmt->superclass);
+  for (const std::shared_ptr<Function> &method : stmt->methods) {
+    if (this->level == 0 && !method->deferred())
+      this->nested.emplace_back(stmt->name.lexeme + '.' + method->name.lexeme, method);
+    this->scan_function(*method);
+  }
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Expression> stmt) {
+  this->scan(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Function> stmt) {
+  this->declare(stmt->name);
+  if (this->level == 0 && !stmt->deferred())
+    this->nested.emplace_back(stmt->name.lexeme, stmt);
+  this->scan_function(*stmt);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<If> stmt) {
+  this->scan(stmt->condition);
+  this->scan(stmt->then_branch);
+  if (stmt->else_branch != nullptr)
+    this->scan(stmt->else_branch);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Import> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Print> stmt) {
+  this->scan(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Return> stmt) {
+  if (stmt->value != nullptr)
+    this->scan(stmt->value);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Var> stmt) {
+  if (stmt->initializer != nullptr)
+    this->scan(stmt->initializer);
+  this->declare(stmt->name);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<While> stmt) {
+  this->scan(stmt->condition);
+  this->scan(stmt->body);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Assign> expr) {
+  this->scan(expr->value);
+  this->reference(expr->name, expr->depth);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Binary> expr) {
+  this->scan(expr->left);
+  this->scan(expr->right);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Call> expr) {
+  this->scan(expr->callee);
+  for (const std::shared_ptr<Expr> &argument : expr->arguments)
+    this->scan(argument);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Get> expr) {
+  this->scan(expr->object);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Grouping> expr) {
+  this->scan(expr->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Literal> expr) {
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Logical> expr) {
+  this->scan(expr->left);
+  this->scan(expr->right);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Set> expr) {
+  this->scan(expr->value);
+  this->scan(expr->object);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Super> expr) {
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<This> expr) {
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Unary> expr) {
+  this->scan(expr->right);
+  return nullptr;
+}
+
+[[nodiscard]] Object CaptureScanner::visit(std::shared_ptr<Variable> expr) {
+  this->reference(expr->name, expr->depth);
+  return nullptr;
+}
+
+void CaptureScanner::scan(const std::shared_ptr<Stmt> &stmt) {
+  this->nodes += this->level == 0;
+  (void)dispatch(*this, stmt);
+}
+
+void CaptureScanner::scan(const std::shared_ptr<Expr> &expr) {
+  this->nodes += this->level == 0;
+  (void)dispatch(*this, expr);
+}
+
+void CaptureScanner::scan_function(const Function &function) {
+  // a deferred body is resolved against its own declaration only; it can
+  // not see the locals of this body.
+  if (function.deferred())
+    return;
+  // nor are there locals to capture around a top-level function.
+  if (this->level == 0 && this->scopes.empty())
+    return;
+  ++this->level;
+  this->scopes.emplace_back();
+  for (const Token &param : function.params)
+    this->declare(param);
+  for (const std::shared_ptr<Stmt> &stmt : function.body())
+    this->scan(stmt);
+  this->scopes.pop_back();
+  --this->level;
+}
+
+void CaptureScanner::declare(const Token &name) {
+  if (!this->scopes.empty())
+    this->scopes.back()[&name.lexeme] = Declaration{&name, this->level};
+}
+
+void CaptureScanner::reference(const Token &name, int depth) {
+  if (depth < 0)
+    return;
+  for (auto scope = this->scopes.rbegin(); scope != this->scopes.rend(); ++scope)
+    if (auto it = scope->find(&name.lexeme); it != scope->end()) {
+      if (it->second.level < this->level)
+        this->captured.insert(it->second.name);
+      return;
+    }
+}
+
+IrBuilder::IrBuilder(IrFunction &function)
+    : function{function} {}
+
+[[nodiscard]] bool IrBuilder::build(const std::vector<Token> &params, const std::vector<std::shared_ptr<Stmt>> &body) {
+  CaptureScanner scanner;
+  this->captured = scanner.scan(this->function.script() ? nullptr : &params, body);
+  this->nested = scanner.take_nested();
+  if (scanner.size() > max_size)
+    return false;
+  this->current = this->new_block(true);
+  if (!this->function.script()) {
+    this->scopes.emplace_back();
+    const std::vector<ValueType> &types = this->function.declaration->param_types;
+    for (std::size_t i = 0; i < params.size(); ++i) {
+      const int parameter = this->emit(Opcode::PARAMETER);
+      IrInstruction &instruction = this->function.values[parameter];
+      instruction.name = &params[i];
+      instruction.annotation = types.empty() ? ValueType::ANY : types[i];
+      this->define(params[i], this->declare(params[i]), parameter);
+    }
+  }
+  for (std::size_t i = 0; i < body.size(); ++i) {
+    this->statement = static_cast<int>(i);
+    this->build(body[i]);
+  }
+  this->statement = -1;
+  if (!this->function.script())
+    (void)this->emit(Opcode::RETURN, {this->constant(nullptr)});
+
+  // a COPY is read when some read of its variable yields it, directly or
+  // through phis.
+  std::vector<bool> visited(this->function.values.size());
+  std::vector<int> work;
+  for (int read : this->reads)
+    work.push_back(read);
+  while (!work.empty()) {
+    const int id = this->function.resolve(work.back());
+    work.pop_back();
+    if (visited[id])
+      continue;
+    visited[id] = true;
+    IrInstruction &instruction = this->function.values[id];
+    if (instruction.opcode == Opcode::COPY)
+      instruction.read = true;
+    else if (instruction.opcode == Opcode::PHI)
+      for (int operand : instruction.operands)
+        work.push_back(operand);
+  }
+
+  // loops are numbered outermost first, so an inner loop's blocks get
+  // their number last.
+  for (std::size_t loop = 0; loop < this->function.loops.size(); ++loop) {
+    IrLoop &l = this->function.loops[loop];
+    l.parent = this->function.blocks[l.header].loop;
+    for (int block = l.header; block < l.end; ++block)
+      this->function.blocks[block].loop = static_cast<int>(loop);
+  }
+  return true;
+}
+
+[[nodiscard]] std::vector<std::pair<std::string, std::shared_ptr<Function>>> IrBuilder::take_nested() {
+  return std::move(this->nested);
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Block> stmt) {
+  this->scopes.emplace_back();
+  // the block a for loop with an initializer desugars into.
+  if (stmt->statements.size() == 2 && stmt->statements[0]->kind == StmtKind::VAR &&
+      stmt->statements[1]->kind == StmtKind::WHILE) {
+    std::vector<std::pair<const Token *, int>> definitions = this->definitions();
+    this->build(stmt->statements[0]);
+    this->build_loop(static_cast<const While &>(*stmt->statements[1]), *stmt, std::move(definitions));
+  } else
+    for (const std::shared_ptr<Stmt> &statement : stmt->statements)
+      this->build(statement);
+  this->scopes.pop_back();
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Class> stmt) {
+  const int variable = this->declare(stmt->name);
+  std::vector<int> operands;
+  if (stmt->superclass != nullptr)
+    operands.push_back(this->build(stmt->superclass));
+  const int klass = this->emit(Opcode::CLOSURE, std::move(operands));
+  this->function.values[klass].name = &stmt->name;
+  this->define(stmt->name, variable, klass);
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Expression> stmt) {
+  (void)this->build(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Function> stmt) {
+  const int variable = this->declare(stmt->name);
+  const int closure = this->emit(Opcode::CLOSURE);
+  this->function.values[closure].name = &stmt->name;
+  this->define(stmt->name, variable, closure);
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<If> stmt) {
+  const int condition = this->build(stmt->condition);
+  const int then_block = this->new_block(false), else_block = this->new_block(false);
+  (void)this->branch(condition, then_block, else_block);
+  this->seal(then_block);
+  this->seal(else_block);
+  this->current = then_block;
+  this->build(stmt->then_branch);
+  const int then_end = this->current;
+  this->current = else_block;
+  if (stmt->else_branch != nullptr)
+    this->build(stmt->else_branch);
+  const int else_end = this->current;
+  const int merge = this->new_block(false);
+  this->current = then_end;
+  this->jump(merge);
+  this->current = else_end;
+  this->jump(merge);
+  this->seal(merge);
+  this->current = merge;
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Import> stmt) {
+  const int import = this->emit(Opcode::IMPORT);
+  this->function.values[import].name = &stmt->path;
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Print> stmt) {
+  (void)this->emit(Opcode::PRINT, {this->build(stmt->expression)});
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Return> stmt) {
+  const int value = stmt->value != nullptr ? this->build(stmt->value) : this->constant(nullptr);
+  (void)this->emit(Opcode::RETURN, {value});
+  // whatever follows the return is unreachable.
+  this->current = this->new_block(true);
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Var> stmt) {
+  const int value = stmt->initializer != nullptr ? this->build(stmt->initializer) : this->constant(nullptr);
+  this->define(stmt->name, this->declare(stmt->name), value, stmt.get(), nullptr, stmt->type);
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<While> stmt) {
+  this->build_loop(*stmt, *stmt, this->definitions());
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Assign> expr) {
+  const int value = this->build(expr->value);
+  const int variable = expr->depth >= 0 ? this->lookup(expr->name) : -1;
+  if (variable < 0 || this->variables[variable].captured) {
+    const int store = this->emit(Opcode::STORE, {value});
+    this->function.values[store].name = &expr->name;
+    this->value = value;
+    return nullptr;
+  }
+  this->define(expr->name, variable, value, nullptr, expr.get(), expr->check);
+  this->value = this->function.values_of[expr.get()];
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Binary> expr) {
+  const int left = this->build(expr->left);
+  const int right = this->build(expr->right);
+  this->value = this->emit(Opcode::BINARY, {left, right}, expr.get());
+  this->function.values[this->value].op = expr->op.type;
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Call> expr) {
+  std::vector<int> operands{this->build(expr->callee)};
+  for (const std::shared_ptr<Expr> &argument : expr->arguments)
+    operands.push_back(this->build(argument));
+  this->value = this->emit(Opcode::CALL, std::move(operands), expr.get());
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Get> expr) {
+  this->value = this->emit(Opcode::GET, {this->build(expr->object)}, expr.get());
+  this->function.values[this->value].name = &expr->name;
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Grouping> expr) {
+  this->value = this->build(expr->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Literal> expr) {
+  this->value = this->constant(expr->value);
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Logical> expr) {
+  const int left = this->build(expr->left);
+  const int left_end = this->current;
+  const int right_block = this->new_block(false), merge = this->new_block(false);
+  if (expr->op.type == TokenType::OR)
+    (void)this->branch(left, merge, right_block);
+  else
+    (void)this->branch(left, right_block, merge);
+  this->seal(right_block);
+  this->current = right_block;
+  const int right = this->build(expr->right);
+  this->jump(merge);
+  this->seal(merge);
+  this->current = merge;
+  // the operand the expression evaluates to, in the order of the
+  // predecessors of the merge block.
+  const int phi = this->new_phi(merge);
+  IrInstruction &instruction = this->function.values[phi];
+  instruction.operands = this->function.blocks[merge].predecessors[0] == left_end ? std::vector<int>{left, right}
+                                                                                  : std::vector<int>{right, left};
+  instruction.origin = expr.get();
+  instruction.op = expr->op.type;
+  this->value = phi;
+  this->function.values_of[expr.get()] = phi;
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Set> expr) {
+  const int object = this->build(expr->object);
+  const int value = this->build(expr->value);
+  const int set = this->emit(Opcode::SET, {object, value}, expr.get());
+  this->function.values[set].name = &expr->name;
+  this->value = value;
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Super> expr) {
+  this->value = this->emit(Opcode::SUPER, {}, expr.get());
+  this->function.values[this->value].name = &expr->method;
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<This> expr) {
+  this->value = this->emit(Opcode::LOAD, {}, expr.get());
+  this->function.values[this->value].name = &expr->keyword;
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Unary> expr) {
+  this->value = this->emit(Opcode::UNARY, {this->build(expr->right)}, expr.get());
+  this->function.values[this->value].op = expr->op.type;
+  return nullptr;
+}
+
+[[nodiscard]] Object IrBuilder::visit(std::shared_ptr<Variable> expr) {
+  const int variable = expr->depth >= 0 ? this->lookup(expr->name) : -1;
+  if (variable < 0 || this->variables[variable].captured) {
+    this->value = this->emit(Opcode::LOAD, {}, expr.get());
+    this->function.values[this->value].name = &expr->name;
+    return nullptr;
+  }
+  this->value = this->read(variable, this->current);
+  this->reads.push_back(this->value);
+  this->function.values_of[expr.get()] = this->value;
+  return nullptr;
+}
+
+void IrBuilder::build(const std::shared_ptr<Stmt> &stmt) {
+  (void)dispatch(*this, stmt);
+}
+
+[[nodiscard]] int IrBuilder::build(const std::shared_ptr<Expr> &expr) {
+  (void)dispatch(*this, expr);
+  return this->value;
+}
+
+void IrBuilder::build_loop(const While &loop, const Stmt &hoist,
+                           std::vector<std::pair<const Token *, int>> definitions) {
+  const int preheader = this->current;
+  const int header = this->new_block(false);
+  this->jump(header);
+  this->current = header;
+  const int condition = this->build(loop.condition);
+  const int body = this->new_block(false);
+  const int exit_branch = this->branch(condition, body, -1);
+  this->seal(body);
+  const std::size_t index = this->function.loops.size();
+  this->function.loops.push_back(IrLoop{preheader, header, -1, -1, &hoist, std::move(definitions)});
+  this->current = body;
+  this->build(loop.body);
+  this->jump(header);
+  const int exit = this->new_block(false);
+  IrInstruction &branch = this->function.values[exit_branch];
+  branch.targets[1] = exit;
+  this->function.blocks[exit].predecessors.push_back(branch.block);
+  this->seal(header);
+  this->seal(exit);
+  this->function.loops[index].end = exit;
+  this->current = exit;
+}
+
+[[nodiscard]] int IrBuilder::emit(Opcode opcode, std::vector<int> operands, Expr *origin) {
+  const int id = static_cast<int>(this->function.values.size());
+  IrInstruction instruction{opcode, this->current, std::move(operands)};
+  instruction.origin = origin;
+  instruction.statement = this->statement;
+  this->function.values.push_back(std::move(instruction));
+  this->function.replacement.push_back(id);
+  std::vector<int> &instructions = this->function.blocks[this->current].instructions;
+  if (opcode == Opcode::PARAMETER)
+    instructions.insert(instructions.begin() + this->prologue++, id);
+  else
+    instructions.push_back(id);
+  if (origin != nullptr)
+    this->function.values_of[origin] = id;
+  return id;
+}
+
+// constants are materialized in the entry block, which dominates every use.
+[[nodiscard]] int IrBuilder::constant(Object value) {
+  const int id = static_cast<int>(this->function.values.size());
+  IrInstruction instruction{Opcode::CONSTANT, 0};
+  instruction.constant = std::move(value);
+  this->function.values.push_back(std::move(instruction));
+  this->function.replacement.push_back(id);
+  std::vector<int> &instructions = this->function.blocks[0].instructions;
+  instructions.insert(instructions.begin() + this->prologue++, id);
+  return id;
+}
+
+[[nodiscard]] int IrBuilder::new_block(bool sealed) {
+  this->function.blocks.push_back(IrBlock{.sealed = sealed});
+  return static_cast<int>(this->function.blocks.size()) - 1;
+}
+
+void IrBuilder::jump(int target) {
+  IrInstruction &jump = this->function.values[this->emit(Opcode::JUMP)];
+  jump.targets.push_back(target);
+  this->function.blocks[target].predecessors.push_back(this->current);
+}
+
+[[nodiscard]] int IrBuilder::branch(int condition, int if_true, int if_false) {
+  const int id = this->emit(Opcode::BRANCH, {condition});
+  this->function.values[id].targets = {if_true, if_false};
+  for (int target : {if_true, if_false})
+    if (target >= 0)
+      this->function.blocks[target].predecessors.push_back(this->current);
+  return id;
+}
+
+void IrBuilder::seal(int block) {
+  if (auto it = this->incomplete_phis.find(block); it != this->incomplete_phis.end()) {
+    for (auto [variable, phi] : it->second)
+      (void)this->add_phi_operands(variable, phi);
+    this->incomplete_phis.erase(it);
+  }
+  this->function.blocks[block].sealed = true;
+}
+
+[[nodiscard]] int IrBuilder::declare(const Token &name) {
+  if (this->scopes.empty())
+    return -1;
+  const int variable = static_cast<int>(this->variables.size());
+  this->variables.push_back(Local{&name, this->captured.contains(&name)});
+  this->current_definitions.emplace_back();
+  this->scopes.back()[&name.lexeme] = variable;
+  return variable;
+}
+
+void IrBuilder::define(const Token &name, int variable, int value, const Var *declaration, Expr *origin,
+                       ValueType annotation) {
+  if (variable < 0 || this->variables[variable].captured) {
+    const int store = this->emit(Opcode::STORE, {value});
+    this->function.values[store].name = &name;
+    return;
+  }
+  const int copy = this->emit(Opcode::COPY, {value}, origin);
+  IrInstruction &instruction = this->function.values[copy];
+  instruction.name = &name;
+  instruction.declaration = declaration;
+  instruction.annotation = annotation;
+  if (declaration != nullptr)
+    this->function.copies[declaration] = copy;
+  this->write(variable, this->current, copy);
+}
+
+[[nodiscard]] int IrBuilder::lookup(const Token &name) const {
+  for (auto scope = this->scopes.rbegin(); scope != this->scopes.rend(); ++scope)
+    if (auto it = scope->find(&name.lexeme); it != scope->end())
+      return it->second;
+  // a local of an enclosing function.
+  return -1;
+}
+
+void IrBuilder::write(int variable, int block, int value) {
+  this->current_definitions[variable][block] = value;
+}
+
+[[nodiscard]] int IrBuilder::read(int variable, int block) {
+  const std::unordered_map<int, int> &definitions = this->current_definitions[variable];
+  if (auto it = definitions.find(block); it != definitions.end())
+    return this->function.resolve(it->second);
+  return this->read_recursive(variable, block);
+}
+
+[[nodiscard]] int IrBuilder::read_recursive(int variable, int block) {
+  const IrBlock &b = this->function.blocks[block];
+  int value;
+  if (!b.sealed) {
+    value = this->new_phi(block);
+    this->incomplete_phis[block].emplace_back(variable, value);
+  } else if (b.predecessors.empty())
+    // only unreachable code reads a variable nothing defined on its path.
+    value = this->constant(nullptr);
+  else if (b.predecessors.size() == 1)
+    value = this->read(variable, b.predecessors[0]);
+  else {
+    value = this->new_phi(block);
+    // breaks cycles through loops.
+    this->write(variable, block, value);
+    value = this->add_phi_operands(variable, value);
+  }
+  this->write(variable, block, value);
+  return value;
+}
+
+[[nodiscard]] int IrBuilder::new_phi(int block) {
+  const int id = static_cast<int>(this->function.values.size());
+  this->function.values.push_back(IrInstruction{Opcode::PHI, block});
+  this->function.replacement.push_back(id);
+  IrBlock &b = this->function.blocks[block];
+  b.instructions.insert(b.instructions.begin() + b.phis++, id);
+  return id;
+}
+
+[[nodiscard]] int IrBuilder::add_phi_operands(int variable, int phi) {
+  // the predecessors are copied: reading may add blocks.
+  const std::vector<int> predecessors = this->function.blocks[this->function.values[phi].block].predecessors;
+  for (int predecessor : predecessors) {
+    const int operand = this->read(variable, predecessor);
+    this->function.values[phi].operands.push_back(operand);
+  }
+  return this->try_remove_trivial_phi(phi);
+}
+
+[[nodiscard]] int IrBuilder::try_remove_trivial_phi(int phi) {
+  int same = -1;
+  for (int operand : this->function.values[phi].operands) {
+    operand = this->function.resolve(operand);
+    if (operand == same || operand == phi)
+      continue;
+    if (same >= 0)
+      return phi;
+    same = operand;
+  }
+  if (same < 0)
+    same = this->constant(nullptr);
+  // phis using this one may have become trivial as well; the optimizer
+  // removes those.
+  this->function.replace(phi, same);
+  return same;
+}
+
+// the variables in scope that a loop's hoisted code may read, innermost
+// first; shadowed ones can not be named there.
+[[nodiscard]] std::vector<std::pair<const Token *, int>> IrBuilder::definitions() {
+  std::vector<std::pair<const Token *, int>> result;
+  std::unordered_set<const std::string *> seen;
+  for (auto scope = this->scopes.rbegin(); scope != this->scopes.rend(); ++scope)
+    for (auto [name, variable] : *scope) {
+      if (!seen.insert(name).second || this->variables[variable].captured)
+        continue;
+      // hoisted code may read the variable, so its definition stays.
+      const int value = this->read(variable, this->current);
+      this->reads.push_back(value);
+      result.emplace_back(this->variables[variable].name, value);
+    }
+  return result;
+}
+}// namespace loxplusplus
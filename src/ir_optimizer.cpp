@@ -0,0 +1,1009 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <algorithm>
+#include <charconv>
+#include <optional>
+
+#include "../include/ir_optimizer.hpp"
+
+namespace loxplusplus {
+static constexpr const char *pass_names[] = {"copy propagation", "type inference", "common subexpressions",
+                                             "loop invariants", "dead code"};
+
+// how deep a value computed outside a loop is rebuilt in front of it.
+static constexpr int materialize_depth = 8;
+
+[[nodiscard]] static bool arithmetic(TokenType op) {
+  switch (op) {
+  case TokenType::MINUS:
+  case TokenType::PLUS:
+  case TokenType::SLASH:
+  case TokenType::STAR:
+  case TokenType::GREATER:
+  case TokenType::GREATER_EQUAL:
+  case TokenType::LESS:
+  case TokenType::LESS_EQUAL:
+    return true;
+  default:
+    return false;
+  }
+}
+
+[[nodiscard]] static bool commutative(TokenType op, ValueType operands) {
+  return op == TokenType::STAR || op == TokenType::EQUAL_EQUAL || op == TokenType::BANG_EQUAL ||
+         (op == TokenType::PLUS && operands == ValueType::NUMBER);
+}
+
+[[nodiscard]] static ValueType literal_type(const Object &value) {
+  switch (value.index()) {
+  case IntegerIndex:
+  case DoubleIndex: return ValueType::NUMBER;
+  case StringIndex: return ValueType::STRING;
+  case BoolIndex: return ValueType::BOOL;
+  default: return ValueType::ANY;
+  }
+}
+
+IrOptimizer::IrOptimizer(Lexicon &lexicon)
+    : lexicon{lexicon} {}
+
+[[nodiscard]] bool IrOptimizer::optimize(std::vector<std::shared_ptr<Stmt>> &statements) {
+  static const std::vector<Token> none;
+  IrFunction script{"<script>"};
+  bool changed = this->optimize(script, statements, none);
+  return this->optimize_nested() || changed;
+}
+
+[[nodiscard]] bool IrOptimizer::optimize_function(const Function &function, std::vector<std::shared_ptr<Stmt>> &body) {
+  IrFunction ir{function.name.lexeme, &function};
+  bool changed = this->optimize(ir, body, function.params);
+  return this->optimize_nested() || changed;
+}
+
+void IrOptimizer::enable_dump() {
+  this->dump = true;
+}
+
+[[nodiscard]] std::string IrOptimizer::report() const {
+  std::string text = this->dumped;
+  for (int pass = 0; pass < PASSES; ++pass) {
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(this->statistics[pass].time);
+    text += std::string(pass_names[pass]) + ": " + std::to_string(this->statistics[pass].changes) + " changes in " +
+            std::to_string(microseconds.count()) + "us\n";
+  }
+  return text;
+}
+
+[[nodiscard]] bool IrOptimizer::optimize_nested() {
+  bool changed = false;
+  while (!this->nested.empty()) {
+    auto [name, declaration] = std::move(this->nested.back());
+    this->nested.pop_back();
+    IrFunction ir{std::move(name), declaration.get()};
+    std::vector<std::shared_ptr<Stmt>> body = declaration->body();
+    if (this->optimize(ir, body, declaration->params)) {
+      declaration->replace_body(std::move(body));
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+[[nodiscard]] bool IrOptimizer::optimize(IrFunction &function, std::vector<std::shared_ptr<Stmt>> &body,
+                                         const std::vector<Token> &params) {
+  IrBuilder builder(function);
+  const bool built = builder.build(params, body);
+  for (auto &nested : builder.take_nested())
+    this->nested.push_back(std::move(nested));
+  if (!built)
+    return false;
+  this->function = &function;
+  for (int pass = 0; pass < PASSES; ++pass)
+    this->run(static_cast<Pass>(pass), function);
+  if (this->dump)
+    this->dumped += function.to_string();
+
+  this->plan(body);
+  bool changed = false;
+  std::vector<std::shared_ptr<Stmt>> lowered;
+  for (std::size_t i = 0; i < body.size(); ++i) {
+    std::shared_ptr<Stmt> stmt = this->lower(body[i]);
+    changed = changed || stmt != body[i];
+    if (stmt == nullptr)
+      continue;
+    // the temporaries of the top-level statements are scoped to the
+    // statement, or they would become globals.
+    std::vector<std::shared_ptr<Stmt>> temporaries;
+    if (function.script())
+      for (int value : this->reused)
+        if (this->statements[value] == static_cast<int>(i))
+          temporaries.push_back(this->declare(value));
+    if (temporaries.empty())
+      lowered.push_back(std::move(stmt));
+    else {
+      temporaries.push_back(std::move(stmt));
+      lowered.push_back(std::make_shared<Block>(std::move(temporaries)));
+    }
+  }
+  if (!function.script() && !this->reused.empty()) {
+    std::vector<std::shared_ptr<Stmt>> temporaries;
+    for (int value : this->reused)
+      temporaries.push_back(this->declare(value));
+    lowered.insert(lowered.begin(), temporaries.begin(), temporaries.end());
+  }
+  if (changed)
+    body = std::move(lowered);
+
+  this->function = nullptr;
+  this->live.clear();
+  this->temporaries.clear();
+  this->hoists.clear();
+  this->hoisted.clear();
+  this->reused.clear();
+  this->in_scope.clear();
+  return changed;
+}
+
+void IrOptimizer::run(Pass pass, IrFunction &function) {
+  const auto begin = std::chrono::steady_clock::now();
+  std::size_t changes = 0;
+  switch (pass) {
+  case COPY_PROPAGATION: changes = this->propagate_copies(function); break;
+  case TYPES: changes = this->infer_types(function); break;
+  case CSE: changes = this->eliminate_common_subexpressions(function); break;
+  case LICM: changes = this->hoist_invariants(function); break;
+  case DCE: changes = this->eliminate_dead_code(function); break;
+  default: break;
+  }
+  this->statistics[pass].time += std::chrono::steady_clock::now() - begin;
+  this->statistics[pass].changes += changes;
+}
+
+// a copy without a runtime check is its operand. the phis that became
+// trivial on the way are removed as well.
+[[nodiscard]] std::size_t IrOptimizer::propagate_copies(IrFunction &function) {
+  std::size_t changes = 0;
+  for (std::size_t id = 0; id < function.values.size(); ++id) {
+    const IrInstruction &instruction = function.values[id];
+    if (!instruction.removed && instruction.opcode == Opcode::COPY && instruction.annotation == ValueType::ANY) {
+      function.replace(static_cast<int>(id), instruction.operands[0]);
+      ++changes;
+    }
+  }
+  for (bool again = true; again;) {
+    again = false;
+    for (std::size_t id = 0; id < function.values.size(); ++id) {
+      IrInstruction &instruction = function.values[id];
+      if (instruction.removed || instruction.opcode != Opcode::PHI)
+        continue;
+      int same = -1;
+      bool trivial = true;
+      for (int operand : instruction.operands) {
+        operand = function.resolve(operand);
+        if (operand == same || operand == static_cast<int>(id))
+          continue;
+        if (same >= 0) {
+          trivial = false;
+          break;
+        }
+        same = operand;
+      }
+      if (trivial && same >= 0) {
+        function.replace(static_cast<int>(id), same);
+        ++changes;
+        again = true;
+      }
+    }
+  }
+  for (IrInstruction &instruction : function.values)
+    for (int &operand : instruction.operands)
+      operand = function.resolve(operand);
+  return changes;
+}
+
+// an optimistic fixpoint: a value is of unknown type until an operand says
+// otherwise, so loop phis of numbers stay numbers.
+[[nodiscard]] std::size_t IrOptimizer::infer_types(IrFunction &function) {
+  std::vector<std::optional<ValueType>> types(function.values.size());
+  auto transfer = [&](const IrInstruction &instruction) -> std::optional<ValueType> {
+    switch (instruction.opcode) {
+    case Opcode::CONSTANT: return literal_type(instruction.constant);
+    case Opcode::PARAMETER: return instruction.annotation;
+    case Opcode::COPY:
+      if (instruction.annotation != ValueType::ANY)
+        return instruction.annotation;
+      return types[instruction.operands[0]];
+    case Opcode::PHI: {
+      std::optional<ValueType> type;
+      for (int operand : instruction.operands)
+        if (types[operand].has_value()) {
+          if (type.has_value() && *type != *types[operand])
+            return ValueType::ANY;
+          type = types[operand];
+        }
+      return type;
+    }
+    case Opcode::UNARY:
+      return instruction.op == TokenType::BANG ? ValueType::BOOL : ValueType::NUMBER;
+    case Opcode::BINARY: {
+      if (instruction.op != TokenType::PLUS)
+        return arithmetic(instruction.op) && instruction.op != TokenType::GREATER &&
+                       instruction.op != TokenType::GREATER_EQUAL && instruction.op != TokenType::LESS &&
+                       instruction.op != TokenType::LESS_EQUAL
+                   ? ValueType::NUMBER
+                   : ValueType::BOOL;
+      const std::optional<ValueType> left = types[instruction.operands[0]], right = types[instruction.operands[1]];
+      if (left == ValueType::ANY || right == ValueType::ANY)
+        return ValueType::ANY;
+      if (!left.has_value() || !right.has_value())
+        return std::nullopt;
+      if (*left == *right && (*left == ValueType::NUMBER || *left == ValueType::STRING))
+        return *left;
+      return ValueType::ANY;
+    }
+    default:
+      return ValueType::ANY;
+    }
+  };
+  for (bool again = true; again;) {
+    again = false;
+    for (std::size_t id = 0; id < function.values.size(); ++id) {
+      if (function.values[id].removed)
+        continue;
+      const std::optional<ValueType> type = transfer(function.values[id]);
+      if (type != types[id]) {
+        types[id] = type;
+        again = true;
+      }
+    }
+  }
+
+  std::size_t changes = 0;
+  for (std::size_t id = 0; id < function.values.size(); ++id) {
+    IrInstruction &instruction = function.values[id];
+    instruction.type = types[id].value_or(ValueType::ANY);
+  }
+  for (IrInstruction &instruction : function.values) {
+    if (instruction.removed)
+      continue;
+    auto operand = [&](int i) { return function.values[instruction.operands[i]].type; };
+    switch (instruction.opcode) {
+    case Opcode::CONSTANT:
+    case Opcode::PARAMETER:
+    case Opcode::PHI:
+      instruction.pure = true;
+      break;
+    case Opcode::COPY:
+      // a copy the TypeChecker left a runtime check on may throw.
+      instruction.pure = instruction.declaration != nullptr ? instruction.declaration->check == ValueType::ANY
+                                                            : instruction.annotation == ValueType::ANY;
+      break;
+    case Opcode::UNARY:
+      instruction.pure = instruction.op == TokenType::BANG || operand(0) == ValueType::NUMBER;
+      if (instruction.op == TokenType::MINUS && operand(0) == ValueType::NUMBER) {
+        auto *unary = static_cast<Unary *>(instruction.origin);
+        changes += !unary->numeric;
+        unary->numeric = true;
+      }
+      break;
+    case Opcode::BINARY: {
+      const bool numbers = operand(0) == ValueType::NUMBER && operand(1) == ValueType::NUMBER;
+      instruction.pure = instruction.op == TokenType::EQUAL_EQUAL || instruction.op == TokenType::BANG_EQUAL ||
+                         numbers ||
+                         (instruction.op == TokenType::PLUS && operand(0) == ValueType::STRING &&
+                          operand(1) == ValueType::STRING);
+      if (numbers && arithmetic(instruction.op)) {
+        auto *binary = static_cast<Binary *>(instruction.origin);
+        changes += !binary->numeric;
+        binary->numeric = true;
+      }
+      break;
+    }
+    default:
+      instruction.pure = false;
+      break;
+    }
+  }
+  return changes;
+}
+
+// walks the dominator tree, keeping the pure values computed on the way to
+// each block in a scoped table.
+[[nodiscard]] std::size_t IrOptimizer::eliminate_common_subexpressions(IrFunction &function) {
+  const std::vector<int> order = this->reverse_postorder(function);
+  std::vector<int> index(function.blocks.size(), -1), dominator(function.blocks.size(), -1);
+  for (std::size_t i = 0; i < order.size(); ++i)
+    index[order[i]] = static_cast<int>(i);
+  // cooper, harvey and kennedy's iteration over the reverse postorder.
+  dominator[0] = 0;
+  for (bool again = true; again;) {
+    again = false;
+    for (std::size_t i = 1; i < order.size(); ++i) {
+      int idom = -1;
+      for (int predecessor : function.blocks[order[i]].predecessors) {
+        if (index[predecessor] < 0 || dominator[predecessor] < 0)
+          continue;
+        if (idom < 0) {
+          idom = predecessor;
+          continue;
+        }
+        int a = predecessor, b = idom;
+        while (a != b) {
+          while (index[a] > index[b])
+            a = dominator[a];
+          while (index[b] > index[a])
+            b = dominator[b];
+        }
+        idom = a;
+      }
+      if (dominator[order[i]] != idom) {
+        dominator[order[i]] = idom;
+        again = true;
+      }
+    }
+  }
+  std::vector<std::vector<int>> children(function.blocks.size());
+  for (std::size_t i = 1; i < order.size(); ++i)
+    children[dominator[order[i]]].push_back(order[i]);
+
+  auto key = [&](const IrInstruction &instruction) -> std::string {
+    std::string text = std::to_string(static_cast<int>(instruction.opcode)) + ':' +
+                       std::to_string(static_cast<int>(instruction.op));
+    if (instruction.opcode == Opcode::CONSTANT) {
+      text += ':' + std::to_string(instruction.constant.index()) + ':';
+      switch (instruction.constant.index()) {
+      case StringIndex: text += std::get<StringIndex>(instruction.constant); break;
+      case DoubleIndex: {
+        char buffer[32];
+        text.append(buffer, std::to_chars(buffer, buffer + sizeof buffer, std::get<DoubleIndex>(instruction.constant)).ptr);
+        break;
+      }
+      case BoolIndex: text += std::get<BoolIndex>(instruction.constant) ? '1' : '0'; break;
+      case IntegerIndex: text += std::to_string(std::get<IntegerIndex>(instruction.constant)); break;
+      default: break;
+      }
+      return text;
+    }
+    std::vector<int> operands = instruction.operands;
+    if (instruction.opcode == Opcode::BINARY &&
+        commutative(instruction.op, function.values[operands[0]].type == function.values[operands[1]].type
+                                        ? function.values[operands[0]].type
+                                        : ValueType::ANY))
+      std::sort(operands.begin(), operands.end());
+    for (int operand : operands)
+      text += ':' + std::to_string(operand);
+    return text;
+  };
+
+  std::size_t changes = 0;
+  std::unordered_map<std::string, int> available;
+  std::vector<std::string> scoped;
+  // a block is entered when its mark is negative and left when it is not.
+  std::vector<std::pair<int, int>> stack{{0, -1}};
+  while (!stack.empty()) {
+    auto [block, mark] = stack.back();
+    stack.pop_back();
+    if (mark >= 0) {
+      while (static_cast<int>(scoped.size()) > mark) {
+        available.erase(scoped.back());
+        scoped.pop_back();
+      }
+      continue;
+    }
+    stack.emplace_back(block, static_cast<int>(scoped.size()));
+    for (int id : function.blocks[block].instructions) {
+      IrInstruction &instruction = function.values[id];
+      if (instruction.removed || !instruction.pure ||
+          (instruction.opcode != Opcode::CONSTANT && instruction.opcode != Opcode::BINARY &&
+           instruction.opcode != Opcode::UNARY))
+        continue;
+      for (int &operand : instruction.operands)
+        operand = function.resolve(operand);
+      std::string text = key(instruction);
+      if (auto it = available.find(text); it != available.end()) {
+        function.replace(id, it->second);
+        changes += instruction.opcode != Opcode::CONSTANT;
+        continue;
+      }
+      available.emplace(text, id);
+      scoped.push_back(std::move(text));
+    }
+    for (int child : children[block])
+      stack.emplace_back(child, -1);
+  }
+  for (IrInstruction &instruction : function.values)
+    for (int &operand : instruction.operands)
+      operand = function.resolve(operand);
+  return changes;
+}
+
+// inner loops first, so a value can move out of several nested loops.
+[[nodiscard]] std::size_t IrOptimizer::hoist_invariants(IrFunction &function) {
+  this->live.assign(function.loops.size(), {});
+  for (std::size_t loop = 0; loop < function.loops.size(); ++loop)
+    for (auto [name, value] : function.loops[loop].definitions)
+      this->live[loop].emplace(function.resolve(value), name);
+  auto position = [&](int value) {
+    const IrInstruction &instruction = function.values[value];
+    return instruction.hoisted >= 0 ? function.loops[instruction.hoisted].preheader : instruction.block;
+  };
+
+  std::size_t changes = 0;
+  for (int loop = static_cast<int>(function.loops.size()) - 1; loop >= 0; --loop) {
+    const IrLoop &l = function.loops[loop];
+    auto inside = [&](int block) { return block >= l.header && block < l.end; };
+    for (bool again = true; again;) {
+      again = false;
+      for (int block = l.header; block < l.end; ++block)
+        for (int id : function.blocks[block].instructions) {
+          IrInstruction &instruction = function.values[id];
+          if (instruction.removed || !instruction.pure ||
+              (instruction.opcode != Opcode::BINARY && instruction.opcode != Opcode::UNARY) ||
+              !inside(position(id)) ||
+              std::any_of(instruction.operands.begin(), instruction.operands.end(),
+                          [&](int operand) { return inside(position(operand)); }) ||
+              !std::all_of(instruction.operands.begin(), instruction.operands.end(),
+                           [&](int operand) { return this->materializable(function, operand, loop, 1); }))
+            continue;
+          changes += instruction.hoisted < 0;
+          instruction.hoisted = loop;
+          again = true;
+        }
+    }
+  }
+  return changes;
+}
+
+[[nodiscard]] std::size_t IrOptimizer::eliminate_dead_code(IrFunction &function) {
+  std::vector<bool> reachable(function.blocks.size());
+  for (int block : this->reverse_postorder(function))
+    reachable[block] = true;
+  std::size_t changes = 0;
+  for (std::size_t block = 0; block < function.blocks.size(); ++block)
+    if (!reachable[block])
+      for (int id : function.blocks[block].instructions)
+        if (!function.values[id].removed) {
+          function.values[id].removed = true;
+          ++changes;
+        }
+
+  std::vector<bool> used(function.values.size());
+  std::vector<int> work;
+  for (std::size_t id = 0; id < function.values.size(); ++id)
+    if (!function.values[id].removed && !function.values[id].pure)
+      work.push_back(static_cast<int>(id));
+  while (!work.empty()) {
+    const int id = work.back();
+    work.pop_back();
+    if (used[id])
+      continue;
+    used[id] = true;
+    for (int operand : function.values[id].operands)
+      work.push_back(operand);
+  }
+  for (std::size_t id = 0; id < function.values.size(); ++id) {
+    IrInstruction &instruction = function.values[id];
+    // a store nobody reads is dropped when lowering.
+    if (instruction.opcode == Opcode::COPY && !instruction.read && instruction.annotation == ValueType::ANY)
+      ++changes;
+    else if (!instruction.removed && instruction.pure && !used[id] && instruction.hoisted < 0) {
+      instruction.removed = true;
+      ++changes;
+    }
+  }
+  return changes;
+}
+
+[[nodiscard]] std::vector<int> IrOptimizer::reverse_postorder(const IrFunction &function) const {
+  std::vector<int> order;
+  std::vector<bool> visited(function.blocks.size());
+  // a block is finished when its successor index runs past the end.
+  std::vector<std::pair<int, std::size_t>> stack{{0, 0}};
+  visited[0] = true;
+  while (!stack.empty()) {
+    auto &[block, next] = stack.back();
+    const std::vector<int> &instructions = function.blocks[block].instructions;
+    const std::vector<int> *targets = nullptr;
+    if (!instructions.empty()) {
+      const IrInstruction &last = function.values[instructions.back()];
+      if (last.opcode == Opcode::BRANCH || last.opcode == Opcode::JUMP)
+        targets = &last.targets;
+    }
+    if (targets != nullptr && next < targets->size()) {
+      const int successor = (*targets)[next++];
+      if (!visited[successor]) {
+        visited[successor] = true;
+        stack.emplace_back(successor, 0);
+      }
+      continue;
+    }
+    order.push_back(block);
+    stack.pop_back();
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+// whether value can be computed in front of loop from constants, variables
+// holding values there and temporaries of values hoisted out of it.
+[[nodiscard]] bool IrOptimizer::materializable(IrFunction &function, int value, int loop, int depth) {
+  const IrInstruction &instruction = function.values[value];
+  if (instruction.opcode == Opcode::CONSTANT || this->live[loop].contains(value) ||
+      (instruction.hoisted >= 0 && this->encloses(function, instruction.hoisted, loop)))
+    return true;
+  if (depth >= materialize_depth || !instruction.pure ||
+      (instruction.opcode != Opcode::BINARY && instruction.opcode != Opcode::UNARY))
+    return false;
+  return std::all_of(instruction.operands.begin(), instruction.operands.end(),
+                     [&](int operand) { return this->materializable(function, operand, loop, depth + 1); });
+}
+
+[[nodiscard]] std::shared_ptr<Expr> IrOptimizer::materialize(IrFunction &function, int value, int loop, bool root) {
+  const IrInstruction &instruction = function.values[value];
+  if (instruction.opcode == Opcode::CONSTANT)
+    return std::make_shared<Literal>(instruction.constant);
+  if (!root && instruction.hoisted >= 0 && this->encloses(function, instruction.hoisted, loop))
+    return std::make_shared<Variable>(*this->temporaries.at(value));
+  if (!root)
+    if (auto it = this->live[loop].find(value); it != this->live[loop].end())
+      return std::make_shared<Variable>(*it->second);
+  if (instruction.opcode == Opcode::UNARY) {
+    const auto *unary = static_cast<const Unary *>(instruction.origin);
+    auto result = std::make_shared<Unary>(unary->op, this->materialize(function, instruction.operands[0], loop, false));
+    result->numeric = unary->numeric;
+    return result;
+  }
+  const auto *binary = static_cast<const Binary *>(instruction.origin);
+  auto result = std::make_shared<Binary>(this->materialize(function, instruction.operands[0], loop, false), binary->op,
+                                         this->materialize(function, instruction.operands[1], loop, false));
+  result->numeric = binary->numeric;
+  return result;
+}
+
+[[nodiscard]] bool IrOptimizer::encloses(const IrFunction &function, int outer, int loop) const {
+  for (; loop >= 0; loop = function.loops[loop].parent)
+    if (loop == outer)
+      return true;
+  return false;
+}
+
+// picks the temporaries: one per hoisted value, and one per value computed
+// by an expression and reused by another one after it, when that saves more
+// than a single operation or saves it in a loop.
+void IrOptimizer::plan(const std::vector<std::shared_ptr<Stmt>> &body) {
+  IrFunction &function = *this->function;
+  this->hoisted.assign(function.loops.size(), {});
+  for (std::size_t id = 0; id < function.values.size(); ++id) {
+    const IrInstruction &instruction = function.values[id];
+    if (instruction.hoisted >= 0) {
+      this->hoisted[instruction.hoisted].push_back(static_cast<int>(id));
+      this->temporaries[static_cast<int>(id)] = &this->temporary("0licm", instruction.origin);
+    }
+  }
+  for (std::size_t loop = 0; loop < function.loops.size(); ++loop)
+    if (!this->hoisted[loop].empty())
+      this->hoists[function.loops[loop].hoist] = static_cast<int>(loop);
+
+  // a reused value needs its computing occurrence to run, and hides the
+  // expressions nested in its other occurrences; dropping one value can
+  // only uncover occurrences of the others, so this settles.
+  for (bool first = true;; first = false) {
+    this->occurrences.clear();
+    this->statements.clear();
+    this->defined.clear();
+    this->invariant.clear();
+    for (std::size_t i = 0; i < body.size(); ++i) {
+      this->statement = static_cast<int>(i);
+      this->count(body[i]);
+    }
+    std::set<int> next;
+    for (auto [value, count] : this->occurrences) {
+      if (count < 2 || !this->defined.contains(value) || (!first && !this->reused.contains(value)))
+        continue;
+      // reusing a single operation saves no more than reading a variable
+      // costs, unless it saves it in a loop.
+      const std::vector<int> &operands = function.values[value].operands;
+      if (!this->invariant.contains(value) && std::none_of(operands.begin(), operands.end(), [&](int operand) {
+            const Opcode opcode = function.values[operand].opcode;
+            return opcode == Opcode::BINARY || opcode == Opcode::UNARY;
+          }))
+        continue;
+      if (function.script()) {
+        const int statement = this->statements[value];
+        if (statement < 0)
+          continue;
+        const StmtKind kind = body[statement]->kind;
+        if (kind == StmtKind::VAR || kind == StmtKind::FUNCTION || kind == StmtKind::CLASS)
+          continue;
+      }
+      next.insert(value);
+    }
+    if (!first && next == this->reused)
+      break;
+    this->reused = std::move(next);
+  }
+  this->statement = -1;
+  for (int value : this->reused)
+    this->temporaries[value] = &this->temporary("0cse", function.values[value].origin);
+}
+
+void IrOptimizer::count(const std::shared_ptr<Stmt> &stmt) {
+  const auto hoist = this->hoists.find(stmt.get());
+  if (hoist != this->hoists.end())
+    this->in_scope.insert(hoist->second);
+  switch (stmt->kind) {
+  case StmtKind::BLOCK:
+    for (const std::shared_ptr<Stmt> &statement : std::static_pointer_cast<Block>(stmt)->statements)
+      this->count(statement);
+    break;
+  case StmtKind::EXPRESSION:
+    this->count(std::static_pointer_cast<Expression>(stmt)->expression);
+    break;
+  case StmtKind::IF: {
+    auto branch = std::static_pointer_cast<If>(stmt);
+    this->count(branch->condition);
+    this->count(branch->then_branch);
+    if (branch->else_branch != nullptr)
+      this->count(branch->else_branch);
+    break;
+  }
+  case StmtKind::PRINT:
+    this->count(std::static_pointer_cast<Print>(stmt)->expression);
+    break;
+  case StmtKind::RETURN:
+    if (auto value = std::static_pointer_cast<Return>(stmt)->value; value != nullptr)
+      this->count(value);
+    break;
+  case StmtKind::VAR:
+    if (auto initializer = std::static_pointer_cast<Var>(stmt)->initializer; initializer != nullptr)
+      this->count(initializer);
+    break;
+  case StmtKind::WHILE: {
+    auto loop = std::static_pointer_cast<While>(stmt);
+    this->count(loop->condition);
+    this->count(loop->body);
+    break;
+  }
+  default:
+    break;
+  }
+  if (hoist != this->hoists.end())
+    this->in_scope.erase(hoist->second);
+}
+
+void IrOptimizer::count(const std::shared_ptr<Expr> &expr) {
+  switch (expr->kind) {
+  case ExprKind::ASSIGN:
+    this->count(std::static_pointer_cast<Assign>(expr)->value);
+    break;
+  case ExprKind::BINARY:
+  case ExprKind::UNARY: {
+    const int value = this->value_of(expr.get());
+    if (value >= 0) {
+      const IrInstruction &instruction = this->function->values[value];
+      if (instruction.hoisted >= 0) {
+        if (this->in_scope.contains(instruction.hoisted))
+          return;
+      } else {
+        ++this->occurrences[value];
+        auto [it, inserted] = this->statements.emplace(value, this->statement);
+        if (!inserted && it->second != this->statement)
+          it->second = -1;
+        if (instruction.origin == expr.get())
+          this->defined.insert(value);
+        else {
+          // an occurrence in a loop the computing one is not in repeats
+          // the work on every iteration.
+          const IrInstruction &original = this->function->values[this->function->values_of.at(expr.get())];
+          if (this->function->blocks[original.block].loop != this->function->blocks[instruction.block].loop)
+            this->invariant.insert(value);
+          if (this->reused.contains(value))
+            return;
+        }
+      }
+    }
+    if (expr->kind == ExprKind::UNARY) {
+      this->count(std::static_pointer_cast<Unary>(expr)->right);
+      break;
+    }
+    auto binary = std::static_pointer_cast<Binary>(expr);
+    this->count(binary->left);
+    this->count(binary->right);
+    break;
+  }
+  case ExprKind::CALL: {
+    auto call = std::static_pointer_cast<Call>(expr);
+    this->count(call->callee);
+    for (const std::shared_ptr<Expr> &argument : call->arguments)
+      this->count(argument);
+    break;
+  }
+  case ExprKind::GET:
+    this->count(std::static_pointer_cast<Get>(expr)->object);
+    break;
+  case ExprKind::GROUPING:
+    this->count(std::static_pointer_cast<Grouping>(expr)->expression);
+    break;
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    this->count(logical->left);
+    this->count(logical->right);
+    break;
+  }
+  case ExprKind::SET: {
+    auto set = std::static_pointer_cast<Set>(expr);
+    this->count(set->object);
+    this->count(set->value);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+// returns the statement itself when nothing in it changed, and null when it
+// is removed.
+[[nodiscard]] std::shared_ptr<Stmt> IrOptimizer::lower(const std::shared_ptr<Stmt> &stmt) {
+  const auto hoist = this->hoists.find(stmt.get());
+  if (hoist == this->hoists.end())
+    return this->lower_statement(stmt);
+  const int loop = hoist->second;
+  this->in_scope.insert(loop);
+  std::shared_ptr<Stmt> lowered = this->lower_statement(stmt);
+  this->in_scope.erase(loop);
+  std::vector<std::shared_ptr<Stmt>> statements;
+  for (int value : this->hoisted[loop])
+    statements.push_back(
+      std::make_shared<Var>(*this->temporaries.at(value), this->materialize(*this->function, value, loop, true)));
+  statements.push_back(std::move(lowered));
+  return std::make_shared<Block>(std::move(statements));
+}
+
+[[nodiscard]] std::shared_ptr<Stmt> IrOptimizer::lower_statement(const std::shared_ptr<Stmt> &stmt) {
+  switch (stmt->kind) {
+  case StmtKind::BLOCK: {
+    auto block = std::static_pointer_cast<Block>(stmt);
+    bool changed = false;
+    std::vector<std::shared_ptr<Stmt>> statements;
+    for (const std::shared_ptr<Stmt> &statement : block->statements) {
+      std::shared_ptr<Stmt> lowered = this->lower(statement);
+      changed = changed || lowered != statement;
+      if (lowered != nullptr)
+        statements.push_back(std::move(lowered));
+    }
+    return changed ? std::make_shared<Block>(std::move(statements)) : stmt;
+  }
+  case StmtKind::EXPRESSION: {
+    auto expression = std::static_pointer_cast<Expression>(stmt);
+    if (this->pure(expression->expression))
+      return nullptr;
+    std::shared_ptr<Expr> lowered = this->lower(expression->expression);
+    return lowered != expression->expression ? std::make_shared<Expression>(std::move(lowered)) : stmt;
+  }
+  case StmtKind::IF: {
+    auto branch = std::static_pointer_cast<If>(stmt);
+    std::shared_ptr<Expr> condition = this->lower(branch->condition);
+    std::shared_ptr<Stmt> then_branch = this->lower(branch->then_branch);
+    std::shared_ptr<Stmt> else_branch = branch->else_branch != nullptr ? this->lower(branch->else_branch) : nullptr;
+    if (condition == branch->condition && then_branch == branch->then_branch && else_branch == branch->else_branch)
+      return stmt;
+    if (then_branch == nullptr)
+      then_branch = std::make_shared<Block>(std::vector<std::shared_ptr<Stmt>>{});
+    return std::make_shared<If>(std::move(condition), std::move(then_branch), std::move(else_branch));
+  }
+  case StmtKind::PRINT: {
+    auto print = std::static_pointer_cast<Print>(stmt);
+    std::shared_ptr<Expr> lowered = this->lower(print->expression);
+    return lowered != print->expression ? std::make_shared<Print>(std::move(lowered)) : stmt;
+  }
+  case StmtKind::RETURN: {
+    auto ret = std::static_pointer_cast<Return>(stmt);
+    if (ret->value == nullptr)
+      return stmt;
+    std::shared_ptr<Expr> lowered = this->lower(ret->value);
+    if (lowered == ret->value)
+      return stmt;
+    auto result = std::make_shared<Return>(ret->keyword, std::move(lowered));
+    result->check = ret->check;
+    return result;
+  }
+  case StmtKind::VAR: {
+    auto var = std::static_pointer_cast<Var>(stmt);
+    if (var->initializer == nullptr)
+      return stmt;
+    std::shared_ptr<Expr> lowered;
+    // nothing reads the variable before it is assigned again.
+    auto copy = this->function->copies.find(var.get());
+    if (copy == this->function->copies.end() || this->function->values[copy->second].read ||
+        var->type != ValueType::ANY || !this->pure(var->initializer))
+      lowered = this->lower(var->initializer);
+    else if (var->initializer->kind == ExprKind::LITERAL)
+      return stmt;
+    else
+      lowered = this->placeholder(this->function->values[this->function->values[copy->second].operands[0]].type);
+    if (lowered == var->initializer)
+      return stmt;
+    auto result = std::make_shared<Var>(var->name, std::move(lowered));
+    result->type = var->type;
+    result->check = var->check;
+    return result;
+  }
+  case StmtKind::WHILE: {
+    auto loop = std::static_pointer_cast<While>(stmt);
+    std::shared_ptr<Expr> condition = this->lower(loop->condition);
+    std::shared_ptr<Stmt> body = this->lower(loop->body);
+    if (condition == loop->condition && body == loop->body)
+      return stmt;
+    if (body == nullptr)
+      body = std::make_shared<Block>(std::vector<std::shared_ptr<Stmt>>{});
+    return std::make_shared<While>(std::move(condition), std::move(body));
+  }
+  default:
+    // functions and classes are optimized on their own.
+    return stmt;
+  }
+}
+
+[[nodiscard]] std::shared_ptr<Expr> IrOptimizer::lower(const std::shared_ptr<Expr> &expr) {
+  switch (expr->kind) {
+  case ExprKind::ASSIGN: {
+    auto assign = std::static_pointer_cast<Assign>(expr);
+    std::shared_ptr<Expr> value = this->lower(assign->value);
+    if (this->dead(*assign))
+      return value;
+    if (value == assign->value)
+      return expr;
+    auto result = std::make_shared<Assign>(assign->name, std::move(value));
+    result->check = assign->check;
+    return result;
+  }
+  case ExprKind::BINARY:
+  case ExprKind::UNARY: {
+    const int value = this->value_of(expr.get());
+    bool define = false;
+    if (value >= 0) {
+      const IrInstruction &instruction = this->function->values[value];
+      if ((instruction.hoisted >= 0 && this->in_scope.contains(instruction.hoisted)) ||
+          (this->reused.contains(value) && instruction.origin != expr.get()))
+        return std::make_shared<Variable>(*this->temporaries.at(value));
+      define = this->reused.contains(value);
+    }
+    std::shared_ptr<Expr> lowered = expr;
+    if (expr->kind == ExprKind::UNARY) {
+      auto unary = std::static_pointer_cast<Unary>(expr);
+      if (auto right = this->lower(unary->right); right != unary->right) {
+        auto result = std::make_shared<Unary>(unary->op, std::move(right));
+        result->numeric = unary->numeric;
+        lowered = result;
+      }
+    } else {
+      auto binary = std::static_pointer_cast<Binary>(expr);
+      auto left = this->lower(binary->left);
+      auto right = this->lower(binary->right);
+      if (left != binary->left || right != binary->right) {
+        auto result = std::make_shared<Binary>(std::move(left), binary->op, std::move(right));
+        result->numeric = binary->numeric;
+        lowered = result;
+      }
+    }
+    if (define)
+      return std::make_shared<Assign>(*this->temporaries.at(value), std::move(lowered));
+    return lowered;
+  }
+  case ExprKind::CALL: {
+    auto call = std::static_pointer_cast<Call>(expr);
+    std::shared_ptr<Expr> callee = this->lower(call->callee);
+    bool changed = callee != call->callee;
+    std::vector<std::shared_ptr<Expr>> arguments;
+    for (const std::shared_ptr<Expr> &argument : call->arguments) {
+      arguments.push_back(this->lower(argument));
+      changed = changed || arguments.back() != argument;
+    }
+    return changed ? std::make_shared<Call>(std::move(callee), call->paren, std::move(arguments)) : expr;
+  }
+  case ExprKind::GET: {
+    auto get = std::static_pointer_cast<Get>(expr);
+    std::shared_ptr<Expr> object = this->lower(get->object);
+    return object != get->object ? std::make_shared<Get>(std::move(object), get->name) : expr;
+  }
+  case ExprKind::GROUPING: {
+    auto grouping = std::static_pointer_cast<Grouping>(expr);
+    std::shared_ptr<Expr> inner = this->lower(grouping->expression);
+    return inner != grouping->expression ? std::make_shared<Grouping>(std::move(inner)) : expr;
+  }
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    std::shared_ptr<Expr> left = this->lower(logical->left), right = this->lower(logical->right);
+    if (left == logical->left && right == logical->right)
+      return expr;
+    return std::make_shared<Logical>(std::move(left), logical->op, std::move(right));
+  }
+  case ExprKind::SET: {
+    auto set = std::static_pointer_cast<Set>(expr);
+    std::shared_ptr<Expr> object = this->lower(set->object), value = this->lower(set->value);
+    if (object == set->object && value == set->value)
+      return expr;
+    return std::make_shared<Set>(std::move(object), set->name, std::move(value));
+  }
+  default:
+    return expr;
+  }
+}
+
+// whether evaluating expr has no effect and never throws. the expression
+// computing a reused value has one: it stores the temporary.
+[[nodiscard]] bool IrOptimizer::pure(const std::shared_ptr<Expr> &expr) {
+  switch (expr->kind) {
+  case ExprKind::ASSIGN: {
+    auto assign = std::static_pointer_cast<Assign>(expr);
+    return this->dead(*assign) && this->pure(assign->value);
+  }
+  case ExprKind::BINARY:
+  case ExprKind::UNARY: {
+    const int value = this->value_of(expr.get());
+    if (value < 0 || !this->function->values[value].pure ||
+        (this->reused.contains(value) && this->function->values[value].origin == expr.get()))
+      return false;
+    if (expr->kind == ExprKind::UNARY)
+      return this->pure(std::static_pointer_cast<Unary>(expr)->right);
+    auto binary = std::static_pointer_cast<Binary>(expr);
+    return this->pure(binary->left) && this->pure(binary->right);
+  }
+  case ExprKind::GROUPING:
+    return this->pure(std::static_pointer_cast<Grouping>(expr)->expression);
+  case ExprKind::LITERAL:
+  case ExprKind::THIS:
+    return true;
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    return this->pure(logical->left) && this->pure(logical->right);
+  }
+  case ExprKind::VARIABLE:
+    // reading an undefined global throws.
+    return std::static_pointer_cast<Variable>(expr)->depth >= 0;
+  default:
+    return false;
+  }
+}
+
+// an assignment to a local that nothing reads before the next one.
+[[nodiscard]] bool IrOptimizer::dead(const Assign &assign) {
+  auto copy = this->function->values_of.find(&assign);
+  if (copy == this->function->values_of.end())
+    return false;
+  const IrInstruction &instruction = this->function->values[copy->second];
+  return instruction.opcode == Opcode::COPY && !instruction.read && assign.check == ValueType::ANY;
+}
+
+[[nodiscard]] int IrOptimizer::value_of(const Expr *expr) {
+  auto it = this->function->values_of.find(expr);
+  return it != this->function->values_of.end() ? this->function->resolve(it->second) : -1;
+}
+
+// a `var` of the temporary, initialized to a value of its type.
+[[nodiscard]] std::shared_ptr<Stmt> IrOptimizer::declare(int value) {
+  return std::make_shared<Var>(*this->temporaries.at(value), this->placeholder(this->function->values[value].type));
+}
+
+// the cheapest value of a type, for variables assigned before they are read;
+// the JIT only compiles locals with an initializer of their type.
+[[nodiscard]] std::shared_ptr<Expr> IrOptimizer::placeholder(ValueType type) {
+  switch (type) {
+  case ValueType::NUMBER: return std::make_shared<Literal>(std::int64_t{0});
+  case ValueType::STRING: return std::make_shared<Literal>(std::string());
+  case ValueType::BOOL: return std::make_shared<Literal>(false);
+  default: return nullptr;
+  }
+}
+
+[[nodiscard]] const Token &IrOptimizer::temporary(const std::string &prefix, const Expr *origin) {
+  const int line = origin->kind == ExprKind::UNARY ? static_cast<const Unary *>(origin)->op.line
+                                                   : static_cast<const Binary *>(origin)->op.line;
+  return this->tokens.emplace_back(TokenType::IDENTIFIER, prefix + std::to_string(this->next_temporary++), line,
+                                   this->lexicon);
+}
+}// namespace loxplusplus
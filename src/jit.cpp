@@ -0,0 +1,489 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <cstring>
+
+#include "../include/interpreter.hpp"
+#include "../include/jit.hpp"
+
+#ifdef LOX_JIT_SUPPORTED
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace loxplusplus {
+static constexpr X64Emitter::Register parameter_registers[Jit::max_parameters]{
+  X64Emitter::RSI, X64Emitter::RDX, X64Emitter::RCX, X64Emitter::R8, X64Emitter::R9};
+
+Jit::Jit(std::size_t threshold)
+    : threshold{threshold} {
+}
+
+Jit::~Jit() {
+#ifdef LOX_JIT_SUPPORTED
+  for (const auto &[address, size] : this->regions)
+    munmap(address, size);
+#endif
+  if (this->perf_map != nullptr)
+    std::fclose(this->perf_map);
+}
+
+[[nodiscard]] std::optional<Object> Jit::call(Interpreter &interpreter,
+                                              const std::shared_ptr<Function> &declaration,
+                                              const std::vector<Object> &arguments) {
+  Entry &entry = this->entries[declaration.get()];
+  if (entry.failed)
+    return std::nullopt;
+  if (entry.code == nullptr) {
+    if (entry.calls++ < this->threshold)
+      return std::nullopt;
+    if (!this->compile(*declaration, entry)) {
+      entry.failed = true;
+      return std::nullopt;
+    }
+  }
+  std::int64_t values[Jit::max_parameters]{};
+  for (std::size_t i = 0; i < arguments.size(); ++i) {
+    if (!is_integer(arguments[i]))
+      return std::nullopt;
+    values[i] = std::get<IntegerIndex>(arguments[i]);
+  }
+  // recursive calls are compiled as direct calls, which is only valid while
+  // the global still refers to this function.
+  if (entry.self_call) {
+    const Object *self = interpreter.global_slots.find(declaration->slot);
+    if (self == nullptr || self->index() != LoxFunctionIndex ||
+        std::get<LoxFunctionIndex>(*self)->declaration != declaration)
+      return std::nullopt;
+  }
+  std::int64_t bail[2] = {0, static_cast<std::int64_t>(interpreter.stack_limit)};
+  const std::int64_t result = entry.code(bail, values[0], values[1], values[2], values[3], values[4]);
+  if (bail[0] != 0) {
+    if (++entry.bails >= Jit::max_bails)
+      entry.failed = true;
+    return std::nullopt;
+  }
+  return result;
+}
+
+[[nodiscard]] bool Jit::compile(const Function &declaration, Entry &entry) {
+#ifdef LOX_JIT_SUPPORTED
+  if (declaration.params.size() > Jit::max_parameters)
+    return false;
+  JitCompiler compiler{declaration};
+  if (!compiler.compile())
+    return false;
+  void *address = this->install(compiler.code(), declaration.name.lexeme);
+  if (address == nullptr)
+    return false;
+  entry.code = reinterpret_cast<Code>(address);
+  entry.self_call = compiler.calls_itself();
+  return true;
+#else
+  return false;
+#endif
+}
+
+// copies the code into its own executable mapping and registers it in
+// /tmp/perf-<pid>.map so `perf report` can symbolize jitted frames.
+[[nodiscard]] void *Jit::install(const std::vector<std::uint8_t> &code, const std::string &name) {
+#ifdef LOX_JIT_SUPPORTED
+  void *address = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (address == MAP_FAILED)
+    return nullptr;
+  std::memcpy(address, code.data(), code.size());
+  if (mprotect(address, code.size(), PROT_READ | PROT_EXEC) != 0) {
+    munmap(address, code.size());
+    return nullptr;
+  }
+  this->regions.emplace_back(address, code.size());
+  if (this->perf_map == nullptr)
+    this->perf_map = std::fopen(("/tmp/perf-" + std::to_string(getpid()) + ".map").c_str(), "a");
+  if (this->perf_map != nullptr) {
+    std::fprintf(this->perf_map, "%lx %zx lox::%s\n",
+                 reinterpret_cast<unsigned long>(address), code.size(), name.c_str());
+    std::fflush(this->perf_map);
+  }
+  return address;
+#else
+  return nullptr;
+#endif
+}
+
+JitCompiler::JitCompiler(const Function &function)
+    : function{function} {
+}
+
+// frame layout: [rbp - 8] holds the bail flag pointer, parameters and locals
+// follow in declaration order. a frame below the interpreter's stack limit
+// bails, so the interpreter reports the overflow. falling off the end of the body returns nil,
+// which native code cannot represent, so it bails like any failed guard.
+[[nodiscard]] bool JitCompiler::compile() {
+  this->entry = this->emitter.new_label();
+  this->bail = this->emitter.new_label();
+  this->epilogue = this->emitter.new_label();
+  this->emitter.bind(this->entry);
+  this->emitter.push(X64Emitter::RBP);
+  this->emitter.mov(X64Emitter::RBP, X64Emitter::RSP);
+  const std::size_t frame = this->emitter.sub_rsp_placeholder();
+  this->emitter.store(-8, X64Emitter::RDI);
+  this->emitter.cmp(X64Emitter::RSP, X64Emitter::RDI, 8);
+  this->emitter.jump(X64Emitter::BELOW, this->bail);
+  this->scopes.emplace_back();
+  for (std::size_t i = 0; i < this->function.params.size(); ++i) {
+    const Local &local = this->declare(this->function.params[i].lexeme, Type::INTEGER);
+    this->emitter.store(local.offset, parameter_registers[i]);
+  }
+  try {
+    this->compile(this->function.body());
+  } catch (const Unsupported &) {
+    return false;
+  }
+  this->emitter.bind(this->bail);
+  this->emitter.load(X64Emitter::RCX, -8);
+  this->emitter.store_indirect(X64Emitter::RCX, 1);
+  this->emitter.bind(this->epilogue);
+  this->emitter.mov(X64Emitter::RSP, X64Emitter::RBP);
+  this->emitter.pop(X64Emitter::RBP);
+  this->emitter.ret();
+  this->emitter.patch_imm32(frame, (this->frame_size + 15) & ~15);
+  return true;
+}
+
+[[nodiscard]] const std::vector<std::uint8_t> &JitCompiler::code() {
+  return this->emitter.finish();
+}
+
+[[nodiscard]] bool JitCompiler::calls_itself() const {
+  return this->self_call;
+}
+
+void JitCompiler::compile(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  for (const std::shared_ptr<Stmt> &statement : statements)
+    this->compile(statement);
+}
+
+void JitCompiler::compile(std::shared_ptr<Stmt> stmt) {
+  (void)dispatch(*this, stmt);
+}
+
+[[nodiscard]] JitCompiler::Type JitCompiler::compile(std::shared_ptr<Expr> expr) {
+  (void)dispatch(*this, expr);
+  return this->type;
+}
+
+void JitCompiler::expect(std::shared_ptr<Expr> expr, Type type) {
+  if (this->compile(std::move(expr)) != type)
+    throw Unsupported{};
+}
+
+void JitCompiler::push() {
+  this->emitter.push(X64Emitter::RAX);
+  ++this->pushed;
+}
+
+void JitCompiler::pop(X64Emitter::Register reg) {
+  this->emitter.pop(reg);
+  --this->pushed;
+}
+
+[[nodiscard]] JitCompiler::Local *JitCompiler::find(const std::string &name) {
+  for (auto scope = this->scopes.rbegin(); scope != this->scopes.rend(); ++scope) {
+    if (auto it = scope->find(name); it != scope->end())
+      return &it->second;
+  }
+  return nullptr;
+}
+
+[[nodiscard]] JitCompiler::Local &JitCompiler::declare(const std::string &name, Type type) {
+  const std::int32_t offset = this->next_offset;
+  this->next_offset -= 8;
+  this->frame_size = -this->next_offset - 8;
+  return this->scopes.back()[name] = Local{offset, type};
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Block> stmt) {
+  this->scopes.emplace_back();
+  this->compile(stmt->statements);
+  this->scopes.pop_back();
+  return nullptr;
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Class> stmt) {
+  throw Unsupported{};
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Expression> stmt) {
+  (void)this->compile(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Function> stmt) {
+  throw Unsupported{};
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<If> stmt) {
+  X64Emitter::Label otherwise = this->emitter.new_label(), end = this->emitter.new_label();
+  this->expect(stmt->condition, Type::BOOLEAN);
+  this->emitter.test(X64Emitter::RAX, X64Emitter::RAX);
+  this->emitter.jump(X64Emitter::EQUAL, otherwise);
+  this->compile(stmt->then_branch);
+  this->emitter.jump(end);
+  this->emitter.bind(otherwise);
+  if (stmt->else_branch != nullptr)
+    this->compile(stmt->else_branch);
+  this->emitter.bind(end);
+  return nullptr;
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Import> stmt) {
+  throw Unsupported{};
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Print> stmt) {
+  throw Unsupported{};
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Return> stmt) {
+  // the integer result can only satisfy a num annotation.
+  if (stmt->value == nullptr || (stmt->check != ValueType::ANY && stmt->check != ValueType::NUMBER))
+    throw Unsupported{};
+  this->expect(stmt->value, Type::INTEGER);
+  this->emitter.jump(this->epilogue);
+  return nullptr;
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Var> stmt) {
+  if (stmt->initializer == nullptr)
+    throw Unsupported{};
+  const Type type = this->compile(stmt->initializer);
+  if (stmt->check != ValueType::ANY && stmt->check != (type == Type::INTEGER ? ValueType::NUMBER : ValueType::BOOL))
+    throw Unsupported{};
+  const Local &local = this->declare(stmt->name.lexeme, type);
+  this->emitter.store(local.offset, X64Emitter::RAX);
+  return nullptr;
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<While> stmt) {
+  X64Emitter::Label start = this->emitter.new_label(), end = this->emitter.new_label();
+  this->emitter.bind(start);
+  this->expect(stmt->condition, Type::BOOLEAN);
+  this->emitter.test(X64Emitter::RAX, X64Emitter::RAX);
+  this->emitter.jump(X64Emitter::EQUAL, end);
+  this->compile(stmt->body);
+  this->emitter.jump(start);
+  this->emitter.bind(end);
+  return nullptr;
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Assign> expr) {
+  Local *local = this->find(expr->name.lexeme);
+  if (local == nullptr)
+    throw Unsupported{};
+  this->expect(expr->value, local->type);
+  this->emitter.store(local->offset, X64Emitter::RAX);
+  this->type = local->type;
+  return nullptr;
+}
+
+// every arithmetic guard mirrors a case where the interpreter would leave the
+// integer representation (beyond 2^53, -0, inexact division) and bails instead.
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Binary> expr) {
+  const Type left = this->compile(expr->left);
+  this->push();
+  const Type right = this->compile(expr->right);
+  this->emitter.mov(X64Emitter::RCX, X64Emitter::RAX);
+  this->pop(X64Emitter::RAX);
+  switch (expr->op.type) {
+  case TokenType::BANG_EQUAL:
+  case TokenType::EQUAL_EQUAL: {
+    if (left != right)
+      throw Unsupported{};
+    this->emitter.cmp(X64Emitter::RAX, X64Emitter::RCX);
+    this->emitter.set(expr->op.type == TokenType::EQUAL_EQUAL ? X64Emitter::EQUAL : X64Emitter::NOT_EQUAL);
+    this->type = Type::BOOLEAN;
+    return nullptr;
+  }
+  default:
+    break;
+  }
+  if (left != Type::INTEGER || right != Type::INTEGER)
+    throw Unsupported{};
+  this->type = Type::INTEGER;
+  switch (expr->op.type) {
+  case TokenType::GREATER:
+  case TokenType::GREATER_EQUAL:
+  case TokenType::LESS:
+  case TokenType::LESS_EQUAL: {
+    this->emitter.cmp(X64Emitter::RAX, X64Emitter::RCX);
+    this->emitter.set(expr->op.type == TokenType::GREATER         ? X64Emitter::GREATER
+                      : expr->op.type == TokenType::GREATER_EQUAL ? X64Emitter::GREATER_EQUAL
+                      : expr->op.type == TokenType::LESS          ? X64Emitter::LESS
+                                                                  : X64Emitter::LESS_EQUAL);
+    this->type = Type::BOOLEAN;
+    break;
+  }
+  case TokenType::PLUS: {
+    this->emitter.add(X64Emitter::RAX, X64Emitter::RCX);
+    this->guard_exact();
+    break;
+  }
+  case TokenType::MINUS: {
+    this->emitter.sub(X64Emitter::RAX, X64Emitter::RCX);
+    this->guard_exact();
+    break;
+  }
+  case TokenType::STAR: {
+    X64Emitter::Label done = this->emitter.new_label();
+    this->emitter.mov(X64Emitter::RDX, X64Emitter::RAX);
+    this->emitter.or_(X64Emitter::RDX, X64Emitter::RCX);
+    this->emitter.imul(X64Emitter::RAX, X64Emitter::RCX);
+    this->emitter.jump(X64Emitter::OVERFLOW_, this->bail);
+    this->emitter.test(X64Emitter::RAX, X64Emitter::RAX);
+    this->emitter.jump(X64Emitter::NOT_EQUAL, done);
+    this->emitter.test(X64Emitter::RDX, X64Emitter::RDX);
+    this->emitter.jump(X64Emitter::SIGN, this->bail);
+    this->emitter.bind(done);
+    this->guard_exact();
+    break;
+  }
+  case TokenType::SLASH: {
+    X64Emitter::Label divide = this->emitter.new_label(), done = this->emitter.new_label();
+    this->emitter.test(X64Emitter::RCX, X64Emitter::RCX);
+    this->emitter.jump(X64Emitter::EQUAL, this->bail);
+    this->emitter.cmp(X64Emitter::RCX, -1);
+    this->emitter.jump(X64Emitter::NOT_EQUAL, divide);
+    this->emitter.neg(X64Emitter::RAX);
+    this->emitter.jump(X64Emitter::OVERFLOW_, this->bail);
+    this->emitter.test(X64Emitter::RAX, X64Emitter::RAX);
+    this->emitter.jump(X64Emitter::EQUAL, this->bail);
+    this->emitter.jump(done);
+    this->emitter.bind(divide);
+    this->emitter.cqo();
+    this->emitter.idiv(X64Emitter::RCX);
+    this->emitter.test(X64Emitter::RDX, X64Emitter::RDX);
+    this->emitter.jump(X64Emitter::NOT_EQUAL, this->bail);
+    this->emitter.test(X64Emitter::RAX, X64Emitter::RAX);
+    this->emitter.jump(X64Emitter::NOT_EQUAL, done);
+    this->emitter.test(X64Emitter::RCX, X64Emitter::RCX);
+    this->emitter.jump(X64Emitter::SIGN, this->bail);
+    this->emitter.bind(done);
+    break;
+  }
+  default:
+    throw Unsupported{};
+  }
+  return nullptr;
+}
+
+// operands are at most 2^53 in magnitude, so a sum or difference cannot
+// overflow 64 bits; only the range needs checking. clobbers rdx.
+void JitCompiler::guard_exact() {
+  this->emitter.mov(X64Emitter::RDX, max_exact_integer);
+  this->emitter.cmp(X64Emitter::RAX, X64Emitter::RDX);
+  this->emitter.jump(X64Emitter::GREATER, this->bail);
+  this->emitter.neg(X64Emitter::RDX);
+  this->emitter.cmp(X64Emitter::RAX, X64Emitter::RDX);
+  this->emitter.jump(X64Emitter::LESS, this->bail);
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Call> expr) {
+  if (expr->callee->kind != ExprKind::VARIABLE)
+    throw Unsupported{};
+  auto callee = std::static_pointer_cast<Variable>(expr->callee);
+  if (callee->name.lexeme != this->function.name.lexeme ||
+      this->find(callee->name.lexeme) != nullptr ||
+      expr->arguments.size() != this->function.params.size())
+    throw Unsupported{};
+  for (const std::shared_ptr<Expr> &argument : expr->arguments) {
+    this->expect(argument, Type::INTEGER);
+    this->push();
+  }
+  for (std::size_t i = expr->arguments.size(); i > 0; --i)
+    this->pop(parameter_registers[i - 1]);
+  const bool align = this->pushed % 2 != 0;
+  if (align)
+    this->emitter.sub_rsp(8);
+  this->emitter.load(X64Emitter::RDI, -8);
+  this->emitter.call(this->entry);
+  if (align)
+    this->emitter.add_rsp(8);
+  this->emitter.load(X64Emitter::RCX, -8);
+  this->emitter.compare_indirect(X64Emitter::RCX, 0);
+  this->emitter.jump(X64Emitter::NOT_EQUAL, this->bail);
+  this->self_call = true;
+  this->type = Type::INTEGER;
+  return nullptr;
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Get> expr) {
+  throw Unsupported{};
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Grouping> expr) {
+  (void)this->compile(expr->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Literal> expr) {
+  if (expr->value.index() == IntegerIndex) {
+    this->emitter.mov(X64Emitter::RAX, std::get<IntegerIndex>(expr->value));
+    this->type = Type::INTEGER;
+  } else if (expr->value.index() == BoolIndex) {
+    this->emitter.mov(X64Emitter::RAX, static_cast<std::int64_t>(std::get<BoolIndex>(expr->value)));
+    this->type = Type::BOOLEAN;
+  } else {
+    throw Unsupported{};
+  }
+  return nullptr;
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Logical> expr) {
+  X64Emitter::Label end = this->emitter.new_label();
+  this->expect(expr->left, Type::BOOLEAN);
+  this->emitter.test(X64Emitter::RAX, X64Emitter::RAX);
+  this->emitter.jump(expr->op.type == TokenType::OR ? X64Emitter::NOT_EQUAL : X64Emitter::EQUAL, end);
+  this->expect(expr->right, Type::BOOLEAN);
+  this->emitter.bind(end);
+  this->type = Type::BOOLEAN;
+  return nullptr;
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Set> expr) {
+  throw Unsupported{};
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Super> expr) {
+  throw Unsupported{};
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<This> expr) {
+  throw Unsupported{};
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Unary> expr) {
+  if (expr->op.type == TokenType::BANG) {
+    this->expect(expr->right, Type::BOOLEAN);
+    this->emitter.xor_(X64Emitter::RAX, 1);
+    return nullptr;
+  }
+  this->expect(expr->right, Type::INTEGER);
+  this->emitter.test(X64Emitter::RAX, X64Emitter::RAX);
+  this->emitter.jump(X64Emitter::EQUAL, this->bail);
+  this->emitter.neg(X64Emitter::RAX);
+  this->emitter.jump(X64Emitter::OVERFLOW_, this->bail);
+  return nullptr;
+}
+
+[[nodiscard]] Object JitCompiler::visit(std::shared_ptr<Variable> expr) {
+  const Local *local = this->find(expr->name.lexeme);
+  if (local == nullptr)
+    throw Unsupported{};
+  this->emitter.load(X64Emitter::RAX, local->offset);
+  this->type = local->type;
+  return nullptr;
+}
+}// namespace loxplusplus
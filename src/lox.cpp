@@ -4,13 +4,13 @@
 // Distributed under the terms of the MIT License.
 //
 
+#include <cstdlib>
 #include <fstream>
 
-#include "../include/error.hpp"
-#include "../include/interpreter.hpp"
-#include "../include/parser.hpp"
-#include "../include/resolver.hpp"
+#include "../include/batch_runner.hpp"
+#include "../include/engine.hpp"
 #include "../include/scanner.hpp"
+#include "../include/server.hpp"
 
 using namespace loxplusplus;
 
@@ -25,36 +25,149 @@ using namespace loxplusplus;
   return std::move(contents);
 }
 
-Interpreter interpreter;
-
-void run(std::string_view source) noexcept {
-  Scanner scanner(std::move(source));
-  std::vector<Token> tokens = scanner.scan_tokens();
-  Parser parser(tokens);
-  auto statements = parser.parse();
-  if (had_error || had_runtime_error)
-    return;
-  Resolver resolver{interpreter};
-  resolver.resolve(statements);
-  if (had_error || had_runtime_error)
-    return;
-  interpreter.interpret(statements);
+void usage() noexcept {
+  std::cout << "Usage: loxpp [--output <file>] [--line-buffered] [--jit] [--jit-threshold <calls>] [--compile-closures] [--lazy-parse] [--dump-ir] [--stats] [--memoize] [--cache <dir>] [--batch <dir-or-list> [--jobs <n>]] [--serve <socket> [--preload <module>]...] [--snapshot-in <file>] [--snapshot-out <file>] [--emit-cpp script] [--check-scan <chunks> script] [script]\n"
+               "       loxpp --client <socket> [arguments]\n";
 }
 
 int main(int argc, char *argv[]) {
-  if (argc > 2) {
-    std::cout << "Usage: loxpp [script]\n";
-  } else if (argc == 2) {
-    run(read_file(argv[1]));
+  // everything after the socket belongs to the server.
+  if (argc >= 3 && std::string_view(argv[1]) == "--client")
+    return Client::run(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+  Engine engine;
+  EngineOptions options;
+  std::string_view script, output_path, batch, serve, snapshot_in, snapshot_out;
+  std::vector<std::string> preload;
+  std::size_t jobs{ThreadPool::default_threads()}, check_scan{0};
+  bool emit_cpp{false}, line_buffered{false};
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--output" && i + 1 < argc) {
+      output_path = argv[++i];
+    } else if (arg == "--line-buffered") {
+      line_buffered = true;
+    } else if (arg == "--jit") {
+      options.jit_threshold = Jit::default_threshold;
+    } else if (arg == "--jit-threshold" && i + 1 < argc) {
+      options.jit_threshold = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--cache" && i + 1 < argc) {
+      options.cache_directory = argv[++i];
+    } else if (arg == "--compile-closures") {
+      options.compile_closures = true;
+    } else if (arg == "--lazy-parse") {
+      options.lazy_parsing = true;
+    } else if (arg == "--dump-ir") {
+      options.dump_ir = true;
+    } else if (arg == "--stats") {
+      options.stats = true;
+    } else if (arg == "--memoize") {
+      options.memoize = true;
+    } else if (arg == "--batch" && i + 1 < argc) {
+      batch = argv[++i];
+    } else if (arg == "--jobs" && i + 1 < argc) {
+      jobs = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--serve" && i + 1 < argc) {
+      serve = argv[++i];
+    } else if (arg == "--preload" && i + 1 < argc) {
+      preload.emplace_back(argv[++i]);
+    } else if (arg == "--snapshot-in" && i + 1 < argc) {
+      snapshot_in = argv[++i];
+    } else if (arg == "--snapshot-out" && i + 1 < argc) {
+      snapshot_out = argv[++i];
+    } else if (arg == "--emit-cpp") {
+      emit_cpp = true;
+    } else if (arg == "--check-scan" && i + 1 < argc) {
+      check_scan = std::strtoull(argv[++i], nullptr, 10);
+    } else if (script.empty() && !arg.starts_with("--")) {
+      script = arg;
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  // functions of the closure compiler have no serialized form.
+  if (options.compile_closures && !snapshot_out.empty()) {
+    std::cerr << "--snapshot-out cannot be combined with --compile-closures.\n";
+    return 1;
+  }
+  // compares a scan forced into chunks with a sequential one.
+  if (check_scan != 0) {
+    if (script.empty() || emit_cpp || !batch.empty() || !serve.empty()) {
+      usage();
+      return 1;
+    }
+    const std::string source = read_file(script);
+    return Scanner::check_chunks(source, check_scan, std::cerr) ? 0 : 1;
+  }
+  if (!serve.empty()) {
+    if (!script.empty() || emit_cpp || !batch.empty()) {
+      usage();
+      return 1;
+    }
+    Diagnostics diagnostics;
+    if (!ModuleCache::preload(preload, diagnostics))
+      return 1;
+    Server server{std::string(serve), options};
+    if (!server.serve()) {
+      std::cerr << "failed to serve on '" << serve << "'.\n";
+      return 1;
+    }
+    return 0;
+  }
+  if (!batch.empty()) {
+    if (!script.empty() || emit_cpp) {
+      usage();
+      return 1;
+    }
+    auto scripts = BatchRunner::collect(std::string(batch));
+    if (!scripts.has_value()) {
+      std::cerr << "failed to read batch '" << batch << "'.\n";
+      return 1;
+    }
+    OutputSink output;
+    if (!output_path.empty() && !output.open(std::string(output_path))) {
+      std::cerr << "failed to open output file '" << output_path << "'.\n";
+      return 1;
+    }
+    output.set_line_buffered(line_buffered);
+    // every script runs in an engine of its own.
+    options.whole_program = true;
+    BatchRunner runner(options, jobs);
+    const BatchRunner::Statistics statistics = runner.run(*scripts, output, std::cerr);
+    BatchRunner::report(statistics, runner.jobs(), std::cerr);
+    return statistics.failed == 0 ? 0 : 1;
+  }
+  if (!output_path.empty() && !engine.open_output(std::string(output_path))) {
+    std::cerr << "failed to open output file '" << output_path << "'.\n";
+    return 1;
+  }
+  engine.set_line_buffered(line_buffered);
+  // the repl and snapshots carry globals from one program to another.
+  options.whole_program = !script.empty() && snapshot_in.empty() && snapshot_out.empty();
+  engine.configure(options);
+  if (!snapshot_in.empty() && !engine.load_snapshot(std::string(snapshot_in))) {
+    std::cerr << "failed to read snapshot '" << snapshot_in << "'.\n";
+    return 1;
+  }
+  if (!script.empty() && emit_cpp) {
+    (void)engine.transpile(read_file(script), script);
+  } else if (!script.empty()) {
+    // a prelude that failed leaves half-initialized globals behind.
+    if (engine.run(read_file(script), script) == Engine::Result::OK && !snapshot_out.empty() &&
+        !engine.save_snapshot(std::string(snapshot_out)))
+      std::cerr << "failed to write snapshot '" << snapshot_out << "'.\n";
+  } else if (emit_cpp) {
+    usage();
+    return 1;
   } else {
     std::string input, temp;
     std::cout << "Running lox++ REPL.\n"
                  "Use 'exit' to exit.\n"
                  "Use '\\' character to continue code on new line.\n";
     while(true) {
+      engine.flush();
       std::cout << "> ";
-      std::getline(std::cin, input);
-      if(input == "exit")
+      if(!std::getline(std::cin, input) || input == "exit")
         break;
       if(!input.empty() && input.back() == '\\') {
         input.pop_back();
@@ -70,8 +183,8 @@ int main(int argc, char *argv[]) {
           }
         }
       }
-      run(input.data());
-      had_error = had_runtime_error = false;
+      (void)engine.run(input);
     }
   }
+  engine.flush();
 }
\ No newline at end of file
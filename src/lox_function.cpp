@@ -8,6 +8,7 @@
 #include "../include/environment.hpp"
 #include "../include/interpreter.hpp"
 #include "../include/lox_instance.hpp"
+#include "../include/memo_table.hpp"
 #include "../include/stmt.hpp"
 
 namespace loxplusplus {
@@ -23,12 +24,36 @@ LoxFunction::LoxFunction(std::shared_ptr<Function> declaration,
 }
 
 [[nodiscard]] Object LoxFunction::call(Interpreter &interpreter, std::vector<Object> arguments) {
+  interpreter.check_stack(this->declaration->name);
+  if (!this->declaration->param_types.empty())
+    this->check_arguments(arguments);
+  // a memoized function runs without the jit, which would not consult the
+  // table on recursive calls.
+  if (const std::shared_ptr<MemoTable> &memo = this->declaration->memo;
+      memo != nullptr && memo->applies(interpreter.global_slots, arguments)) {
+    if (const Object *result = memo->find(arguments); result != nullptr)
+      return *result;
+    std::vector<Object> key = arguments;
+    Object result = this->execute(interpreter, std::move(arguments));
+    memo->insert(std::move(key), result);
+    return result;
+  }
+  if (interpreter.jit != nullptr && !this->is_initializer && this->closure == interpreter.globals) {
+    if (std::optional<Object> result = interpreter.jit->call(interpreter, this->declaration, arguments);
+        result.has_value())
+      return std::move(*result);
+  }
+  return this->execute(interpreter, std::move(arguments));
+}
+
+[[nodiscard]] Object LoxFunction::execute(Interpreter &interpreter, std::vector<Object> arguments) {
   auto environment = std::make_shared<Environment>(closure);
   for (std::size_t i = 0; i < this->declaration->params.size(); ++i) {
     environment->define(this->declaration->params[i].lexeme, arguments[i]);
   }
   try {
-    interpreter.execute_block(declaration->body, environment);
+    const bool replaced = declaration->replaced != nullptr && interpreter.replaceable(*declaration->replaced);
+    interpreter.execute_block(replaced ? declaration->replaced->statements : declaration->body(), environment);
   } catch (const LoxReturnException &return_value) {
     if (this->is_initializer)
       return this->closure->get_at(0, "this");
@@ -36,13 +61,30 @@ LoxFunction::LoxFunction(std::shared_ptr<Function> declaration,
   }
   if (this->is_initializer)
     return this->closure->get_at(0, "this");
+  this->check_fall_through();
   return nullptr;
 }
 
+void LoxFunction::check_arguments(const std::vector<Object> &arguments) const {
+  const std::vector<ValueType> &types = this->declaration->param_types;
+  for (std::size_t i = 0; i < types.size(); ++i)
+    if (types[i] != ValueType::ANY)
+      check_type(this->declaration->params[i], "'" + this->declaration->params[i].lexeme + "'", types[i], arguments[i]);
+}
+
+void LoxFunction::check_fall_through() const {
+  if (this->declaration->return_type != ValueType::ANY)
+    check_type(this->declaration->name, "return value", this->declaration->return_type, nullptr);
+}
+
 [[nodiscard]] std::string LoxFunction::to_string() {
   return "<fn " + declaration->name.lexeme + ">";
 }
 
+[[nodiscard]] bool LoxFunction::declared_by(const Function &declaration) const noexcept {
+  return this->declaration.get() == &declaration;
+}
+
 [[nodiscard]] std::shared_ptr<LoxFunction> LoxFunction::bind(std::shared_ptr<LoxInstance> instance) {
   auto environment = std::make_shared<Environment>(this->closure);
   environment->define("this", instance);
@@ -0,0 +1,293 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <cstdint>
+#include <iostream>
+
+#include "../include/lox_runtime.hpp"
+#include "../include/output_sink.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace loxplusplus::runtime {
+static OutputSink output;
+// lowest stack address calls may reach, set by run(); the same bounds as the
+// interpreter's.
+static std::uintptr_t stack_limit = 0;
+static constexpr std::size_t stack_margin = std::size_t{256} << 10;
+static constexpr std::size_t max_stack_size = std::size_t{4} << 20;
+
+// lowest address of the calling thread's stack, or 0 if it is unknown.
+[[nodiscard]] static std::uintptr_t stack_bottom() {
+#ifdef __linux__
+  pthread_attr_t attributes;
+  if (pthread_getattr_np(pthread_self(), &attributes) != 0)
+    return 0;
+  void *address = nullptr;
+  std::size_t size = 0;
+  const int status = pthread_attr_getstack(&attributes, &address, &size);
+  pthread_attr_destroy(&attributes);
+  if (status == 0)
+    return reinterpret_cast<std::uintptr_t>(address);
+#endif
+  return 0;
+}
+
+static void check_stack(int line) {
+  const char marker = 0;
+  if (reinterpret_cast<std::uintptr_t>(&marker) < stack_limit)
+    throw Error{line, "stack overflow."};
+}
+
+[[nodiscard]] Method *Class::find_method(const std::string &name) const {
+  for (const Class *klass = this; klass != nullptr; klass = klass->superclass.get())
+    if (auto it = klass->methods.find(name); it != klass->methods.end())
+      return it->second.get();
+  return nullptr;
+}
+
+[[nodiscard]] Value function(std::string name, std::size_t arity, std::function<Value(Arguments &)> body) {
+  return std::make_shared<Function>(Function{std::move(name), arity, std::move(body)});
+}
+
+[[nodiscard]] std::shared_ptr<Method> method(std::string name, std::size_t arity, bool is_initializer,
+                                             std::function<Value(const std::shared_ptr<Instance> &, Arguments &)> body) {
+  return std::make_shared<Method>(Method{std::move(name), arity, is_initializer, std::move(body)});
+}
+
+[[nodiscard]] std::shared_ptr<Class> superclass(const Value &value, int line) {
+  if (value.index() != LoxClassIndex)
+    throw Error{line, "superclass must be a class."};
+  return std::get<LoxClassIndex>(value);
+}
+
+static void check_numbers(const Operands &operands, int line) {
+  if (!is_number(operands.left) || !is_number(operands.right))
+    throw Error{line, "operands must be numbers."};
+}
+
+[[nodiscard]] Value add(const Operands &operands, int line) {
+  if (is_number(operands.left) && is_number(operands.right))
+    return number_add(operands.left, operands.right);
+  if (operands.left.index() == StringIndex && operands.right.index() == StringIndex)
+    return std::get<StringIndex>(operands.left) + std::get<StringIndex>(operands.right);
+  throw Error{line, "operands must be two numbers or two strings."};
+}
+
+[[nodiscard]] Value subtract(const Operands &operands, int line) {
+  check_numbers(operands, line);
+  return number_subtract(operands.left, operands.right);
+}
+
+[[nodiscard]] Value multiply(const Operands &operands, int line) {
+  check_numbers(operands, line);
+  return number_multiply(operands.left, operands.right);
+}
+
+[[nodiscard]] Value divide(const Operands &operands, int line) {
+  check_numbers(operands, line);
+  return number_divide(operands.left, operands.right);
+}
+
+[[nodiscard]] Value greater(const Operands &operands, int line) {
+  check_numbers(operands, line);
+  return number_less(operands.right, operands.left);
+}
+
+[[nodiscard]] Value greater_equal(const Operands &operands, int line) {
+  check_numbers(operands, line);
+  return number_less_equal(operands.right, operands.left);
+}
+
+[[nodiscard]] Value less(const Operands &operands, int line) {
+  check_numbers(operands, line);
+  return number_less(operands.left, operands.right);
+}
+
+[[nodiscard]] Value less_equal(const Operands &operands, int line) {
+  check_numbers(operands, line);
+  return number_less_equal(operands.left, operands.right);
+}
+
+// mirrors Interpreter::is_equal; callables and instances never compare equal.
+[[nodiscard]] static bool is_equal(const Value &a, const Value &b) {
+  if (a.index() == NullptrIndex && b.index() == NullptrIndex)
+    return true;
+  if (a.index() == NullptrIndex)
+    return false;
+  if (a.index() == StringIndex && b.index() == StringIndex)
+    return std::get<StringIndex>(a) == std::get<StringIndex>(b);
+  if (is_number(a) && is_number(b))
+    return number_equal(a, b);
+  if (a.index() == BoolIndex && b.index() == BoolIndex)
+    return std::get<BoolIndex>(a) == std::get<BoolIndex>(b);
+  return false;
+}
+
+[[nodiscard]] Value equal(const Operands &operands) {
+  return is_equal(operands.left, operands.right);
+}
+
+[[nodiscard]] Value not_equal(const Operands &operands) {
+  return !is_equal(operands.left, operands.right);
+}
+
+[[nodiscard]] Value negate(const Value &operand, int line) {
+  if (!is_number(operand))
+    throw Error{line, "operand must be a number."};
+  return number_negate(operand);
+}
+
+[[nodiscard]] Value checked(Value value, Type type, const char *subject, int line) {
+  switch (type) {
+  case Type::NUMBER: {
+    if (is_number(value))
+      return value;
+    throw Error{line, std::string(subject) + " must be of type num."};
+  }
+  case Type::STRING: {
+    if (value.index() == StringIndex)
+      return value;
+    throw Error{line, std::string(subject) + " must be of type str."};
+  }
+  case Type::BOOL: {
+    if (value.index() == BoolIndex)
+      return value;
+    throw Error{line, std::string(subject) + " must be of type bool."};
+  }
+  default: {
+    return value;
+  }
+  }
+}
+
+void define_global(Global &global, Value value, Type type) {
+  global.value = std::move(value);
+  global.defined = true;
+  global.type = type;
+}
+
+[[nodiscard]] const Value &get_global(const Global &global, int line) {
+  if (!global.defined)
+    throw Error{line, "undefined variable '" + std::string(global.name) + "'."};
+  return global.value;
+}
+
+Value assign_global(Global &global, Value value, int line) {
+  if (!global.defined)
+    throw Error{line, "undefined variable '" + std::string(global.name) + "'."};
+  if (global.type != Type::ANY)
+    value = checked(std::move(value), global.type, ("'" + std::string(global.name) + "'").c_str(), line);
+  return global.value = std::move(value);
+}
+
+[[nodiscard]] static Value bind(Method *method, const std::shared_ptr<Instance> &self) {
+  return function(method->name, method->arity, [method, self](Arguments &arguments) {
+    return method->body(self, arguments);
+  });
+}
+
+static void check_arity(std::size_t arity, const Arguments &arguments, int line) {
+  if (arguments.size() != arity)
+    throw Error{line, "expected " + std::to_string(arity) + " arguments but got " + std::to_string(arguments.size()) + "."};
+}
+
+Value call(Invocation invocation, int line) {
+  check_stack(line);
+  if (invocation.callee.index() == LoxFunctionIndex) {
+    const auto &function = std::get<LoxFunctionIndex>(invocation.callee);
+    check_arity(function->arity, invocation.arguments, line);
+    return function->body(invocation.arguments);
+  }
+  if (invocation.callee.index() == LoxClassIndex) {
+    const auto &klass = std::get<LoxClassIndex>(invocation.callee);
+    Method *initializer = klass->find_method("init");
+    check_arity(initializer != nullptr ? initializer->arity : 0, invocation.arguments, line);
+    auto instance = std::make_shared<Instance>(Instance{klass, {}});
+    if (initializer != nullptr)
+      initializer->body(instance, invocation.arguments);
+    return instance;
+  }
+  throw Error{line, "can only call functions and classes."};
+}
+
+[[nodiscard]] Value get(const Value &object, const char *name, int line) {
+  if (object.index() != LoxInstanceIndex)
+    throw Error{line, "only instances have properties."};
+  const auto &instance = std::get<LoxInstanceIndex>(object);
+  if (auto it = instance->fields.find(name); it != instance->fields.end())
+    return it->second;
+  if (Method *method = instance->klass->find_method(name))
+    return bind(method, instance);
+  throw Error{line, "undefined property '" + std::string(name) + "'."};
+}
+
+[[nodiscard]] const std::shared_ptr<Instance> &instance_for_set(const Value &object, int line) {
+  if (object.index() != LoxInstanceIndex)
+    throw Error{line, "only instances have fields."};
+  return std::get<LoxInstanceIndex>(object);
+}
+
+[[nodiscard]] Value super_method(const std::shared_ptr<Class> &superclass, const std::shared_ptr<Instance> &self,
+                                 const char *name, int line) {
+  if (Method *method = superclass->find_method(name))
+    return bind(method, self);
+  throw Error{line, "undefined property '" + std::string(name) + "'."};
+}
+
+void print(const Value &value) {
+  switch (value.index()) {
+  case StringIndex: {
+    output.write_line(std::get<StringIndex>(value));
+    break;
+  }
+  case IntegerIndex:
+  case DoubleIndex: {
+    NumberBuffer buffer;
+    output.write_line(number_to_chars(value, buffer));
+    break;
+  }
+  case BoolIndex: {
+    output.write_line(std::get<BoolIndex>(value) ? "true" : "false");
+    break;
+  }
+  case LoxFunctionIndex: {
+    output.write_line("<fn " + std::get<LoxFunctionIndex>(value)->name + ">");
+    break;
+  }
+  case LoxClassIndex: {
+    output.write_line(std::get<LoxClassIndex>(value)->name);
+    break;
+  }
+  case LoxInstanceIndex: {
+    output.write_line(std::get<LoxInstanceIndex>(value)->klass->name + " instance");
+    break;
+  }
+  default: {
+    output.write_line("nil");
+  }
+  }
+}
+
+int run(void (*program)()) {
+  if (const std::uintptr_t bottom = stack_bottom(); bottom != 0)
+    stack_limit = bottom + stack_margin;
+  else {
+    const auto base = reinterpret_cast<std::uintptr_t>(&program);
+    stack_limit = base > max_stack_size ? base - max_stack_size : 0;
+  }
+  try {
+    program();
+  } catch (const Error &error) {
+    output.flush();
+    std::cerr << "[line " << error.line << "]: " << error.message << '\n';
+  }
+  output.flush();
+  return 0;
+}
+}// namespace loxplusplus::runtime
@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include "../include/mapped_file.hpp"
+
+#ifdef LOX_MAPPED_FILES
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace loxplusplus {
+MappedFile::MappedFile(const std::string &path) {
+#ifdef LOX_MAPPED_FILES
+  int descriptor = ::open(path.c_str(), O_RDONLY);
+  if (descriptor < 0)
+    return;
+  struct stat status;
+  if (::fstat(descriptor, &status) == 0 && status.st_size > 0) {
+    void *mapping = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (mapping != MAP_FAILED) {
+      this->data = static_cast<const char *>(mapping);
+      this->size = status.st_size;
+    }
+  }
+  ::close(descriptor);
+#else
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    return;
+  this->contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  if (this->contents.empty())
+    return;
+  this->data = this->contents.data();
+  this->size = this->contents.size();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef LOX_MAPPED_FILES
+  if (this->data != nullptr)
+    ::munmap(const_cast<char *>(this->data), this->size);
+#endif
+}
+}// namespace loxplusplus
@@ -0,0 +1,75 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <bit>
+#include <functional>
+
+#include "../include/lox_function.hpp"
+#include "../include/memo_table.hpp"
+
+namespace loxplusplus {
+MemoTable::MemoTable(std::vector<std::pair<int, const Function *>> callees)
+    : callees{std::move(callees)} {}
+
+[[nodiscard]] bool MemoTable::applies(const GlobalTable &globals, const std::vector<Object> &arguments) const {
+  for (const Object &argument : arguments)
+    if (argument.index() != DoubleIndex && argument.index() != IntegerIndex && argument.index() != StringIndex &&
+        argument.index() != BoolIndex && argument.index() != NullptrIndex)
+      return false;
+  for (const auto &[slot, declaration] : this->callees) {
+    const Object *callee = globals.find(slot);
+    if (callee == nullptr || callee->index() != LoxFunctionIndex ||
+        !std::get<LoxFunctionIndex>(*callee)->declared_by(*declaration))
+      return false;
+  }
+  return true;
+}
+
+[[nodiscard]] const Object *MemoTable::find(const std::vector<Object> &arguments) const {
+  auto result = this->results.find(arguments);
+  return result != this->results.end() ? &result->second : nullptr;
+}
+
+void MemoTable::insert(std::vector<Object> arguments, Object result) {
+  if (this->results.size() >= MemoTable::capacity)
+    this->results.clear();
+  this->results.try_emplace(std::move(arguments), std::move(result));
+}
+
+[[nodiscard]] std::size_t MemoTable::Hash::operator()(const std::vector<Object> &arguments) const noexcept {
+  std::size_t hash = arguments.size();
+  for (const Object &argument : arguments) {
+    std::size_t value = 0;
+    switch (argument.index()) {
+    case StringIndex: value = std::hash<std::string>{}(std::get<StringIndex>(argument)); break;
+    case DoubleIndex: value = std::hash<std::uint64_t>{}(std::bit_cast<std::uint64_t>(std::get<DoubleIndex>(argument))); break;
+    case BoolIndex: value = std::get<BoolIndex>(argument); break;
+    case IntegerIndex: value = std::hash<std::int64_t>{}(std::get<IntegerIndex>(argument)); break;
+    default: break;
+    }
+    hash ^= value + argument.index() + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+[[nodiscard]] bool MemoTable::Equal::operator()(const std::vector<Object> &a,
+                                                const std::vector<Object> &b) const noexcept {
+  if (a.size() != b.size())
+    return false;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    if (a[i].index() != b[i].index())
+      return false;
+    if (a[i].index() == DoubleIndex) {
+      if (std::bit_cast<std::uint64_t>(std::get<DoubleIndex>(a[i])) !=
+          std::bit_cast<std::uint64_t>(std::get<DoubleIndex>(b[i])))
+        return false;
+    } else if (a[i] != b[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+}// namespace loxplusplus
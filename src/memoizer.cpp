@@ -0,0 +1,142 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include "../include/memoizer.hpp"
+#include "../include/memo_table.hpp"
+
+namespace loxplusplus {
+void Memoizer::memoize(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  for (const std::shared_ptr<Stmt> &stmt : statements) {
+    if (stmt->kind != StmtKind::FUNCTION)
+      continue;
+    auto function = std::static_pointer_cast<Function>(stmt);
+    // a deferred body is not parsed for this.
+    if (function->deferred())
+      continue;
+    Candidate candidate{function};
+    bool pure = true;
+    for (const std::shared_ptr<Stmt> &statement : function->body())
+      pure = pure && Memoizer::pure(statement, candidate.callees, candidate.costly);
+    if (pure)
+      this->candidates.emplace(function->name.lexeme, std::move(candidate));
+  }
+  for (const auto &[name, count] : top_level_declarations(statements))
+    if (count > 1)
+      this->candidates.erase(name);
+
+  // calling a function that is not pure makes the caller impure as well.
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (auto candidate = this->candidates.begin(); candidate != this->candidates.end();) {
+      bool pure = true;
+      for (const std::string &callee : candidate->second.callees)
+        pure = pure && this->candidates.contains(callee);
+      if (pure) {
+        ++candidate;
+        continue;
+      }
+      candidate = this->candidates.erase(candidate);
+      changed = true;
+    }
+  }
+
+  for (const auto &[name, candidate] : this->candidates) {
+    if (!candidate.costly)
+      continue;
+    std::unordered_set<std::string> visited;
+    std::vector<std::pair<int, const Function *>> dependencies;
+    for (const std::string &callee : candidate.callees)
+      this->depend(callee, visited, dependencies);
+    candidate.function->memo = std::make_shared<MemoTable>(std::move(dependencies));
+  }
+  this->candidates.clear();
+}
+
+// the functions a result depends on are every function reachable through
+// calls, the function itself included when it recurses.
+void Memoizer::depend(const std::string &name, std::unordered_set<std::string> &visited,
+                      std::vector<std::pair<int, const Function *>> &dependencies) const {
+  if (!visited.insert(name).second)
+    return;
+  const Candidate &candidate = this->candidates.at(name);
+  dependencies.emplace_back(candidate.function->slot, candidate.function.get());
+  for (const std::string &callee : candidate.callees)
+    this->depend(callee, visited, dependencies);
+}
+
+[[nodiscard]] bool Memoizer::pure(const std::shared_ptr<Stmt> &stmt, Callees &callees, bool &costly) {
+  switch (stmt->kind) {
+  case StmtKind::BLOCK:
+    for (const std::shared_ptr<Stmt> &statement : std::static_pointer_cast<Block>(stmt)->statements)
+      if (!pure(statement, callees, costly))
+        return false;
+    return true;
+  case StmtKind::EXPRESSION:
+    return pure(std::static_pointer_cast<Expression>(stmt)->expression, callees, costly);
+  case StmtKind::IF: {
+    auto branch = std::static_pointer_cast<If>(stmt);
+    return pure(branch->condition, callees, costly) && pure(branch->then_branch, callees, costly) &&
+           (branch->else_branch == nullptr || pure(branch->else_branch, callees, costly));
+  }
+  case StmtKind::RETURN: {
+    auto result = std::static_pointer_cast<Return>(stmt);
+    return result->value == nullptr || pure(result->value, callees, costly);
+  }
+  case StmtKind::VAR: {
+    auto var = std::static_pointer_cast<Var>(stmt);
+    return var->initializer == nullptr || pure(var->initializer, callees, costly);
+  }
+  case StmtKind::WHILE: {
+    auto loop = std::static_pointer_cast<While>(stmt);
+    costly = true;
+    return pure(loop->condition, callees, costly) && pure(loop->body, callees, costly);
+  }
+  default:
+    return false;
+  }
+}
+
+[[nodiscard]] bool Memoizer::pure(const std::shared_ptr<Expr> &expr, Callees &callees, bool &costly) {
+  switch (expr->kind) {
+  case ExprKind::ASSIGN: {
+    auto assign = std::static_pointer_cast<Assign>(expr);
+    return assign->depth >= 0 && pure(assign->value, callees, costly);
+  }
+  case ExprKind::BINARY: {
+    auto binary = std::static_pointer_cast<Binary>(expr);
+    return pure(binary->left, callees, costly) && pure(binary->right, callees, costly);
+  }
+  case ExprKind::CALL: {
+    auto call = std::static_pointer_cast<Call>(expr);
+    if (call->callee->kind != ExprKind::VARIABLE)
+      return false;
+    auto callee = std::static_pointer_cast<Variable>(call->callee);
+    if (callee->depth >= 0)
+      return false;
+    callees.insert(callee->name.lexeme);
+    costly = true;
+    for (const std::shared_ptr<Expr> &argument : call->arguments)
+      if (!pure(argument, callees, costly))
+        return false;
+    return true;
+  }
+  case ExprKind::GROUPING:
+    return pure(std::static_pointer_cast<Grouping>(expr)->expression, callees, costly);
+  case ExprKind::LITERAL:
+    return true;
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    return pure(logical->left, callees, costly) && pure(logical->right, callees, costly);
+  }
+  case ExprKind::UNARY:
+    return pure(std::static_pointer_cast<Unary>(expr)->right, callees, costly);
+  case ExprKind::VARIABLE:
+    return std::static_pointer_cast<Variable>(expr)->depth >= 0;
+  default:
+    return false;
+  }
+}
+}// namespace loxplusplus
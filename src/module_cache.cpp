@@ -0,0 +1,145 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <fstream>
+#include <sstream>
+
+#include "../include/dead_code_eliminator.hpp"
+#include "../include/engine.hpp"
+#include "../include/inliner.hpp"
+#include "../include/module_cache.hpp"
+#include "../include/optimizer.hpp"
+#include "../include/program_cache.hpp"
+#include "../include/scalar_replacer.hpp"
+#include "../include/thread_pool.hpp"
+
+namespace loxplusplus {
+[[nodiscard]] Modules ModuleCache::load(const std::vector<std::shared_ptr<Stmt>> &statements,
+                                        const std::filesystem::path &directory,
+                                        SymbolTable &symbols,
+                                        Diagnostics &diagnostics) {
+  Modules modules;
+  std::vector<Import *> frontier = link(statements, directory);
+  while (!frontier.empty()) {
+    // one entry per module not seen yet; the first import names it in errors.
+    std::vector<Import *> pending;
+    for (Import *import : frontier)
+      if (modules.try_emplace(import->module, nullptr).second)
+        pending.push_back(import);
+    std::vector<std::shared_ptr<const Image>> loaded(pending.size());
+    ThreadPool pool;
+    pool.run(pending.size(), [&](std::size_t index) {
+      loaded[index] = get(pending[index]->module);
+    });
+    frontier.clear();
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+      if (loaded[i] == nullptr) {
+        diagnostics.error(pending[i]->path, "cannot open module '" + pending[i]->module + "'.");
+        continue;
+      }
+      if (!loaded[i]->errors.empty())
+        diagnostics.forward(loaded[i]->errors);
+      std::shared_ptr<const Module> module = instantiate(pending[i]->module, *loaded[i], symbols);
+      modules[pending[i]->module] = module;
+      for (const std::shared_ptr<Stmt> &stmt : module->statements)
+        if (stmt->kind == StmtKind::IMPORT)
+          frontier.push_back(static_cast<Import *>(stmt.get()));
+    }
+  }
+  return modules;
+}
+
+[[nodiscard]] bool ModuleCache::preload(const std::vector<std::string> &paths, Diagnostics &diagnostics) {
+  Lexicon lexicon;
+  SymbolTable symbols;
+  std::vector<std::shared_ptr<Stmt>> imports;
+  for (const std::string &path : paths)
+    imports.push_back(std::make_shared<Import>(Token(TokenType::IMPORT, "import", 0, lexicon),
+                                               Token(TokenType::STRING, '"' + path + '"', 0, lexicon)));
+  (void)load(imports, std::filesystem::current_path(), symbols, diagnostics);
+  return !diagnostics.failed();
+}
+
+[[nodiscard]] std::vector<Import *> ModuleCache::link(const std::vector<std::shared_ptr<Stmt>> &statements,
+                                                      const std::filesystem::path &directory) {
+  std::vector<Import *> imports;
+  for (const std::shared_ptr<Stmt> &stmt : statements) {
+    if (stmt->kind != StmtKind::IMPORT)
+      continue;
+    auto import = std::static_pointer_cast<Import>(stmt);
+    const std::string &lexeme = import->path.lexeme;
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::absolute(directory / lexeme.substr(1, lexeme.size() - 2), error);
+    import->module = std::filesystem::weakly_canonical(path, error).string();
+    imports.push_back(import.get());
+  }
+  return imports;
+}
+
+[[nodiscard]] std::shared_ptr<const ModuleCache::Image> ModuleCache::get(const std::string &path) {
+  std::error_code error;
+  const std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, error);
+  if (error)
+    return nullptr;
+  {
+    std::lock_guard<std::mutex> lock{ModuleCache::mutex};
+    if (auto it = ModuleCache::entries.find(path); it != ModuleCache::entries.end() && it->second.modified == modified)
+      return it->second.image;
+  }
+  // compiled without the lock, so unrelated modules build in parallel. two
+  // threads racing on the same module both compile it and the last one wins.
+  std::shared_ptr<const Image> image = compile(path);
+  if (image == nullptr)
+    return nullptr;
+  std::lock_guard<std::mutex> lock{ModuleCache::mutex};
+  ModuleCache::entries[path] = Entry{modified, image};
+  return image;
+}
+
+[[nodiscard]] std::shared_ptr<const ModuleCache::Image> ModuleCache::compile(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    return nullptr;
+  std::ostringstream source, errors;
+  source << file.rdbuf();
+  auto image = std::make_shared<Image>();
+  Diagnostics diagnostics(errors);
+  // the slots the resolver assigns here are not stored; the image only
+  // records which names are globals.
+  Lexicon lexicon;
+  SymbolTable symbols;
+  std::optional<std::vector<std::shared_ptr<Stmt>>> statements = Engine::compile(source.str(), diagnostics, lexicon,
+                                                                                 symbols);
+  if (!statements.has_value()) {
+    image->errors = "in module '" + path + "':\n" + std::move(errors).str();
+    return image;
+  }
+  ProgramWriter writer;
+  image->bytes = writer.write(0, *statements);
+  return image;
+}
+
+[[nodiscard]] std::shared_ptr<const Module> ModuleCache::instantiate(const std::string &path, const Image &image,
+                                                                     SymbolTable &symbols) {
+  auto module = std::make_shared<Module>();
+  module->path = path;
+  module->errors = image.errors;
+  if (!image.errors.empty())
+    return module;
+  ProgramReader reader(image.bytes.data(), image.bytes.size(), module->lexicon, symbols);
+  module->statements = reader.read(0);
+  (void)link(module->statements, std::filesystem::path(path).parent_path());
+  DeadCodeEliminator eliminator;
+  eliminator.eliminate(module->statements);
+  ScalarReplacer replacer(module->lexicon);
+  replacer.replace(module->statements);
+  Optimizer optimizer;
+  optimizer.optimize(module->statements);
+  Inliner inliner;
+  inliner.inline_calls(module->statements);
+  return module;
+}
+}// namespace loxplusplus
\ No newline at end of file
@@ -0,0 +1,281 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include "../include/optimizer.hpp"
+#include "../include/number.hpp"
+
+namespace loxplusplus {
+void Optimizer::optimize(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  for (const std::shared_ptr<Stmt> &statement : statements)
+    this->optimize(statement);
+}
+
+void Optimizer::optimize(std::shared_ptr<Stmt> stmt) {
+  (void)dispatch(*this, stmt);
+}
+
+[[nodiscard]] Object Optimizer::visit(std::shared_ptr<Block> stmt) {
+  if (std::shared_ptr<CountedLoop> loop = this->counted_loop(*stmt); loop != nullptr)
+    std::static_pointer_cast<While>(stmt->statements[1])->counted = std::move(loop);
+  this->optimize(stmt->statements);
+  if (stmt->replaced != nullptr)
+    this->optimize(stmt->replaced->statements);
+  return nullptr;
+}
+
+[[nodiscard]] Object Optimizer::visit(std::shared_ptr<Class> stmt) {
+  for (const std::shared_ptr<Function> &method : stmt->methods)
+    this->optimize(method);
+  return nullptr;
+}
+
+[[nodiscard]] Object Optimizer::visit(std::shared_ptr<Expression> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object Optimizer::visit(std::shared_ptr<Function> stmt) {
+  // a deferred body is optimized once it has been parsed.
+  if (stmt->deferred())
+    return nullptr;
+  this->optimize(stmt->body());
+  if (stmt->replaced != nullptr)
+    this->optimize(stmt->replaced->statements);
+  return nullptr;
+}
+
+[[nodiscard]] Object Optimizer::visit(std::shared_ptr<If> stmt) {
+  this->optimize(stmt->then_branch);
+  if (stmt->else_branch != nullptr)
+    this->optimize(stmt->else_branch);
+  return nullptr;
+}
+
+[[nodiscard]] Object Optimizer::visit(std::shared_ptr<Import> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object Optimizer::visit(std::shared_ptr<Print> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object Optimizer::visit(std::shared_ptr<Return> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object Optimizer::visit(std::shared_ptr<Var> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object Optimizer::visit(std::shared_ptr<While> stmt) {
+  this->optimize(stmt->body);
+  return nullptr;
+}
+
+// matches the shape Parser::for_statement desugars a counting loop into:
+//   { var i = a; while (i < n) { body; i = i + k; } }
+// where k is an integer literal and i is neither assigned nor captured by the
+// body or the limit. the comparison may be any of <, <=, > and >=.
+[[nodiscard]] std::shared_ptr<CountedLoop> Optimizer::counted_loop(const Block &block) {
+  if (block.statements.size() != 2)
+    return nullptr;
+  if (block.statements[0]->kind != StmtKind::VAR || block.statements[1]->kind != StmtKind::WHILE)
+    return nullptr;
+  auto var = std::static_pointer_cast<Var>(block.statements[0]);
+  auto loop = std::static_pointer_cast<While>(block.statements[1]);
+  if (var->initializer == nullptr || loop->condition->kind != ExprKind::BINARY)
+    return nullptr;
+  const std::string &name = var->name.lexeme;
+  auto condition = std::static_pointer_cast<Binary>(loop->condition);
+  switch (condition->op.type) {
+  case TokenType::LESS:
+  case TokenType::LESS_EQUAL:
+  case TokenType::GREATER:
+  case TokenType::GREATER_EQUAL:
+    break;
+  default:
+    return nullptr;
+  }
+  if (condition->left->kind != ExprKind::VARIABLE)
+    return nullptr;
+  auto index = std::static_pointer_cast<Variable>(condition->left);
+  if (index->depth != 0 || index->name.lexeme != name || loop->body->kind != StmtKind::BLOCK)
+    return nullptr;
+  auto body = std::static_pointer_cast<Block>(loop->body);
+  if (body->statements.size() != 2 || body->statements[1]->kind != StmtKind::EXPRESSION)
+    return nullptr;
+  auto increment = std::static_pointer_cast<Expression>(body->statements[1]);
+  if (increment->expression->kind != ExprKind::ASSIGN)
+    return nullptr;
+  auto assign = std::static_pointer_cast<Assign>(increment->expression);
+  if (assign->depth != 1 || assign->name.lexeme != name || assign->value->kind != ExprKind::BINARY)
+    return nullptr;
+  auto sum = std::static_pointer_cast<Binary>(assign->value);
+  if ((sum->op.type != TokenType::PLUS && sum->op.type != TokenType::MINUS) ||
+      sum->left->kind != ExprKind::VARIABLE || sum->right->kind != ExprKind::LITERAL)
+    return nullptr;
+  auto operand = std::static_pointer_cast<Variable>(sum->left);
+  auto amount = std::static_pointer_cast<Literal>(sum->right);
+  if (operand->depth != 1 || operand->name.lexeme != name || !is_integer(amount->value))
+    return nullptr;
+  std::int64_t step = std::get<IntegerIndex>(amount->value);
+  if (sum->op.type == TokenType::MINUS) {
+    if (step == std::numeric_limits<std::int64_t>::min())
+      return nullptr;
+    step = -step;
+  }
+  if (step == 0)
+    return nullptr;
+  VariableEscapeScanner scanner{name};
+  if (scanner.escapes(body->statements[0]) || scanner.escapes(condition->right))
+    return nullptr;
+  return std::make_shared<CountedLoop>(CountedLoop{name, condition, body->statements[0], step});
+}
+
+VariableEscapeScanner::VariableEscapeScanner(const std::string &name)
+    : name{name} {
+}
+
+[[nodiscard]] bool VariableEscapeScanner::escapes(std::shared_ptr<Stmt> stmt) {
+  this->found = false;
+  this->scan(std::move(stmt));
+  return this->found;
+}
+
+[[nodiscard]] bool VariableEscapeScanner::escapes(std::shared_ptr<Expr> expr) {
+  this->found = false;
+  this->scan(std::move(expr));
+  return this->found;
+}
+
+void VariableEscapeScanner::scan(std::shared_ptr<Stmt> stmt) {
+  if (!this->found)
+    (void)dispatch(*this, stmt);
+}
+
+void VariableEscapeScanner::scan(std::shared_ptr<Expr> expr) {
+  if (!this->found)
+    (void)dispatch(*this, expr);
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Block> stmt) {
+  for (const std::shared_ptr<Stmt> &statement : stmt->statements)
+    this->scan(statement);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Class> stmt) {
+  this->found = true;
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Expression> stmt) {
+  this->scan(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Function> stmt) {
+  this->found = true;
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<If> stmt) {
+  this->scan(stmt->condition);
+  this->scan(stmt->then_branch);
+  if (stmt->else_branch != nullptr)
+    this->scan(stmt->else_branch);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Import> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Print> stmt) {
+  this->scan(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Return> stmt) {
+  if (stmt->value != nullptr)
+    this->scan(stmt->value);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Var> stmt) {
+  if (stmt->initializer != nullptr)
+    this->scan(stmt->initializer);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<While> stmt) {
+  this->scan(stmt->condition);
+  this->scan(stmt->body);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Assign> expr) {
+  if (expr->name.lexeme == this->name)
+    this->found = true;
+  this->scan(expr->value);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Binary> expr) {
+  this->scan(expr->left);
+  this->scan(expr->right);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Call> expr) {
+  this->scan(expr->callee);
+  for (const std::shared_ptr<Expr> &argument : expr->arguments)
+    this->scan(argument);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Get> expr) {
+  this->scan(expr->object);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Grouping> expr) {
+  this->scan(expr->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Literal> expr) {
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Logical> expr) {
+  this->scan(expr->left);
+  this->scan(expr->right);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Set> expr) {
+  this->scan(expr->object);
+  this->scan(expr->value);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Super> expr) {
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<This> expr) {
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Unary> expr) {
+  this->scan(expr->right);
+  return nullptr;
+}
+
+[[nodiscard]] Object VariableEscapeScanner::visit(std::shared_ptr<Variable> expr) {
+  return nullptr;
+}
+}// namespace loxplusplus
@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <cstring>
+
+#include "../include/output_sink.hpp"
+
+namespace loxplusplus {
+OutputSink::OutputSink(std::FILE *file, std::size_t capacity)
+    : file{file}, buffer(capacity) {
+}
+
+OutputSink::OutputSink(OutputWriter writer, std::size_t capacity)
+    : file{nullptr}, writer{std::move(writer)}, buffer(capacity) {
+}
+
+OutputSink::~OutputSink() {
+  this->close();
+}
+
+[[nodiscard]] bool OutputSink::open(const std::string &path) {
+  std::FILE *target = std::fopen(path.c_str(), "wb");
+  if (target == nullptr)
+    return false;
+  this->close();
+  this->file = target;
+  this->writer = nullptr;
+  this->owns_file = true;
+  return true;
+}
+
+void OutputSink::set_line_buffered(bool line_buffered) {
+  this->line_buffered = line_buffered;
+}
+
+void OutputSink::write(std::string_view text) {
+  if (text.size() > this->buffer.size() - this->size) {
+    this->flush_buffer();
+    if (text.size() > this->buffer.size()) {
+      this->emit(text.data(), text.size());
+      return;
+    }
+  }
+  std::memcpy(this->buffer.data() + this->size, text.data(), text.size());
+  this->size += text.size();
+}
+
+void OutputSink::write_line(std::string_view text) {
+  this->write(text);
+  if (this->size == this->buffer.size())
+    this->flush_buffer();
+  this->buffer[this->size++] = '\n';
+  if (this->line_buffered)
+    this->flush();
+}
+
+void OutputSink::flush() {
+  this->flush_buffer();
+  if (this->file != nullptr)
+    std::fflush(this->file);
+}
+
+void OutputSink::flush_buffer() {
+  if (this->size == 0)
+    return;
+  this->emit(this->buffer.data(), this->size);
+  this->size = 0;
+}
+
+void OutputSink::emit(const char *data, std::size_t count) {
+  if (this->writer)
+    this->writer(std::string_view(data, count));
+  else
+    std::fwrite(data, 1, count, this->file);
+}
+
+void OutputSink::close() {
+  this->flush();
+  if (this->owns_file)
+    std::fclose(this->file);
+  this->owns_file = false;
+}
+}// namespace loxplusplus
@@ -4,28 +4,43 @@
 // Distributed under the terms of the MIT License.
 //
 
+#include <utility>
+
+#include "../include/dead_code_eliminator.hpp"
+#include "../include/ir_optimizer.hpp"
+#include "../include/optimizer.hpp"
 #include "../include/parser.hpp"
+#include "../include/resolver.hpp"
+#include "../include/type_checker.hpp"
 
 namespace loxplusplus {
-Parser::Parser(const std::vector<Token> &tokens)
-    : tokens{tokens} {
+Parser::Parser(const std::vector<SourceToken> &tokens, Lexicon &lexicon, Diagnostics &diagnostics)
+    : tokens{tokens}, lexicon{lexicon}, diagnostics{diagnostics} {
+}
+
+Parser::Parser(std::shared_ptr<const std::vector<SourceToken>> tokens, Lexicon &lexicon, SymbolTable &symbols,
+               Diagnostics &diagnostics)
+    : tokens{*tokens}, lexicon{lexicon}, diagnostics{diagnostics}, shared_tokens{std::move(tokens)}, symbols{&symbols} {
 }
 
 [[nodiscard]] std::vector<std::shared_ptr<Stmt>> Parser::parse() {
   std::vector<std::shared_ptr<Stmt>> statements;
   while (!this->is_at_end()) {
-    statements.push_back(std::move(this->declaration()));
+    if (this->match(TokenType::IMPORT))
+      statements.push_back(std::move(this->import_declaration()));
+    else
+      statements.push_back(std::move(this->declaration()));
   }
   return statements;
 }
 
 [[nodiscard]] std::shared_ptr<Stmt> Parser::declaration() {
   try {
-    if (this->match({TokenType::CLASS}))
+    if (this->match(TokenType::CLASS))
       return std::move(this->class_declaration());
-    if (this->match({TokenType::FUN}))
+    if (this->match(TokenType::FUN))
       return std::move(this->function("function"));
-    if (this->match({TokenType::VAR}))
+    if (this->match(TokenType::VAR))
       return std::move(this->var_declaration());
     return std::move(this->statement());
   } catch (const ParseError &error) {
@@ -34,14 +49,27 @@ Parser::Parser(const std::vector<Token> &tokens)
   }
 }
 
+[[nodiscard]] std::shared_ptr<Stmt> Parser::import_declaration() {
+  try {
+    Token keyword = this->token(this->previous());
+    Token path = this->token(this->consume(TokenType::STRING, "expect module path after 'import'."));
+    this->consume(TokenType::SEMICOLON, "expect ';' after module path.");
+    return std::make_shared<Import>(std::move(keyword), std::move(path));
+  } catch (const ParseError &error) {
+    this->synchronize();
+    return nullptr;
+  }
+}
+
 [[nodiscard]] std::shared_ptr<Stmt> Parser::class_declaration() {
-  Token name = this->consume(TokenType::IDENTIFIER, "expect class name.");
+  Token name = this->token(this->consume(TokenType::IDENTIFIER, "expect class name."));
   std::shared_ptr<Variable> superclass = nullptr;
-  if (this->match({TokenType::LESS})) {
+  if (this->match(TokenType::LESS)) {
     this->consume(TokenType::IDENTIFIER, "expect superclass name.");
-    superclass = std::make_shared<Variable>(this->previous());
+    superclass = std::make_shared<Variable>(this->token(this->previous()));
   }
   this->consume(TokenType::LEFT_BRACE, "expect '{' before class body.");
+  this->in_subclass = superclass != nullptr;
   std::vector<std::shared_ptr<Function>> methods;
   while (!this->check(TokenType::RIGHT_BRACE) && !this->is_at_end()) {
     methods.push_back(this->function("method"));
@@ -51,17 +79,19 @@ Parser::Parser(const std::vector<Token> &tokens)
 }
 
 [[nodiscard]] std::shared_ptr<Stmt> Parser::statement() {
-  if (this->match({TokenType::FOR}))
+  if (this->match(TokenType::FOR))
     return std::move(this->for_statement());
-  if (this->match({TokenType::IF}))
+  if (this->match(TokenType::IF))
     return std::move(this->if_statement());
-  if (this->match({TokenType::PRINT}))
+  if (this->match(TokenType::IMPORT))
+    throw parse_error(this->previous(), "imports are only allowed at the top level.");
+  if (this->match(TokenType::PRINT))
     return std::move(this->print_statement());
-  if (this->match({TokenType::RETURN}))
+  if (this->match(TokenType::RETURN))
     return std::move(this->return_statement());
-  if (this->match({TokenType::WHILE}))
+  if (this->match(TokenType::WHILE))
     return std::move(this->while_statement());
-  if (this->match({TokenType::LEFT_BRACE}))
+  if (this->match(TokenType::LEFT_BRACE))
     return std::make_shared<Block>(std::move(this->block()));
   return std::move(this->expression_statement());
 }
@@ -69,9 +99,9 @@ Parser::Parser(const std::vector<Token> &tokens)
 [[nodiscard]] std::shared_ptr<Stmt> Parser::for_statement() {
   this->consume(TokenType::LEFT_PAREN, "expect '(' after 'for'.");
   std::shared_ptr<Stmt> initializer;
-  if (this->match({TokenType::SEMICOLON})) {
+  if (this->match(TokenType::SEMICOLON)) {
     initializer = nullptr;
-  } else if (this->match({TokenType::VAR})) {
+  } else if (this->match(TokenType::VAR)) {
     initializer = std::move(this->var_declaration());
   } else {
     initializer = std::move(this->expression_statement());
@@ -108,7 +138,7 @@ Parser::Parser(const std::vector<Token> &tokens)
   this->consume(TokenType::RIGHT_PAREN, "expect ')' after if condition.");
   std::shared_ptr<Stmt> then_branch = std::move(this->statement());
   std::shared_ptr<Stmt> else_branch = nullptr;
-  if (this->match({TokenType::ELSE})) {
+  if (this->match(TokenType::ELSE)) {
     else_branch = std::move(this->statement());
   }
   return std::make_shared<If>(std::move(condition), std::move(then_branch), std::move(else_branch));
@@ -121,7 +151,7 @@ Parser::Parser(const std::vector<Token> &tokens)
 }
 
 [[nodiscard]] std::shared_ptr<Stmt> Parser::return_statement() {
-  Token keyword = this->previous();
+  Token keyword = this->token(this->previous());
   std::shared_ptr<Expr> value = nullptr;
   if (!this->check(TokenType::SEMICOLON))
     value = std::move(this->expression());
@@ -130,13 +160,18 @@ Parser::Parser(const std::vector<Token> &tokens)
 }
 
 [[nodiscard]] std::shared_ptr<Stmt> Parser::var_declaration() {
-  Token name = this->consume(TokenType::IDENTIFIER, "expect variable name.");
+  Token name = this->token(this->consume(TokenType::IDENTIFIER, "expect variable name."));
+  const ValueType type = this->match(TokenType::COLON) ? this->annotation() : ValueType::ANY;
   std::shared_ptr<Expr> initializer = nullptr;
-  if (this->match({TokenType::EQUAL})) {
+  if (this->match(TokenType::EQUAL)) {
     initializer = std::move(this->expression());
+  } else if (type != ValueType::ANY) {
+    this->diagnostics.error(name, "annotated variable needs an initializer.");
   }
   this->consume(TokenType::SEMICOLON, "expect ';' after variable declaration.");
-  return std::make_shared<Var>(std::move(name), std::move(initializer));
+  std::shared_ptr<Var> var = std::make_shared<Var>(std::move(name), std::move(initializer));
+  var->type = type;
+  return var;
 }
 
 [[nodiscard]] std::shared_ptr<Stmt> Parser::while_statement() {
@@ -154,112 +189,163 @@ Parser::Parser(const std::vector<Token> &tokens)
 }
 
 [[nodiscard]] std::shared_ptr<Function> Parser::function(std::string kind) {
-  Token name = this->consume(TokenType::IDENTIFIER, "expect " + kind + " name.");
+  Token name = this->token(this->consume(TokenType::IDENTIFIER, "expect " + kind + " name."));
   this->consume(TokenType::LEFT_PAREN, "expect '(' after " + kind + " name.");
   std::vector<Token> parameters;
+  std::vector<ValueType> types;
+  bool annotated = false;
   if (!this->check(TokenType::RIGHT_PAREN)) {
     do {
       if (parameters.size() >= 255) {
-        error(this->peek(), "can't have more than 255 parameters.");
+        this->diagnostics.error(this->peek(), "can't have more than 255 parameters.");
       }
-      parameters.push_back(this->consume(TokenType::IDENTIFIER, "expect parameter name."));
-    } while (this->match({TokenType::COMMA}));
+      parameters.push_back(this->token(this->consume(TokenType::IDENTIFIER, "expect parameter name.")));
+      types.push_back(this->match(TokenType::COLON) ? this->annotation() : ValueType::ANY);
+      annotated = annotated || types.back() != ValueType::ANY;
+    } while (this->match(TokenType::COMMA));
   }
   this->consume(TokenType::RIGHT_PAREN, "expect ')' after parameters.");
+  const ValueType return_type = this->match(TokenType::COLON) ? this->annotation() : ValueType::ANY;
+  if (return_type != ValueType::ANY && kind == "method" && name.lexeme == "init")
+    this->diagnostics.error(name, "can't annotate the return type of an initializer.");
   this->consume(TokenType::LEFT_BRACE, "expect '{' before " + kind + " body.");
-  std::vector<std::shared_ptr<Stmt>> body = this->block();
+  std::shared_ptr<Function> function;
+  if (this->shared_tokens != nullptr && this->block_depth == 0) {
+    function = this->defer_function(std::move(name), std::move(parameters), kind == "method");
+  } else {
+    std::vector<std::shared_ptr<Stmt>> body = this->block();
+    function = std::make_shared<Function>(std::move(name), std::move(parameters), std::move(body));
+  }
+  if (annotated)
+    function->param_types = std::move(types);
+  function->return_type = return_type;
+  return function;
+}
+
+// reads the type name following ':'.
+[[nodiscard]] ValueType Parser::annotation() {
+  const SourceToken &type = this->consume(TokenType::IDENTIFIER, "expect type name after ':'.");
+  if (type.lexeme == "num")
+    return ValueType::NUMBER;
+  if (type.lexeme == "str")
+    return ValueType::STRING;
+  if (type.lexeme == "bool")
+    return ValueType::BOOL;
+  this->diagnostics.error(type, "unknown type '" + std::string(type.lexeme) + "'.");
+  return ValueType::ANY;
+}
+
+// skips to the brace closing the body and records where it starts. errors
+// inside the body surface as a runtime error of the first call, with the
+// parse and resolve errors reported as usual before it.
+[[nodiscard]] std::shared_ptr<Function> Parser::defer_function(Token name, std::vector<Token> parameters, bool method) {
+  const int begin = this->current;
+  for (int depth = 1; depth > 0;) {
+    if (this->is_at_end())
+      throw parse_error(this->peek(), "expect '}' after block.");
+    const TokenType type = this->advance().type;
+    if (type == TokenType::LEFT_BRACE)
+      ++depth;
+    else if (type == TokenType::RIGHT_BRACE)
+      --depth;
+  }
+  DeferredBody body = [tokens = this->shared_tokens, &lexicon = this->lexicon, &symbols = *this->symbols,
+                       &diagnostics = this->diagnostics, begin, method,
+                       subclass = this->in_subclass](const Function &function) {
+    const bool had_error = std::exchange(diagnostics.had_error, false);
+    Parser parser(tokens, lexicon, symbols, diagnostics);
+    parser.current = begin;
+    // functions nested in the body are parsed along with it.
+    parser.block_depth = 1;
+    std::vector<std::shared_ptr<Stmt>> statements = parser.block();
+    if (!diagnostics.had_error) {
+      Resolver resolver(diagnostics, symbols);
+      resolver.resolve_deferred(function, statements, method, subclass);
+    }
+    if (!diagnostics.had_error) {
+      TypeChecker checker(diagnostics);
+      checker.check_function(function, statements);
+    }
+    if (std::exchange(diagnostics.had_error, had_error))
+      throw RuntimeError(function.name, "invalid body of '" + function.name.lexeme + "'.");
+    if (IrOptimizer ir(lexicon); ir.optimize_function(function, statements)) {
+      Resolver resolver(diagnostics, symbols);
+      resolver.resolve_deferred(function, statements, method, subclass);
+    }
+    DeadCodeEliminator eliminator;
+    eliminator.eliminate_function(statements);
+    Optimizer optimizer;
+    optimizer.optimize(statements);
+    return statements;
+  };
   return std::make_shared<Function>(std::move(name), std::move(parameters), std::move(body));
 }
 
 [[nodiscard]] std::vector<std::shared_ptr<Stmt>> Parser::block() {
+  ++this->block_depth;
   std::vector<std::shared_ptr<Stmt>> statements;
   while (!this->check(TokenType::RIGHT_BRACE) && !this->is_at_end())
     statements.push_back(std::move(this->declaration()));
+  --this->block_depth;
   this->consume(TokenType::RIGHT_BRACE, "expect '}' after block.");
   return statements;
 }
 
 [[nodiscard]] std::shared_ptr<Expr> Parser::expression() {
-  return std::move(this->assignment());
-}
-
-[[nodiscard]] std::shared_ptr<Expr> Parser::assignment() {
-  std::shared_ptr<Expr> expr = std::move(this->or_());
-  if (this->match({TokenType::EQUAL})) {
-    Token equals = this->previous();
-    std::shared_ptr<Expr> value = std::move(this->assignment());
-    if (const std::shared_ptr<Variable> &variable = std::dynamic_pointer_cast<Variable>(expr);
-        variable != nullptr)
-      return std::make_shared<Assign>(variable->name, std::move(value));
-    else if (const std::shared_ptr<Get> get = std::dynamic_pointer_cast<Get>(expr);
-             get != nullptr)
-      return std::make_shared<Set>(get->object, get->name, std::move(value));
-    error(std::move(equals), "invalid assignment target.");
-  }
-  return std::move(expr);
-}
-
-[[nodiscard]] std::shared_ptr<Expr> Parser::or_() {
-  std::shared_ptr<Expr> expr = std::move(this->and_());
-  while (this->match({TokenType::OR})) {
-    Token op = this->previous();
-    expr = std::make_shared<Logical>(std::move(expr), std::move(op), std::move(this->and_()));
-  }
-  return std::move(expr);
-}
-
-[[nodiscard]] std::shared_ptr<Expr> Parser::and_() {
-  std::shared_ptr<Expr> expr = std::move(this->equality());
-  while (this->match({TokenType::AND})) {
-    Token op = this->previous();
-    expr = std::make_shared<Logical>(expr, std::move(op), std::move(this->equality()));
-  }
-  return std::move(expr);
-}
-
-[[nodiscard]] std::shared_ptr<Expr> Parser::equality() {
-  std::shared_ptr<Expr> expr = std::move(this->comparison());
-  while (this->match({TokenType::BANG_EQUAL, TokenType::EQUAL_EQUAL})) {
-    Token op = this->previous();
-    expr = std::make_shared<Binary>(expr, std::move(op), std::move(this->comparison()));
-  }
-  return std::move(expr);
-}
-
-[[nodiscard]] std::shared_ptr<Expr> Parser::comparison() {
-  std::shared_ptr<Expr> expr = std::move(this->term());
-  while (this->match({TokenType::GREATER, TokenType::GREATER_EQUAL,
-                      TokenType::LESS, TokenType::LESS_EQUAL})) {
-    Token op = this->previous();
-    expr = std::make_shared<Binary>(expr, std::move(op), std::move(this->term()));
-  }
-  return std::move(expr);
-}
-
-[[nodiscard]] std::shared_ptr<Expr> Parser::term() {
-  std::shared_ptr<Expr> expr = std::move(this->factor());
-  while (this->match({TokenType::MINUS, TokenType::PLUS})) {
-    Token op = this->previous();
-    expr = std::make_shared<Binary>(expr, std::move(op), std::move(this->factor()));
-  }
-  return std::move(expr);
-}
-
-[[nodiscard]] std::shared_ptr<Expr> Parser::factor() {
-  std::shared_ptr<Expr> expr = std::move(this->unary());
-  while (this->match({TokenType::SLASH, TokenType::STAR})) {
-    Token op = this->previous();
-    expr = std::make_shared<Binary>(expr, std::move(op), std::move(this->unary()));
-  }
-  return std::move(expr);
-}
-
-[[nodiscard]] std::shared_ptr<Expr> Parser::unary() {
-  if (this->match({TokenType::BANG, TokenType::MINUS})) {
-    Token op = this->previous();
-    return std::make_shared<Unary>(std::move(op), std::move(this->unary()));
+  return this->parse_precedence(Precedence::ASSIGNMENT);
+}
+
+// parses an operand, then folds in every following operator that binds at
+// least as tightly as minimum. left-associative operators parse their right
+// operand one level above their own; assignment parses it at its own level.
+[[nodiscard]] std::shared_ptr<Expr> Parser::parse_precedence(Precedence minimum) {
+  // the expression parsed so far when it is an assignment target.
+  std::shared_ptr<Variable> variable;
+  std::shared_ptr<Get> get;
+  std::shared_ptr<Expr> expr;
+  if (this->match(TokenType::IDENTIFIER))
+    expr = variable = std::make_shared<Variable>(this->token(this->previous()));
+  else
+    expr = this->prefix();
+  while (true) {
+    const Precedence precedence = precedence_of(this->peek().type);
+    if (precedence < minimum)
+      return expr;
+    const SourceToken &op = this->advance();
+    if (op.type == TokenType::EQUAL) {
+      std::shared_ptr<Expr> value = this->parse_precedence(Precedence::ASSIGNMENT);
+      if (variable != nullptr)
+        return std::make_shared<Assign>(variable->name, std::move(value));
+      if (get != nullptr)
+        return std::make_shared<Set>(get->object, get->name, std::move(value));
+      this->diagnostics.error(op, "invalid assignment target.");
+      return expr;
+    }
+    variable = nullptr;
+    get = nullptr;
+    switch (op.type) {
+    case TokenType::LEFT_PAREN: {
+      expr = this->finish_call(std::move(expr));
+      break;
+    }
+    case TokenType::DOT: {
+      Token name = this->token(this->consume(TokenType::IDENTIFIER, "expect property name after '.'."));
+      expr = get = std::make_shared<Get>(std::move(expr), std::move(name));
+      break;
+    }
+    case TokenType::AND:
+    case TokenType::OR: {
+      std::shared_ptr<Expr> right = this->parse_precedence(next(precedence));
+      expr = std::make_shared<Logical>(std::move(expr), this->token(op), std::move(right));
+      break;
+    }
+    default: {
+      std::shared_ptr<Expr> right = this->parse_precedence(next(precedence));
+      expr = std::make_shared<Binary>(std::move(expr), this->token(op), std::move(right));
+      break;
+    }
+    }
   }
-  return std::move(this->call());
 }
 
 [[nodiscard]] std::shared_ptr<Expr> Parser::finish_call(std::shared_ptr<Expr> callee) {
@@ -267,65 +353,57 @@ Parser::Parser(const std::vector<Token> &tokens)
   if (!this->check(TokenType::RIGHT_PAREN)) {
     do {
       if (arguments.size() >= 255) {
-        error(this->peek(), "can't have more than 255 arguments.");
+        this->diagnostics.error(this->peek(), "can't have more than 255 arguments.");
       }
       arguments.push_back(this->expression());
-    } while (this->match({TokenType::COMMA}));
-  }
-  Token paren = this->consume(TokenType::RIGHT_PAREN, "expect ')' after arguments.");
-  return std::make_shared<Call>(callee, std::move(paren), std::move(arguments));
-}
-
-[[nodiscard]] std::shared_ptr<Expr> Parser::call() {
-  std::shared_ptr<Expr> expr = this->primary();
-  while (true) {
-    if (this->match({TokenType::LEFT_PAREN})) {
-      expr = this->finish_call(expr);
-    } else if (this->match({TokenType::DOT})) {
-      Token name = this->consume(TokenType::IDENTIFIER, "expect property name after '.'.");
-      expr = std::make_shared<Get>(expr, std::move(name));
-    } else {
-      break;
-    }
+    } while (this->match(TokenType::COMMA));
   }
-  return std::move(expr);
+  Token paren = this->token(this->consume(TokenType::RIGHT_PAREN, "expect ')' after arguments."));
+  return std::make_shared<Call>(std::move(callee), std::move(paren), std::move(arguments));
 }
 
-[[nodiscard]] std::shared_ptr<Expr> Parser::primary() {
-  if (this->match({TokenType::FALSE}))
+[[nodiscard]] std::shared_ptr<Expr> Parser::prefix() {
+  if (this->is_at_end())
+    throw parse_error(this->peek(), "expect expression.");
+  const SourceToken &token = this->advance();
+  switch (token.type) {
+  case TokenType::FALSE:
     return std::make_shared<Literal>(false);
-  if (this->match({TokenType::TRUE}))
+  case TokenType::TRUE:
     return std::make_shared<Literal>(true);
-  if (this->match({TokenType::NIL}))
+  case TokenType::NIL:
     return std::make_shared<Literal>(nullptr);
-  if (this->match({TokenType::NUMBER, TokenType::STRING}))
-    return std::make_shared<Literal>(this->previous().literal);
-  if (this->match({TokenType::SUPER})) {
-    Token keyword = this->previous();
+  case TokenType::NUMBER:
+  case TokenType::STRING:
+    return std::make_shared<Literal>(token.literal());
+  case TokenType::BANG:
+  case TokenType::MINUS:
+    return std::make_shared<Unary>(this->token(token), this->parse_precedence(Precedence::UNARY));
+  case TokenType::SUPER: {
     this->consume(TokenType::DOT, "expect '.' after 'super'.");
-    Token method = this->consume(TokenType::IDENTIFIER, "expect superclass method name.");
-    return std::make_shared<Super>(std::move(keyword), std::move(method));
+    Token method = this->token(this->consume(TokenType::IDENTIFIER, "expect superclass method name."));
+    return std::make_shared<Super>(this->token(token), std::move(method));
   }
-  if (this->match({TokenType::THIS}))
-    return std::make_shared<This>(std::move(this->previous()));
-  if (this->match({TokenType::IDENTIFIER}))
-    return std::make_shared<Variable>(std::move(this->previous()));
-  if (this->match({TokenType::LEFT_PAREN})) {
-    std::shared_ptr<Expr> expr = std::move(this->expression());
+  case TokenType::THIS:
+    return std::make_shared<This>(this->token(token));
+  case TokenType::LEFT_PAREN: {
+    std::shared_ptr<Expr> expr = this->expression();
     this->consume(TokenType::RIGHT_PAREN, "expect ')' after expression.");
     return std::make_shared<Grouping>(std::move(expr));
   }
-  throw parse_error(this->peek(), "expect expression.");
+  default:
+    break;
+  }
+  // the offending token is left for synchronize() to skip.
+  --this->current;
+  throw parse_error(token, "expect expression.");
 }
 
-[[nodiscard]] bool Parser::match(std::initializer_list<TokenType> &&type) {
-  for (auto &typ : std::move(type)) {
-    if (this->check(typ)) {
-      this->advance();
-      return true;
-    }
-  }
-  return false;
+[[nodiscard]] bool Parser::match(TokenType type) {
+  if (!this->check(type))
+    return false;
+  ++this->current;
+  return true;
 }
 
 [[nodiscard]] bool Parser::check(TokenType type) {
@@ -338,28 +416,32 @@ Parser::Parser(const std::vector<Token> &tokens)
   return this->peek().type == EOF_;
 }
 
-Token Parser::consume(TokenType type, std::string_view message) {
+const SourceToken &Parser::consume(TokenType type, std::string_view message) {
   if (this->check(type))
-    return std::move(this->advance());
+    return this->advance();
   throw parse_error(this->peek(), std::move(message));
 }
 
-Token Parser::advance() {
+const SourceToken &Parser::advance() {
   if (!this->is_at_end())
     ++this->current;
   return this->previous();
 }
 
-[[nodiscard]] Token Parser::peek() {
-  return this->tokens.at(this->current);
+[[nodiscard]] const SourceToken &Parser::peek() const {
+  return this->tokens[this->current];
+}
+
+[[nodiscard]] const SourceToken &Parser::previous() const {
+  return this->tokens[this->current - 1];
 }
 
-[[nodiscard]] Token Parser::previous() {
-  return this->tokens.at(this->current - 1);
+[[nodiscard]] Token Parser::token(const SourceToken &token) {
+  return Token(token, this->lexicon);
 }
 
-Parser::ParseError Parser::parse_error(const Token &token, std::string_view message) {
-  error(token, message);
+Parser::ParseError Parser::parse_error(const SourceToken &token, std::string_view message) {
+  this->diagnostics.error(token, message);
   return ParseError("");
 }
 
@@ -374,6 +456,7 @@ void Parser::synchronize() {
     case TokenType::VAR:
     case TokenType::FOR:
     case TokenType::IF:
+    case TokenType::IMPORT:
     case TokenType::WHILE:
     case TokenType::PRINT:
     case TokenType::RETURN:
@@ -0,0 +1,703 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "../include/mapped_file.hpp"
+#include "../include/program_cache.hpp"
+
+namespace loxplusplus {
+static constexpr char magic[4] = {'L', 'O', 'X', 'C'};
+
+ProgramCache::ProgramCache(std::string directory)
+    : directory{std::move(directory)} {}
+
+[[nodiscard]] std::optional<std::vector<std::shared_ptr<Stmt>>> ProgramCache::load(std::string_view source, Lexicon &lexicon, SymbolTable &symbols) const {
+  const std::uint64_t key = ProgramCache::key(source);
+  MappedFile file(this->path(key));
+  if (file.data == nullptr)
+    return std::nullopt;
+  try {
+    ProgramReader reader(file.data, file.size, lexicon, symbols);
+    return reader.read(key);
+  } catch (const ProgramReader::Corrupt &) {
+    return std::nullopt;
+  }
+}
+
+void ProgramCache::store(std::string_view source, const std::vector<std::shared_ptr<Stmt>> &statements) const {
+  const std::uint64_t key = ProgramCache::key(source);
+  ProgramWriter writer;
+  const std::string bytes = writer.write(key, statements);
+  std::error_code error;
+  std::filesystem::create_directories(this->directory, error);
+  // written aside and renamed, so concurrent runs never map a partial file.
+  const std::string path = this->path(key),
+                    temporary = path + ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file)
+      return;
+    file.write(bytes.data(), bytes.size());
+    if (!file)
+      return;
+  }
+  std::filesystem::rename(temporary, path, error);
+  if (error)
+    std::filesystem::remove(temporary, error);
+}
+
+// the stored statements carry what the Resolver, the TypeChecker and the
+// IrOptimizer made of the source, which any build may change; seeding with
+// the build makes a rebuilt binary miss the files of an older one, and the
+// format version covers the layout of the file.
+[[nodiscard]] std::uint64_t ProgramCache::key(std::string_view source) {
+  static constexpr std::string_view build = __DATE__ " " __TIME__;
+  return hash(source, hash(build));
+}
+
+[[nodiscard]] std::string ProgramCache::path(std::uint64_t key) const {
+  static constexpr char digits[] = "0123456789abcdef";
+  std::string name(16, '0');
+  for (int i = 15; i >= 0; --i, key >>= 4)
+    name[i] = digits[key & 15];
+  return (std::filesystem::path(this->directory) / (name + ".loxc")).string();
+}
+
+[[nodiscard]] std::uint64_t ProgramCache::hash(std::string_view bytes, std::uint64_t seed) {
+  std::uint64_t hash = seed;
+  for (unsigned char c : bytes) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+[[nodiscard]] std::string ProgramWriter::write(std::uint64_t key, const std::vector<std::shared_ptr<Stmt>> &statements) {
+  this->write(statements);
+  std::string payload;
+  auto append = [](std::string &bytes, const auto &value) {
+    bytes.append(reinterpret_cast<const char *>(&value), sizeof value);
+  };
+  append(payload, static_cast<std::uint32_t>(this->pool.size()));
+  for (std::string_view value : this->pool) {
+    append(payload, static_cast<std::uint32_t>(value.size()));
+    payload.append(value);
+  }
+  payload.append(this->nodes);
+  std::string bytes(magic, sizeof magic);
+  append(bytes, ProgramCache::format_version);
+  append(bytes, key);
+  append(bytes, ProgramCache::hash(payload));
+  return bytes + payload;
+}
+
+template <typename T>
+void ProgramWriter::write_value(T value) {
+  this->nodes.append(reinterpret_cast<const char *>(&value), sizeof value);
+}
+
+void ProgramWriter::write_kind(NodeKind kind) {
+  this->write_value(static_cast<std::uint8_t>(kind));
+}
+
+void ProgramWriter::write_type(ValueType type) {
+  this->write_value(static_cast<std::uint8_t>(type));
+}
+
+void ProgramWriter::write_string(const std::string &value) {
+  auto [it, inserted] = this->pool_index.try_emplace(value, static_cast<std::uint32_t>(this->pool.size()));
+  if (inserted)
+    this->pool.push_back(value);
+  this->write_value(it->second);
+}
+
+void ProgramWriter::write(const Token &token) {
+  // token types include negative enumerators.
+  this->write_value(static_cast<std::int16_t>(token.type));
+  this->write_value(static_cast<std::int32_t>(token.line));
+  this->write_string(token.lexeme);
+}
+
+void ProgramWriter::write(std::shared_ptr<Stmt> stmt) {
+  if (stmt == nullptr)
+    this->write_kind(NodeKind::NONE);
+  else
+    (void)dispatch(*this, stmt);
+}
+
+void ProgramWriter::write(std::shared_ptr<Expr> expr) {
+  if (expr == nullptr)
+    this->write_kind(NodeKind::NONE);
+  else
+    (void)dispatch(*this, expr);
+}
+
+void ProgramWriter::write(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  this->write_value(static_cast<std::uint32_t>(statements.size()));
+  for (const std::shared_ptr<Stmt> &stmt : statements)
+    this->write(stmt);
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Block> stmt) {
+  this->write_kind(NodeKind::BLOCK);
+  this->write(stmt->statements);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Class> stmt) {
+  this->write_kind(NodeKind::CLASS);
+  this->write(stmt->name);
+  this->write(std::static_pointer_cast<Expr>(stmt->superclass));
+  this->write_value(static_cast<std::uint32_t>(stmt->methods.size()));
+  for (const std::shared_ptr<Function> &method : stmt->methods)
+    (void)this->visit(method);
+  this->write_value(static_cast<std::uint8_t>(stmt->slot >= 0));
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Expression> stmt) {
+  this->write_kind(NodeKind::EXPRESSION);
+  this->write(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Function> stmt) {
+  this->write_kind(NodeKind::FUNCTION);
+  this->write(stmt->name);
+  this->write_value(static_cast<std::uint32_t>(stmt->params.size()));
+  for (const Token &param : stmt->params)
+    this->write(param);
+  this->write_value(static_cast<std::uint8_t>(!stmt->param_types.empty()));
+  for (ValueType type : stmt->param_types)
+    this->write_type(type);
+  this->write_type(stmt->return_type);
+  this->write(stmt->body());
+  this->write_value(static_cast<std::uint8_t>(stmt->slot >= 0));
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<If> stmt) {
+  this->write_kind(NodeKind::IF);
+  this->write(stmt->condition);
+  this->write(stmt->then_branch);
+  this->write(stmt->else_branch);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Import> stmt) {
+  this->write_kind(NodeKind::IMPORT);
+  this->write(stmt->keyword);
+  this->write(stmt->path);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Print> stmt) {
+  this->write_kind(NodeKind::PRINT);
+  this->write(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Return> stmt) {
+  this->write_kind(NodeKind::RETURN);
+  this->write(stmt->keyword);
+  this->write(stmt->value);
+  this->write_type(stmt->check);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Var> stmt) {
+  this->write_kind(NodeKind::VAR);
+  this->write(stmt->name);
+  this->write(stmt->initializer);
+  this->write_value(static_cast<std::uint8_t>(stmt->slot >= 0));
+  this->write_type(stmt->type);
+  this->write_type(stmt->check);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<While> stmt) {
+  this->write_kind(NodeKind::WHILE);
+  this->write(stmt->condition);
+  this->write(stmt->body);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Assign> expr) {
+  this->write_kind(NodeKind::ASSIGN);
+  this->write(expr->name);
+  this->write(expr->value);
+  this->write_value(static_cast<std::int32_t>(expr->depth));
+  this->write_value(static_cast<std::uint8_t>(expr->slot >= 0));
+  this->write_type(expr->check);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Binary> expr) {
+  this->write_kind(NodeKind::BINARY);
+  this->write(expr->left);
+  this->write(expr->op);
+  this->write(expr->right);
+  this->write_value(static_cast<std::uint8_t>(expr->numeric));
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Call> expr) {
+  this->write_kind(NodeKind::CALL);
+  this->write(expr->callee);
+  this->write(expr->paren);
+  this->write_value(static_cast<std::uint32_t>(expr->arguments.size()));
+  for (const std::shared_ptr<Expr> &argument : expr->arguments)
+    this->write(argument);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Get> expr) {
+  this->write_kind(NodeKind::GET);
+  this->write(expr->object);
+  this->write(expr->name);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Grouping> expr) {
+  this->write_kind(NodeKind::GROUPING);
+  this->write(expr->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Literal> expr) {
+  this->write_kind(NodeKind::LITERAL);
+  this->write_value(static_cast<std::uint8_t>(expr->value.index()));
+  switch (expr->value.index()) {
+  case StringIndex: {
+    this->write_string(std::get<StringIndex>(expr->value));
+    break;
+  }
+  case DoubleIndex: {
+    this->write_value(std::get<DoubleIndex>(expr->value));
+    break;
+  }
+  case IntegerIndex: {
+    this->write_value(std::get<IntegerIndex>(expr->value));
+    break;
+  }
+  case BoolIndex: {
+    this->write_value(static_cast<std::uint8_t>(std::get<BoolIndex>(expr->value)));
+    break;
+  }
+  }
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Logical> expr) {
+  this->write_kind(NodeKind::LOGICAL);
+  this->write(expr->left);
+  this->write(expr->op);
+  this->write(expr->right);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Set> expr) {
+  this->write_kind(NodeKind::SET);
+  this->write(expr->object);
+  this->write(expr->name);
+  this->write(expr->value);
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Super> expr) {
+  this->write_kind(NodeKind::SUPER);
+  this->write(expr->keyword);
+  this->write(expr->method);
+  this->write_value(static_cast<std::int32_t>(expr->depth));
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<This> expr) {
+  this->write_kind(NodeKind::THIS);
+  this->write(expr->keyword);
+  this->write_value(static_cast<std::int32_t>(expr->depth));
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Unary> expr) {
+  this->write_kind(NodeKind::UNARY);
+  this->write(expr->op);
+  this->write(expr->right);
+  this->write_value(static_cast<std::uint8_t>(expr->numeric));
+  return nullptr;
+}
+
+[[nodiscard]] Object ProgramWriter::visit(std::shared_ptr<Variable> expr) {
+  this->write_kind(NodeKind::VARIABLE);
+  this->write(expr->name);
+  this->write_value(static_cast<std::int32_t>(expr->depth));
+  this->write_value(static_cast<std::uint8_t>(expr->slot >= 0));
+  return nullptr;
+}
+
+ProgramReader::ProgramReader(const char *data, std::size_t size, Lexicon &lexicon, SymbolTable &symbols)
+    : cursor{data}, end{data + size}, lexicon{lexicon}, symbols{symbols} {}
+
+[[nodiscard]] std::vector<std::shared_ptr<Stmt>> ProgramReader::read(std::uint64_t key) {
+  this->read_header(key);
+  std::vector<std::shared_ptr<Stmt>> statements = this->read_statements();
+  if (this->cursor != this->end)
+    throw Corrupt{};
+  return statements;
+}
+
+[[nodiscard]] std::vector<std::shared_ptr<Function>> ProgramReader::read_functions(std::uint64_t key,
+                                                                                 std::vector<std::vector<Capture>> &captures) {
+  this->read_header(key);
+  const auto count = this->read_value<std::uint32_t>();
+  std::vector<std::shared_ptr<Function>> functions;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    if (this->read_kind() != NodeKind::FUNCTION)
+      throw Corrupt{};
+    this->captures = &captures.emplace_back();
+    functions.push_back(this->read_function(false));
+  }
+  this->captures = nullptr;
+  if (this->cursor != this->end)
+    throw Corrupt{};
+  return functions;
+}
+
+void ProgramReader::read_header(std::uint64_t key) {
+  if (this->end - this->cursor < static_cast<std::ptrdiff_t>(sizeof magic) ||
+      std::memcmp(this->cursor, magic, sizeof magic) != 0)
+    throw Corrupt{};
+  this->cursor += sizeof magic;
+  if (this->read_value<std::uint32_t>() != ProgramCache::format_version || this->read_value<std::uint64_t>() != key)
+    throw Corrupt{};
+  const auto checksum = this->read_value<std::uint64_t>();
+  if (ProgramCache::hash(std::string_view(this->cursor, this->end - this->cursor)) != checksum)
+    throw Corrupt{};
+  const auto count = this->read_value<std::uint32_t>();
+  for (std::uint32_t i = 0; i < count; ++i) {
+    const auto size = this->read_value<std::uint32_t>();
+    if (static_cast<std::size_t>(this->end - this->cursor) < size)
+      throw Corrupt{};
+    this->pool.emplace_back(this->cursor, size);
+    this->cursor += size;
+  }
+}
+
+template <typename T>
+[[nodiscard]] T ProgramReader::read_value() {
+  if (static_cast<std::size_t>(this->end - this->cursor) < sizeof(T))
+    throw Corrupt{};
+  T value;
+  std::memcpy(&value, this->cursor, sizeof(T));
+  this->cursor += sizeof(T);
+  return value;
+}
+
+[[nodiscard]] NodeKind ProgramReader::read_kind() {
+  const auto kind = this->read_value<std::uint8_t>();
+  if (kind > static_cast<std::uint8_t>(NodeKind::WHILE))
+    throw Corrupt{};
+  return static_cast<NodeKind>(kind);
+}
+
+[[nodiscard]] const std::string &ProgramReader::read_string() {
+  const auto index = this->read_value<std::uint32_t>();
+  if (index >= this->pool.size())
+    throw Corrupt{};
+  return this->pool[index];
+}
+
+[[nodiscard]] Token ProgramReader::read_token() {
+  // every enumerator fits in a signed byte; other values are not a TokenType.
+  const auto raw = this->read_value<std::int16_t>();
+  if (raw < -128 || raw > 127)
+    throw Corrupt{};
+  const auto type = static_cast<TokenType>(raw);
+  const auto line = this->read_value<std::int32_t>();
+  return Token(type, this->read_string(), line, this->lexicon);
+}
+
+[[nodiscard]] int ProgramReader::read_slot(const Token &name) {
+  return this->read_value<std::uint8_t>() != 0 ? this->symbols.intern(name.lexeme) : -1;
+}
+
+[[nodiscard]] int ProgramReader::read_slot(const Token &name, bool global) {
+  const int slot = this->read_slot(name);
+  if ((slot >= 0) != global)
+    throw Corrupt{};
+  return slot;
+}
+
+[[nodiscard]] int ProgramReader::read_depth(const Token &name, bool local) {
+  const auto depth = this->read_value<std::int32_t>();
+  if (depth == -1 && !local)
+    return depth;
+  if (depth < 0)
+    throw Corrupt{};
+  this->require(depth, name.lexeme);
+  return depth;
+}
+
+void ProgramReader::require(int depth, std::string_view name) {
+  const auto scopes = static_cast<int>(this->scopes.size());
+  if (depth >= scopes && this->captures != nullptr)
+    this->captures->push_back(Capture{depth - scopes, std::string(name)});
+  else if (depth >= scopes || !this->scopes[scopes - 1 - depth].contains(name))
+    throw Corrupt{};
+}
+
+void ProgramReader::begin_scope() {
+  this->scopes.emplace_back();
+}
+
+void ProgramReader::end_scope() {
+  this->scopes.pop_back();
+}
+
+void ProgramReader::declare(const Token &name) {
+  if (!this->scopes.empty())
+    this->scopes.back().insert(name.lexeme);
+}
+
+[[nodiscard]] ValueType ProgramReader::read_type() {
+  const auto type = this->read_value<std::uint8_t>();
+  if (type > static_cast<std::uint8_t>(ValueType::BOOL))
+    throw Corrupt{};
+  return static_cast<ValueType>(type);
+}
+
+[[nodiscard]] std::vector<std::shared_ptr<Stmt>> ProgramReader::read_statements() {
+  const auto count = this->read_value<std::uint32_t>();
+  std::vector<std::shared_ptr<Stmt>> statements;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    std::shared_ptr<Stmt> stmt = this->read_stmt();
+    if (stmt == nullptr)
+      throw Corrupt{};
+    statements.push_back(std::move(stmt));
+  }
+  return statements;
+}
+
+[[nodiscard]] std::shared_ptr<Function> ProgramReader::read_function(bool method) {
+  Token name = this->read_token();
+  // a detached function keeps the slot it had where it was declared.
+  const bool detached = this->captures != nullptr && this->scopes.empty();
+  const bool global = !method && this->scopes.empty();
+  if (!method)
+    this->declare(name);
+  const auto count = this->read_value<std::uint32_t>();
+  std::vector<Token> params;
+  this->begin_scope();
+  for (std::uint32_t i = 0; i < count; ++i) {
+    params.push_back(this->read_token());
+    this->declare(params.back());
+  }
+  std::vector<ValueType> param_types;
+  if (this->read_value<std::uint8_t>() != 0)
+    for (std::uint32_t i = 0; i < count; ++i)
+      param_types.push_back(this->read_type());
+  const ValueType return_type = this->read_type();
+  std::vector<std::shared_ptr<Stmt>> body = this->read_statements();
+  this->end_scope();
+  auto function = std::make_shared<Function>(name, std::move(params), std::move(body));
+  function->param_types = std::move(param_types);
+  function->return_type = return_type;
+  function->slot = detached ? this->read_slot(name) : this->read_slot(name, global);
+  return function;
+}
+
+[[nodiscard]] std::shared_ptr<Stmt> ProgramReader::read_stmt() {
+  switch (this->read_kind()) {
+  case NodeKind::NONE: {
+    return nullptr;
+  }
+  case NodeKind::BLOCK: {
+    this->begin_scope();
+    auto block = std::make_shared<Block>(this->read_statements());
+    this->end_scope();
+    return block;
+  }
+  case NodeKind::CLASS: {
+    Token name = this->read_token();
+    const bool global = this->scopes.empty();
+    this->declare(name);
+    std::shared_ptr<Expr> superclass = this->read_expr();
+    if (superclass != nullptr && superclass->kind != ExprKind::VARIABLE)
+      throw Corrupt{};
+    auto variable = std::static_pointer_cast<Variable>(superclass);
+    if (variable != nullptr) {
+      this->begin_scope();
+      this->scopes.back().insert("super");
+    }
+    this->begin_scope();
+    this->scopes.back().insert("this");
+    const auto count = this->read_value<std::uint32_t>();
+    std::vector<std::shared_ptr<Function>> methods;
+    for (std::uint32_t i = 0; i < count; ++i) {
+      if (this->read_kind() != NodeKind::FUNCTION)
+        throw Corrupt{};
+      methods.push_back(this->read_function(true));
+    }
+    this->end_scope();
+    if (variable != nullptr)
+      this->end_scope();
+    auto klass = std::make_shared<Class>(name, std::move(variable), std::move(methods));
+    klass->slot = this->read_slot(name, global);
+    return klass;
+  }
+  case NodeKind::EXPRESSION: {
+    return std::make_shared<Expression>(this->read_expr());
+  }
+  case NodeKind::FUNCTION: {
+    return this->read_function(false);
+  }
+  case NodeKind::IF: {
+    std::shared_ptr<Expr> condition = this->read_expr();
+    std::shared_ptr<Stmt> then_branch = this->read_stmt();
+    std::shared_ptr<Stmt> else_branch = this->read_stmt();
+    return std::make_shared<If>(std::move(condition), std::move(then_branch), std::move(else_branch));
+  }
+  case NodeKind::IMPORT: {
+    Token keyword = this->read_token();
+    Token path = this->read_token();
+    return std::make_shared<Import>(std::move(keyword), std::move(path));
+  }
+  case NodeKind::PRINT: {
+    return std::make_shared<Print>(this->read_expr());
+  }
+  case NodeKind::RETURN: {
+    Token keyword = this->read_token();
+    auto result = std::make_shared<Return>(keyword, this->read_expr());
+    result->check = this->read_type();
+    return result;
+  }
+  case NodeKind::VAR: {
+    Token name = this->read_token();
+    const bool global = this->scopes.empty();
+    this->declare(name);
+    auto var = std::make_shared<Var>(name, this->read_expr());
+    var->slot = this->read_slot(name, global);
+    var->type = this->read_type();
+    var->check = this->read_type();
+    return var;
+  }
+  case NodeKind::WHILE: {
+    std::shared_ptr<Expr> condition = this->read_expr();
+    return std::make_shared<While>(std::move(condition), this->read_stmt());
+  }
+  default: {
+    throw Corrupt{};
+  }
+  }
+}
+
+[[nodiscard]] std::shared_ptr<Expr> ProgramReader::read_expr() {
+  switch (this->read_kind()) {
+  case NodeKind::NONE: {
+    return nullptr;
+  }
+  case NodeKind::ASSIGN: {
+    Token name = this->read_token();
+    auto assign = std::make_shared<Assign>(name, this->read_expr());
+    assign->depth = this->read_depth(name, false);
+    assign->slot = this->read_slot(name, assign->depth < 0);
+    assign->check = this->read_type();
+    return assign;
+  }
+  case NodeKind::BINARY: {
+    std::shared_ptr<Expr> left = this->read_expr();
+    Token op = this->read_token();
+    auto binary = std::make_shared<Binary>(std::move(left), op, this->read_expr());
+    binary->numeric = this->read_value<std::uint8_t>() != 0;
+    return binary;
+  }
+  case NodeKind::CALL: {
+    std::shared_ptr<Expr> callee = this->read_expr();
+    Token paren = this->read_token();
+    const auto count = this->read_value<std::uint32_t>();
+    std::vector<std::shared_ptr<Expr>> arguments;
+    for (std::uint32_t i = 0; i < count; ++i)
+      arguments.push_back(this->read_expr());
+    return std::make_shared<Call>(std::move(callee), paren, std::move(arguments));
+  }
+  case NodeKind::GET: {
+    std::shared_ptr<Expr> object = this->read_expr();
+    return std::make_shared<Get>(std::move(object), this->read_token());
+  }
+  case NodeKind::GROUPING: {
+    return std::make_shared<Grouping>(this->read_expr());
+  }
+  case NodeKind::LITERAL: {
+    switch (this->read_value<std::uint8_t>()) {
+    case StringIndex: {
+      return std::make_shared<Literal>(this->read_string());
+    }
+    case DoubleIndex: {
+      return std::make_shared<Literal>(this->read_value<double>());
+    }
+    case IntegerIndex: {
+      return std::make_shared<Literal>(this->read_value<std::int64_t>());
+    }
+    case BoolIndex: {
+      return std::make_shared<Literal>(this->read_value<std::uint8_t>() != 0);
+    }
+    case NullptrIndex: {
+      return std::make_shared<Literal>(nullptr);
+    }
+    default: {
+      throw Corrupt{};
+    }
+    }
+  }
+  case NodeKind::LOGICAL: {
+    std::shared_ptr<Expr> left = this->read_expr();
+    Token op = this->read_token();
+    return std::make_shared<Logical>(std::move(left), op, this->read_expr());
+  }
+  case NodeKind::SET: {
+    std::shared_ptr<Expr> object = this->read_expr();
+    Token name = this->read_token();
+    return std::make_shared<Set>(std::move(object), name, this->read_expr());
+  }
+  case NodeKind::SUPER: {
+    Token keyword = this->read_token();
+    Token method = this->read_token();
+    auto super = std::make_shared<Super>(keyword, method);
+    super->depth = this->read_depth(keyword, true);
+    // the instance is bound one scope inside the superclass.
+    if (super->depth == 0)
+      throw Corrupt{};
+    this->require(super->depth - 1, "this");
+    return super;
+  }
+  case NodeKind::THIS: {
+    auto self = std::make_shared<This>(this->read_token());
+    self->depth = this->read_depth(self->keyword, true);
+    return self;
+  }
+  case NodeKind::UNARY: {
+    Token op = this->read_token();
+    auto unary = std::make_shared<Unary>(op, this->read_expr());
+    unary->numeric = this->read_value<std::uint8_t>() != 0;
+    return unary;
+  }
+  case NodeKind::VARIABLE: {
+    Token name = this->read_token();
+    auto variable = std::make_shared<Variable>(name);
+    variable->depth = this->read_depth(name, false);
+    variable->slot = this->read_slot(name, variable->depth < 0);
+    return variable;
+  }
+  default: {
+    throw Corrupt{};
+  }
+  }
+}
+}// namespace loxplusplus
@@ -7,7 +7,8 @@
 #include "../include/resolver.hpp"
 
 namespace loxplusplus {
-Resolver::Resolver(Interpreter &interpreter) : interpreter{interpreter} {}
+Resolver::Resolver(Diagnostics &diagnostics, SymbolTable &symbols)
+    : diagnostics{diagnostics}, symbols{symbols} {}
 
 [[nodiscard]] Object Resolver::visit(std::shared_ptr<Block> stmt) {
   this->begin_scope();
@@ -21,8 +22,10 @@ Resolver::Resolver(Interpreter &interpreter) : interpreter{interpreter} {}
   this->current_class = ClassType::CLASS;
   this->declare(stmt->name);
   this->define(stmt->name);
+  if (this->scopes.empty())
+    stmt->slot = this->global_slot(stmt->name);
   if (stmt->superclass != nullptr && stmt->name.lexeme == stmt->superclass->name.lexeme) {
-    error(stmt->superclass->name, "a class can't inherit from itself.");
+    this->diagnostics.error(stmt->superclass->name, "a class can't inherit from itself.");
   }
   if (stmt->superclass != nullptr) {
     this->current_class = ClassType::SUBCLASS;
@@ -38,7 +41,8 @@ Resolver::Resolver(Interpreter &interpreter) : interpreter{interpreter} {}
     FunctionType declaration = FunctionType::METHOD;
     if (method->name.lexeme == "init")
       declaration = FunctionType::INITIALIZER;
-    this->resolve_function(method, declaration);
+    if (!method->deferred())
+      this->resolve_function(*method, method->body(), declaration);
   }
   this->end_scope();
   if (stmt->superclass != nullptr)
@@ -55,7 +59,10 @@ Resolver::Resolver(Interpreter &interpreter) : interpreter{interpreter} {}
 [[nodiscard]] Object Resolver::visit(std::shared_ptr<Function> stmt) {
   this->declare(stmt->name);
   this->define(stmt->name);
-  this->resolve_function(stmt, FunctionType::FUNCTION);
+  if (this->scopes.empty())
+    stmt->slot = this->global_slot(stmt->name);
+  if (!stmt->deferred())
+    this->resolve_function(*stmt, stmt->body(), FunctionType::FUNCTION);
   return nullptr;
 }
 
@@ -67,6 +74,10 @@ Resolver::Resolver(Interpreter &interpreter) : interpreter{interpreter} {}
   return nullptr;
 }
 
+[[nodiscard]] Object Resolver::visit(std::shared_ptr<Import> stmt) {
+  return nullptr;
+}
+
 [[nodiscard]] Object Resolver::visit(std::shared_ptr<Print> stmt) {
   this->resolve(stmt->expression);
   return nullptr;
@@ -74,11 +85,11 @@ Resolver::Resolver(Interpreter &interpreter) : interpreter{interpreter} {}
 
 [[nodiscard]] Object Resolver::visit(std::shared_ptr<Return> stmt) {
   if (current_function == FunctionType::NONE) {
-    error(stmt->keyword, "can't return from top-level code.");
+    this->diagnostics.error(stmt->keyword, "can't return from top-level code.");
   }
   if (stmt->value != nullptr) {
     if (current_function == FunctionType::INITIALIZER) {
-      error(stmt->keyword, "can't return a value from an initializer.");
+      this->diagnostics.error(stmt->keyword, "can't return a value from an initializer.");
     }
     this->resolve(stmt->value);
   }
@@ -91,6 +102,8 @@ Resolver::Resolver(Interpreter &interpreter) : interpreter{interpreter} {}
     this->resolve(stmt->initializer);
   }
   this->define(stmt->name);
+  if (this->scopes.empty())
+    stmt->slot = this->global_slot(stmt->name);
   return nullptr;
 }
 
@@ -102,7 +115,9 @@ Resolver::Resolver(Interpreter &interpreter) : interpreter{interpreter} {}
 
 [[nodiscard]] Object Resolver::visit(std::shared_ptr<Assign> expr) {
   this->resolve(expr->value);
-  this->resolve_local(expr, expr->name);
+  expr->depth = this->resolve_local(expr->name);
+  if (expr->depth < 0)
+    expr->slot = this->global_slot(expr->name);
   return nullptr;
 }
 
@@ -147,20 +162,20 @@ Resolver::Resolver(Interpreter &interpreter) : interpreter{interpreter} {}
 
 [[nodiscard]] Object Resolver::visit(std::shared_ptr<Super> expr) {
   if (this->current_class == ClassType::NONE) {
-    error(expr->keyword, "can't user 'super' outside of a class.");
+    this->diagnostics.error(expr->keyword, "can't user 'super' outside of a class.");
   } else if (this->current_class != ClassType::SUBCLASS) {
-    error(expr->keyword, "can't user 'super' in a class with no superclass.");
+    this->diagnostics.error(expr->keyword, "can't user 'super' in a class with no superclass.");
   }
-  this->resolve_local(expr, expr->keyword);
+  expr->depth = this->resolve_local(expr->keyword);
   return nullptr;
 }
 
 [[nodiscard]] Object Resolver::visit(std::shared_ptr<This> expr) {
   if (this->current_class == ClassType::NONE) {
-    error(expr->keyword, "can't use 'this' outside of a class.");
+    this->diagnostics.error(expr->keyword, "can't use 'this' outside of a class.");
     return nullptr;
   }
-  this->resolve_local(expr, expr->keyword);
+  expr->depth = this->resolve_local(expr->keyword);
   return nullptr;
 }
 
@@ -173,10 +188,12 @@ Resolver::Resolver(Interpreter &interpreter) : interpreter{interpreter} {}
   if (!this->scopes.empty()) {
     auto &scope = this->scopes.back();
     if (auto it = scope.find(expr->name.lexeme); it != scope.end() && it->second == false) {
-      error(expr->name, "can't read local variable in its own initializer.");
+      this->diagnostics.error(expr->name, "can't read local variable in its own initializer.");
     }
   }
-  this->resolve_local(expr, expr->name);
+  expr->depth = this->resolve_local(expr->name);
+  if (expr->depth < 0)
+    expr->slot = this->global_slot(expr->name);
   return nullptr;
 }
 
@@ -185,24 +202,43 @@ void Resolver::resolve(const std::vector<std::shared_ptr<Stmt>> &statements) {
     this->resolve(statement);
 }
 
-void Resolver::resolve(std::shared_ptr<Stmt> stmt) {
-  stmt->accept(*this);
+void Resolver::resolve(const std::shared_ptr<Stmt> &stmt) {
+  (void)dispatch(*this, stmt);
+}
+
+void Resolver::resolve(const std::shared_ptr<Expr> &expr) {
+  (void)dispatch(*this, expr);
 }
 
-void Resolver::resolve(std::shared_ptr<Expr> expr) {
-  expr->accept(*this);
+void Resolver::resolve_deferred(const Function &function, const std::vector<std::shared_ptr<Stmt>> &body,
+                                bool method, bool subclass) {
+  if (!method) {
+    this->resolve_function(function, body, FunctionType::FUNCTION);
+    return;
+  }
+  this->current_class = subclass ? ClassType::SUBCLASS : ClassType::CLASS;
+  if (subclass) {
+    this->begin_scope();
+    this->scopes.back()["super"] = true;
+  }
+  this->begin_scope();
+  this->scopes.back()["this"] = true;
+  this->resolve_function(function, body,
+                         function.name.lexeme == "init" ? FunctionType::INITIALIZER : FunctionType::METHOD);
+  this->scopes.clear();
+  this->current_class = ClassType::NONE;
 }
 
-void Resolver::resolve_function(std::shared_ptr<Function> function,
+void Resolver::resolve_function(const Function &function, const std::vector<std::shared_ptr<Stmt>> &body,
                                 FunctionType type) {
   FunctionType enclosingFunction = current_function;
   current_function = type;
   this->begin_scope();
-  for (const Token &param : function->params) {
+  for (const Token &param : function.params) {
     this->declare(param);
     this->define(param);
   }
-  this->resolve(function->body);
+  this->resolve(body);
   this->end_scope();
   current_function = enclosingFunction;
 }
@@ -220,7 +256,7 @@ void Resolver::declare(const Token &name) {
     return;
   std::map<std::string, bool> &scope = this->scopes.back();
   if (scope.find(name.lexeme) != scope.end()) {
-    error(name, "already variable with this name in this scope.");
+    this->diagnostics.error(name, "already variable with this name in this scope.");
   }
   scope[name.lexeme] = false;
 }
@@ -231,12 +267,15 @@ void Resolver::define(const Token &name) {
   this->scopes.back()[name.lexeme] = true;
 }
 
-void Resolver::resolve_local(std::shared_ptr<Expr> expr, const Token &name) {
+[[nodiscard]] int Resolver::resolve_local(const Token &name) {
   for (int i = scopes.size() - 1; i >= 0; --i) {
-    if (this->scopes[i].find(name.lexeme) != scopes[i].end()) {
-      this->interpreter.resolve(expr, scopes.size() - 1 - i);
-      return;
-    }
+    if (this->scopes[i].find(name.lexeme) != scopes[i].end())
+      return scopes.size() - 1 - i;
   }
+  return -1;
+}
+
+[[nodiscard]] int Resolver::global_slot(const Token &name) {
+  return this->symbols.intern(name.lexeme);
 }
 }// namespace loxplusplus
\ No newline at end of file
@@ -0,0 +1,664 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <algorithm>
+
+#include "../include/scalar_replacer.hpp"
+
+namespace loxplusplus {
+ScalarReplacer::ScalarReplacer(Lexicon &lexicon)
+    : lexicon{lexicon} {}
+
+void ScalarReplacer::replace(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  for (const std::shared_ptr<Stmt> &stmt : statements) {
+    if (stmt->kind != StmtKind::CLASS)
+      continue;
+    auto klass = std::static_pointer_cast<Class>(stmt);
+    if (Layout layout; ScalarReplacer::layout(*klass, layout))
+      this->layouts[klass->name.lexeme] = std::move(layout);
+  }
+  for (const auto &[name, count] : top_level_declarations(statements))
+    if (count > 1)
+      this->layouts.erase(name);
+  if (this->layouts.empty())
+    return;
+
+  for (const std::shared_ptr<Stmt> &stmt : statements)
+    this->scan(stmt);
+  this->layouts.clear();
+}
+
+[[nodiscard]] bool ScalarReplacer::Layout::stores(const std::string &field) const {
+  return std::any_of(this->fields.begin(), this->fields.end(),
+                     [&field](const auto &stored) { return stored.first == field; });
+}
+
+void ScalarReplacer::scan(const std::shared_ptr<Stmt> &stmt) {
+  (void)dispatch(*this, stmt);
+}
+
+// an init made of `this.f = value;` statements, whose values read nothing
+// but its parameters, globals and fields, and run no code.
+[[nodiscard]] bool ScalarReplacer::layout(const Class &klass, Layout &layout) {
+  if (klass.superclass != nullptr)
+    return false;
+  for (const std::shared_ptr<Function> &method : klass.methods) {
+    if (method->name.lexeme != "init")
+      continue;
+    if (layout.init != nullptr)
+      return false;
+    layout.init = method;
+  }
+  const std::shared_ptr<Function> &init = layout.init;
+  if (init == nullptr || init->deferred() || init->return_type != ValueType::ANY)
+    return false;
+  for (ValueType type : init->param_types)
+    if (type != ValueType::ANY)
+      return false;
+  for (const std::shared_ptr<Stmt> &stmt : init->body()) {
+    if (stmt->kind != StmtKind::EXPRESSION)
+      return false;
+    const std::shared_ptr<Expr> &expression = std::static_pointer_cast<Expression>(stmt)->expression;
+    if (expression->kind != ExprKind::SET)
+      return false;
+    auto set = std::static_pointer_cast<Set>(expression);
+    if (set->object->kind != ExprKind::THIS || layout.stores(set->name.lexeme) || !storable(set->value, *init))
+      return false;
+    layout.fields.emplace_back(set->name.lexeme, set->value);
+  }
+  layout.forwarding = layout.fields.size() == init->params.size();
+  for (std::size_t i = 0; layout.forwarding && i < layout.fields.size(); ++i) {
+    const std::shared_ptr<Expr> &value = layout.fields[i].second;
+    layout.forwarding = value->kind == ExprKind::VARIABLE &&
+                        std::static_pointer_cast<Variable>(value)->depth == 0 &&
+                        std::static_pointer_cast<Variable>(value)->name.lexeme == init->params[i].lexeme;
+  }
+  return true;
+}
+
+[[nodiscard]] bool ScalarReplacer::storable(const std::shared_ptr<Expr> &expr, const Function &init) {
+  switch (expr->kind) {
+  case ExprKind::BINARY: {
+    auto binary = std::static_pointer_cast<Binary>(expr);
+    return storable(binary->left, init) && storable(binary->right, init);
+  }
+  case ExprKind::GET:
+    return storable(std::static_pointer_cast<Get>(expr)->object, init);
+  case ExprKind::GROUPING:
+    return storable(std::static_pointer_cast<Grouping>(expr)->expression, init);
+  case ExprKind::LITERAL:
+    return true;
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    return storable(logical->left, init) && storable(logical->right, init);
+  }
+  case ExprKind::UNARY:
+    return storable(std::static_pointer_cast<Unary>(expr)->right, init);
+  case ExprKind::VARIABLE: {
+    auto variable = std::static_pointer_cast<Variable>(expr);
+    return variable->depth < 0 ||
+           (variable->depth == 0 && std::any_of(init.params.begin(), init.params.end(), [&variable](const Token &param) {
+              return param.lexeme == variable->name.lexeme;
+            }));
+  }
+  default:
+    return false;
+  }
+}
+
+// whether running a statement may call a function, which could assign any
+// global. bodies of nested functions and classes do not run.
+[[nodiscard]] bool ScalarReplacer::calls(const std::shared_ptr<Stmt> &stmt) {
+  switch (stmt->kind) {
+  case StmtKind::BLOCK: {
+    const std::vector<std::shared_ptr<Stmt>> &statements = std::static_pointer_cast<Block>(stmt)->statements;
+    return std::any_of(statements.begin(), statements.end(),
+                       [](const std::shared_ptr<Stmt> &statement) { return calls(statement); });
+  }
+  case StmtKind::CLASS:
+  case StmtKind::FUNCTION:
+    return false;
+  case StmtKind::EXPRESSION:
+    return calls(std::static_pointer_cast<Expression>(stmt)->expression);
+  case StmtKind::IF: {
+    auto branch = std::static_pointer_cast<If>(stmt);
+    return calls(branch->condition) || calls(branch->then_branch) ||
+           (branch->else_branch != nullptr && calls(branch->else_branch));
+  }
+  case StmtKind::PRINT:
+    return calls(std::static_pointer_cast<Print>(stmt)->expression);
+  case StmtKind::RETURN: {
+    const std::shared_ptr<Expr> &value = std::static_pointer_cast<Return>(stmt)->value;
+    return value != nullptr && calls(value);
+  }
+  case StmtKind::VAR: {
+    const std::shared_ptr<Expr> &initializer = std::static_pointer_cast<Var>(stmt)->initializer;
+    return initializer != nullptr && calls(initializer);
+  }
+  case StmtKind::WHILE: {
+    auto loop = std::static_pointer_cast<While>(stmt);
+    return calls(loop->condition) || calls(loop->body);
+  }
+  default:
+    // an import runs a module.
+    return true;
+  }
+}
+
+[[nodiscard]] bool ScalarReplacer::calls(const std::shared_ptr<Expr> &expr) {
+  switch (expr->kind) {
+  case ExprKind::ASSIGN:
+    return calls(std::static_pointer_cast<Assign>(expr)->value);
+  case ExprKind::BINARY: {
+    auto binary = std::static_pointer_cast<Binary>(expr);
+    return calls(binary->left) || calls(binary->right);
+  }
+  case ExprKind::CALL:
+    return true;
+  case ExprKind::GET:
+    return calls(std::static_pointer_cast<Get>(expr)->object);
+  case ExprKind::GROUPING:
+    return calls(std::static_pointer_cast<Grouping>(expr)->expression);
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    return calls(logical->left) || calls(logical->right);
+  }
+  case ExprKind::SET: {
+    auto set = std::static_pointer_cast<Set>(expr);
+    return calls(set->object) || calls(set->value);
+  }
+  case ExprKind::UNARY:
+    return calls(std::static_pointer_cast<Unary>(expr)->right);
+  default:
+    return false;
+  }
+}
+
+[[nodiscard]] Object ScalarReplacer::visit(std::shared_ptr<Block> stmt) {
+  // nested blocks first, so rewriting this one carries their replacements.
+  for (const std::shared_ptr<Stmt> &statement : stmt->statements)
+    this->scan(statement);
+  stmt->replaced = this->replacement(stmt->statements);
+  return nullptr;
+}
+
+// the statements of a scope with its candidates replaced, or null when none
+// of them is.
+[[nodiscard]] std::shared_ptr<ScalarReplacement> ScalarReplacer::replacement(
+    const std::vector<std::shared_ptr<Stmt>> &scope) {
+  std::vector<std::shared_ptr<Stmt>> statements = scope;
+  std::vector<std::pair<std::shared_ptr<Variable>, std::shared_ptr<Function>>> classes;
+  for (std::size_t i = 0; i < statements.size(); ++i) {
+    const Layout *layout = this->candidate(statements[i]);
+    if (layout != nullptr) {
+      auto var = std::static_pointer_cast<Var>(statements[i]);
+      const Instance instance{var->name.lexeme, *layout, this->lexicon};
+      const bool escaped = std::any_of(statements.begin() + i + 1, statements.end(),
+                                       [&instance](const std::shared_ptr<Stmt> &statement) {
+                                         return escapes(instance, statement, 0);
+                                       });
+      if (!escaped) {
+        std::vector<std::shared_ptr<Stmt>> expanded = expand(*var, *layout);
+        std::vector<std::shared_ptr<Stmt>> tail = rewrite(instance, {statements.begin() + i + 1, statements.end()}, 0);
+        classes.emplace_back(std::static_pointer_cast<Variable>(std::static_pointer_cast<Call>(var->initializer)->callee),
+                             layout->init);
+        statements.erase(statements.begin() + i, statements.end());
+        statements.insert(statements.end(), expanded.begin(), expanded.end());
+        statements.insert(statements.end(), tail.begin(), tail.end());
+        i += expanded.size() - 1;
+        if (std::any_of(expanded.begin(), expanded.end(),
+                        [](const std::shared_ptr<Stmt> &statement) { return calls(statement); }))
+          break;
+        continue;
+      }
+    }
+    // a class checked on entering the scope may be replaced from here on.
+    if (calls(statements[i]))
+      break;
+  }
+  if (classes.empty())
+    return nullptr;
+  return std::make_shared<ScalarReplacement>(ScalarReplacement{std::move(classes), std::move(statements)});
+}
+
+[[nodiscard]] Object ScalarReplacer::visit(std::shared_ptr<Class> stmt) {
+  for (const std::shared_ptr<Function> &method : stmt->methods)
+    this->scan(method);
+  return nullptr;
+}
+
+[[nodiscard]] Object ScalarReplacer::visit(std::shared_ptr<Expression> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object ScalarReplacer::visit(std::shared_ptr<Function> stmt) {
+  // a deferred body is parsed after this pass has run. the body shares the
+  // scope of the parameters, which is a block at depth 0 to the rewrite.
+  if (stmt->deferred())
+    return nullptr;
+  for (const std::shared_ptr<Stmt> &statement : stmt->body())
+    this->scan(statement);
+  stmt->replaced = this->replacement(stmt->body());
+  return nullptr;
+}
+
+[[nodiscard]] Object ScalarReplacer::visit(std::shared_ptr<If> stmt) {
+  this->scan(stmt->then_branch);
+  if (stmt->else_branch != nullptr)
+    this->scan(stmt->else_branch);
+  return nullptr;
+}
+
+[[nodiscard]] Object ScalarReplacer::visit(std::shared_ptr<Import> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object ScalarReplacer::visit(std::shared_ptr<Print> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object ScalarReplacer::visit(std::shared_ptr<Return> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object ScalarReplacer::visit(std::shared_ptr<Var> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object ScalarReplacer::visit(std::shared_ptr<While> stmt) {
+  this->scan(stmt->body);
+  return nullptr;
+}
+
+// `var p = K(args);` with K a global naming a replaceable class.
+[[nodiscard]] const ScalarReplacer::Layout *ScalarReplacer::candidate(const std::shared_ptr<Stmt> &stmt) const {
+  if (stmt->kind != StmtKind::VAR)
+    return nullptr;
+  auto var = std::static_pointer_cast<Var>(stmt);
+  if (var->initializer == nullptr || var->initializer->kind != ExprKind::CALL || var->type != ValueType::ANY)
+    return nullptr;
+  auto call = std::static_pointer_cast<Call>(var->initializer);
+  if (call->callee->kind != ExprKind::VARIABLE || std::static_pointer_cast<Variable>(call->callee)->depth >= 0)
+    return nullptr;
+  const auto layout = this->layouts.find(std::static_pointer_cast<Variable>(call->callee)->name.lexeme);
+  if (layout == this->layouts.end() || layout->second.init->params.size() != call->arguments.size())
+    return nullptr;
+  return &layout->second;
+}
+
+// the declarations replacing `var p = K(args);`: the arguments in locals,
+// then the fields init stores, computed from them. when init stores its
+// parameters as they are, the arguments go to the fields directly.
+[[nodiscard]] std::vector<std::shared_ptr<Stmt>> ScalarReplacer::expand(const Var &var, const Layout &layout) {
+  const std::vector<std::shared_ptr<Expr>> &arguments = std::static_pointer_cast<Call>(var.initializer)->arguments;
+  const std::string prefix = "0" + var.name.lexeme;
+  std::vector<std::shared_ptr<Stmt>> statements;
+  if (layout.forwarding) {
+    for (std::size_t i = 0; i < arguments.size(); ++i)
+      statements.push_back(std::make_shared<Var>(
+        Token(TokenType::IDENTIFIER, prefix + "." + layout.fields[i].first, var.name.line, this->lexicon),
+        arguments[i]));
+    return statements;
+  }
+  const std::vector<Token> &params = layout.init->params;
+  for (std::size_t i = 0; i < arguments.size(); ++i)
+    statements.push_back(std::make_shared<Var>(
+      Token(TokenType::IDENTIFIER, prefix + "(" + params[i].lexeme, var.name.line, this->lexicon), arguments[i]));
+  for (const auto &[field, value] : layout.fields)
+    statements.push_back(
+      std::make_shared<Var>(Token(TokenType::IDENTIFIER, prefix + "." + field, var.name.line, this->lexicon),
+                            substitute(value, prefix, *layout.init)));
+  return statements;
+}
+
+// a storable value of init, reading the locals holding the arguments
+// instead of its parameters.
+[[nodiscard]] std::shared_ptr<Expr> ScalarReplacer::substitute(const std::shared_ptr<Expr> &expr,
+                                                               const std::string &prefix, const Function &init) {
+  switch (expr->kind) {
+  case ExprKind::BINARY: {
+    auto binary = std::static_pointer_cast<Binary>(expr);
+    auto result = std::make_shared<Binary>(substitute(binary->left, prefix, init), binary->op,
+                                           substitute(binary->right, prefix, init));
+    result->numeric = binary->numeric;
+    return result;
+  }
+  case ExprKind::GET: {
+    auto get = std::static_pointer_cast<Get>(expr);
+    return std::make_shared<Get>(substitute(get->object, prefix, init), get->name);
+  }
+  case ExprKind::GROUPING:
+    return std::make_shared<Grouping>(substitute(std::static_pointer_cast<Grouping>(expr)->expression, prefix, init));
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    return std::make_shared<Logical>(substitute(logical->left, prefix, init), logical->op,
+                                     substitute(logical->right, prefix, init));
+  }
+  case ExprKind::UNARY: {
+    auto unary = std::static_pointer_cast<Unary>(expr);
+    auto result = std::make_shared<Unary>(unary->op, substitute(unary->right, prefix, init));
+    result->numeric = unary->numeric;
+    return result;
+  }
+  case ExprKind::VARIABLE: {
+    auto variable = std::static_pointer_cast<Variable>(expr);
+    if (variable->depth < 0)
+      return expr;
+    auto result = std::make_shared<Variable>(
+      Token(TokenType::IDENTIFIER, prefix + "(" + variable->name.lexeme, variable->name.line, this->lexicon));
+    result->depth = 0;
+    return result;
+  }
+  default:
+    return expr;
+  }
+}
+
+[[nodiscard]] bool ScalarReplacer::escapes(const Instance &instance, const std::shared_ptr<Stmt> &stmt, int depth) {
+  switch (stmt->kind) {
+  case StmtKind::BLOCK: {
+    const std::vector<std::shared_ptr<Stmt>> &statements = std::static_pointer_cast<Block>(stmt)->statements;
+    return std::any_of(statements.begin(), statements.end(), [&instance, depth](const std::shared_ptr<Stmt> &statement) {
+      return escapes(instance, statement, depth < 0 ? -1 : depth + 1);
+    });
+  }
+  case StmtKind::CLASS: {
+    auto klass = std::static_pointer_cast<Class>(stmt);
+    if (klass->superclass != nullptr && escapes(instance, klass->superclass, depth))
+      return true;
+    return std::any_of(klass->methods.begin(), klass->methods.end(), [&instance](const std::shared_ptr<Function> &method) {
+      return escapes(instance, method, -1);
+    });
+  }
+  case StmtKind::EXPRESSION:
+    return escapes(instance, std::static_pointer_cast<Expression>(stmt)->expression, depth);
+  case StmtKind::FUNCTION: {
+    // the body of a deferred function is not known yet.
+    auto function = std::static_pointer_cast<Function>(stmt);
+    if (function->deferred())
+      return true;
+    const std::vector<std::shared_ptr<Stmt>> &body = function->body();
+    return std::any_of(body.begin(), body.end(), [&instance](const std::shared_ptr<Stmt> &statement) {
+      return escapes(instance, statement, -1);
+    });
+  }
+  case StmtKind::IF: {
+    auto branch = std::static_pointer_cast<If>(stmt);
+    return escapes(instance, branch->condition, depth) || escapes(instance, branch->then_branch, depth) ||
+           (branch->else_branch != nullptr && escapes(instance, branch->else_branch, depth));
+  }
+  case StmtKind::IMPORT:
+    return false;
+  case StmtKind::PRINT:
+    return escapes(instance, std::static_pointer_cast<Print>(stmt)->expression, depth);
+  case StmtKind::RETURN: {
+    const std::shared_ptr<Expr> &value = std::static_pointer_cast<Return>(stmt)->value;
+    return value != nullptr && escapes(instance, value, depth);
+  }
+  case StmtKind::VAR: {
+    const std::shared_ptr<Expr> &initializer = std::static_pointer_cast<Var>(stmt)->initializer;
+    return initializer != nullptr && escapes(instance, initializer, depth);
+  }
+  case StmtKind::WHILE: {
+    auto loop = std::static_pointer_cast<While>(stmt);
+    return escapes(instance, loop->condition, depth) || escapes(instance, loop->body, depth);
+  }
+  }
+  return true;
+}
+
+// the instance escapes through any use but reading or storing a field init
+// stores.
+[[nodiscard]] bool ScalarReplacer::escapes(const Instance &instance, const std::shared_ptr<Expr> &expr, int depth) {
+  switch (expr->kind) {
+  case ExprKind::ASSIGN: {
+    auto assign = std::static_pointer_cast<Assign>(expr);
+    return refers(instance, assign->name, assign->depth, depth) || escapes(instance, assign->value, depth);
+  }
+  case ExprKind::BINARY: {
+    auto binary = std::static_pointer_cast<Binary>(expr);
+    return escapes(instance, binary->left, depth) || escapes(instance, binary->right, depth);
+  }
+  case ExprKind::CALL: {
+    auto call = std::static_pointer_cast<Call>(expr);
+    return escapes(instance, call->callee, depth) ||
+           std::any_of(call->arguments.begin(), call->arguments.end(),
+                       [&instance, depth](const std::shared_ptr<Expr> &argument) {
+                         return escapes(instance, argument, depth);
+                       });
+  }
+  case ExprKind::GET: {
+    auto get = std::static_pointer_cast<Get>(expr);
+    if (depth >= 0 && get->object->kind == ExprKind::VARIABLE) {
+      auto object = std::static_pointer_cast<Variable>(get->object);
+      if (refers(instance, object->name, object->depth, depth))
+        return !instance.layout.stores(get->name.lexeme);
+    }
+    return escapes(instance, get->object, depth);
+  }
+  case ExprKind::GROUPING:
+    return escapes(instance, std::static_pointer_cast<Grouping>(expr)->expression, depth);
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    return escapes(instance, logical->left, depth) || escapes(instance, logical->right, depth);
+  }
+  case ExprKind::SET: {
+    auto set = std::static_pointer_cast<Set>(expr);
+    if (depth >= 0 && set->object->kind == ExprKind::VARIABLE) {
+      auto object = std::static_pointer_cast<Variable>(set->object);
+      if (refers(instance, object->name, object->depth, depth))
+        return !instance.layout.stores(set->name.lexeme) || escapes(instance, set->value, depth);
+    }
+    return escapes(instance, set->object, depth) || escapes(instance, set->value, depth);
+  }
+  case ExprKind::UNARY:
+    return escapes(instance, std::static_pointer_cast<Unary>(expr)->right, depth);
+  case ExprKind::VARIABLE: {
+    auto variable = std::static_pointer_cast<Variable>(expr);
+    return refers(instance, variable->name, variable->depth, depth);
+  }
+  default:
+    return false;
+  }
+}
+
+// inside a nested function any use of the name counts, as its depths are
+// not followed.
+[[nodiscard]] bool ScalarReplacer::refers(const Instance &instance, const Token &name, int reference, int depth) {
+  return name.lexeme == instance.name && (depth < 0 || reference == depth);
+}
+
+[[nodiscard]] std::vector<std::shared_ptr<Stmt>> ScalarReplacer::rewrite(
+  const Instance &instance, const std::vector<std::shared_ptr<Stmt>> &statements, int depth) {
+  std::vector<std::shared_ptr<Stmt>> result;
+  result.reserve(statements.size());
+  for (const std::shared_ptr<Stmt> &statement : statements)
+    result.push_back(rewrite(instance, statement, depth));
+  return result;
+}
+
+// the statement with the fields of the instance read from and stored into
+// their locals; parts without a use of it are shared with the original.
+[[nodiscard]] std::shared_ptr<Stmt> ScalarReplacer::rewrite(const Instance &instance,
+                                                            const std::shared_ptr<Stmt> &stmt, int depth) {
+  switch (stmt->kind) {
+  case StmtKind::BLOCK: {
+    auto block = std::static_pointer_cast<Block>(stmt);
+    std::vector<std::shared_ptr<Stmt>> statements = rewrite(instance, block->statements, depth + 1);
+    std::shared_ptr<ScalarReplacement> replaced = block->replaced;
+    if (replaced != nullptr)
+      replaced = std::make_shared<ScalarReplacement>(
+        ScalarReplacement{replaced->classes, rewrite(instance, replaced->statements, depth + 1)});
+    if (statements == block->statements && (replaced == nullptr || replaced->statements == block->replaced->statements))
+      return stmt;
+    auto result = std::make_shared<Block>(std::move(statements));
+    result->replaced = std::move(replaced);
+    return result;
+  }
+  case StmtKind::EXPRESSION: {
+    auto expression = std::static_pointer_cast<Expression>(stmt);
+    std::shared_ptr<Expr> value = rewrite(instance, expression->expression, depth);
+    if (value == expression->expression)
+      return stmt;
+    return std::make_shared<Expression>(std::move(value));
+  }
+  case StmtKind::IF: {
+    auto branch = std::static_pointer_cast<If>(stmt);
+    std::shared_ptr<Expr> condition = rewrite(instance, branch->condition, depth);
+    std::shared_ptr<Stmt> then_branch = rewrite(instance, branch->then_branch, depth);
+    std::shared_ptr<Stmt> else_branch =
+      branch->else_branch != nullptr ? rewrite(instance, branch->else_branch, depth) : nullptr;
+    if (condition == branch->condition && then_branch == branch->then_branch && else_branch == branch->else_branch)
+      return stmt;
+    return std::make_shared<If>(std::move(condition), std::move(then_branch), std::move(else_branch));
+  }
+  case StmtKind::PRINT: {
+    auto print = std::static_pointer_cast<Print>(stmt);
+    std::shared_ptr<Expr> value = rewrite(instance, print->expression, depth);
+    if (value == print->expression)
+      return stmt;
+    return std::make_shared<Print>(std::move(value));
+  }
+  case StmtKind::RETURN: {
+    auto ret = std::static_pointer_cast<Return>(stmt);
+    if (ret->value == nullptr)
+      return stmt;
+    std::shared_ptr<Expr> value = rewrite(instance, ret->value, depth);
+    if (value == ret->value)
+      return stmt;
+    auto result = std::make_shared<Return>(ret->keyword, std::move(value));
+    result->check = ret->check;
+    return result;
+  }
+  case StmtKind::VAR: {
+    auto var = std::static_pointer_cast<Var>(stmt);
+    if (var->initializer == nullptr)
+      return stmt;
+    std::shared_ptr<Expr> initializer = rewrite(instance, var->initializer, depth);
+    if (initializer == var->initializer)
+      return stmt;
+    auto result = std::make_shared<Var>(var->name, std::move(initializer));
+    result->slot = var->slot;
+    result->type = var->type;
+    result->check = var->check;
+    return result;
+  }
+  case StmtKind::WHILE: {
+    auto loop = std::static_pointer_cast<While>(stmt);
+    std::shared_ptr<Expr> condition = rewrite(instance, loop->condition, depth);
+    std::shared_ptr<Stmt> body = rewrite(instance, loop->body, depth);
+    if (condition == loop->condition && body == loop->body)
+      return stmt;
+    auto result = std::make_shared<While>(std::move(condition), std::move(body));
+    result->counted = loop->counted;
+    return result;
+  }
+  default:
+    // nested functions and classes do not use the instance.
+    return stmt;
+  }
+}
+
+[[nodiscard]] std::shared_ptr<Expr> ScalarReplacer::rewrite(const Instance &instance,
+                                                            const std::shared_ptr<Expr> &expr, int depth) {
+  switch (expr->kind) {
+  case ExprKind::ASSIGN: {
+    auto assign = std::static_pointer_cast<Assign>(expr);
+    std::shared_ptr<Expr> value = rewrite(instance, assign->value, depth);
+    if (value == assign->value)
+      return expr;
+    auto result = std::make_shared<Assign>(assign->name, std::move(value));
+    result->depth = assign->depth;
+    result->slot = assign->slot;
+    result->check = assign->check;
+    return result;
+  }
+  case ExprKind::BINARY: {
+    auto binary = std::static_pointer_cast<Binary>(expr);
+    std::shared_ptr<Expr> left = rewrite(instance, binary->left, depth);
+    std::shared_ptr<Expr> right = rewrite(instance, binary->right, depth);
+    if (left == binary->left && right == binary->right)
+      return expr;
+    auto result = std::make_shared<Binary>(std::move(left), binary->op, std::move(right));
+    result->numeric = binary->numeric;
+    return result;
+  }
+  case ExprKind::CALL: {
+    auto call = std::static_pointer_cast<Call>(expr);
+    std::shared_ptr<Expr> callee = rewrite(instance, call->callee, depth);
+    std::vector<std::shared_ptr<Expr>> arguments;
+    arguments.reserve(call->arguments.size());
+    for (const std::shared_ptr<Expr> &argument : call->arguments)
+      arguments.push_back(rewrite(instance, argument, depth));
+    if (callee == call->callee && arguments == call->arguments)
+      return expr;
+    auto result = std::make_shared<Call>(std::move(callee), call->paren, std::move(arguments));
+    result->inlined = call->inlined;
+    return result;
+  }
+  case ExprKind::GET: {
+    auto get = std::static_pointer_cast<Get>(expr);
+    if (get->object->kind == ExprKind::VARIABLE) {
+      auto object = std::static_pointer_cast<Variable>(get->object);
+      if (refers(instance, object->name, object->depth, depth)) {
+        auto result = std::make_shared<Variable>(
+          Token(TokenType::IDENTIFIER, "0" + instance.name + "." + get->name.lexeme, get->name.line, instance.lexicon));
+        result->depth = depth;
+        return result;
+      }
+    }
+    std::shared_ptr<Expr> object = rewrite(instance, get->object, depth);
+    if (object == get->object)
+      return expr;
+    return std::make_shared<Get>(std::move(object), get->name);
+  }
+  case ExprKind::GROUPING: {
+    auto grouping = std::static_pointer_cast<Grouping>(expr);
+    std::shared_ptr<Expr> expression = rewrite(instance, grouping->expression, depth);
+    if (expression == grouping->expression)
+      return expr;
+    return std::make_shared<Grouping>(std::move(expression));
+  }
+  case ExprKind::LOGICAL: {
+    auto logical = std::static_pointer_cast<Logical>(expr);
+    std::shared_ptr<Expr> left = rewrite(instance, logical->left, depth);
+    std::shared_ptr<Expr> right = rewrite(instance, logical->right, depth);
+    if (left == logical->left && right == logical->right)
+      return expr;
+    return std::make_shared<Logical>(std::move(left), logical->op, std::move(right));
+  }
+  case ExprKind::SET: {
+    auto set = std::static_pointer_cast<Set>(expr);
+    std::shared_ptr<Expr> value = rewrite(instance, set->value, depth);
+    if (set->object->kind == ExprKind::VARIABLE) {
+      auto object = std::static_pointer_cast<Variable>(set->object);
+      if (refers(instance, object->name, object->depth, depth)) {
+        auto result = std::make_shared<Assign>(
+          Token(TokenType::IDENTIFIER, "0" + instance.name + "." + set->name.lexeme, set->name.line, instance.lexicon),
+          std::move(value));
+        result->depth = depth;
+        return result;
+      }
+    }
+    std::shared_ptr<Expr> object = rewrite(instance, set->object, depth);
+    if (object == set->object && value == set->value)
+      return expr;
+    return std::make_shared<Set>(std::move(object), set->name, std::move(value));
+  }
+  case ExprKind::UNARY: {
+    auto unary = std::static_pointer_cast<Unary>(expr);
+    std::shared_ptr<Expr> right = rewrite(instance, unary->right, depth);
+    if (right == unary->right)
+      return expr;
+    auto result = std::make_shared<Unary>(unary->op, std::move(right));
+    result->numeric = unary->numeric;
+    return result;
+  }
+  default:
+    return expr;
+  }
+}
+}// namespace loxplusplus
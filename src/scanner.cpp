@@ -4,18 +4,131 @@
 // Distributed under the terms of the MIT License.
 //
 
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+
 #include "../include/scanner.hpp"
+#include "../include/thread_pool.hpp"
 
 namespace loxplusplus {
-Scanner::Scanner(std::string_view source) : source{source} {}
+Scanner::Scanner(std::string_view source, Diagnostics &diagnostics)
+    : source{source}, diagnostics{diagnostics} {}
+
+[[nodiscard]] std::vector<SourceToken> Scanner::scan_tokens() {
+  if (this->source.size() >= parallel_threshold && ThreadPool::default_threads() > 1)
+    this->scan_chunks(ThreadPool::default_threads() * 4);
+  else
+    this->scan();
+  this->tokens.emplace_back(TokenType::EOF_, "", this->line);
+  return this->tokens;
+}
 
-[[nodiscard]] std::vector<Token> Scanner::scan_tokens() {
+[[nodiscard]] std::vector<SourceToken> Scanner::scan_tokens(std::size_t chunks) {
+  this->scan_chunks(chunks);
+  this->tokens.emplace_back(TokenType::EOF_, "", this->line);
+  return this->tokens;
+}
+
+[[nodiscard]] bool Scanner::check_chunks(std::string_view source, std::size_t chunks, std::ostream &report) {
+  std::ostringstream sequential_errors, chunked_errors;
+  Diagnostics sequential_diagnostics(sequential_errors), chunked_diagnostics(chunked_errors);
+  const std::vector<SourceToken> expected = Scanner(source, sequential_diagnostics).scan_tokens();
+  const std::vector<SourceToken> actual = Scanner(source, chunked_diagnostics).scan_tokens(chunks);
+  for (std::size_t i = 0; i < expected.size() && i < actual.size(); ++i) {
+    const SourceToken &a = expected[i], &b = actual[i];
+    if (a.type != b.type || a.line != b.line || a.lexeme.data() != b.lexeme.data() || a.lexeme.size() != b.lexeme.size()) {
+      report << "token " << i << ": expected '" << a.lexeme << "' on line " << a.line << ", got '" << b.lexeme
+             << "' on line " << b.line << ".\n";
+      return false;
+    }
+  }
+  if (expected.size() != actual.size()) {
+    report << "expected " << expected.size() << " tokens, got " << actual.size() << ".\n";
+    return false;
+  }
+  if (sequential_errors.str() != chunked_errors.str() ||
+      sequential_diagnostics.had_error != chunked_diagnostics.had_error) {
+    report << "expected errors:\n"
+           << sequential_errors.str() << "got:\n"
+           << chunked_errors.str();
+    return false;
+  }
+  return true;
+}
+
+// tracks just enough of the lexical state to tell whether a newline ends a
+// line inside a string literal. a comment always ends at its newline, so the
+// next line start is safe once it is past the target size of the chunk.
+[[nodiscard]] std::vector<Scanner::Chunk> Scanner::split(std::string_view source, std::size_t count) {
+  std::vector<Chunk> chunks{{0, 1}};
+  const std::size_t target = source.size() / count;
+  bool in_string = false, in_comment = false;
+  int line = 1;
+  for (std::size_t i = 0; i < source.size(); ++i) {
+    switch (source[i]) {
+    case '\n': {
+      ++line;
+      in_comment = false;
+      if (!in_string && i + 1 < source.size() && i + 1 - chunks.back().begin >= target)
+        chunks.push_back({i + 1, line});
+      break;
+    }
+    case '"': {
+      if (!in_comment)
+        in_string = !in_string;
+      break;
+    }
+    case '/': {
+      if (!in_string && !in_comment && i + 1 < source.size() && source[i + 1] == '/') {
+        in_comment = true;
+        ++i;
+      }
+      break;
+    }
+    }
+  }
+  return chunks;
+}
+
+// scans the chunks on a pool and appends their tokens in source order. each
+// chunk reports into its own buffer, so errors come out in the same order
+// as from a sequential scan.
+void Scanner::scan_chunks(std::size_t count) {
+  ThreadPool pool;
+  const std::vector<Chunk> chunks = split(this->source, std::max<std::size_t>(count, 1));
+  std::vector<std::vector<SourceToken>> tokens(chunks.size());
+  std::vector<std::ostringstream> errors(chunks.size());
+  std::vector<char> failed(chunks.size(), false);
+  std::vector<int> lines(chunks.size());
+  pool.run(chunks.size(), [&](std::size_t i) {
+    const std::size_t end = i + 1 < chunks.size() ? chunks[i + 1].begin : this->source.size();
+    Diagnostics diagnostics(errors[i]);
+    Scanner scanner(this->source.substr(chunks[i].begin, end - chunks[i].begin), diagnostics);
+    scanner.line = chunks[i].line;
+    scanner.scan();
+    tokens[i] = std::move(scanner.tokens);
+    failed[i] = diagnostics.had_error;
+    lines[i] = scanner.line;
+  });
+  std::size_t total = 1;
+  for (const std::vector<SourceToken> &part : tokens)
+    total += part.size();
+  this->tokens.reserve(total);
+  for (std::size_t i = 0; i < chunks.size(); ++i) {
+    std::move(tokens[i].begin(), tokens[i].end(), std::back_inserter(this->tokens));
+    if (failed[i])
+      this->diagnostics.forward(errors[i].str());
+  }
+  this->line = lines.back();
+  this->current = this->source.size();
+}
+
+void Scanner::scan() {
   while (!this->is_at_end()) {
     this->start = this->current;
     this->scan_token();
   }
-  this->tokens.emplace_back(TokenType::EOF_, "", nullptr, this->line);
-  return this->tokens;
 }
 
 void Scanner::scan_token() {
@@ -26,6 +139,7 @@ void Scanner::scan_token() {
   case '{':
   case '}':
   case ',':
+  case ':':
   case '.':
   case '-':
   case '+':
@@ -77,7 +191,7 @@ void Scanner::scan_token() {
     } else if (this->is_alpha(c)) {
       this->identifier();
     } else {
-      error(line, "unexpected character.");
+      this->diagnostics.error(line, "unexpected character.");
     }
     break;
   }
@@ -87,7 +201,7 @@ void Scanner::scan_token() {
 void Scanner::identifier() {
   while (this->is_alpha_numeric(this->peek()))
     this->advance();
-  std::string text = std::string(source.substr(start, current - start));
+  const std::string_view text = this->source.substr(this->start, this->current - this->start);
   TokenType type;
   if (auto match = this->keywords.find(text); match == this->keywords.end()) {
     type = TokenType::IDENTIFIER;
@@ -105,8 +219,7 @@ void Scanner::number() {
     while (this->is_digit(this->peek()))
       this->advance();
   }
-  this->add_token(TokenType::NUMBER,
-                  std::stold(std::string(source.substr(start, current - start))));
+  this->add_token(TokenType::NUMBER);
 }
 
 void Scanner::string() {
@@ -116,11 +229,11 @@ void Scanner::string() {
     this->advance();
   }
   if (this->is_at_end()) {
-    error(line, "unterminated string.");
+    this->diagnostics.error(line, "unterminated string.");
     return;
   }
   this->advance();
-  this->add_token(TokenType::STRING, std::string(this->source.substr(this->start + 1, this->current - 2 - this->start)));
+  this->add_token(TokenType::STRING);
 }
 
 [[nodiscard]] bool Scanner::match(const char &expected) {
@@ -165,13 +278,6 @@ const char &Scanner::advance() {
 }
 
 void Scanner::add_token(TokenType type) {
-  this->add_token(type, nullptr);
-}
-
-void Scanner::add_token(TokenType type, Object literal) {
-  this->tokens.emplace_back(type,
-                            std::string(this->source.substr(this->start, this->current - this->start)),
-                            literal,
-                            this->line);
+  this->tokens.emplace_back(type, this->source.substr(this->start, this->current - this->start), this->line);
 }
 }// namespace loxplusplus
\ No newline at end of file
@@ -0,0 +1,290 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <streambuf>
+#include <thread>
+
+#include "../include/server.hpp"
+
+#ifdef LOX_SERVER_SUPPORTED
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace loxplusplus {
+#ifdef LOX_SERVER_SUPPORTED
+// exit statuses of sysexits.h, as used by the reference lox implementations.
+static constexpr int status_usage = 64;
+static constexpr int status_compile_error = 65;
+static constexpr int status_no_input = 66;
+static constexpr int status_runtime_error = 70;
+
+static bool send_all(int descriptor, const char *data, std::size_t size) {
+  while (size > 0) {
+    ssize_t written = ::write(descriptor, data, size);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return false;
+    data += written;
+    size -= static_cast<std::size_t>(written);
+  }
+  return true;
+}
+
+static bool receive_all(int descriptor, char *data, std::size_t size) {
+  while (size > 0) {
+    ssize_t received = ::read(descriptor, data, size);
+    if (received < 0 && errno == EINTR)
+      continue;
+    if (received <= 0)
+      return false;
+    data += received;
+    size -= static_cast<std::size_t>(received);
+  }
+  return true;
+}
+
+static bool send_frame(int descriptor, char kind, std::string_view payload) {
+  const auto length = static_cast<std::uint32_t>(payload.size());
+  const char header[5] = {kind,
+                          static_cast<char>(length & 0xff),
+                          static_cast<char>(length >> 8 & 0xff),
+                          static_cast<char>(length >> 16 & 0xff),
+                          static_cast<char>(length >> 24 & 0xff)};
+  return send_all(descriptor, header, sizeof header) && send_all(descriptor, payload.data(), payload.size());
+}
+
+static bool receive_frame(int descriptor, char &kind, std::string &payload) {
+  unsigned char header[5];
+  if (!receive_all(descriptor, reinterpret_cast<char *>(header), sizeof header))
+    return false;
+  kind = static_cast<char>(header[0]);
+  const std::uint32_t length = header[1] | header[2] << 8 | header[3] << 16 | static_cast<std::uint32_t>(header[4]) << 24;
+  payload.resize(length);
+  return receive_all(descriptor, payload.data(), length);
+}
+
+// unbuffered stream that sends everything written to it as frames of kind.
+// Diagnostics writes each message at once, so a message is one frame.
+class FrameBuffer : public std::streambuf {
+public:
+  FrameBuffer(int descriptor, char kind)
+      : descriptor{descriptor}, kind{kind} {}
+
+protected:
+  std::streamsize xsputn(const char *data, std::streamsize count) override {
+    (void)send_frame(this->descriptor, this->kind, std::string_view(data, count));
+    return count;
+  }
+
+  int_type overflow(int_type character) override {
+    if (!traits_type::eq_int_type(character, traits_type::eof())) {
+      const char value = traits_type::to_char_type(character);
+      (void)send_frame(this->descriptor, this->kind, std::string_view(&value, 1));
+    }
+    return traits_type::not_eof(character);
+  }
+
+private:
+  int descriptor;
+  char kind;
+};
+
+Server::Server(std::string socket_path, EngineOptions options)
+    : socket_path{std::move(socket_path)}, options{std::move(options)} {}
+
+[[nodiscard]] bool Server::serve() {
+  std::signal(SIGPIPE, SIG_IGN);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (this->socket_path.size() >= sizeof address.sun_path)
+    return false;
+  std::memcpy(address.sun_path, this->socket_path.c_str(), this->socket_path.size() + 1);
+  int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0)
+    return false;
+  // a socket file left behind by an earlier server would make bind fail.
+  ::unlink(this->socket_path.c_str());
+  if (::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof address) < 0 || ::listen(listener, SOMAXCONN) < 0) {
+    ::close(listener);
+    return false;
+  }
+  while (true) {
+    int connection = ::accept(listener, nullptr, nullptr);
+    if (connection < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      ::close(listener);
+      return false;
+    }
+    std::thread([this, connection] {
+      this->handle(connection);
+      ::close(connection);
+    }).detach();
+  }
+}
+
+void Server::handle(int connection) const {
+  std::vector<std::string> arguments;
+  std::string directory, input, payload;
+  for (char kind; receive_frame(connection, kind, payload);) {
+    if (kind == 'a')
+      arguments.push_back(std::move(payload));
+    else if (kind == 'd')
+      directory = std::move(payload);
+    else if (kind == 'i')
+      input.append(payload);
+    else if (kind == 'r')
+      break;
+    else
+      return;
+    payload.clear();
+  }
+
+  FrameBuffer error_buffer(connection, 'e');
+  std::ostream errors(&error_buffer);
+  EngineOptions options = this->options;
+  std::filesystem::path script;
+  bool line_buffered{false};
+  int status{0};
+  for (std::size_t i = 0; i < arguments.size() && status == 0; ++i) {
+    const std::string &arg = arguments[i];
+    if (arg == "--line-buffered") {
+      line_buffered = true;
+    } else if (arg == "--jit") {
+      options.jit_threshold = Jit::default_threshold;
+    } else if (arg == "--jit-threshold" && i + 1 < arguments.size()) {
+      options.jit_threshold = std::strtoull(arguments[++i].c_str(), nullptr, 10);
+    } else if (arg == "--cache" && i + 1 < arguments.size()) {
+      options.cache_directory = (std::filesystem::path(directory) / arguments[++i]).string();
+    } else if (arg == "--compile-closures") {
+      options.compile_closures = true;
+    } else if (arg == "--lazy-parse") {
+      options.lazy_parsing = true;
+    } else if (arg == "--dump-ir") {
+      options.dump_ir = true;
+    } else if (arg == "--stats") {
+      options.stats = true;
+    } else if (arg == "--memoize") {
+      options.memoize = true;
+    } else if (script.empty() && !arg.starts_with("--")) {
+      script = std::filesystem::path(directory) / arg;
+    } else {
+      errors << "unsupported argument '" << arg << "'.\n";
+      status = status_usage;
+    }
+  }
+
+  // a source read from standard input imports relative to the client's
+  // working directory.
+  std::string source = std::move(input), origin = (std::filesystem::path(directory) / "-").string();
+  if (status == 0 && !script.empty()) {
+    std::ifstream file(script, std::ios::binary);
+    std::ostringstream contents;
+    if (file && contents << file.rdbuf()) {
+      source = std::move(contents).str();
+      origin = script.string();
+    } else {
+      errors << "failed to open file '" << script.string() << "'.\n";
+      status = status_no_input;
+    }
+  }
+
+  if (status == 0) {
+    // the engine runs this one program.
+    options.whole_program = true;
+    Engine engine([connection](std::string_view text) { (void)send_frame(connection, 'o', text); }, errors);
+    engine.set_line_buffered(line_buffered);
+    engine.configure(options);
+    switch (engine.run(source, origin)) {
+    case Engine::Result::OK: break;
+    case Engine::Result::COMPILE_ERROR: status = status_compile_error; break;
+    case Engine::Result::RUNTIME_ERROR: status = status_runtime_error; break;
+    }
+  }
+  const char exit_status[4] = {static_cast<char>(status), 0, 0, 0};
+  (void)send_frame(connection, 'x', std::string_view(exit_status, sizeof exit_status));
+}
+
+[[nodiscard]] int Client::run(const std::string &socket_path, const std::vector<std::string> &arguments) {
+  std::signal(SIGPIPE, SIG_IGN);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  int connection = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (connection < 0 || socket_path.size() >= sizeof address.sun_path) {
+    std::cerr << "failed to connect to '" << socket_path << "'.\n";
+    return 1;
+  }
+  std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+  if (::connect(connection, reinterpret_cast<sockaddr *>(&address), sizeof address) < 0) {
+    std::cerr << "failed to connect to '" << socket_path << "'.\n";
+    ::close(connection);
+    return 1;
+  }
+
+  bool has_script{false};
+  for (std::size_t i = 0; i < arguments.size(); ++i) {
+    if (arguments[i] == "--jit-threshold" || arguments[i] == "--cache")
+      ++i;
+    else if (!arguments[i].starts_with("--"))
+      has_script = true;
+  }
+  bool sent = true;
+  for (const std::string &arg : arguments)
+    sent = sent && send_frame(connection, 'a', arg);
+  std::error_code error;
+  sent = sent && send_frame(connection, 'd', std::filesystem::current_path(error).string());
+  if (!has_script) {
+    std::ostringstream input;
+    input << std::cin.rdbuf();
+    sent = sent && send_frame(connection, 'i', input.view());
+  }
+  sent = sent && send_frame(connection, 'r', {});
+
+  std::string payload;
+  for (char kind; sent && receive_frame(connection, kind, payload);) {
+    if (kind == 'o') {
+      std::fwrite(payload.data(), 1, payload.size(), stdout);
+    } else if (kind == 'e') {
+      std::fflush(stdout);
+      std::fwrite(payload.data(), 1, payload.size(), stderr);
+    } else if (kind == 'x' && payload.size() == 4) {
+      ::close(connection);
+      std::fflush(stdout);
+      return static_cast<unsigned char>(payload[0]);
+    }
+  }
+  ::close(connection);
+  std::fflush(stdout);
+  std::cerr << "connection to '" << socket_path << "' closed before the script finished.\n";
+  return 1;
+}
+#else
+Server::Server(std::string socket_path, EngineOptions options)
+    : socket_path{std::move(socket_path)}, options{std::move(options)} {}
+
+[[nodiscard]] bool Server::serve() {
+  return false;
+}
+
+void Server::handle(int connection) const {
+}
+
+[[nodiscard]] int Client::run(const std::string &socket_path, const std::vector<std::string> &arguments) {
+  std::cerr << "--client needs unix sockets, which this platform does not provide.\n";
+  return 1;
+}
+#endif
+}// namespace loxplusplus
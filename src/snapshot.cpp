@@ -0,0 +1,480 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <typeinfo>
+
+#include "../include/interpreter.hpp"
+#include "../include/mapped_file.hpp"
+#include "../include/optimizer.hpp"
+#include "../include/program_cache.hpp"
+#include "../include/snapshot.hpp"
+
+namespace loxplusplus {
+static constexpr char magic[4] = {'L', 'O', 'X', 'S'};
+static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+[[nodiscard]] bool Snapshot::save(const std::string &path, const Interpreter &interpreter) {
+  std::string bytes;
+  try {
+    SnapshotWriter writer;
+    bytes = writer.write(interpreter);
+  } catch (const SnapshotWriter::Unsupported &) {
+    return false;
+  } catch (const RuntimeError &) {
+    // a deferred function body failed to parse.
+    return false;
+  }
+  // written aside and renamed, so a reader never maps a partial snapshot.
+  const std::string temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file || !file.write(bytes.data(), bytes.size()))
+      return false;
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  if (error)
+    std::filesystem::remove(temporary, error);
+  return !error;
+}
+
+[[nodiscard]] bool Snapshot::restore(const std::string &path, Interpreter &interpreter, Lexicon &lexicon) {
+  MappedFile file(path);
+  if (file.data == nullptr)
+    return false;
+  try {
+    SnapshotReader reader(file.data, file.size, lexicon);
+    reader.read(interpreter);
+  } catch (const SnapshotReader::Corrupt &) {
+    return false;
+  }
+  return true;
+}
+
+[[nodiscard]] std::string SnapshotWriter::write(const Interpreter &interpreter) {
+  // every root gets its id first; the records then reach the rest of the
+  // heap breadth first and are written in id order.
+  (void)this->reference(interpreter.globals);
+  std::vector<std::pair<std::string, const Object *>> globals;
+  std::vector<ValueType> types;
+  for (std::size_t symbol = 0; symbol < interpreter.global_slots.slots.size(); ++symbol) {
+    const std::optional<Object> &value = interpreter.global_slots.slots[symbol];
+    if (!value.has_value())
+      continue;
+    globals.emplace_back(interpreter.symbols.name(static_cast<int>(symbol)), &*value);
+    types.push_back(interpreter.global_slots.types[symbol]);
+    if (value->index() == LoxFunctionIndex)
+      (void)this->reference(std::get<LoxFunctionIndex>(*value));
+    else if (value->index() == LoxClassIndex)
+      (void)this->reference(std::get<LoxClassIndex>(*value));
+    else if (value->index() == LoxInstanceIndex)
+      (void)this->reference(std::get<LoxInstanceIndex>(*value));
+  }
+  for (std::size_t id = 0; id < this->objects.size(); ++id)
+    this->write_record(HeapObject(this->objects[id]));
+  const std::uint32_t count = static_cast<std::uint32_t>(this->objects.size());
+
+  this->write_raw(static_cast<std::uint32_t>(globals.size()));
+  for (const auto &[name, value] : globals) {
+    this->write_string(name);
+    this->write_value(*value);
+  }
+  for (ValueType type : types)
+    this->write_raw(static_cast<std::uint8_t>(type));
+  this->write_raw(static_cast<std::uint32_t>(interpreter.imported.size()));
+  for (const std::string &module : interpreter.imported)
+    this->write_string(module);
+
+  ProgramWriter program;
+  const std::string image = program.write(0, this->declarations);
+  auto append = [](std::string &bytes, const auto &value) {
+    bytes.append(reinterpret_cast<const char *>(&value), sizeof value);
+  };
+  std::string payload;
+  append(payload, static_cast<std::uint64_t>(image.size()));
+  payload.append(image);
+  append(payload, count);
+  payload.append(this->heap);
+  std::string bytes(magic, sizeof magic);
+  append(bytes, Snapshot::format_version);
+  append(bytes, ProgramCache::hash(payload));
+  return bytes + payload;
+}
+
+void SnapshotWriter::write_record(const HeapObject &object) {
+  this->write_raw(static_cast<std::uint8_t>(object.index()));
+  switch (static_cast<HeapKind>(object.index())) {
+  case HeapKind::ENVIRONMENT: {
+    const auto &environment = std::get<std::shared_ptr<Environment>>(object);
+    this->write_raw(environment->enclosing == nullptr ? none : this->reference(environment->enclosing));
+    this->write_entries(environment->values);
+    break;
+  }
+  case HeapKind::FUNCTION: {
+    const auto &function = std::get<std::shared_ptr<LoxFunction>>(object);
+    this->write_raw(this->declaration(function->declaration));
+    this->write_raw(this->reference(function->closure));
+    this->write_raw(static_cast<std::uint8_t>(function->is_initializer));
+    break;
+  }
+  case HeapKind::CLASS: {
+    const auto &klass = std::get<std::shared_ptr<LoxClass>>(object);
+    this->write_string(klass->name);
+    this->write_raw(klass->superclass == nullptr ? none : this->reference(klass->superclass));
+    std::map<std::string, Object> methods(klass->methods.begin(), klass->methods.end());
+    this->write_entries(methods);
+    break;
+  }
+  case HeapKind::INSTANCE: {
+    const auto &instance = std::get<std::shared_ptr<LoxInstance>>(object);
+    this->write_raw(this->reference(instance->klass));
+    this->write_entries(instance->fields);
+    break;
+  }
+  }
+}
+
+void SnapshotWriter::write_value(const Object &value) {
+  this->write_raw(static_cast<std::uint8_t>(value.index()));
+  switch (value.index()) {
+  case StringIndex: this->write_string(std::get<StringIndex>(value)); break;
+  case DoubleIndex: this->write_raw(std::get<DoubleIndex>(value)); break;
+  case BoolIndex: this->write_raw(static_cast<std::uint8_t>(std::get<BoolIndex>(value))); break;
+  case NullptrIndex: break;
+  case LoxFunctionIndex: this->write_raw(this->reference(std::get<LoxFunctionIndex>(value))); break;
+  case LoxClassIndex: this->write_raw(this->reference(std::get<LoxClassIndex>(value))); break;
+  case LoxInstanceIndex: this->write_raw(this->reference(std::get<LoxInstanceIndex>(value))); break;
+  case IntegerIndex: this->write_raw(std::get<IntegerIndex>(value)); break;
+  }
+}
+
+void SnapshotWriter::write_entries(const std::map<std::string, Object> &entries) {
+  this->write_raw(static_cast<std::uint32_t>(entries.size()));
+  for (const auto &[name, value] : entries) {
+    this->write_string(name);
+    this->write_value(value);
+  }
+}
+
+void SnapshotWriter::write_string(std::string_view value) {
+  this->write_raw(static_cast<std::uint32_t>(value.size()));
+  this->heap.append(value);
+}
+
+[[nodiscard]] std::uint32_t SnapshotWriter::reference(const HeapObject &object) {
+  const void *address = std::visit([](const auto &pointer) -> const void * { return pointer.get(); }, object);
+  if (auto it = this->ids.find(address); it != this->ids.end())
+    return it->second;
+  // subclasses such as ClosureFunction carry compiled code instead of an
+  // environment and cannot be written.
+  if (object.index() == static_cast<std::size_t>(HeapKind::FUNCTION) &&
+      typeid(*std::get<std::shared_ptr<LoxFunction>>(object)) != typeid(LoxFunction))
+    throw Unsupported{};
+  const auto id = static_cast<std::uint32_t>(this->objects.size());
+  this->ids.emplace(address, id);
+  this->objects.push_back(object);
+  return id;
+}
+
+[[nodiscard]] std::uint32_t SnapshotWriter::declaration(const std::shared_ptr<Function> &function) {
+  auto [it, inserted] = this->declaration_ids.try_emplace(function.get(), static_cast<std::uint32_t>(this->declarations.size()));
+  if (inserted)
+    this->declarations.push_back(function);
+  return it->second;
+}
+
+template <typename T>
+void SnapshotWriter::write_raw(T value) {
+  this->heap.append(reinterpret_cast<const char *>(&value), sizeof value);
+}
+
+SnapshotReader::SnapshotReader(const char *data, std::size_t size, Lexicon &lexicon)
+    : cursor{data}, end{data + size}, lexicon{lexicon} {}
+
+void SnapshotReader::read(Interpreter &interpreter) {
+  if (this->end - this->cursor < static_cast<std::ptrdiff_t>(sizeof magic) ||
+      std::memcmp(this->cursor, magic, sizeof magic) != 0)
+    throw Corrupt{};
+  this->cursor += sizeof magic;
+  if (this->read_raw<std::uint32_t>() != Snapshot::format_version)
+    throw Corrupt{};
+  const auto checksum = this->read_raw<std::uint64_t>();
+  if (ProgramCache::hash(std::string_view(this->cursor, this->end - this->cursor)) != checksum)
+    throw Corrupt{};
+  const auto image_size = this->read_raw<std::uint64_t>();
+  if (static_cast<std::uint64_t>(this->end - this->cursor) < image_size)
+    throw Corrupt{};
+  std::vector<std::vector<ProgramReader::Capture>> captures;
+  try {
+    ProgramReader program(this->cursor, image_size, this->lexicon, interpreter.symbols);
+    this->declarations = program.read_functions(0, captures);
+  } catch (const ProgramReader::Corrupt &) {
+    throw Corrupt{};
+  }
+  this->cursor += image_size;
+
+  const auto count = this->read_count();
+  for (std::uint32_t id = 0; id < count; ++id)
+    this->records.push_back(this->read_record());
+  std::vector<std::pair<std::string, Value>> globals = this->read_entries();
+  std::vector<ValueType> types(globals.size());
+  for (ValueType &type : types) {
+    const auto value = this->read_raw<std::uint8_t>();
+    if (value > static_cast<std::uint8_t>(ValueType::BOOL))
+      throw Corrupt{};
+    type = static_cast<ValueType>(value);
+  }
+  std::vector<std::string> imported(this->read_count());
+  for (std::string &module : imported)
+    module = this->read_string();
+  if (this->cursor != this->end)
+    throw Corrupt{};
+
+  // everything is validated before the interpreter is touched.
+  if (this->records.empty() || this->records[0].kind != HeapKind::ENVIRONMENT || this->records[0].link != none)
+    throw Corrupt{};
+  for (const Record &record : this->records) {
+    switch (record.kind) {
+    case HeapKind::ENVIRONMENT:
+    case HeapKind::CLASS:
+      if (record.link != none)
+        this->check(record.link, record.kind);
+      break;
+    case HeapKind::FUNCTION:
+      if (record.declaration >= this->declarations.size())
+        throw Corrupt{};
+      this->check(record.link, HeapKind::ENVIRONMENT);
+      break;
+    case HeapKind::INSTANCE:
+      this->check(record.link, HeapKind::CLASS);
+      break;
+    }
+    for (const auto &[name, value] : record.entries) {
+      this->check(value);
+      if (record.kind == HeapKind::CLASS && (!value.id.has_value() || this->records[*value.id].kind != HeapKind::FUNCTION))
+        throw Corrupt{};
+    }
+  }
+  for (const auto &[name, value] : globals)
+    this->check(value);
+  // functions held by classes only run bound to an instance; any other
+  // reference may call them with their closure as is.
+  std::vector<bool> plain(count, false), bound(count, false);
+  for (const Record &record : this->records)
+    for (const auto &[name, value] : record.entries)
+      if (value.id.has_value())
+        (record.kind == HeapKind::CLASS ? bound : plain)[*value.id] = true;
+  for (const auto &[name, value] : globals)
+    if (value.id.has_value())
+      plain[*value.id] = true;
+  for (std::uint32_t id = 0; id < count; ++id) {
+    const Record &record = this->records[id];
+    if (record.kind != HeapKind::FUNCTION)
+      continue;
+    if (plain[id])
+      this->check(record, captures[record.declaration], false);
+    if (bound[id])
+      this->check(record, captures[record.declaration], true);
+  }
+
+  // allocation: environments, then functions closing over them, classes
+  // after their superclasses and methods, instances after their classes.
+  this->objects.resize(count);
+  for (std::uint32_t id = 0; id < count; ++id)
+    if (this->records[id].kind == HeapKind::ENVIRONMENT)
+      this->objects[id] = id == 0 ? interpreter.globals : std::make_shared<Environment>();
+  for (std::uint32_t id = 0; id < count; ++id) {
+    const Record &record = this->records[id];
+    if (record.kind == HeapKind::ENVIRONMENT && record.link != none)
+      std::get<std::shared_ptr<Environment>>(this->objects[id])->enclosing = std::get<std::shared_ptr<Environment>>(this->objects[record.link]);
+    else if (record.kind == HeapKind::FUNCTION)
+      this->objects[id] = std::make_shared<LoxFunction>(this->declarations[record.declaration],
+                                                        std::get<std::shared_ptr<Environment>>(this->objects[record.link]),
+                                                        record.is_initializer);
+  }
+  std::vector<bool> building(count, false);
+  for (std::uint32_t id = 0; id < count; ++id)
+    if (this->records[id].kind == HeapKind::CLASS)
+      (void)this->build_class(id, building);
+  for (std::uint32_t id = 0; id < count; ++id)
+    if (this->records[id].kind == HeapKind::INSTANCE)
+      this->objects[id] = std::make_shared<LoxInstance>(std::get<std::shared_ptr<LoxClass>>(this->objects[this->records[id].link]));
+
+  // linking: values may refer to any object.
+  for (std::uint32_t id = 0; id < count; ++id) {
+    const Record &record = this->records[id];
+    if (record.kind == HeapKind::ENVIRONMENT) {
+      auto &values = std::get<std::shared_ptr<Environment>>(this->objects[id])->values;
+      for (const auto &[name, value] : record.entries)
+        values[name] = this->resolve(value);
+    } else if (record.kind == HeapKind::INSTANCE) {
+      auto &fields = std::get<std::shared_ptr<LoxInstance>>(this->objects[id])->fields;
+      for (const auto &[name, value] : record.entries)
+        fields[name] = this->resolve(value);
+    }
+  }
+  for (std::size_t i = 0; i < globals.size(); ++i)
+    interpreter.global_slots.define(interpreter.symbols.intern(globals[i].first), this->resolve(globals[i].second), types[i]);
+  interpreter.imported.insert(imported.begin(), imported.end());
+
+  Optimizer optimizer;
+  std::vector<std::shared_ptr<Stmt>> bodies(this->declarations.begin(), this->declarations.end());
+  optimizer.optimize(bodies);
+}
+
+[[nodiscard]] SnapshotReader::Record SnapshotReader::read_record() {
+  Record record{};
+  const auto kind = this->read_raw<std::uint8_t>();
+  if (kind > static_cast<std::uint8_t>(HeapKind::INSTANCE))
+    throw Corrupt{};
+  record.kind = static_cast<HeapKind>(kind);
+  switch (record.kind) {
+  case HeapKind::ENVIRONMENT:
+    record.link = this->read_raw<std::uint32_t>();
+    record.entries = this->read_entries();
+    break;
+  case HeapKind::FUNCTION:
+    record.declaration = this->read_raw<std::uint32_t>();
+    record.link = this->read_raw<std::uint32_t>();
+    record.is_initializer = this->read_raw<std::uint8_t>() != 0;
+    break;
+  case HeapKind::CLASS:
+    record.name = this->read_string();
+    record.link = this->read_raw<std::uint32_t>();
+    record.entries = this->read_entries();
+    break;
+  case HeapKind::INSTANCE:
+    record.link = this->read_raw<std::uint32_t>();
+    record.entries = this->read_entries();
+    break;
+  }
+  return record;
+}
+
+[[nodiscard]] SnapshotReader::Value SnapshotReader::read_value() {
+  Value value;
+  switch (this->read_raw<std::uint8_t>()) {
+  case StringIndex: value.literal = this->read_string(); break;
+  case DoubleIndex: value.literal = this->read_raw<double>(); break;
+  case BoolIndex: value.literal = this->read_raw<std::uint8_t>() != 0; break;
+  case NullptrIndex: value.literal = nullptr; break;
+  case LoxFunctionIndex:
+  case LoxClassIndex:
+  case LoxInstanceIndex: value.id = this->read_raw<std::uint32_t>(); break;
+  case IntegerIndex: value.literal = this->read_raw<std::int64_t>(); break;
+  default: throw Corrupt{};
+  }
+  return value;
+}
+
+[[nodiscard]] std::vector<std::pair<std::string, SnapshotReader::Value>> SnapshotReader::read_entries() {
+  std::vector<std::pair<std::string, Value>> entries(this->read_count());
+  for (auto &[name, value] : entries) {
+    name = this->read_string();
+    value = this->read_value();
+  }
+  return entries;
+}
+
+// a count can never exceed the bytes left, which bounds allocations made for
+// a corrupt file.
+[[nodiscard]] std::uint32_t SnapshotReader::read_count() {
+  const auto count = this->read_raw<std::uint32_t>();
+  if (static_cast<std::size_t>(this->end - this->cursor) < count)
+    throw Corrupt{};
+  return count;
+}
+
+[[nodiscard]] std::string SnapshotReader::read_string() {
+  const auto size = this->read_raw<std::uint32_t>();
+  if (static_cast<std::size_t>(this->end - this->cursor) < size)
+    throw Corrupt{};
+  std::string value(this->cursor, size);
+  this->cursor += size;
+  return value;
+}
+
+void SnapshotReader::check(std::uint32_t id, HeapKind kind) const {
+  if (id >= this->records.size() || this->records[id].kind != kind)
+    throw Corrupt{};
+}
+
+// values only refer to functions, classes and instances, never to
+// environments.
+void SnapshotReader::check(const Value &value) const {
+  if (value.id.has_value() && (*value.id >= this->records.size() || this->records[*value.id].kind == HeapKind::ENVIRONMENT))
+    throw Corrupt{};
+}
+
+void SnapshotReader::check(const Record &function, const std::vector<ProgramReader::Capture> &captures,
+                           bool bound) const {
+  auto holds = [this](std::uint32_t environment, int distance, std::string_view name) {
+    for (; distance > 0; --distance) {
+      environment = this->records[environment].link;
+      if (environment == none)
+        return false;
+    }
+    const auto &entries = this->records[environment].entries;
+    return std::any_of(entries.begin(), entries.end(), [name](const auto &entry) { return entry.first == name; });
+  };
+  // bind puts an environment holding 'this' between the body and the closure.
+  for (const ProgramReader::Capture &capture : captures) {
+    if (!bound) {
+      if (!holds(function.link, capture.distance, capture.name))
+        throw Corrupt{};
+    } else if (capture.distance == 0 ? capture.name != "this" : !holds(function.link, capture.distance - 1, capture.name)) {
+      throw Corrupt{};
+    }
+  }
+  // an initializer returns the 'this' of its closure.
+  if (function.is_initializer && !bound && !holds(function.link, 0, "this"))
+    throw Corrupt{};
+}
+
+[[nodiscard]] Object SnapshotReader::resolve(const Value &value) const {
+  if (!value.id.has_value())
+    return value.literal;
+  const HeapObject &object = this->objects[*value.id];
+  switch (static_cast<HeapKind>(object.index())) {
+  case HeapKind::FUNCTION: return std::get<std::shared_ptr<LoxFunction>>(object);
+  case HeapKind::CLASS: return std::get<std::shared_ptr<LoxClass>>(object);
+  case HeapKind::INSTANCE: return std::get<std::shared_ptr<LoxInstance>>(object);
+  default: return nullptr;
+  }
+}
+
+[[nodiscard]] std::shared_ptr<LoxClass> SnapshotReader::build_class(std::uint32_t id, std::vector<bool> &building) {
+  if (auto *klass = std::get_if<std::shared_ptr<LoxClass>>(&this->objects[id]))
+    return *klass;
+  // a superclass chain that loops back cannot come from a real heap.
+  if (building[id])
+    throw Corrupt{};
+  building[id] = true;
+  const Record &record = this->records[id];
+  std::shared_ptr<LoxClass> superclass = record.link == none ? nullptr : this->build_class(record.link, building);
+  std::map<std::string, std::shared_ptr<LoxFunction>> methods;
+  for (const auto &[name, value] : record.entries)
+    methods[name] = std::get<std::shared_ptr<LoxFunction>>(this->objects[*value.id]);
+  auto klass = std::make_shared<LoxClass>(record.name, std::move(superclass), std::move(methods));
+  this->objects[id] = klass;
+  return klass;
+}
+
+template <typename T>
+[[nodiscard]] T SnapshotReader::read_raw() {
+  if (static_cast<std::size_t>(this->end - this->cursor) < sizeof(T))
+    throw Corrupt{};
+  T value;
+  std::memcpy(&value, this->cursor, sizeof(T));
+  this->cursor += sizeof(T);
+  return value;
+}
+}// namespace loxplusplus
@@ -11,7 +11,7 @@ Stmt::~Stmt() {
 }
 
 Block::Block(std::vector<std::shared_ptr<Stmt>> statements)
-    : statements{std::move(statements)} {}
+    : Stmt(StmtKind::BLOCK), statements{std::move(statements)} {}
 
 Block::~Block() {
 }
@@ -22,7 +22,7 @@ Block::~Block() {
 
 Class::Class(Token name, std::shared_ptr<Variable> superclass,
              std::vector<std::shared_ptr<Function>> methods)
-    : name{std::move(name)}, superclass{std::move(superclass)},
+    : Stmt(StmtKind::CLASS), name{std::move(name)}, superclass{std::move(superclass)},
       methods{std::move(methods)} {}
 
 Class::~Class() {
@@ -33,7 +33,7 @@ Class::~Class() {
 }
 
 Expression::Expression(std::shared_ptr<Expr> expression)
-    : expression{std::move(expression)} {}
+    : Stmt(StmtKind::EXPRESSION), expression{std::move(expression)} {}
 
 Expression::~Expression() {
 }
@@ -44,18 +44,37 @@ Expression::~Expression() {
 
 Function::Function(Token name, std::vector<Token> params,
                    std::vector<std::shared_ptr<Stmt>> body)
-    : name{std::move(name)}, params{std::move(params)}, body{std::move(body)} {}
+    : Stmt(StmtKind::FUNCTION), name{std::move(name)}, params{std::move(params)}, statements{std::move(body)} {}
+
+Function::Function(Token name, std::vector<Token> params, DeferredBody deferred)
+    : Stmt(StmtKind::FUNCTION), name{std::move(name)}, params{std::move(params)}, pending{std::move(deferred)} {}
 
 Function::~Function() {
 }
 
+[[nodiscard]] const std::vector<std::shared_ptr<Stmt>> &Function::body() const {
+  if (this->pending) {
+    this->statements = this->pending(*this);
+    this->pending = nullptr;
+  }
+  return this->statements;
+}
+
+void Function::replace_body(std::vector<std::shared_ptr<Stmt>> body) {
+  this->statements = std::move(body);
+}
+
+[[nodiscard]] bool Function::deferred() const noexcept {
+  return static_cast<bool>(this->pending);
+}
+
 [[nodiscard]] Object Function::accept(StmtVisitor &visitor) {
   return visitor.visit(shared_from_this());
 }
 
 If::If(std::shared_ptr<Expr> condition, std::shared_ptr<Stmt> then_branch,
        std::shared_ptr<Stmt> else_branch)
-    : condition{std::move(condition)}, then_branch{std::move(then_branch)},
+    : Stmt(StmtKind::IF), condition{std::move(condition)}, then_branch{std::move(then_branch)},
       else_branch{std::move(else_branch)} {}
 
 If::~If() {
@@ -65,8 +84,18 @@ If::~If() {
   return visitor.visit(shared_from_this());
 }
 
+Import::Import(Token keyword, Token path)
+    : Stmt(StmtKind::IMPORT), keyword{std::move(keyword)}, path{std::move(path)} {}
+
+Import::~Import() {
+}
+
+[[nodiscard]] Object Import::accept(StmtVisitor &visitor) {
+  return visitor.visit(shared_from_this());
+}
+
 Print::Print(std::shared_ptr<Expr> expression)
-    : expression{std::move(expression)} {}
+    : Stmt(StmtKind::PRINT), expression{std::move(expression)} {}
 
 Print::~Print() {
 }
@@ -76,7 +105,7 @@ Print::~Print() {
 }
 
 Return::Return(Token keyword, std::shared_ptr<Expr> value)
-    : keyword{std::move(keyword)}, value{std::move(value)} {}
+    : Stmt(StmtKind::RETURN), keyword{std::move(keyword)}, value{std::move(value)} {}
 
 Return::~Return() {
 }
@@ -86,7 +115,7 @@ Return::~Return() {
 }
 
 Var::Var(Token name, std::shared_ptr<Expr> initializer)
-    : name{std::move(name)}, initializer{std::move(initializer)} {}
+    : Stmt(StmtKind::VAR), name{std::move(name)}, initializer{std::move(initializer)} {}
 
 Var::~Var() {
 }
@@ -96,7 +125,7 @@ Var::~Var() {
 }
 
 While::While(std::shared_ptr<Expr> condition, std::shared_ptr<Stmt> body)
-    : condition{std::move(condition)}, body{std::move(body)} {}
+    : Stmt(StmtKind::WHILE), condition{std::move(condition)}, body{std::move(body)} {}
 
 While::~While() {
 }
@@ -104,4 +133,18 @@ While::~While() {
 [[nodiscard]] Object While::accept(StmtVisitor &visitor) {
   return visitor.visit(shared_from_this());
 }
-}// namespace loxplusplus
\ No newline at end of file
+
+[[nodiscard]] std::unordered_map<std::string, std::size_t> top_level_declarations(
+  const std::vector<std::shared_ptr<Stmt>> &statements) {
+  std::unordered_map<std::string, std::size_t> declarations;
+  for (const std::shared_ptr<Stmt> &stmt : statements) {
+    if (stmt->kind == StmtKind::VAR)
+      ++declarations[std::static_pointer_cast<Var>(stmt)->name.lexeme];
+    else if (stmt->kind == StmtKind::FUNCTION)
+      ++declarations[std::static_pointer_cast<Function>(stmt)->name.lexeme];
+    else if (stmt->kind == StmtKind::CLASS)
+      ++declarations[std::static_pointer_cast<Class>(stmt)->name.lexeme];
+  }
+  return declarations;
+}
+}// namespace loxplusplus
@@ -0,0 +1,23 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include "../include/symbol_table.hpp"
+
+namespace loxplusplus {
+[[nodiscard]] int SymbolTable::intern(std::string_view name) {
+  if (auto it = this->symbols.find(name); it != this->symbols.end())
+    return it->second;
+  const int symbol = static_cast<int>(this->names.size());
+  // deque never relocates its elements, so the key view stays valid.
+  const std::string &stored = this->names.emplace_back(name);
+  this->symbols.emplace(stored, symbol);
+  return symbol;
+}
+
+[[nodiscard]] const std::string &SymbolTable::name(int symbol) const {
+  return this->names.at(symbol);
+}
+}// namespace loxplusplus
\ No newline at end of file
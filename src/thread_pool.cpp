@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+#include "../include/thread_pool.hpp"
+
+namespace loxplusplus {
+ThreadPool::ThreadPool(std::size_t threads)
+    : threads{std::max<std::size_t>(threads, 1)}, queues(this->threads) {}
+
+void ThreadPool::run(std::size_t count, const std::function<void(std::size_t)> &task) {
+  std::size_t workers = std::min(this->threads, std::max<std::size_t>(count, 1));
+  for (std::size_t worker = 0; worker < workers; ++worker) {
+    std::size_t begin = count * worker / workers, end = count * (worker + 1) / workers;
+    std::lock_guard<std::mutex> lock(this->queues[worker].mutex);
+    for (std::size_t index = begin; index < end; ++index)
+      this->queues[worker].tasks.push_back(index);
+  }
+  // tasks are never added while running, so a worker that finds every queue
+  // empty can stop.
+  std::vector<std::thread> helpers;
+  helpers.reserve(workers - 1);
+  for (std::size_t worker = 1; worker < workers; ++worker)
+    helpers.emplace_back([this, worker, &task] { this->work(worker, task); });
+  this->work(0, task);
+  for (auto &helper: helpers)
+    helper.join();
+  if (std::exception_ptr error = std::exchange(this->error, nullptr))
+    std::rethrow_exception(error);
+}
+
+[[nodiscard]] std::size_t ThreadPool::size() const noexcept {
+  return this->threads;
+}
+
+[[nodiscard]] std::size_t ThreadPool::default_threads() noexcept {
+  return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+void ThreadPool::work(std::size_t worker, const std::function<void(std::size_t)> &task) {
+  for (std::size_t index; this->take(worker, index) || this->steal(worker, index);) {
+    try {
+      task(index);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      if (this->error == nullptr)
+        this->error = std::current_exception();
+    }
+  }
+}
+
+[[nodiscard]] bool ThreadPool::take(std::size_t worker, std::size_t &index) {
+  Queue &queue = this->queues[worker];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty())
+    return false;
+  index = queue.tasks.front();
+  queue.tasks.pop_front();
+  return true;
+}
+
+[[nodiscard]] bool ThreadPool::steal(std::size_t worker, std::size_t &index) {
+  for (std::size_t offset = 1; offset < this->queues.size(); ++offset) {
+    Queue &queue = this->queues[(worker + offset) % this->queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+      continue;
+    index = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+  }
+  return false;
+}
+}// namespace loxplusplus
@@ -4,20 +4,39 @@
 // Distributed under the terms of the MIT License.
 //
 
+#include <charconv>
+#include <limits>
+
 #include "../include/token.hpp"
+#include "../include/number.hpp"
 
 namespace loxplusplus {
-Token::Token(TokenType type, std::string lexeme, Object literal, int line) noexcept
+SourceToken::SourceToken(TokenType type, std::string_view lexeme, int line) noexcept
     : type{type},
-      lexeme{std::move(lexeme)},
-      literal{std::move(literal)},
-      line{line} {
+      line{line},
+      lexeme{lexeme} {
 }
 
-Token::~Token() noexcept {
+// integers beyond 2^53 in magnitude become doubles. literals have no sign or
+// exponent, so one out of the double range overflows to infinity when it has
+// a nonzero integer part and underflows to zero otherwise, as with strtod.
+[[nodiscard]] Object SourceToken::literal() const {
+  if (this->type == TokenType::STRING)
+    return std::string(this->lexeme.substr(1, this->lexeme.size() - 2));
+  const char *first = this->lexeme.data(),
+             *last = this->lexeme.data() + this->lexeme.size();
+  if (std::int64_t integer; this->lexeme.find('.') == std::string_view::npos &&
+                            std::from_chars(first, last, integer).ec == std::errc{} && is_exact_integer(integer))
+    return integer;
+  double value = 0.0;
+  if (std::from_chars(first, last, value).ec == std::errc::result_out_of_range) {
+    const std::size_t digit = this->lexeme.find_first_not_of('0');
+    value = digit != std::string_view::npos && this->lexeme[digit] != '.' ? std::numeric_limits<double>::infinity() : 0.0;
+  }
+  return value;
 }
 
-[[nodiscard]] std::string Token::to_string() const noexcept {
+[[nodiscard]] std::string SourceToken::to_string() const noexcept {
   std::string literal_text;
   switch (this->type) {
   case TokenType::IDENTIFIER: {
@@ -25,11 +44,12 @@ Token::~Token() noexcept {
     break;
   }
   case TokenType::STRING: {
-    literal_text = std::get<StringIndex>(this->literal);
+    literal_text = std::get<StringIndex>(this->literal());
     break;
   }
   case TokenType::NUMBER: {
-    literal_text = std::to_string(std::get<LongDoubleIndex>(this->literal));
+    NumberBuffer buffer;
+    literal_text = number_to_chars(this->literal(), buffer);
     break;
   }
   case TokenType::TRUE: {
@@ -45,6 +65,25 @@ Token::~Token() noexcept {
     break;
   }
   }
-  return loxplusplus::to_string(this->type) + " " + this->lexeme + " " + literal_text;
+  return loxplusplus::to_string(this->type) + " " + std::string(this->lexeme) + " " + literal_text;
+}
+
+[[nodiscard]] const std::string &Lexicon::intern(std::string_view lexeme) {
+  if (auto it = this->lexemes.find(lexeme); it != this->lexemes.end())
+    return *it->second;
+  // deque never relocates its elements, so the key view stays valid.
+  const std::string &stored = this->storage.emplace_back(lexeme);
+  this->lexemes.emplace(stored, &stored);
+  return stored;
+}
+
+Token::Token(TokenType type, std::string_view lexeme, int line, Lexicon &lexicon)
+    : type{type},
+      line{line},
+      lexeme{lexicon.intern(lexeme)} {
+}
+
+Token::Token(const SourceToken &token, Lexicon &lexicon)
+    : Token(token.type, token.lexeme, token.line, lexicon) {
 }
 }// namespace loxplusplus
\ No newline at end of file
@@ -0,0 +1,421 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <charconv>
+#include <cmath>
+
+#include "../include/transpiler.hpp"
+
+namespace loxplusplus {
+[[nodiscard]] std::string Transpiler::transpile(const std::vector<std::shared_ptr<Stmt>> &statements,
+                                                std::string_view source_name, const Modules &modules) {
+  this->modules = &modules;
+  // the first translation only discovers which locals are captured.
+  this->translate(statements);
+  this->translate(statements);
+  std::string output = "// generated by lox++ --emit-cpp from " + std::string(source_name) + ".\n"
+                       "// build: c++ -std=c++20 -O2 -I <lox++>/include <this file> "
+                       "<lox++>/src/lox_runtime.cpp <lox++>/src/output_sink.cpp\n"
+                       "#include \"lox_runtime.hpp\"\n\n"
+                       "using namespace loxplusplus::runtime;\n\n";
+  for (const std::string &name : this->globals)
+    output.append("static Global g_" + name + "{\"" + name + "\"};\n");
+  if (!this->globals.empty())
+    output.push_back('\n');
+  output.append("static void program() {\n" + this->code + "}\n\n"
+                "int main() {\n"
+                "  return run(program);\n"
+                "}\n");
+  return output;
+}
+
+void Transpiler::translate(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  this->code.clear();
+  this->indent = 1;
+  this->function_depth = this->class_count = 0;
+  this->imported.clear();
+  for (const std::shared_ptr<Stmt> &stmt : statements)
+    this->emit(stmt);
+}
+
+void Transpiler::emit(std::shared_ptr<Stmt> stmt) {
+  (void)dispatch(*this, stmt);
+}
+
+[[nodiscard]] std::string Transpiler::emit(std::shared_ptr<Expr> expr) {
+  return std::get<StringIndex>(dispatch(*this, expr));
+}
+
+void Transpiler::line(const std::string &text) {
+  this->code.append(this->indent * 2, ' ').append(text).push_back('\n');
+}
+
+// translates the parameters and body of a function into a c++ lambda. the
+// lambda copies the cells and the receiver it refers to, so it may outlive
+// the scope it was created in like a lox closure does.
+[[nodiscard]] std::string Transpiler::lambda(const Function &function, FunctionType type) {
+  std::string enclosing_code = std::move(this->code);
+  FunctionType enclosing_function = this->current_function;
+  this->code.clear();
+  this->current_function = type;
+  ++this->function_depth;
+  ++this->indent;
+  this->begin_scope();
+  for (std::size_t i = 0; i < function.params.size(); ++i) {
+    const Token &param = function.params[i];
+    const ValueType param_type = function.param_types.empty() ? ValueType::ANY : function.param_types[i];
+    this->line(this->declare(&param, param.lexeme,
+                             checked("std::move(args[" + std::to_string(i) + "])", param_type,
+                                     "'" + param.lexeme + "'", param.line)));
+  }
+  for (const std::shared_ptr<Stmt> &stmt : function.body())
+    this->emit(stmt);
+  if (type == FunctionType::INITIALIZER)
+    this->line("return Value(self);");
+  else
+    this->line("return " + checked("Value(nullptr)", function.return_type, "return value", function.name.line) + ";");
+  this->end_scope();
+  --this->indent;
+  --this->function_depth;
+  this->current_function = enclosing_function;
+  std::string lambda = type == FunctionType::FUNCTION ? "[=](Arguments &args) -> Value {\n"
+                                                      : "[=](const std::shared_ptr<Instance> &self, Arguments &args) -> Value {\n";
+  lambda.append(this->code).append(this->indent * 2, ' ').push_back('}');
+  this->code = std::move(enclosing_code);
+  return lambda;
+}
+
+void Transpiler::begin_scope() {
+  this->scopes.emplace_back();
+}
+
+void Transpiler::end_scope() {
+  this->scopes.pop_back();
+}
+
+[[nodiscard]] std::string Transpiler::declare(const void *key, const std::string &name, const std::string &value) {
+  auto [it, inserted] = this->declarations.try_emplace(key, Declaration{this->function_depth});
+  this->scopes.back()[name] = key;
+  if (it->second.captured)
+    return "Cell l_" + name + " = std::make_shared<Value>(" + value + ");";
+  return "Value l_" + name + " = " + value + ";";
+}
+
+[[nodiscard]] std::string Transpiler::reference(const std::string &name, int depth) {
+  if (depth < 0)
+    return this->global(name);
+  Declaration &declaration = this->declarations.at(this->scopes[this->scopes.size() - 1 - depth].at(name));
+  if (declaration.function_depth != this->function_depth)
+    declaration.captured = true;
+  return declaration.captured ? "(*l_" + name + ")" : "l_" + name;
+}
+
+[[nodiscard]] std::string Transpiler::global(const std::string &name) {
+  this->globals.insert(name);
+  return "g_" + name;
+}
+
+[[nodiscard]] std::string Transpiler::type_literal(ValueType type) {
+  static constexpr const char *names[] = {"Type::ANY", "Type::NUMBER", "Type::STRING", "Type::BOOL"};
+  return names[static_cast<std::size_t>(type)];
+}
+
+// wraps value with the runtime check the TypeChecker left to an annotation.
+[[nodiscard]] std::string Transpiler::checked(const std::string &value, ValueType type, const std::string &subject, int line) {
+  if (type == ValueType::ANY)
+    return value;
+  return "checked(" + value + ", " + type_literal(type) + ", \"" + subject + "\", " + std::to_string(line) + ")";
+}
+
+[[nodiscard]] std::string Transpiler::string_literal(const std::string &value) {
+  static constexpr char digits[] = "01234567";
+  std::string literal = "std::string(\"";
+  for (unsigned char c : value) {
+    if (c == '"' || c == '\\') {
+      literal.push_back('\\');
+      literal.push_back(static_cast<char>(c));
+    } else if (c == '\n') {
+      literal.append("\\n");
+    } else if (c < 0x20 || c >= 0x7f || c == '?') {
+      // octal escapes keep trigraph-like and non-ascii bytes verbatim.
+      literal.push_back('\\');
+      literal.push_back(digits[c >> 6]);
+      literal.push_back(digits[(c >> 3) & 7]);
+      literal.push_back(digits[c & 7]);
+    } else {
+      literal.push_back(static_cast<char>(c));
+    }
+  }
+  return literal + "\", " + std::to_string(value.size()) + ")";
+}
+
+[[nodiscard]] std::string Transpiler::number_literal(const Object &value) {
+  if (value.index() == IntegerIndex)
+    return "Value(std::int64_t(" + std::to_string(std::get<IntegerIndex>(value)) + "))";
+  const double number = std::get<DoubleIndex>(value);
+  if (std::isinf(number))
+    return "Value(std::numeric_limits<double>::infinity())";
+  char buffer[64];
+  std::string text(buffer, std::to_chars(buffer, buffer + sizeof buffer, number).ptr);
+  if (text.find_first_of(".e") == std::string::npos)
+    text.append(".0");
+  return "Value(" + text + ")";
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Block> stmt) {
+  this->line("{");
+  ++this->indent;
+  this->begin_scope();
+  for (const std::shared_ptr<Stmt> &statement : stmt->statements)
+    this->emit(statement);
+  this->end_scope();
+  --this->indent;
+  this->line("}");
+  return nullptr;
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Class> stmt) {
+  const std::string index = std::to_string(this->class_count++), klass = "c_" + index;
+  std::string superclass = "nullptr";
+  if (stmt->superclass != nullptr) {
+    superclass = "s_" + index;
+    this->line("std::shared_ptr<Class> " + superclass + " = superclass(" + this->emit(stmt->superclass) + ", " +
+               std::to_string(stmt->superclass->name.line) + ");");
+  }
+  std::string name;
+  if (this->scopes.empty()) {
+    name = this->global(stmt->name.lexeme);
+    this->line("define_global(" + name + ", nullptr);");
+  } else {
+    this->line(this->declare(stmt.get(), stmt->name.lexeme, "nullptr"));
+    name = this->reference(stmt->name.lexeme, 0);
+  }
+  this->line("auto " + klass + " = std::make_shared<Class>(Class{\"" + stmt->name.lexeme + "\", " + superclass + ", {}});");
+  if (stmt->superclass != nullptr) {
+    this->begin_scope();
+    this->scopes.back()["super"] = nullptr;
+  }
+  this->begin_scope();
+  this->scopes.back()["this"] = nullptr;
+  this->superclasses.push_back(superclass);
+  for (const std::shared_ptr<Function> &method : stmt->methods) {
+    const bool is_initializer = method->name.lexeme == "init";
+    this->line(klass + "->methods[\"" + method->name.lexeme + "\"] = method(\"" + method->name.lexeme + "\", " +
+               std::to_string(method->params.size()) + ", " + (is_initializer ? "true" : "false") + ", " +
+               this->lambda(*method, is_initializer ? FunctionType::INITIALIZER : FunctionType::METHOD) + ");");
+  }
+  this->superclasses.pop_back();
+  this->end_scope();
+  if (stmt->superclass != nullptr)
+    this->end_scope();
+  if (this->scopes.empty())
+    this->line("define_global(" + name + ", " + klass + ");");
+  else
+    this->line(name + " = " + klass + ";");
+  return nullptr;
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Expression> stmt) {
+  this->line("(void)(" + this->emit(stmt->expression) + ");");
+  return nullptr;
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Function> stmt) {
+  std::string name;
+  if (this->scopes.empty()) {
+    name = this->global(stmt->name.lexeme);
+  } else {
+    // declared before the body, which may call the function recursively.
+    this->line(this->declare(stmt.get(), stmt->name.lexeme, "nullptr"));
+    name = this->reference(stmt->name.lexeme, 0);
+  }
+  const std::string function = "function(\"" + stmt->name.lexeme + "\", " + std::to_string(stmt->params.size()) +
+                               ", " + this->lambda(*stmt, FunctionType::FUNCTION) + ")";
+  if (this->scopes.empty())
+    this->line("define_global(" + name + ", " + function + ");");
+  else
+    this->line(name + " = " + function + ";");
+  return nullptr;
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<If> stmt) {
+  this->line("if (truthy(" + this->emit(stmt->condition) + ")) {");
+  ++this->indent;
+  this->emit(stmt->then_branch);
+  --this->indent;
+  if (stmt->else_branch != nullptr) {
+    this->line("} else {");
+    ++this->indent;
+    this->emit(stmt->else_branch);
+    --this->indent;
+  }
+  this->line("}");
+  return nullptr;
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Import> stmt) {
+  if (!this->imported.insert(stmt->module).second)
+    return nullptr;
+  this->line("// module " + stmt->module);
+  for (const std::shared_ptr<Stmt> &statement : this->modules->at(stmt->module)->statements)
+    this->emit(statement);
+  return nullptr;
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Print> stmt) {
+  this->line("print(" + this->emit(stmt->expression) + ");");
+  return nullptr;
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Return> stmt) {
+  if (this->current_function == FunctionType::INITIALIZER)
+    this->line("return Value(self);");
+  else
+    this->line("return " + checked(stmt->value != nullptr ? this->emit(stmt->value) : "Value(nullptr)", stmt->check,
+                                   "return value", stmt->keyword.line) + ";");
+  return nullptr;
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Var> stmt) {
+  const std::string value = checked(stmt->initializer != nullptr ? this->emit(stmt->initializer) : "Value(nullptr)",
+                                    stmt->check, "'" + stmt->name.lexeme + "'", stmt->name.line);
+  if (this->scopes.empty() && stmt->type != ValueType::ANY)
+    this->line("define_global(" + this->global(stmt->name.lexeme) + ", " + value + ", " + type_literal(stmt->type) + ");");
+  else if (this->scopes.empty())
+    this->line("define_global(" + this->global(stmt->name.lexeme) + ", " + value + ");");
+  else
+    this->line(this->declare(stmt.get(), stmt->name.lexeme, value));
+  return nullptr;
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<While> stmt) {
+  this->line("while (truthy(" + this->emit(stmt->condition) + ")) {");
+  ++this->indent;
+  this->emit(stmt->body);
+  --this->indent;
+  this->line("}");
+  return nullptr;
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Assign> expr) {
+  const std::string value = checked(this->emit(expr->value), expr->check, "'" + expr->name.lexeme + "'", expr->name.line);
+  if (expr->depth < 0)
+    return "assign_global(" + this->global(expr->name.lexeme) + ", " + value + ", " + std::to_string(expr->name.line) + ")";
+  return "(" + this->reference(expr->name.lexeme, expr->depth) + " = " + value + ")";
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Binary> expr) {
+  const std::string operands = "Operands{" + this->emit(expr->left) + ", " + this->emit(expr->right) + "}",
+                    line = std::to_string(expr->op.line);
+  switch (expr->op.type) {
+  case TokenType::BANG_EQUAL: {
+    return "not_equal(" + operands + ")";
+  }
+  case TokenType::EQUAL_EQUAL: {
+    return "equal(" + operands + ")";
+  }
+  case TokenType::GREATER: {
+    return "greater(" + operands + ", " + line + ")";
+  }
+  case TokenType::GREATER_EQUAL: {
+    return "greater_equal(" + operands + ", " + line + ")";
+  }
+  case TokenType::LESS: {
+    return "less(" + operands + ", " + line + ")";
+  }
+  case TokenType::LESS_EQUAL: {
+    return "less_equal(" + operands + ", " + line + ")";
+  }
+  case TokenType::MINUS: {
+    return "subtract(" + operands + ", " + line + ")";
+  }
+  case TokenType::PLUS: {
+    return "add(" + operands + ", " + line + ")";
+  }
+  case TokenType::SLASH: {
+    return "divide(" + operands + ", " + line + ")";
+  }
+  case TokenType::STAR: {
+    return "multiply(" + operands + ", " + line + ")";
+  }
+  default: {
+    return std::string("Value(nullptr)");
+  }
+  }
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Call> expr) {
+  std::string invocation = "Invocation{" + this->emit(expr->callee) + ", {";
+  for (std::size_t i = 0; i < expr->arguments.size(); ++i) {
+    if (i != 0)
+      invocation.append(", ");
+    invocation.append(this->emit(expr->arguments[i]));
+  }
+  return "call(" + invocation + "}}, " + std::to_string(expr->paren.line) + ")";
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Get> expr) {
+  return "get(" + this->emit(expr->object) + ", \"" + expr->name.lexeme + "\", " + std::to_string(expr->name.line) + ")";
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Grouping> expr) {
+  return "(" + this->emit(expr->expression) + ")";
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Literal> expr) {
+  switch (expr->value.index()) {
+  case StringIndex: {
+    return "Value(" + string_literal(std::get<StringIndex>(expr->value)) + ")";
+  }
+  case IntegerIndex:
+  case DoubleIndex: {
+    return number_literal(expr->value);
+  }
+  case BoolIndex: {
+    return std::string(std::get<BoolIndex>(expr->value) ? "Value(true)" : "Value(false)");
+  }
+  default: {
+    return std::string("Value(nullptr)");
+  }
+  }
+}
+
+// logical operators and property assignment must not evaluate their right
+// side in every case, so they become immediately invoked lambdas.
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Logical> expr) {
+  const std::string short_circuit = expr->op.type == TokenType::OR ? "truthy(left)" : "!truthy(left)";
+  return "[&]() -> Value { Value left = " + this->emit(expr->left) + "; if (" + short_circuit +
+         ") return left; return " + this->emit(expr->right) + "; }()";
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Set> expr) {
+  return "[&]() -> Value { Value object = " + this->emit(expr->object) + "; const auto &instance = instance_for_set(object, " +
+         std::to_string(expr->name.line) + "); return instance->fields[\"" + expr->name.lexeme + "\"] = " +
+         this->emit(expr->value) + "; }()";
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Super> expr) {
+  return "super_method(" + this->superclasses.back() + ", self, \"" + expr->method.lexeme + "\", " +
+         std::to_string(expr->method.line) + ")";
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<This> expr) {
+  return std::string("Value(self)");
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Unary> expr) {
+  const std::string operand = this->emit(expr->right);
+  if (expr->op.type == TokenType::BANG)
+    return "Value(!truthy(" + operand + "))";
+  return "negate(" + operand + ", " + std::to_string(expr->op.line) + ")";
+}
+
+[[nodiscard]] Object Transpiler::visit(std::shared_ptr<Variable> expr) {
+  if (expr->depth < 0)
+    return "get_global(" + this->global(expr->name.lexeme) + ", " + std::to_string(expr->name.line) + ")";
+  return this->reference(expr->name.lexeme, expr->depth);
+}
+}// namespace loxplusplus
@@ -0,0 +1,252 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <utility>
+
+#include "../include/type_checker.hpp"
+
+namespace loxplusplus {
+TypeChecker::TypeChecker(Diagnostics &diagnostics)
+    : diagnostics{diagnostics} {}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Block> stmt) {
+  this->begin_scope();
+  this->check(stmt->statements);
+  this->end_scope();
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Class> stmt) {
+  this->declare(stmt->name, ValueType::ANY);
+  if (stmt->superclass != nullptr)
+    (void)this->infer(stmt->superclass);
+  for (const std::shared_ptr<Function> &method : stmt->methods)
+    if (!method->deferred())
+      this->check_function(*method, method->body());
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Expression> stmt) {
+  (void)this->infer(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Function> stmt) {
+  this->declare(stmt->name, ValueType::ANY);
+  if (!stmt->deferred())
+    this->check_function(*stmt, stmt->body());
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<If> stmt) {
+  (void)this->infer(stmt->condition);
+  this->check(stmt->then_branch);
+  if (stmt->else_branch != nullptr)
+    this->check(stmt->else_branch);
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Import> stmt) {
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Print> stmt) {
+  (void)this->infer(stmt->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Return> stmt) {
+  if (this->return_type == ValueType::ANY) {
+    if (stmt->value != nullptr)
+      (void)this->infer(stmt->value);
+    return nullptr;
+  }
+  if (stmt->value == nullptr) {
+    this->diagnostics.error(stmt->keyword, "expect a value of type " + std::string(type_name(this->return_type)) + ".");
+    return nullptr;
+  }
+  stmt->check = this->expect(stmt->keyword, "return value", this->return_type, this->infer(stmt->value));
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Var> stmt) {
+  const ValueType initializer = stmt->initializer != nullptr ? this->infer(stmt->initializer) : ValueType::ANY;
+  if (stmt->type != ValueType::ANY && stmt->initializer != nullptr)
+    stmt->check = this->expect(stmt->name, "'" + stmt->name.lexeme + "'", stmt->type, initializer);
+  this->declare(stmt->name, stmt->type);
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<While> stmt) {
+  (void)this->infer(stmt->condition);
+  this->check(stmt->body);
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Assign> expr) {
+  const ValueType value = this->infer(expr->value);
+  // assignments to globals are checked by the GlobalTable.
+  const ValueType declared = expr->depth >= 0 ? this->lookup(expr->name) : ValueType::ANY;
+  if (declared != ValueType::ANY)
+    expr->check = this->expect(expr->name, "'" + expr->name.lexeme + "'", declared, value);
+  this->type = declared != ValueType::ANY ? declared : value;
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Binary> expr) {
+  const ValueType left = this->infer(expr->left), right = this->infer(expr->right);
+  const bool numbers = left == ValueType::NUMBER && right == ValueType::NUMBER;
+  switch (expr->op.type) {
+  case TokenType::BANG_EQUAL:
+  case TokenType::EQUAL_EQUAL:
+    this->type = ValueType::BOOL;
+    break;
+  case TokenType::GREATER:
+  case TokenType::GREATER_EQUAL:
+  case TokenType::LESS:
+  case TokenType::LESS_EQUAL:
+    expr->numeric = numbers;
+    this->type = ValueType::BOOL;
+    break;
+  case TokenType::PLUS:
+    expr->numeric = numbers;
+    // a sum that does not throw has the type of its operands.
+    this->type = left == ValueType::NUMBER || right == ValueType::NUMBER   ? ValueType::NUMBER
+                 : left == ValueType::STRING || right == ValueType::STRING ? ValueType::STRING
+                                                                           : ValueType::ANY;
+    break;
+  default:
+    expr->numeric = numbers;
+    this->type = ValueType::NUMBER;
+    break;
+  }
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Call> expr) {
+  (void)this->infer(expr->callee);
+  for (const std::shared_ptr<Expr> &argument : expr->arguments)
+    (void)this->infer(argument);
+  this->type = ValueType::ANY;
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Get> expr) {
+  (void)this->infer(expr->object);
+  this->type = ValueType::ANY;
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Grouping> expr) {
+  this->type = this->infer(expr->expression);
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Literal> expr) {
+  switch (expr->value.index()) {
+  case IntegerIndex:
+  case DoubleIndex: this->type = ValueType::NUMBER; break;
+  case StringIndex: this->type = ValueType::STRING; break;
+  case BoolIndex: this->type = ValueType::BOOL; break;
+  default: this->type = ValueType::ANY; break;
+  }
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Logical> expr) {
+  const ValueType left = this->infer(expr->left), right = this->infer(expr->right);
+  // the result is one of the operands.
+  this->type = left == right ? left : ValueType::ANY;
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Set> expr) {
+  (void)this->infer(expr->value);
+  (void)this->infer(expr->object);
+  this->type = ValueType::ANY;
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Super> expr) {
+  this->type = ValueType::ANY;
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<This> expr) {
+  this->type = ValueType::ANY;
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Unary> expr) {
+  const ValueType right = this->infer(expr->right);
+  if (expr->op.type == TokenType::BANG) {
+    this->type = ValueType::BOOL;
+    return nullptr;
+  }
+  expr->numeric = right == ValueType::NUMBER;
+  this->type = ValueType::NUMBER;
+  return nullptr;
+}
+
+[[nodiscard]] Object TypeChecker::visit(std::shared_ptr<Variable> expr) {
+  this->type = expr->depth >= 0 ? this->lookup(expr->name) : ValueType::ANY;
+  return nullptr;
+}
+
+void TypeChecker::check(const std::vector<std::shared_ptr<Stmt>> &statements) {
+  for (const std::shared_ptr<Stmt> &statement : statements)
+    this->check(statement);
+}
+
+void TypeChecker::check_function(const Function &function, const std::vector<std::shared_ptr<Stmt>> &body) {
+  const ValueType enclosing = std::exchange(this->return_type, function.return_type);
+  this->begin_scope();
+  for (std::size_t i = 0; i < function.params.size(); ++i)
+    this->declare(function.params[i], function.param_types.empty() ? ValueType::ANY : function.param_types[i]);
+  this->check(body);
+  this->end_scope();
+  this->return_type = enclosing;
+}
+
+void TypeChecker::check(const std::shared_ptr<Stmt> &stmt) {
+  (void)dispatch(*this, stmt);
+}
+
+[[nodiscard]] ValueType TypeChecker::infer(const std::shared_ptr<Expr> &expr) {
+  (void)dispatch(*this, expr);
+  return this->type;
+}
+
+[[nodiscard]] ValueType TypeChecker::expect(const Token &token, std::string_view subject, ValueType expected,
+                                            ValueType actual) {
+  if (actual == ValueType::ANY)
+    return expected;
+  if (actual != expected)
+    this->diagnostics.error(token, std::string(subject) + " must be of type " + std::string(type_name(expected)) +
+                                       ", not " + std::string(type_name(actual)) + ".");
+  return ValueType::ANY;
+}
+
+void TypeChecker::begin_scope() {
+  this->scopes.emplace_back();
+}
+
+void TypeChecker::end_scope() {
+  this->scopes.pop_back();
+}
+
+void TypeChecker::declare(const Token &name, ValueType type) {
+  if (!this->scopes.empty())
+    this->scopes.back()[name.lexeme] = type;
+}
+
+[[nodiscard]] ValueType TypeChecker::lookup(const Token &name) const {
+  for (auto scope = this->scopes.rbegin(); scope != this->scopes.rend(); ++scope)
+    if (auto it = scope->find(name.lexeme); it != scope->end())
+      return it->second;
+  return ValueType::ANY;
+}
+}// namespace loxplusplus
@@ -0,0 +1,235 @@
+// MIT License
+//
+// Copyright (c) 2024 Ferhat Geçdoğan All Rights Reserved.
+// Distributed under the terms of the MIT License.
+//
+
+#include <cstring>
+#include <limits>
+
+#include "../include/x64_emitter.hpp"
+
+namespace loxplusplus {
+static constexpr std::size_t unbound = std::numeric_limits<std::size_t>::max();
+
+[[nodiscard]] X64Emitter::Label X64Emitter::new_label() {
+  this->labels.push_back(unbound);
+  return this->labels.size() - 1;
+}
+
+void X64Emitter::bind(Label label) {
+  this->labels[label] = this->code.size();
+}
+
+void X64Emitter::push(Register reg) {
+  if (reg >= R8)
+    this->byte(0x41);
+  this->byte(0x50 + (reg & 7));
+}
+
+void X64Emitter::pop(Register reg) {
+  if (reg >= R8)
+    this->byte(0x41);
+  this->byte(0x58 + (reg & 7));
+}
+
+void X64Emitter::mov(Register dst, Register src) {
+  this->register_operands(0x89, src, dst);
+}
+
+void X64Emitter::mov(Register dst, std::int64_t imm) {
+  this->byte(0x48 | (dst >= R8 ? 1 : 0));
+  this->byte(0xB8 + (dst & 7));
+  for (int i = 0; i < 8; ++i)
+    this->byte(static_cast<std::uint8_t>(static_cast<std::uint64_t>(imm) >> (i * 8)));
+}
+
+void X64Emitter::load(Register dst, std::int32_t displacement) {
+  this->rex(dst, RBP);
+  this->byte(0x8B);
+  this->rbp_operand(dst, displacement);
+}
+
+void X64Emitter::store(std::int32_t displacement, Register src) {
+  this->rex(src, RBP);
+  this->byte(0x89);
+  this->rbp_operand(src, displacement);
+}
+
+// mov qword [base], imm32
+void X64Emitter::store_indirect(Register base, std::int32_t imm) {
+  this->rex(RAX, base);
+  this->byte(0xC7);
+  this->byte(base & 7);
+  this->imm32(imm);
+}
+
+// cmp qword [base], imm8
+void X64Emitter::compare_indirect(Register base, std::int8_t imm) {
+  this->rex(RAX, base);
+  this->byte(0x83);
+  this->byte(0x38 | (base & 7));
+  this->byte(static_cast<std::uint8_t>(imm));
+}
+
+void X64Emitter::add(Register dst, Register src) {
+  this->register_operands(0x01, src, dst);
+}
+
+void X64Emitter::sub(Register dst, Register src) {
+  this->register_operands(0x29, src, dst);
+}
+
+void X64Emitter::imul(Register dst, Register src) {
+  this->rex(dst, src);
+  this->byte(0x0F);
+  this->byte(0xAF);
+  this->byte(0xC0 | ((dst & 7) << 3) | (src & 7));
+}
+
+void X64Emitter::or_(Register dst, Register src) {
+  this->register_operands(0x09, src, dst);
+}
+
+void X64Emitter::cmp(Register left, Register right) {
+  this->register_operands(0x39, right, left);
+}
+
+void X64Emitter::cmp(Register left, std::int8_t imm) {
+  this->rex(RAX, left);
+  this->byte(0x83);
+  this->byte(0xF8 | (left & 7));
+  this->byte(static_cast<std::uint8_t>(imm));
+}
+
+// cmp left, qword [base + displacement]; base must not be rsp.
+void X64Emitter::cmp(Register left, Register base, std::int8_t displacement) {
+  this->rex(left, base);
+  this->byte(0x3B);
+  this->byte(0x40 | ((left & 7) << 3) | (base & 7));
+  this->byte(static_cast<std::uint8_t>(displacement));
+}
+
+void X64Emitter::test(Register left, Register right) {
+  this->register_operands(0x85, right, left);
+}
+
+void X64Emitter::xor_(Register dst, std::int8_t imm) {
+  this->rex(RAX, dst);
+  this->byte(0x83);
+  this->byte(0xF0 | (dst & 7));
+  this->byte(static_cast<std::uint8_t>(imm));
+}
+
+void X64Emitter::add_rsp(std::int32_t imm) {
+  this->byte(0x48);
+  this->byte(0x81);
+  this->byte(0xC4);
+  this->imm32(imm);
+}
+
+void X64Emitter::sub_rsp(std::int32_t imm) {
+  this->byte(0x48);
+  this->byte(0x81);
+  this->byte(0xEC);
+  this->imm32(imm);
+}
+
+// emits `sub rsp, imm32` and returns the offset of the immediate, so the
+// frame size can be patched in once it is known.
+[[nodiscard]] std::size_t X64Emitter::sub_rsp_placeholder() {
+  this->sub_rsp(0);
+  return this->code.size() - 4;
+}
+
+void X64Emitter::patch_imm32(std::size_t offset, std::int32_t imm) {
+  std::memcpy(this->code.data() + offset, &imm, sizeof imm);
+}
+
+void X64Emitter::neg(Register reg) {
+  this->rex(RAX, reg);
+  this->byte(0xF7);
+  this->byte(0xD8 | (reg & 7));
+}
+
+void X64Emitter::cqo() {
+  this->byte(0x48);
+  this->byte(0x99);
+}
+
+void X64Emitter::idiv(Register divisor) {
+  this->rex(RAX, divisor);
+  this->byte(0xF7);
+  this->byte(0xF8 | (divisor & 7));
+}
+
+// setcc al; movzx eax, al
+void X64Emitter::set(Condition condition) {
+  this->byte(0x0F);
+  this->byte(0x90 + condition);
+  this->byte(0xC0);
+  this->byte(0x0F);
+  this->byte(0xB6);
+  this->byte(0xC0);
+}
+
+void X64Emitter::jump(Label label) {
+  this->byte(0xE9);
+  this->rel32(label);
+}
+
+void X64Emitter::jump(Condition condition, Label label) {
+  this->byte(0x0F);
+  this->byte(0x80 + condition);
+  this->rel32(label);
+}
+
+void X64Emitter::call(Label label) {
+  this->byte(0xE8);
+  this->rel32(label);
+}
+
+void X64Emitter::ret() {
+  this->byte(0xC3);
+}
+
+[[nodiscard]] const std::vector<std::uint8_t> &X64Emitter::finish() {
+  for (const Fixup &fixup : this->fixups) {
+    const auto target = static_cast<std::int64_t>(this->labels[fixup.label]);
+    const auto next = static_cast<std::int64_t>(fixup.offset + 4);
+    this->patch_imm32(fixup.offset, static_cast<std::int32_t>(target - next));
+  }
+  this->fixups.clear();
+  return this->code;
+}
+
+void X64Emitter::byte(std::uint8_t value) {
+  this->code.push_back(value);
+}
+
+void X64Emitter::imm32(std::int32_t value) {
+  for (int i = 0; i < 4; ++i)
+    this->byte(static_cast<std::uint8_t>(static_cast<std::uint32_t>(value) >> (i * 8)));
+}
+
+// REX.W prefix, extended with the high bits of the modrm reg and rm fields.
+void X64Emitter::rex(Register reg, Register rm) {
+  this->byte(0x48 | (reg >= R8 ? 4 : 0) | (rm >= R8 ? 1 : 0));
+}
+
+void X64Emitter::register_operands(std::uint8_t opcode, Register reg, Register rm) {
+  this->rex(reg, rm);
+  this->byte(opcode);
+  this->byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+void X64Emitter::rbp_operand(Register reg, std::int32_t displacement) {
+  this->byte(0x80 | ((reg & 7) << 3) | (RBP & 7));
+  this->imm32(displacement);
+}
+
+void X64Emitter::rel32(Label label) {
+  this->fixups.push_back(Fixup{this->code.size(), label});
+  this->imm32(0);
+}
+}// namespace loxplusplus